@@ -25,7 +25,11 @@
 #include "names.h"
 #include "pointer.h"
 #include "log.h"
+#include "abort.h"
+#include "simple-ref-count.h"
 
+#include <cstdlib>
+#include <map>
 #include <sstream>
 
 /**
@@ -296,159 +300,283 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 
 /**
  * \ingroup config-impl
- * Abstract class to parse Config paths into object references.
+ * A set of Config paths, stored as a tree of path elements so that
+ * paths with a common prefix are resolved only once.
  */
-class Resolver
+class PathTree : public SimpleRefCount<PathTree>
 {
 public:
+  /** One element of a Config path. */
+  struct Node
+  {
+    /** The path element. */
+    std::string item;
+    /** Whether \c item is a plain index in a container. */
+    bool isIndex;
+    /** The index in a container, if \c isIndex. */
+    std::size_t index;
+    /** Whether \c item is a call to GetObject. */
+    bool isGetObject;
+    /** Whether \c tid was found when the path was added. */
+    bool hasTid;
+    /** The TypeId to get, if \c isGetObject. */
+    TypeId tid;
+    /** The next elements, by path element. */
+    std::map<std::string, std::size_t> children;
+    /** The paths which end at this element. */
+    std::vector<std::size_t> ends;
+  };
+
+  /** Constructor. */
+  PathTree ();
   /**
-   * Construct from a base Config path.
+   * Add a Config path.
    *
    * \param [in] path The Config path.
+   * \returns The identifier of the path.
    */
-  Resolver (std::string path);
-  /** Destructor. */
-  virtual ~Resolver ();
-
+  std::size_t Add (std::string path);
   /**
-   * Parse the stored Config path into an object reference,
-   * beginning at the indicated root object.
+   * Get the number of paths.
    *
-   * \param [in] root The object corresponding to the current position in
-   *                  in the Config path.
+   * \returns The number of paths.
    */
-  void Resolve (Ptr<Object> root);
-
-private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
+  std::size_t GetN (void) const;
   /**
-   * Parse the next element in the Config path.
+   * Get a path.
    *
-   * \param [in] path The remaining portion of the Config path.
-   * \param [in] root The object corresponding to the current position
-   *                  in the Config path.
+   * \param [in] id The identifier of the path.
+   * \returns The Config path, as added.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  std::string GetPath (std::size_t id) const;
   /**
-   * Parse an index on the Config path.
+   * Get a node of the tree.  Node 0 is the root of every path.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] i The index of the node.
+   * \returns The node.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
-  /**
-   * Handle one object found on the path.
-   *
-   * \param [in] object The current object on the Config path.
-   */
-  void DoResolveOne (Ptr<Object> object);
-  /**
-   * Get the current Config path.
-   *
-   * \returns The current Config path.
-   */
-  std::string GetResolvedPath (void) const;
+  const Node & GetNode (std::size_t i) const;
+
+private:
   /**
-   * Handle one found object.
+   * Find or add a child node.
    *
-   * \param [in] object The found object.
-   * \param [in] path The matching Config path context.
+   * \param [in] parent The index of the parent node.
+   * \param [in] item The path element.
+   * \returns The index of the child node.
    */
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
+  std::size_t AddChild (std::size_t parent, std::string item);
 
-  /** Current list of path tokens. */
-  std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /** The nodes, referring to each other by index. */
+  std::vector<Node> m_nodes;
+  /** The paths, as added. */
+  std::vector<std::string> m_paths;
 
-};  // class Resolver
+};  // class PathTree
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
-{
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
-}
-Resolver::~Resolver ()
+PathTree::PathTree ()
 {
   NS_LOG_FUNCTION (this);
+  m_nodes.push_back (Node ());
+  m_nodes[0].isIndex = false;
+  m_nodes[0].index = 0;
+  m_nodes[0].isGetObject = false;
+  m_nodes[0].hasTid = false;
 }
-void
-Resolver::Canonicalize (void)
+
+std::size_t
+PathTree::Add (std::string path)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << path);
+
+  std::size_t id = m_paths.size ();
+  m_paths.push_back (path);
 
   // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
+  if (path.find ("/") != 0)
     {
-      // no slash at start
-      m_path = "/" + m_path;
+      path = "/" + path;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  if (path.find_last_of ("/") != (path.size () - 1))
     {
-      // no slash at end
-      m_path = m_path + "/";
+      path = path + "/";
     }
+
+  std::size_t node = 0;
+  std::string::size_type cur = 0;
+  std::string::size_type next = path.find ("/", 1);
+  while (next != std::string::npos)
+    {
+      node = AddChild (node, path.substr (cur + 1, next - (cur + 1)));
+      cur = next;
+      next = path.find ("/", cur + 1);
+    }
+  m_nodes[node].ends.push_back (id);
+  return id;
 }
 
-void
-Resolver::Resolve (Ptr<Object> root)
+std::size_t
+PathTree::AddChild (std::size_t parent, std::string item)
 {
-  NS_LOG_FUNCTION (this << root);
+  NS_LOG_FUNCTION (this << parent << item);
+
+  std::map<std::string, std::size_t>::const_iterator found = m_nodes[parent].children.find (item);
+  if (found != m_nodes[parent].children.end ())
+    {
+      return found->second;
+    }
 
-  DoResolve (m_path, root);
+  Node node;
+  node.item = item;
+  // a plain decimal number, which ArrayMatcher only matches to itself.
+  node.isIndex = !item.empty () && item.size () < 10
+    && (item[0] != '0' || item.size () == 1)
+    && item.find_first_not_of ("0123456789") == std::string::npos;
+  node.index = node.isIndex ? std::strtoul (item.c_str (), 0, 10) : 0;
+  node.isGetObject = item.find ("$") == 0;
+  node.hasTid = node.isGetObject
+    && TypeId::LookupByNameFailSafe (item.substr (1, item.size () - 1), &node.tid);
+
+  std::size_t child = m_nodes.size ();
+  m_nodes.push_back (node);
+  m_nodes[parent].children[item] = child;
+  return child;
+}
+
+std::size_t
+PathTree::GetN (void) const
+{
+  return m_paths.size ();
 }
 
 std::string
-Resolver::GetResolvedPath (void) const
+PathTree::GetPath (std::size_t id) const
 {
-  NS_LOG_FUNCTION (this);
+  return m_paths[id];
+}
 
-  std::string fullPath = "/";
-  for (std::vector<std::string>::const_iterator i = m_workStack.begin (); i != m_workStack.end (); i++)
-    {
-      fullPath += *i + "/";
-    }
-  return fullPath;
+const PathTree::Node &
+PathTree::GetNode (std::size_t i) const
+{
+  return m_nodes[i];
+}
+
+/**
+ * \ingroup config-impl
+ * Parse the Config paths of a PathTree into object references.
+ */
+class PathTreeResolver
+{
+public:
+  /**
+   * Construct from a set of Config paths.
+   *
+   * \param [in] tree The Config paths.
+   */
+  PathTreeResolver (const PathTree &tree);
+
+  /**
+   * Parse the Config paths into object references,
+   * beginning at the indicated root object.
+   *
+   * \param [in] root The object corresponding to the root of the
+   *                  Config paths.
+   */
+  void Resolve (Ptr<Object> root);
+
+  /** The objects found, for each path. */
+  std::vector<std::vector<Ptr<Object> > > m_objects;
+  /** The matching Config path contexts, for each path. */
+  std::vector<std::vector<std::string> > m_contexts;
+
+private:
+  /**
+   * Record the object found for the paths ending at a node,
+   * then parse the next elements.
+   *
+   * \param [in] node The current node.
+   * \param [in] root The object corresponding to \pname{node}.
+   * \param [in] context The matching Config path context.
+   */
+  void DoResolve (std::size_t node, Ptr<Object> root, std::string context);
+  /**
+   * Parse one element of the Config paths.
+   *
+   * \param [in] node The node of the element.
+   * \param [in] root The object corresponding to the parent node.
+   * \param [in] context The matching Config path context of \pname{root}.
+   */
+  void DoResolveChild (std::size_t node, Ptr<Object> root, std::string context);
+  /**
+   * Parse an index on the Config paths.
+   *
+   * \param [in] node The node of the container attribute.
+   * \param [in] root The object holding the container.
+   * \param [in] info The container attribute.
+   * \param [in] context The matching Config path context of the container.
+   */
+  void DoArrayResolve (std::size_t node, Ptr<Object> root,
+                       const struct TypeId::AttributeInformation &info,
+                       std::string context);
+
+  /** The Config paths. */
+  const PathTree &m_tree;
+
+};  // class PathTreeResolver
+
+PathTreeResolver::PathTreeResolver (const PathTree &tree)
+  : m_objects (tree.GetN ()),
+    m_contexts (tree.GetN ()),
+    m_tree (tree)
+{
+  NS_LOG_FUNCTION (this << &tree);
 }
 
 void
-Resolver::DoResolveOne (Ptr<Object> object)
+PathTreeResolver::Resolve (Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << object);
+  NS_LOG_FUNCTION (this << root);
 
-  NS_LOG_DEBUG ("resolved=" << GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+  DoResolve (0, root, "/");
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+PathTreeResolver::DoResolve (std::size_t node, Ptr<Object> root, std::string context)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << node << root << context);
 
-  if (next == std::string::npos)
-    {
-      //
-      // If root is zero, we're beginning to see if we can use the object name
-      // service to resolve this path.  It is impossible to have a object name
-      // associated with the root of the object name service since that root
-      // is not an object.  This path must be referring to something in another
-      // namespace and it will have been found already since the name service
-      // is always consulted last.
-      //
-      if (root)
+  const PathTree::Node &n = m_tree.GetNode (node);
+  //
+  // If root is zero, we're beginning to see if we can use the object name
+  // service to resolve this path.  It is impossible to have a object name
+  // associated with the root of the object name service since that root
+  // is not an object.  This path must be referring to something in another
+  // namespace and it will have been found already since the name service
+  // is always consulted last.
+  //
+  if (root)
+    {
+      for (std::vector<std::size_t>::const_iterator i = n.ends.begin (); i != n.ends.end (); ++i)
         {
-          DoResolveOne (root);
+          NS_LOG_DEBUG ("resolved=" << context);
+          m_objects[*i].push_back (root);
+          m_contexts[*i].push_back (context);
         }
-      return;
     }
-  std::string item = path.substr (1, next - 1);
-  std::string pathLeft = path.substr (next, path.size () - next);
+  for (std::map<std::string, std::size_t>::const_iterator i = n.children.begin ();
+       i != n.children.end (); ++i)
+    {
+      DoResolveChild (i->second, root, context);
+    }
+}
+
+void
+PathTreeResolver::DoResolveChild (std::size_t node, Ptr<Object> root, std::string context)
+{
+  NS_LOG_FUNCTION (this << node << root << context);
+
+  const PathTree::Node &n = m_tree.GetNode (node);
+  const std::string &item = n.item;
 
   //
   // If root is zero, we're beginning to see if we can use the object name
@@ -457,16 +585,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // the root of the "/Names" namespace, so we just ignore it and move on to
   // the next segment.
   //
-  if (root == 0)
+  if (root == 0 && item.compare (0, 5, "Names") == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
-        {
-          m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
-          m_workStack.pop_back ();
-          return;
-        }
+      DoResolve (node, root, context + item + "/");
+      return;
     }
 
   //
@@ -479,9 +601,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   if (namedObject)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
-      m_workStack.pop_back ();
+      DoResolve (node, namedObject, context + item + "/");
       return;
     }
 
@@ -496,22 +616,19 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (n.isGetObject)
     {
       // This is a call to GetObject
       std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject=" << tidString << " on path=" << GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
+      NS_LOG_DEBUG ("GetObject=" << tidString << " on path=" << context);
+      TypeId tid = n.hasTid ? n.tid : TypeId::LookupByName (tidString);
       Ptr<Object> object = root->GetObject<Object> (tid);
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject (" << tidString << ") failed on path=" << GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject (" << tidString << ") failed on path=" << context);
           return;
         }
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
-      m_workStack.pop_back ();
+      DoResolve (node, object, context + item + "/");
     }
   else
     {
@@ -536,34 +653,28 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
               const PointerChecker *pChecker = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
               if (pChecker != 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)=" << info.name << " on path=" << GetResolvedPath ());
+                  NS_LOG_DEBUG ("GetAttribute(ptr)=" << info.name << " on path=" << context);
                   PointerValue pValue;
                   root->GetAttribute (info.name, pValue);
                   Ptr<Object> object = pValue.Get<Object> ();
                   if (object == 0)
                     {
                       NS_LOG_ERROR ("Requested object name=\"" << item <<
-                                    "\" exists on path=\"" << GetResolvedPath () << "\""
+                                    "\" exists on path=\"" << context << "\""
                                     " but is null.");
                       continue;
                     }
                   foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
+                  DoResolve (node, object, context + info.name + "/");
                 }
               // attempt to cast to an object vector.
               const ObjectPtrContainerChecker *vectorChecker =
                 dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
               if (vectorChecker != 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)=" << info.name << " on path=" << GetResolvedPath () << pathLeft);
+                  NS_LOG_DEBUG ("GetAttribute(vector)=" << info.name << " on path=" << context);
                   foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
+                  DoArrayResolve (node, root, info, context + info.name + "/");
                 }
               // this could be anything else and we don't know what to do with it.
               // So, we just ignore it.
@@ -575,37 +686,62 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 
       if (!foundMatch)
         {
-          NS_LOG_DEBUG ("Requested item=" << item << " does not exist on path=" << GetResolvedPath ());
+          NS_LOG_DEBUG ("Requested item=" << item << " does not exist on path=" << context);
           return;
         }
     }
 }
 
 void
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+PathTreeResolver::DoArrayResolve (std::size_t node, Ptr<Object> root,
+                                  const struct TypeId::AttributeInformation &info,
+                                  std::string context)
 {
-  NS_LOG_FUNCTION (this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
-    {
-      return;
-    }
-  std::string item = path.substr (1, next - 1);
-  std::string pathLeft = path.substr (next, path.size () - next);
-
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  NS_LOG_FUNCTION (this << node << root << info.name << context);
+
+  const PathTree::Node &n = m_tree.GetNode (node);
+  const ObjectPtrContainerAccessor *accessor =
+    dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+  std::size_t size = 0;
+  bool direct = accessor != 0 && (info.flags & TypeId::ATTR_GET)
+    && accessor->GetN (PeekPointer (root), &size);
+
+  // The whole container is only fetched for the elements which cannot
+  // be looked up directly by index.
+  ObjectPtrContainerValue container;
+  bool haveContainer = false;
+
+  for (std::map<std::string, std::size_t>::const_iterator i = n.children.begin ();
+       i != n.children.end (); ++i)
     {
-      if (matcher.Matches ((*it).first))
+      const PathTree::Node &child = m_tree.GetNode (i->second);
+      if (direct && child.isIndex && child.index < size)
+        {
+          // Containers are usually indexed by position, as the
+          // NodeList, so try to use the element at that position.
+          std::size_t index;
+          Ptr<Object> object = accessor->Get (PeekPointer (root), child.index, &index);
+          if (index == child.index)
+            {
+              DoResolve (i->second, object, context + child.item + "/");
+              continue;
+            }
+        }
+      if (!haveContainer)
         {
-          std::ostringstream oss;
-          oss << (*it).first;
-          m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
-          m_workStack.pop_back ();
+          root->GetAttribute (info.name, container);
+          haveContainer = true;
+        }
+      ArrayMatcher matcher = ArrayMatcher (child.item);
+      ObjectPtrContainerValue::Iterator it;
+      for (it = container.Begin (); it != container.End (); ++it)
+        {
+          if (matcher.Matches ((*it).first))
+            {
+              std::ostringstream oss;
+              oss << (*it).first;
+              DoResolve (i->second, (*it).second, context + oss.str () + "/");
+            }
         }
     }
 }
@@ -633,6 +769,14 @@ public:
   void Disconnect (std::string path, const CallbackBase &cb);
   /** \copydoc Config::LookupMatches() */
   MatchContainer LookupMatches (std::string path);
+  /**
+   * Find the objects which match a set of Config paths,
+   * walking the object trees only once.
+   *
+   * \param [in] tree The Config paths.
+   * \returns The matches of each path, in the order of the paths.
+   */
+  std::vector<MatchContainer> LookupMatches (const PathTree &tree);
 
   /** \copydoc Config::RegisterRootNamespaceObject() */
   void RegisterRootNamespaceObject (Ptr<Object> obj);
@@ -644,7 +788,6 @@ public:
   /** \copydoc Config::GetRootNamespaceObject() */
   Ptr<Object> GetRootNamespaceObject (std::size_t i) const;
 
-private:
   /**
    * Break a Config path into the leading path and the last leaf token.
    * \param [in] path The Config path.
@@ -654,6 +797,7 @@ private:
    */
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
 
+private:
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
 
@@ -751,21 +895,16 @@ MatchContainer
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
-  class LookupMatchesResolver : public Resolver
-  {
-public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
-    {
-    }
-    virtual void DoOne (Ptr<Object> object, std::string path)
-    {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
-    }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+  PathTree tree;
+  tree.Add (path);
+  return LookupMatches (tree)[0];
+}
+
+std::vector<MatchContainer>
+ConfigImpl::LookupMatches (const PathTree &tree)
+{
+  NS_LOG_FUNCTION (this << &tree);
+  PathTreeResolver resolver = PathTreeResolver (tree);
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -778,7 +917,14 @@ public:
   //
   resolver.Resolve (0);
 
-  return MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+  std::vector<MatchContainer> matches;
+  matches.reserve (tree.GetN ());
+  for (std::size_t i = 0; i < tree.GetN (); ++i)
+    {
+      matches.push_back (MatchContainer (resolver.m_objects[i], resolver.m_contexts[i],
+                                         tree.GetPath (i)));
+    }
+  return matches;
 }
 
 void
@@ -817,6 +963,189 @@ ConfigImpl::GetRootNamespaceObject (std::size_t i) const
 }
 
 
+/**
+ * \ingroup config-impl
+ * The operations of a Config::Batch.
+ */
+class BatchImpl : public SimpleRefCount<BatchImpl>
+{
+public:
+  /** The kind of operation. */
+  enum Type
+  {
+    SET,                      //!< Config::Set
+    CONNECT,                  //!< Config::Connect
+    CONNECT_WITHOUT_CONTEXT   //!< Config::ConnectWithoutContext
+  };
+  /** One operation. */
+  struct Operation
+  {
+    Type type;                    //!< The kind of operation.
+    std::string path;             //!< The full Config path.
+    std::string leaf;             //!< The attribute or trace source name.
+    std::size_t id;               //!< The identifier of the object path in the tree.
+    Ptr<AttributeValue> value;    //!< The value to set.
+    CallbackBase cb;              //!< The callback to connect.
+  };
+  /**
+   * Add an operation.
+   * \param [in] type The kind of operation.
+   * \param [in] path The full Config path.
+   * \returns The new operation.
+   */
+  Operation & Add (Type type, std::string path);
+
+  /** The object paths of the operations. */
+  PathTree m_tree;
+  /** The operations, in order. */
+  std::vector<Operation> m_operations;
+};
+
+BatchImpl::Operation &
+BatchImpl::Add (Type type, std::string path)
+{
+  NS_LOG_FUNCTION (this << type << path);
+  Operation op;
+  op.type = type;
+  op.path = path;
+  std::string root;
+  ConfigImpl::Get ()->ParsePath (path, &root, &op.leaf);
+  op.id = m_tree.Add (root);
+  m_operations.push_back (op);
+  return m_operations.back ();
+}
+
+CompiledPath::CompiledPath (std::string path)
+  : m_tree (Create<PathTree> ())
+{
+  NS_LOG_FUNCTION (this << path);
+  m_tree->Add (path);
+}
+CompiledPath::CompiledPath (const CompiledPath &o)
+  : m_tree (o.m_tree)
+{
+  NS_LOG_FUNCTION (this << &o);
+}
+CompiledPath &
+CompiledPath::operator = (const CompiledPath &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  m_tree = o.m_tree;
+  return *this;
+}
+CompiledPath::~CompiledPath ()
+{
+  NS_LOG_FUNCTION (this);
+}
+std::string
+CompiledPath::GetPath (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_tree->GetPath (0);
+}
+MatchContainer
+CompiledPath::LookupMatches (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return ConfigImpl::Get ()->LookupMatches (*m_tree)[0];
+}
+
+Batch::Batch ()
+  : m_impl (Create<BatchImpl> ())
+{
+  NS_LOG_FUNCTION (this);
+}
+Batch::~Batch ()
+{
+  NS_LOG_FUNCTION (this);
+}
+void
+Batch::Set (std::string path, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << path << &value);
+  m_impl->Add (BatchImpl::SET, path).value = value.Copy ();
+}
+void
+Batch::Connect (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  m_impl->Add (BatchImpl::CONNECT, path).cb = cb;
+}
+void
+Batch::ConnectWithoutContext (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  m_impl->Add (BatchImpl::CONNECT_WITHOUT_CONTEXT, path).cb = cb;
+}
+std::size_t
+Batch::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_impl->m_operations.size ();
+}
+void
+Batch::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoApply (false);
+}
+bool
+Batch::ApplyFailSafe (void)
+{
+  NS_LOG_FUNCTION (this);
+  return DoApply (true);
+}
+bool
+Batch::DoApply (bool failSafe)
+{
+  NS_LOG_FUNCTION (this << failSafe);
+
+  // the operations may add operations to a new batch, not to this one.
+  Ptr<BatchImpl> impl = m_impl;
+  m_impl = Create<BatchImpl> ();
+
+  std::vector<MatchContainer> matches = ConfigImpl::Get ()->LookupMatches (impl->m_tree);
+  bool ok = true;
+  for (std::vector<BatchImpl::Operation>::const_iterator i = impl->m_operations.begin ();
+       i != impl->m_operations.end (); ++i)
+    {
+      MatchContainer &container = matches[i->id];
+      bool done;
+      switch (i->type)
+        {
+        case BatchImpl::SET:
+          if (!failSafe)
+            {
+              // Let ObjectBase::SetAttribute raise any errors
+              container.Set (i->leaf, *i->value);
+              done = true;
+            }
+          else
+            {
+              done = container.SetFailSafe (i->leaf, *i->value);
+            }
+          break;
+        case BatchImpl::CONNECT:
+          done = container.ConnectFailSafe (i->leaf, i->cb);
+          break;
+        case BatchImpl::CONNECT_WITHOUT_CONTEXT:
+          done = container.ConnectWithoutContextFailSafe (i->leaf, i->cb);
+          break;
+        default:
+          NS_ABORT_MSG ("Unknown operation");
+          done = false;
+          break;
+        }
+      if (!done && !failSafe)
+        {
+          NS_FATAL_ERROR ("Could not connect callback to " << i->path);
+        }
+      ok &= done;
+    }
+  return ok;
+}
+
+
 void Reset (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -314,6 +314,137 @@ private:
  */
 MatchContainer LookupMatches (std::string path);
 
+class PathTree;
+class BatchImpl;
+
+/**
+ * \ingroup config
+ * \brief A Config path, parsed once to be looked up many times.
+ *
+ * LookupMatches gives the same objects as Config::LookupMatches
+ * on the same path, without parsing the path again.
+ */
+class CompiledPath
+{
+public:
+  /**
+   * \param [in] path The path to match objects against.
+   */
+  CompiledPath (std::string path);
+  /**
+   * Copy constructor.
+   * \param [in] o The CompiledPath to copy.
+   */
+  CompiledPath (const CompiledPath &o);
+  /**
+   * Assignment operator.
+   * \param [in] o The CompiledPath to copy.
+   * \returns This CompiledPath.
+   */
+  CompiledPath & operator = (const CompiledPath &o);
+  /** Destructor. */
+  ~CompiledPath ();
+
+  /**
+   * \returns The path used to perform the object matching.
+   */
+  std::string GetPath (void) const;
+  /**
+   * \returns A container which contains all the objects which
+   *          currently match the path.
+   */
+  MatchContainer LookupMatches (void) const;
+
+private:
+  /** The parsed path. */
+  Ptr<PathTree> m_tree;
+};
+
+/**
+ * \ingroup config
+ * \brief A set of Config::Set and Config::Connect operations,
+ * applied together.
+ *
+ * The paths of all the operations are resolved in a single walk of the
+ * object trees, which shares the work of their common prefixes and looks
+ * up plain indices, such as "/NodeList/12", directly.  This is much faster
+ * than calling Config::Set or Config::Connect for each path when setting
+ * up a large topology.
+ *
+ * The objects are matched when Apply is called, not when the operations
+ * are added, and the operations are then applied in the order they were
+ * added.
+ */
+class Batch
+{
+public:
+  Batch ();
+  /** Destructor. */
+  ~Batch ();
+
+  /**
+   * Add a Config::Set operation.
+   * \param [in] path A path to match attributes.
+   * \param [in] value The value to set in all matching attributes.
+   */
+  void Set (std::string path, const AttributeValue &value);
+  /**
+   * Add a Config::Connect operation.
+   * \param [in] path A path to match trace sources.
+   * \param [in] cb The callback to connect to the matching trace sources.
+   */
+  void Connect (std::string path, const CallbackBase &cb);
+  /**
+   * Add a Config::ConnectWithoutContext operation.
+   * \param [in] path A path to match trace sources.
+   * \param [in] cb The callback to connect to the matching trace sources.
+   */
+  void ConnectWithoutContext (std::string path, const CallbackBase &cb);
+  /**
+   * \returns The number of operations not applied yet.
+   */
+  std::size_t GetN (void) const;
+
+  /**
+   * Apply all the operations, then remove them from this batch.
+   *
+   * As with Config::Set and Config::Connect, this method will raise a fatal
+   * error if an attribute cannot be set, or if no trace source matches the
+   * path of a connect operation.
+   */
+  void Apply (void);
+  /**
+   * Apply all the operations, then remove them from this batch.
+   *
+   * \returns \c true if every operation matched at least one attribute
+   *          or trace source.
+   */
+  bool ApplyFailSafe (void);
+
+private:
+  /**
+   * Apply all the operations, then remove them from this batch.
+   * \param [in] failSafe Whether failures are fatal.
+   * \returns \c true if every operation succeeded.
+   */
+  bool DoApply (bool failSafe);
+
+  /**
+   * Copy constructor, not implemented.
+   * \param [in] o The Batch to copy.
+   */
+  Batch (const Batch &o);
+  /**
+   * Assignment operator, not implemented.
+   * \param [in] o The Batch to copy.
+   * \returns This Batch.
+   */
+  Batch & operator = (const Batch &o);
+
+  /** The operations. */
+  Ptr<BatchImpl> m_impl;
+};
+
 /**
  * \ingroup config
  * \param [in] obj A new root object
@@ -25,6 +25,7 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "enum.h"
 #include "assert.h"
 #include "log.h"
 
@@ -53,6 +54,13 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("Inbox",
+                   "How events scheduled with ScheduleWithContext from "
+                   "threads other than the main thread are handed over.",
+                   EnumValue (LOCK_FREE),
+                   MakeEnumAccessor (&DefaultSimulatorImpl::m_inboxType),
+                   MakeEnumChecker (LOCKED, "Locked",
+                                    LOCK_FREE, "LockFree"))
   ;
   return tid;
 }
@@ -73,6 +81,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_unscheduledEvents = 0;
   m_eventCount = 0;
   m_eventsWithContextEmpty = true;
+  m_inboxType = LOCK_FREE;
+  m_inbox = 0;
   m_main = SystemThread::Self ();
 }
 
@@ -163,6 +173,36 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
+  // Both inboxes are drained so that changing the Inbox attribute
+  // cannot strand events.
+  if (m_inbox.load (std::memory_order_relaxed) != 0)
+    {
+      // take the whole stack at once; it is in LIFO order
+      EventWithContext *head = m_inbox.exchange (0, std::memory_order_acquire);
+      EventWithContext *fifo = 0;
+      while (head != 0)
+        {
+          EventWithContext *next = head->next;
+          head->next = fifo;
+          fifo = head;
+          head = next;
+        }
+      while (fifo != 0)
+        {
+          Scheduler::Event ev;
+          ev.impl = fifo->event;
+          ev.key.m_ts = m_currentTs + fifo->timestamp;
+          ev.key.m_context = fifo->context;
+          ev.key.m_uid = m_uid;
+          m_uid++;
+          m_unscheduledEvents++;
+          m_events->Insert (ev);
+          EventWithContext *next = fifo->next;
+          delete fifo;
+          fifo = next;
+        }
+    }
+
   if (m_eventsWithContextEmpty)
     {
       return;
@@ -263,6 +303,20 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       m_unscheduledEvents++;
       m_events->Insert (ev);
     }
+  else if (m_inboxType == LOCK_FREE)
+    {
+      EventWithContext *ev = new EventWithContext;
+      ev->context = context;
+      // Current time added in ProcessEventsWithContext()
+      ev->timestamp = delay.GetTimeStep ();
+      ev->event = event;
+      ev->next = m_inbox.load (std::memory_order_relaxed);
+      while (!m_inbox.compare_exchange_weak (ev->next, ev,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+        }
+    }
   else
     {
       EventWithContext ev;
@@ -270,6 +324,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
+      ev.next = 0;
       {
         CriticalSection cs (m_eventsWithContextMutex);
         m_eventsWithContext.push_back (ev);
@@ -30,6 +30,7 @@
 #include "ptr.h"
 
 #include <list>
+#include <atomic>
 
 /**
  * \file
@@ -53,6 +54,13 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** How events scheduled from other threads reach the main thread. */
+  enum InboxType
+  {
+    LOCKED,     /**< List protected by a mutex. */
+    LOCK_FREE   /**< Lock-free multiple-producer single-consumer stack. */
+  };
+
   /** Constructor. */
   DefaultSimulatorImpl ();
   /** Destructor. */
@@ -96,6 +104,8 @@ private:
     uint64_t timestamp;
     /** The event implementation. */
     EventImpl *event;
+    /** Next (older) entry in the lock-free inbox. */
+    struct EventWithContext *next;
   };
   /** Container type for the events from a different context. */
   typedef std::list<struct EventWithContext> EventsWithContext;
@@ -108,6 +118,13 @@ private:
   bool m_eventsWithContextEmpty;
   /** Mutex to control access to the list of events with context. */
   SystemMutex m_eventsWithContextMutex;
+  /** Inbox used by ScheduleWithContext from other threads. */
+  InboxType m_inboxType;
+  /**
+   * Head of the lock-free inbox.  Producers push with a CAS, the main
+   * thread takes the whole stack with a single exchange.
+   */
+  std::atomic<struct EventWithContext *> m_inbox;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -21,6 +21,8 @@
 #include "event-impl.h"
 #include "log.h"
 
+#include <new>
+
 /**
  * \file
  * \ingroup events
@@ -31,6 +33,116 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Size class granularity, in bytes. */
+const std::size_t EVENT_GRANULE = 16;
+/** Number of size classes; larger events use the global allocator. */
+const std::size_t EVENT_CLASSES = 16;
+/** Maximum number of free events kept per size class and thread. */
+const uint32_t EVENT_MAX_FREE = 4096;
+
+/** A free event. */
+struct FreeEvent
+{
+  FreeEvent *next;  /**< Next free event of the same size class. */
+};
+
+/**
+ * Per-thread free lists.  This is trivially destructible so that it
+ * stays usable while other thread_local and static objects are
+ * destroyed; the memory is released by EventFreeListsGuard.
+ */
+struct EventFreeLists
+{
+  FreeEvent *head[EVENT_CLASSES];  /**< Free events of each size class. */
+  uint32_t count[EVENT_CLASSES];   /**< Length of each free list. */
+  bool guarded;                    /**< The guard has been constructed. */
+  bool released;                   /**< The guard has been destroyed. */
+};
+
+/** The free lists of the current thread. */
+thread_local EventFreeLists g_eventFreeLists;
+
+/** Release the free lists when the thread exits. */
+struct EventFreeListsGuard
+{
+  ~EventFreeListsGuard ()
+  {
+    EventFreeLists &lists = g_eventFreeLists;
+    for (std::size_t c = 0; c < EVENT_CLASSES; ++c)
+      {
+        while (lists.head[c] != 0)
+          {
+            FreeEvent *event = lists.head[c];
+            lists.head[c] = event->next;
+            ::operator delete (event);
+          }
+        lists.count[c] = 0;
+      }
+    // events freed from now on go back to the global allocator
+    lists.released = true;
+  }
+};
+
+/** Constructed on the first event allocation of each thread. */
+thread_local EventFreeListsGuard g_eventFreeListsGuard;
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  std::size_t c = (size - 1) / EVENT_GRANULE;
+  if (c >= EVENT_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  // Always allocate the whole size class: the event may be freed on a
+  // thread whose free lists are still live and be reused for any
+  // event of this class.
+  EventFreeLists &lists = g_eventFreeLists;
+  if (lists.released)
+    {
+      return ::operator new ((c + 1) * EVENT_GRANULE);
+    }
+  FreeEvent *event = lists.head[c];
+  if (event != 0)
+    {
+      lists.head[c] = event->next;
+      lists.count[c]--;
+      return event;
+    }
+  if (!lists.guarded)
+    {
+      // odr-use the guard to register its destructor for this thread
+      (void) &g_eventFreeListsGuard;
+      lists.guarded = true;
+    }
+  return ::operator new ((c + 1) * EVENT_GRANULE);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  std::size_t c = (size - 1) / EVENT_GRANULE;
+  EventFreeLists &lists = g_eventFreeLists;
+  // An event may be freed on another thread than the one which
+  // allocated it, e.g. with ScheduleWithContext; it then joins the
+  // free list of the freeing thread, which is fine since all the
+  // events of a size class are interchangeable.
+  if (c >= EVENT_CLASSES || lists.released || !lists.guarded
+      || lists.count[c] >= EVENT_MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeEvent *event = static_cast<FreeEvent *> (p);
+  event->next = lists.head[c];
+  lists.head[c] = event;
+  lists.count[c]++;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
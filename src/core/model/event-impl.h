@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,10 +41,31 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from per-thread free lists, one per size class,
+ * so that scheduling an event recycles the memory of an event which
+ * already ran instead of going through the general-purpose allocator.
+ * The bound arguments of the MakeEvent() events are stored in the
+ * event object itself, so they share the same allocation.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
 public:
+  /**
+   * Allocate an event from the free list of its size class.
+   *
+   * \param [in] size The size of the concrete event class.
+   * \returns The memory for the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return an event to the free list of its size class.
+   *
+   * \param [in] p The memory of the event.
+   * \param [in] size The size of the concrete event class.
+   */
+  static void operator delete (void *p, std::size_t size);
+
   /** Default constructor. */
   EventImpl ();
   /** Destructor. */
@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "uinteger.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+    .AddAttribute ("Threshold",
+                   "Buckets holding more events than this are spread "
+                   "over a new rung instead of being sorted.",
+                   UintegerValue (50),
+                   MakeUintegerAccessor (&LadderScheduler::m_threshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxRungs",
+                   "Maximum number of rungs in the ladder.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&LadderScheduler::m_maxRungs),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxBuckets",
+                   "Maximum number of buckets in a rung.",
+                   UintegerValue (1 << 16),
+                   MakeUintegerAccessor (&LadderScheduler::m_maxBuckets),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (0),
+    m_topMax (0),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_qSize (0),
+    m_threshold (50),
+    m_maxRungs (8),
+    m_maxBuckets (1 << 16)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  // Each rung covers the bucket of the rung above it that was being
+  // dequeued, so the first rung whose current bucket starts at or
+  // before ts is the one holding it.
+  for (uint32_t r = 0; r < m_nRungs; ++r)
+    {
+      const Rung &rung = m_rungs[r];
+      if (ts >= rung.start + rung.current * rung.width)
+        {
+          return r;
+        }
+    }
+  return m_nRungs;
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  if (m_bottom.size () - m_bottomHead > m_threshold && m_nRungs < m_maxRungs
+      && m_bottom.back ().key.m_ts > m_bottom[m_bottomHead].key.m_ts)
+    {
+      // Bottom grew too long to keep sorted by insertion: spread it
+      // over a new rung below the others and let Refill sort it again
+      // bucket by bucket.  The new rung must cover all of Bottom's
+      // range, up to the end of the bucket it was dequeued from, or
+      // FindRung would send later inserts past its last bucket.
+      uint64_t first = m_bottom[m_bottomHead].key.m_ts;
+      uint64_t end = m_topStart;
+      if (m_nRungs > 0)
+        {
+          const Rung &parent = m_rungs[m_nRungs - 1];
+          end = parent.start + parent.current * parent.width;
+        }
+      NS_ASSERT (m_bottom.back ().key.m_ts < end);
+      Bucket events (m_bottom.begin () + m_bottomHead, m_bottom.end ());
+      m_bottom.clear ();
+      m_bottomHead = 0;
+      SpawnRung (events, first, end - first);
+      uint32_t r = FindRung (ev.key.m_ts);
+      if (r < m_nRungs)
+        {
+          Rung &rung = m_rungs[r];
+          rung.buckets[(ev.key.m_ts - rung.start) / rung.width].push_back (ev);
+          rung.count++;
+          return;
+        }
+    }
+  Bucket::iterator i = std::upper_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+  m_bottom.insert (i, ev);
+}
+
+void
+LadderScheduler::Insert (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      m_top.push_back (ev);
+    }
+  else
+    {
+      uint32_t r = FindRung (ts);
+      if (r < m_nRungs)
+        {
+          Rung &rung = m_rungs[r];
+          rung.buckets[(ts - rung.start) / rung.width].push_back (ev);
+          rung.count++;
+        }
+      else
+        {
+          InsertBottom (ev);
+        }
+    }
+  m_qSize++;
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      // Refilling does not change which event comes next.
+      const_cast<LadderScheduler *> (this)->Refill ();
+    }
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      Refill ();
+    }
+  Scheduler::Event ev = m_bottom[m_bottomHead];
+  m_bottomHead++;
+  m_qSize--;
+  NS_LOG_DEBUG ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::Remove (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      // m_topMin and m_topMax stay valid bounds
+      RemoveFromBucket (m_top, ev);
+    }
+  else
+    {
+      uint32_t r = FindRung (ts);
+      if (r < m_nRungs)
+        {
+          Rung &rung = m_rungs[r];
+          RemoveFromBucket (rung.buckets[(ts - rung.start) / rung.width], ev);
+          rung.count--;
+        }
+      else
+        {
+          Bucket::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+          NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+          m_bottom.erase (i);
+        }
+    }
+  m_qSize--;
+}
+
+void
+LadderScheduler::SpawnRung (Bucket &events, uint64_t start, uint64_t span)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << span);
+  NS_ASSERT (!events.empty () && span > 0);
+  uint64_t n = std::min<uint64_t> (events.size (), m_maxBuckets);
+  uint64_t width = span / n + (span % n != 0);
+  if (m_nRungs == m_rungs.size ())
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  rung.start = start;
+  rung.width = width;
+  rung.nBuckets = span / width + (span % width != 0);
+  rung.current = 0;
+  rung.count = events.size ();
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.buckets[(i->key.m_ts - start) / width].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_bottom.clear ();
+  m_bottomHead = 0;
+  while (m_qSize > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          // the ladder is empty: spread Top over a new first rung,
+          // Top then starts where that rung ends.
+          NS_ASSERT (!m_top.empty ());
+          SpawnRung (m_top, m_topMin, m_topMax - m_topMin + 1);
+          m_topStart = m_rungs[0].start + m_rungs[0].nBuckets * m_rungs[0].width;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      uint64_t bucketStart = rung.start + rung.current * rung.width;
+      Bucket &bucket = rung.buckets[rung.current];
+      rung.current++;
+      rung.count -= bucket.size ();
+      if (bucket.size () > m_threshold && rung.width > 1 && m_nRungs < m_maxRungs)
+        {
+          // SpawnRung may reallocate m_rungs, move the events out first
+          Bucket events;
+          events.swap (bucket);
+          SpawnRung (events, bucketStart, rung.width);
+          continue;
+        }
+      m_bottom.swap (bucket);
+      std::sort (m_bottom.begin (), m_bottom.end ());
+      return;
+    }
+}
+
+} // namespace ns3
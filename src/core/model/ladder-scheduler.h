@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue published in 2005 in
+ * ["Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng][Tang].
+ *
+ * [Tang]: https://doi.org/10.1145/1103323.1103324 "Tang"
+ *
+ * Events live in one of three tiers:
+ *
+ * - Top: an unsorted vector holding every event at or after
+ *   `m_topStart`, the far future.
+ * - Ladder: a stack of rungs.  Each rung is an array of unsorted
+ *   buckets covering a uniform time span; each rung below the first
+ *   covers a single bucket of the rung above it.
+ * - Bottom: a short sorted vector of the events about to be executed.
+ *
+ * When Bottom is needed and empty, the first non-empty bucket of the lowest
+ * rung is sorted into Bottom, or, if it holds more than `Threshold`
+ * events, spread over a new, finer rung.  When the ladder runs empty
+ * the whole Top is spread over a new first rung whose bucket width is
+ * derived from the span of the Top events.  Bucket widths therefore
+ * adapt to the event distribution as it is consumed, and no operation
+ * ever rehashes the whole event set, unlike the resizing
+ * CalendarScheduler.  Bottom itself is spread over a new rung when
+ * it grows beyond `Threshold` events.
+ *
+ * \par Time Complexity
+ *
+ * Operation    | Amortized %Time | Reason
+ * :----------- | :-------------- | :-----
+ * Insert()     | ~Constant       | Append to Top or to a bucket
+ * IsEmpty()    | Constant        | Explicit queue size
+ * PeekNext()   | ~Constant       | Refill Bottom if empty
+ * Remove()     | Linear          | Search within the tier
+ * RemoveNext() | ~Constant       | Sorting of small buckets
+ *
+ * \par Memory Complexity
+ *
+ * Category  | Memory                           | Reason
+ * :-------- | :------------------------------- | :-----
+ * Overhead  | One `std::vector` per bucket     | Rung storage is kept for reuse
+ * Per Event | 0                                | Events stored in `std::vector` directly
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: an unsorted vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** One rung of the ladder. */
+  struct Rung
+  {
+    /** Timestamp at the start of bucket 0. */
+    uint64_t start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t width;
+    /** Number of buckets in use. */
+    uint32_t nBuckets;
+    /** First bucket not yet moved down the ladder. */
+    uint32_t current;
+    /** Number of events in the rung. */
+    uint32_t count;
+    /** The buckets; may be larger than \c nBuckets when reused. */
+    std::vector<Bucket> buckets;
+  };
+
+  /**
+   * Create a new rung below the existing ones and spread events over it.
+   *
+   * \param [in,out] events The events to spread; emptied on return.
+   * \param [in] start The timestamp at the start of the new rung.
+   * \param [in] span The time span covered by the new rung.
+   */
+  void SpawnRung (Bucket &events, uint64_t start, uint64_t span);
+  /**
+   * Refill Bottom from the ladder, converting Top into a new rung
+   * when the ladder is empty.
+   */
+  void Refill (void);
+  /**
+   * Insert an event into Bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Find the rung an event with this timestamp belongs to.
+   *
+   * \param [in] ts The dimensionless timestamp.
+   * \returns The rung index, or \c m_nRungs if the event belongs to Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Remove an event from an unsorted bucket.
+   *
+   * \param [in,out] bucket The bucket.
+   * \param [in] ev The event.
+   */
+  static void RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+
+  /** Far future events, unsorted. */
+  Bucket m_top;
+  /** Events at or after this timestamp go to Top. */
+  uint64_t m_topStart;
+  /** Smallest timestamp in Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in Top. */
+  uint64_t m_topMax;
+  /** Rung storage; only the first \c m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Next events, sorted; the first \c m_bottomHead have been removed. */
+  Bucket m_bottom;
+  /** Index of the next event in Bottom. */
+  uint32_t m_bottomHead;
+  /** Number of events in queue. */
+  uint32_t m_qSize;
+  /** Buckets larger than this are spread over a new rung. */
+  uint32_t m_threshold;
+  /** Maximum number of rungs. */
+  uint32_t m_maxRungs;
+  /** Maximum number of buckets in a rung. */
+  uint32_t m_maxBuckets;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -0,0 +1,872 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "simulator.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "config.h"
+#include "uinteger.h"
+
+#include "ptr.h"
+#include "pointer.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** The partition whose events the calling thread is running. */
+thread_local void *g_currentPartition = 0;
+
+/** Timestamp of a partition without events. */
+const uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max ();
+
+/** Marks contexts without an explicit partition. */
+const uint32_t NO_PARTITION = 0xffffffff;
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("Threads",
+                   "Number of threads running partitions, including the "
+                   "thread calling Simulator::Run; 0 for the hardware "
+                   "thread count.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_nThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Partitions",
+                   "Number of partitions events are split into by context; "
+                   "0 for one per thread.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_nPartitions),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Lookahead",
+                   "Minimum delay of events scheduled on another partition; "
+                   "0 to use the smallest Delay of the channels in /ChannelList, "
+                   "or none if a channel has no Delay attribute.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookaheadAttribute),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_schedulerFactory ("ns3::MapScheduler"),
+    m_nPartitions (0),
+    m_nThreads (0),
+    m_lookahead (0),
+    m_stop (false),
+    m_currentTs (0),
+    m_windowEnd (0),
+    m_round (0),
+    m_busy (0),
+    m_exit (false),
+    m_nextPartition (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::Initialize (void)
+{
+  if (!m_partitions.empty ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  if (m_nThreads == 0)
+    {
+      m_nThreads = std::max (1u, std::thread::hardware_concurrency ());
+    }
+  if (m_nPartitions == 0)
+    {
+      m_nPartitions = m_nThreads;
+    }
+  // one more for the events without context
+  for (uint32_t i = 0; i <= m_nPartitions; ++i)
+    {
+      Partition *p = new Partition;
+      p->id = i;
+      p->events = m_schedulerFactory.Create<Scheduler> ();
+      p->currentTs = 0;
+      p->currentContext = Simulator::NO_CONTEXT;
+      // uids are allocated from 4, see DefaultSimulatorImpl, and
+      // interleaved so that no two partitions hand out the same one
+      p->currentUid = 0;
+      p->uid = 4 + i;
+      p->eventCount = 0;
+      p->unscheduledEvents = 0;
+      p->sent = 0;
+      p->inbox = 0;
+      m_partitions.push_back (p);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  StopWorkers ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *p = *i;
+      Drain (p);
+      while (!p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      p->events = 0;
+      delete p;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (true)
+    {
+      Ptr<EventImpl> ev;
+      {
+        std::unique_lock<std::mutex> lock (m_destroyMutex);
+        if (m_destroyEvents.empty ())
+          {
+            break;
+          }
+        ev = m_destroyEvents.front ().PeekEventImpl ();
+        m_destroyEvents.pop_front ();
+      }
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+  Initialize ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!(*i)->events->IsEmpty ())
+        {
+          scheduler->Insert ((*i)->events->RemoveNext ());
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetPartition (uint32_t context, uint32_t partition)
+{
+  NS_LOG_FUNCTION (this << context << partition);
+  Initialize ();
+  NS_ASSERT_MSG (partition < m_nPartitions, "No partition " << partition);
+  NS_ASSERT_MSG (context != Simulator::NO_CONTEXT, "NO_CONTEXT has its own partition");
+  if (context >= m_contextPartition.size ())
+    {
+      m_contextPartition.resize (context + 1, NO_PARTITION);
+    }
+  m_contextPartition[context] = partition;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context)
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_partitions[m_nPartitions];
+    }
+  if (context < m_contextPartition.size () && m_contextPartition[context] != NO_PARTITION)
+    {
+      return m_partitions[m_contextPartition[context]];
+    }
+  return m_partitions[context % m_nPartitions];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  return static_cast<Partition *> (g_currentPartition);
+}
+
+bool
+MultithreadedSimulatorImpl::IsForeign (const Partition *owner) const
+{
+  Partition *current = GetCurrent ();
+  // without lookahead, and for public events, partitions run alone
+  return current != 0 && current != owner && m_lookahead != 0
+         && current != m_partitions[m_nPartitions];
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookahead (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_lookaheadAttribute.IsZero ())
+    {
+      m_lookahead = m_lookaheadAttribute.GetTimeStep ();
+      return;
+    }
+  // The smallest delay of any channel, whether or not it crosses
+  // partitions, is a safe lower bound.  A channel without a Delay
+  // attribute, e.g. a wireless channel whose propagation delay depends
+  // on the distance, gives no bound: run without lookahead then.
+  m_lookahead = 0;
+  Config::MatchContainer channels = Config::LookupMatches ("/ChannelList/*");
+  bool found = false;
+  for (uint32_t i = 0; i < channels.GetN (); ++i)
+    {
+      TimeValue delay;
+      if (!channels.Get (i)->GetAttributeFailSafe ("Delay", delay))
+        {
+          NS_LOG_INFO ("channel " << i << " has no Delay, no lookahead");
+          m_lookahead = 0;
+          return;
+        }
+      uint64_t ts = delay.Get ().GetTimeStep ();
+      m_lookahead = found ? std::min (m_lookahead, ts) : ts;
+      found = true;
+    }
+  NS_LOG_INFO ("lookahead " << TimeStep (m_lookahead) << " from " << channels.GetN () << " channels");
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = p->uid;
+  p->uid += m_nPartitions + 1;
+  p->unscheduledEvents++;
+  p->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::Post (Partition *target, Message *message)
+{
+  message->next = target->inbox.load (std::memory_order_relaxed);
+  while (!target->inbox.compare_exchange_weak (message->next, message,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed))
+    {
+    }
+}
+
+void
+MultithreadedSimulatorImpl::PostOperation (Partition *owner, const EventId &id, Message::Type type)
+{
+  if (id.GetTs () < m_currentTs)
+    {
+      // all the events before the window have run
+      return;
+    }
+  Partition *current = GetCurrent ();
+  if (id.GetTs () < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event at " << TimeStep (id.GetTs ()) << " of context " << id.GetContext ()
+                      << (type == Message::CANCEL ? " cancelled" : " removed")
+                      << " from context " << current->currentContext
+                      << " may already have run; it must be at least the lookahead "
+                      << TimeStep (m_lookahead) << " in the future");
+    }
+  Message *message = new Message;
+  message->type = type;
+  message->timestamp = id.GetTs ();
+  message->context = id.GetContext ();
+  message->uid = id.GetUid ();
+  message->source = current->id;
+  message->sequence = current->sent++;
+  message->relative = false;
+  message->event = id.PeekEventImpl ();
+  message->event->Ref ();
+  Post (owner, message);
+}
+
+void
+MultithreadedSimulatorImpl::Drain (Partition *p)
+{
+  if (p->inbox.load (std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+  Message *head = p->inbox.exchange (0, std::memory_order_acquire);
+  std::vector<Message *> messages;
+  for (; head != 0; head = head->next)
+    {
+      if (head->relative)
+        {
+          // scheduled from a foreign thread, relative to the current time
+          head->timestamp += std::max (m_currentTs, p->currentTs);
+        }
+      messages.push_back (head);
+    }
+  // restore the order in which each source sent its messages, then
+  // order the batch independently of thread timing
+  std::reverse (messages.begin (), messages.end ());
+  std::stable_sort (messages.begin (), messages.end (),
+                    [] (const Message *a, const Message *b)
+                    {
+                      if (a->timestamp != b->timestamp)
+                        {
+                          return a->timestamp < b->timestamp;
+                        }
+                      if (a->source != b->source)
+                        {
+                          return a->source < b->source;
+                        }
+                      return a->sequence < b->sequence;
+                    });
+  for (std::vector<Message *>::iterator i = messages.begin (); i != messages.end (); ++i)
+    {
+      Message *m = *i;
+      NS_ASSERT (m->timestamp >= p->currentTs);
+      if (m->type == Message::SCHEDULE)
+        {
+          Insert (p, m->timestamp, m->context, m->event);
+        }
+      else
+        {
+          // between rounds, the partition is not running
+          EventId id (Ptr<EventImpl> (m->event, false), m->timestamp, m->context, m->uid);
+          if (m->type == Message::CANCEL)
+            {
+              Cancel (id);
+            }
+          else
+            {
+              Remove (id);
+            }
+        }
+      delete m;
+    }
+}
+
+uint64_t
+MultithreadedSimulatorImpl::Next (Partition *p) const
+{
+  return p->events->IsEmpty () ? NO_EVENT : p->events->PeekNext ().key.m_ts;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessPartition (Partition *p)
+{
+  g_currentPartition = p;
+  // in a round, Stop() takes effect at the end of the window, whatever
+  // the partitions other threads have reached
+  bool stoppable = m_lookahead == 0 || p == m_partitions[m_nPartitions];
+  while (!p->events->IsEmpty () && !(stoppable && m_stop.load (std::memory_order_relaxed)))
+    {
+      if (p->events->PeekNext ().key.m_ts >= m_windowEnd)
+        {
+          break;
+        }
+      Scheduler::Event next = p->events->RemoveNext ();
+
+      NS_ASSERT (next.key.m_ts >= p->currentTs);
+      p->unscheduledEvents--;
+      p->eventCount++;
+
+      p->currentTs = next.key.m_ts;
+      p->currentContext = next.key.m_context;
+      p->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+    }
+  g_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessRound (void)
+{
+  uint32_t i;
+  while ((i = m_nextPartition.fetch_add (1)) < m_nPartitions)
+    {
+      ProcessPartition (m_partitions[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Worker (void)
+{
+  uint64_t round = 0;
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_roundMutex);
+        m_roundStart.wait (lock, [this, round] { return m_exit || m_round != round; });
+        if (m_exit)
+          {
+            return;
+          }
+        round = m_round;
+      }
+      ProcessRound ();
+      {
+        std::unique_lock<std::mutex> lock (m_roundMutex);
+        m_busy--;
+        if (m_busy == 0)
+          {
+            m_roundEnd.notify_one ();
+          }
+      }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StartWorkers (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_exit = false;
+  while (m_threads.size () + 1 < std::min (m_nThreads, m_nPartitions))
+    {
+      m_threads.push_back (std::thread (&MultithreadedSimulatorImpl::Worker, this));
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StopWorkers (void)
+{
+  NS_LOG_FUNCTION (this);
+  {
+    std::unique_lock<std::mutex> lock (m_roundMutex);
+    m_exit = true;
+  }
+  m_roundStart.notify_all ();
+  for (std::vector<std::thread>::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      i->join ();
+    }
+  m_threads.clear ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty () || (*i)->inbox.load () != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  Initialize ();
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  m_stop = false;
+  CalculateLookahead ();
+  if (m_lookahead != 0)
+    {
+      StartWorkers ();
+    }
+
+  Partition *pub = m_partitions[m_nPartitions];
+  while (!m_stop)
+    {
+      uint64_t next = NO_EVENT;
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          Drain (m_partitions[i]);
+          next = std::min (next, Next (m_partitions[i]));
+        }
+      Drain (pub);
+      uint64_t nextPublic = Next (pub);
+      if (next == NO_EVENT && nextPublic == NO_EVENT)
+        {
+          break;
+        }
+
+      if (nextPublic <= next)
+        {
+          // events without context run alone, they may touch any node
+          m_currentTs = nextPublic;
+          m_windowEnd = nextPublic + 1;
+          ProcessPartition (pub);
+          continue;
+        }
+
+      m_currentTs = next;
+      if (m_lookahead == 0)
+        {
+          // no lookahead: one timestamp at a time, one partition after
+          // the other on this thread
+          m_windowEnd = std::min (next + 1, nextPublic);
+          for (uint32_t i = 0; i < m_nPartitions; ++i)
+            {
+              ProcessPartition (m_partitions[i]);
+            }
+          continue;
+        }
+
+      m_windowEnd = std::min (next + m_lookahead, nextPublic);
+      {
+        std::unique_lock<std::mutex> lock (m_roundMutex);
+        m_nextPartition = 0;
+        m_busy = m_threads.size ();
+        m_round++;
+      }
+      m_roundStart.notify_all ();
+      ProcessRound ();
+      {
+        std::unique_lock<std::mutex> lock (m_roundMutex);
+        m_roundEnd.wait (lock, [this] { return m_busy == 0; });
+      }
+    }
+
+  StopWorkers ();
+  for (uint32_t i = 0; i <= m_nPartitions; ++i)
+    {
+      m_currentTs = std::max (m_currentTs, m_partitions[i]->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  // a public event, so that all partitions stop at the same time
+  Simulator::ScheduleWithContext (Simulator::NO_CONTEXT, delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+  Partition *current = GetCurrent ();
+  if (current == 0)
+    {
+      NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::Schedule Thread-unsafe invocation!");
+      Initialize ();
+      return Insert (GetPartition (Simulator::NO_CONTEXT), m_currentTs + delay.GetTimeStep (),
+                     Simulator::NO_CONTEXT, event);
+    }
+  return Insert (current, current->currentTs + delay.GetTimeStep (), current->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  Initialize ();
+  Partition *current = GetCurrent ();
+  Partition *target = GetPartition (context);
+  if (current == 0 && SystemThread::Equals (m_main))
+    {
+      // outside of Run
+      Insert (target, m_currentTs + delay.GetTimeStep (), context, event);
+      return;
+    }
+  if (current == target || current == m_partitions[m_nPartitions])
+    {
+      // own partition, or public event running alone
+      Insert (target, current->currentTs + delay.GetTimeStep (), context, event);
+      return;
+    }
+
+  Message *message = new Message;
+  message->type = Message::SCHEDULE;
+  message->context = context;
+  message->event = event;
+  if (current == 0)
+    {
+      // Current time added in Drain()
+      message->timestamp = delay.GetTimeStep ();
+      message->uid = 0;
+      message->source = m_nPartitions + 1;
+      message->sequence = 0;
+      message->relative = true;
+    }
+  else
+    {
+      message->timestamp = current->currentTs + delay.GetTimeStep ();
+      message->uid = 0;
+      message->source = current->id;
+      message->sequence = current->sent++;
+      message->relative = false;
+      // without lookahead partitions run one after the other, any
+      // delay is safe
+      if (m_lookahead != 0 && message->timestamp < m_windowEnd)
+        {
+          if (target != m_partitions[m_nPartitions])
+            {
+              NS_FATAL_ERROR ("Event scheduled from context " << current->currentContext
+                              << " to context " << context << " with delay " << delay
+                              << " smaller than the lookahead " << TimeStep (m_lookahead)
+                              << "; set ns3::MultithreadedSimulatorImpl::Lookahead");
+            }
+          // events without context cannot run before the end of the window
+          message->timestamp = m_windowEnd;
+        }
+    }
+  Post (target, message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (Time (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  std::unique_lock<std::mutex> lock (m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  Partition *current = GetCurrent ();
+  return TimeStep (current != 0 ? current->currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - Now ().GetTimeStep ());
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      std::unique_lock<std::mutex> lock (m_destroyMutex);
+      for (std::list<EventId>::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (id.PeekEventImpl () == 0 || m_partitions.empty ())
+    {
+      return;
+    }
+  NS_ASSERT_MSG (GetCurrent () != 0 || SystemThread::Equals (m_main),
+                 "Simulator::Remove Thread-unsafe invocation!");
+  Partition *p = GetPartition (id.GetContext ());
+  if (IsForeign (p))
+    {
+      PostOperation (p, id, Message::REMOVE);
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  p->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  p->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (id.GetUid () != 2 && id.PeekEventImpl () != 0 && !m_partitions.empty ())
+    {
+      NS_ASSERT_MSG (GetCurrent () != 0 || SystemThread::Equals (m_main),
+                     "Simulator::Cancel Thread-unsafe invocation!");
+      Partition *p = GetPartition (id.GetContext ());
+      if (IsForeign (p))
+        {
+          PostOperation (p, id, Message::CANCEL);
+          return;
+        }
+    }
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      std::unique_lock<std::mutex> lock (const_cast<std::mutex &> (m_destroyMutex));
+      for (std::list<EventId>::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0 || m_partitions.empty ())
+    {
+      return true;
+    }
+  // compare with the partition which runs the event
+  Partition *p = const_cast<MultithreadedSimulatorImpl *> (this)->GetPartition (id.GetContext ());
+  if (p != m_partitions[m_nPartitions] && IsForeign (p))
+    {
+      // the other partition is running: only the events before the
+      // window are known to have run, the later ones may be cancelled
+      // at any time
+      if (id.GetTs () < m_currentTs)
+        {
+          return true;
+        }
+      NS_FATAL_ERROR ("State of the event at " << TimeStep (id.GetTs ()) << " of context "
+                      << id.GetContext () << " asked from context " << GetCurrent ()->currentContext
+                      << " while its partition runs");
+    }
+  if (id.GetTs () < p->currentTs
+      || (id.GetTs () == p->currentTs && id.GetUid () <= p->currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *current = GetCurrent ();
+  return current != 0 ? current->currentContext : Simulator::NO_CONTEXT;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (void) const
+{
+  uint64_t count = 0;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      count += (*i)->eventCount;
+    }
+  return count;
+}
+
+} // namespace ns3
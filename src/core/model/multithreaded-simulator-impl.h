@@ -0,0 +1,309 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "object-factory.h"
+#include "nstime.h"
+#include "system-thread.h"
+
+#include "ptr.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A conservative parallel simulator for shared-memory machines.
+ *
+ * The simulation is split in logical processes, or partitions, by event
+ * context: all the events of a node run in the partition of its id,
+ * `context % Partitions` unless set with SetPartition().  Events without
+ * a context (Simulator::NO_CONTEXT) belong to a public partition.
+ *
+ * The simulation advances in rounds.  Each round takes the earliest
+ * pending event time T and lets every partition run, in parallel on a
+ * pool of threads, its events before `T + lookahead`.  An event one
+ * partition schedules for another must therefore be at least
+ * `lookahead` in the future; it goes through a lock-free queue of the
+ * target partition, which is drained between rounds and ordered by
+ * time, source partition and scheduling order so that results do not
+ * depend on thread timing.  Public events run alone, between rounds.
+ *
+ * The lookahead is the Lookahead attribute if set, else the smallest
+ * "Delay" attribute of the channels in /ChannelList, as in
+ * DistributedSimulatorImpl.  If any channel has no "Delay" attribute,
+ * as wireless channels with distance-based propagation delays, there
+ * is no lookahead unless the attribute is set.  Without a lookahead
+ * the partitions run one after another on the calling thread.  Scheduling an event on
+ * another partition closer than the lookahead is a fatal error.
+ *
+ * Event uids are unique across partitions: each partition hands out
+ * every `(Partitions + 1)`-th uid, so that they do not depend on thread
+ * timing either.
+ *
+ * While partitions run in parallel, an event only touches the events
+ * of its own partition directly:
+ *
+ * - Cancel() and Remove() of an event of another partition are sent to
+ *   that partition and applied at the end of the window, before the
+ *   next round.  The event must be at least one lookahead in the
+ *   future, else it may already have run: this is a fatal error.
+ * - IsExpired() and GetDelayLeft() of an event of another partition are
+ *   only defined for events before the current window, which have all
+ *   run; asking about a later event is a fatal error.  Events without
+ *   context do not run during rounds and may always be queried.
+ * - Stop() takes effect at the end of the window, once every partition
+ *   has run its events before it, so that all of them stop at the same
+ *   point.  Stop(delay) is exact when the delay is at least the
+ *   lookahead.
+ *
+ * Public events, and all events when there is no lookahead, run alone
+ * and have none of these restrictions.
+ *
+ * Objects shared by several partitions, e.g. singletons or channels,
+ * must be safe to use from several threads.  In particular the
+ * reference counts of SimpleRefCount, hence of Ptr, are not atomic: an
+ * object may be handed over to another partition, e.g. bound to an
+ * event scheduled there, but the sender must not keep or copy
+ * references to it.  This includes the buffers a Packet shares with its
+ * copies, so a packet sent to another node must not share its data
+ * with a packet the sender keeps.  Packet uids are unique, but their
+ * values depend on thread timing.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
+
+  /**
+   * Assign a context to a partition.  Must be called before any event
+   * is scheduled with this context.
+   *
+   * \param [in] context The context, usually a node id.
+   * \param [in] partition The partition, less than the Partitions attribute.
+   */
+  void SetPartition (uint32_t context, uint32_t partition);
+  /**
+   * \returns The lookahead used by the last call to Run().
+   */
+  Time GetLookahead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An operation sent to another partition. */
+  struct Message
+  {
+    /** The operation. */
+    enum Type
+    {
+      SCHEDULE,           /**< Insert a new event. */
+      CANCEL,             /**< Cancel an event of the target partition. */
+      REMOVE              /**< Remove an event of the target partition. */
+    };
+    Type type;            /**< The operation. */
+    uint64_t timestamp;   /**< Absolute timestamp, or delay if \c relative. */
+    uint32_t context;     /**< The event context. */
+    uint32_t uid;         /**< The event uid, for CANCEL and REMOVE. */
+    uint32_t source;      /**< Sending partition. */
+    uint64_t sequence;    /**< Sending order within the source partition. */
+    bool relative;        /**< Scheduled from a foreign thread. */
+    EventImpl *event;     /**< The event implementation, with a reference. */
+    Message *next;        /**< Next (older) message in the inbox. */
+  };
+
+  /** A logical process. */
+  struct Partition
+  {
+    uint32_t id;                       /**< Partition index. */
+    Ptr<Scheduler> events;             /**< The event queue. */
+    uint64_t currentTs;                /**< Timestamp of the current event. */
+    uint32_t currentContext;           /**< Context of the current event. */
+    uint32_t currentUid;               /**< Unique id of the current event. */
+    uint32_t uid;                      /**< Next event unique id, in steps of the partition count. */
+    uint64_t eventCount;               /**< The event count. */
+    int unscheduledEvents;             /**< Inserted but not executed. */
+    uint64_t sent;                     /**< Messages sent to other partitions. */
+    std::atomic<Message *> inbox;      /**< Messages from other partitions. */
+  };
+
+  /** Create the partitions, on first use. */
+  void Initialize (void);
+  /**
+   * \param [in] context The event context.
+   * \returns The partition running events with this context.
+   */
+  Partition * GetPartition (uint32_t context);
+  /** \returns The partition of the calling thread, or null. */
+  Partition * GetCurrent (void) const;
+  /**
+   * \param [in] owner The partition of an event.
+   * \returns true if the calling thread runs another partition in
+   * parallel with \p owner, and so must not touch its events.
+   */
+  bool IsForeign (const Partition *owner) const;
+  /**
+   * Insert an event into a partition owned by the caller.
+   *
+   * \param [in] p The partition.
+   * \param [in] ts The absolute timestamp.
+   * \param [in] context The event context.
+   * \param [in] event The event.
+   * \returns The event id.
+   */
+  EventId Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Send an event to another partition.
+   *
+   * \param [in] target The target partition.
+   * \param [in] message The message, allocated by the caller.
+   */
+  void Post (Partition *target, Message *message);
+  /**
+   * Send a Cancel() or Remove() to the partition of the event, to be
+   * applied at the end of the window.
+   *
+   * \param [in] owner The partition of the event.
+   * \param [in] id The event.
+   * \param [in] type Message::CANCEL or Message::REMOVE.
+   */
+  void PostOperation (Partition *owner, const EventId &id, Message::Type type);
+  /**
+   * Move the messages of a partition into its event queue.
+   *
+   * \param [in] p The partition.
+   */
+  void Drain (Partition *p);
+  /**
+   * \param [in] p The partition.
+   * \returns The timestamp of the next event of a partition.
+   */
+  uint64_t Next (Partition *p) const;
+  /**
+   * Run the events of a partition before the end of the window.
+   *
+   * \param [in] p The partition.
+   */
+  void ProcessPartition (Partition *p);
+  /** Run partitions of the current round until none is left. */
+  void ProcessRound (void);
+  /** Worker thread body. */
+  void Worker (void);
+  /** Start the worker threads. */
+  void StartWorkers (void);
+  /** Stop the worker threads. */
+  void StopWorkers (void);
+  /** Compute the lookahead from the channel delays. */
+  void CalculateLookahead (void);
+
+  /** Factory for the partition schedulers. */
+  ObjectFactory m_schedulerFactory;
+  /** Number of worker partitions; the public one is last. */
+  uint32_t m_nPartitions;
+  /** Number of threads, including the calling thread. */
+  uint32_t m_nThreads;
+  /** Lookahead set by attribute. */
+  Time m_lookaheadAttribute;
+  /** Lookahead in use. */
+  uint64_t m_lookahead;
+  /** The partitions, the public partition last. */
+  std::vector<Partition *> m_partitions;
+  /** Explicit context to partition assignment. */
+  std::vector<uint32_t> m_contextPartition;
+
+  /** Events to run at Simulator::Destroy() */
+  std::list<EventId> m_destroyEvents;
+  /** Protects m_destroyEvents. */
+  std::mutex m_destroyMutex;
+  /** Flag calling for the end of the simulation. */
+  std::atomic<bool> m_stop;
+  /** Timestamp of the public partition between rounds. */
+  uint64_t m_currentTs;
+  /** End of the current window; events before it may run. */
+  uint64_t m_windowEnd;
+
+  /** Worker threads. */
+  std::vector<std::thread> m_threads;
+  /** Protects the round state below. */
+  std::mutex m_roundMutex;
+  /** Signals a new round to the workers. */
+  std::condition_variable m_roundStart;
+  /** Signals the end of a round to the main thread. */
+  std::condition_variable m_roundEnd;
+  /** Round number, incremented to start a round. */
+  uint64_t m_round;
+  /** Workers still running the current round. */
+  uint32_t m_busy;
+  /** Workers should exit. */
+  bool m_exit;
+  /** Next partition to hand out in the current round. */
+  std::atomic<uint32_t> m_nextPartition;
+
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
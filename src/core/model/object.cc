@@ -29,6 +29,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 
 /**
  * \file
@@ -97,11 +98,9 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates (NewAggregates (1))
 {
   NS_LOG_FUNCTION (this);
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object ()
@@ -126,16 +125,19 @@ Object::~Object ()
     {
       std::free (m_aggregates);
     }
+  else
+    {
+      // the cache may point to this object, and the indexes moved
+      ClearCache (m_aggregates);
+    }
   m_aggregates = 0;
 }
 Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates (NewAggregates (1))
 {
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -145,15 +147,52 @@ Object::Construct (const AttributeConstructionList &attributes)
   ConstructSelf (attributes);
 }
 
+struct Object::Aggregates *
+Object::NewAggregates (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  NS_ASSERT (n > 0);
+  // cache entries hold the index of an aggregate in 16 bits
+  NS_ASSERT (n < 0xffff);
+  struct Aggregates *aggregates =
+    (struct Aggregates *)std::malloc (sizeof(struct Aggregates) + (n - 1) * sizeof(Object*));
+  for (uint32_t i = 0; i < Aggregates::CACHE_SIZE; i++)
+    {
+      new (&aggregates->cache[i]) std::atomic<uint32_t> (0);
+    }
+  aggregates->n = n;
+  return aggregates;
+}
+
+void
+Object::ClearCache (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  // TypeId uids start at 1, so 0 marks an empty entry
+  for (uint32_t i = 0; i < Aggregates::CACHE_SIZE; i++)
+    {
+      aggregates->cache[i].store (0, std::memory_order_relaxed);
+    }
+}
+
 Ptr<Object>
 Object::DoGetObject (TypeId tid) const
+{
+  NS_LOG_FUNCTION (this << tid);
+  return FindAggregate (tid);
+}
+
+Object *
+Object::FindAggregateSlow (TypeId tid) const
 {
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  Object *found = 0;
+  uint32_t index = 0;
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
-  for (uint32_t i = 0; i < n; i++)
+  for (uint32_t i = 0; i < n && found == 0; i++)
     {
       Object *current = m_aggregates->buffer[i];
       TypeId cur = current->GetInstanceTypeId ();
@@ -163,21 +202,17 @@ Object::DoGetObject (TypeId tid) const
         }
       if (cur == tid)
         {
-          // This is an attempt to 'cache' the result of this lookup.
-          // the idea is that if we perform a lookup for a TypeId on this object,
-          // we are likely to perform the same lookup later so, we make sure
-          // that the aggregate array is sorted by the number of accesses
-          // to each object.
-
-          // first, increment the access count
-          current->m_getObjectCount++;
-          // then, update the sort
-          UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          found = current;
+          index = i + 1;
         }
     }
-  return 0;
+  // Remember the result, found or not, until the aggregates change:
+  // the same lookups tend to be repeated on every packet.  A later
+  // lookup of another TypeId mapping to the same entry replaces it.
+  uint16_t uid = tid.GetUid ();
+  m_aggregates->cache[uid & (Aggregates::CACHE_SIZE - 1)]
+    .store ((uint32_t (uid) << 16) | index, std::memory_order_relaxed);
+  return found;
 }
 void
 Object::Initialize (void)
@@ -185,8 +220,7 @@ Object::Initialize (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoInitialize is called. The user's
-   * implementation of the DoInitialize method could call GetObject (which could
-   * reorder the array) and it could call AggregateObject which would add an
+   * implementation of the DoInitialize method could call AggregateObject which would add an
    * object at the end of the array. To be safe, we restart iteration over the
    * array whenever we call some user code, just in case.
    */
@@ -216,8 +250,8 @@ Object::Dispose (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoDispose is called. The user's
-   * DoDispose implementation could call GetObject (which could reorder the array)
-   * and it could call AggregateObject which would add an object at the end of the array.
+   * DoDispose implementation could call AggregateObject which would add an object
+   * at the end of the array.
    * So, to be safe, we restart the iteration over the array whenever we call some
    * user code.
    */
@@ -236,19 +270,6 @@ restart:
     }
 }
 void
-Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
-{
-  NS_LOG_FUNCTION (this << aggregates << j);
-  while (j > 0
-         && aggregates->buffer[j]->m_getObjectCount > aggregates->buffer[j - 1]->m_getObjectCount)
-    {
-      Object *tmp = aggregates->buffer[j - 1];
-      aggregates->buffer[j - 1] = aggregates->buffer[j];
-      aggregates->buffer[j] = tmp;
-      j--;
-    }
-}
-void
 Object::AggregateObject (Ptr<Object> o)
 {
   NS_LOG_FUNCTION (this << o);
@@ -260,9 +281,7 @@ Object::AggregateObject (Ptr<Object> o)
   Object *other = PeekPointer (o);
   // first create the new aggregate buffer.
   uint32_t total = m_aggregates->n + other->m_aggregates->n;
-  struct Aggregates *aggregates =
-    (struct Aggregates *)std::malloc (sizeof(struct Aggregates) + (total - 1) * sizeof(Object*));
-  aggregates->n = total;
+  struct Aggregates *aggregates = NewAggregates (total);
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0],
@@ -281,7 +300,6 @@ Object::AggregateObject (Ptr<Object> o)
                           other->GetInstanceTypeId () <<
                           " on objects of type " << typeId);
         }
-      UpdateSortedArray (aggregates, m_aggregates->n + i);
     }
 
   // keep track of the old aggregate buffers for the iteration
@@ -340,6 +358,8 @@ Object::SetTypeId (TypeId tid)
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (Check ());
   m_tid = tid;
+  // lookups made before, e.g. from a constructor, saw the old type
+  ClearCache (m_aggregates);
 }
 
 void
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <atomic>
 #include "ptr.h"
 #include "attribute.h"
 #include "object-base.h"
@@ -344,12 +345,36 @@ private:
    */
   struct Aggregates
   {
+    /** Number of entries of the lookup cache, a power of two. */
+    enum { CACHE_SIZE = 8 };
+    /**
+     * Lookup cache, indexed by the low bits of the TypeId uid.  Each
+     * entry packs the uid in its high 16 bits and one plus the index
+     * in \c buffer of the Object found in its low 16 bits, 0 if there
+     * is none, so that it is published by a single store and a lookup
+     * from another thread never pairs a uid with another uid's Object.
+     * 0 marks an empty entry.
+     */
+    std::atomic<uint32_t> cache[CACHE_SIZE];
     /** The number of entries in \c buffer. */
     uint32_t n;
     /** The array of Objects. */
     Object *buffer[1];
   };
 
+  /**
+   * Allocate an aggregate list with an empty lookup cache.
+   *
+   * \param [in] n The number of entries in the list.
+   * \return The new list, to be released with std::free().
+   */
+  static struct Aggregates * NewAggregates (uint32_t n);
+  /**
+   * Empty the lookup cache of an aggregate list.
+   *
+   * \param [in] aggregates The aggregate list.
+   */
+  static void ClearCache (struct Aggregates *aggregates);
   /**
    * Find an Object of TypeId tid in the aggregates of this Object.
    *
@@ -357,6 +382,22 @@ private:
    * \return The matching Object, if it is found
    */
   Ptr<Object> DoGetObject (TypeId tid) const;
+  /**
+   * Find an Object of TypeId tid in the aggregates of this Object,
+   * through the lookup cache of the aggregates.
+   *
+   * \param [in] tid The TypeId we're looking for
+   * \return The matching Object, or 0
+   */
+  inline Object * FindAggregate (TypeId tid) const;
+  /**
+   * Search the aggregates for an Object of TypeId tid and record
+   * the result in the lookup cache.
+   *
+   * \param [in] tid The TypeId we're looking for
+   * \return The matching Object, or 0
+   */
+  Object * FindAggregateSlow (TypeId tid) const;
   /**
    * Verify that this Object is still live, by checking it's reference count.
    * \return \c true if the reference count is non zero.
@@ -397,13 +438,6 @@ private:
   */
   void Construct (const AttributeConstructionList &attributes);
 
-  /**
-   * Keep the list of aggregates in most-recently-used order
-   *
-   * \param [in,out] aggregates The list of aggregated Objects.
-   * \param [in] i The most recently used entry in the list.
-   */
-  void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
   /**
    * Attempt to delete this Object.
    *
@@ -435,14 +469,6 @@ private:
    * so the size of the array is indirectly a reference count.
    */
   struct Aggregates * m_aggregates;
-  /**
-   * The number of times the Object was accessed with a
-   * call to GetObject().
-   *
-   * This integer is used to implement a heuristic to sort
-   * the array of aggregates in most-frequently accessed order.
-   */
-  uint32_t m_getObjectCount;
 };
 
 template <typename T>
@@ -465,6 +491,20 @@ ObjectDeleter::Delete (Object *object)
   object->DoDelete ();
 }
 
+Object *
+Object::FindAggregate (TypeId tid) const
+{
+  uint16_t uid = tid.GetUid ();
+  uint32_t entry = m_aggregates->cache[uid & (Aggregates::CACHE_SIZE - 1)]
+    .load (std::memory_order_relaxed);
+  if ((entry >> 16) == uid)
+    {
+      uint32_t i = entry & 0xffff;
+      return i != 0 ? m_aggregates->buffer[i - 1] : 0;
+    }
+  return FindAggregateSlow (tid);
+}
+
 template <typename T>
 Ptr<T>
 Object::GetObject () const
@@ -477,10 +517,10 @@ Object::GetObject () const
       return Ptr<T> (result);
     }
   // if the cast does not work, we try to do a full type check.
-  Ptr<Object> found = DoGetObject (T::GetTypeId ());
+  Object *found = FindAggregate (T::GetTypeId ());
   if (found != 0)
     {
-      return Ptr<T> (static_cast<T *> (PeekPointer (found)));
+      return Ptr<T> (static_cast<T *> (found));
     }
   return 0;
 }
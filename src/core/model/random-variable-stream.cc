@@ -97,6 +97,15 @@ RandomVariableStream::IsAntithetic (void) const
   return m_isAntithetic;
 }
 void
+RandomVariableStream::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      values[i] = GetValue ();
+    }
+}
+void
 RandomVariableStream::SetStream (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
@@ -209,6 +218,29 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double min = m_min;
+  double max = m_max;
+  if (IsAntithetic ())
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          double v = min + values[i] * (max - min);
+          values[i] = min + (max - v);
+        }
+    }
+  else
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          values[i] = min + values[i] * (max - min);
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED (ConstantRandomVariable);
 
@@ -445,6 +477,36 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  bool antithetic = IsAntithetic ();
+  double mean = m_mean;
+  double bound = m_bound;
+  std::size_t done = 0;
+  while (done < n)
+    {
+      // Draw one uniform value per missing value, so that no more
+      // are drawn than with GetValue, and keep the accepted ones.
+      Peek ()->RandU01 (values + done, n - done);
+      std::size_t accepted = done;
+      for (std::size_t i = done; i < n; ++i)
+        {
+          double v = values[i];
+          if (antithetic)
+            {
+              v = (1 - v);
+            }
+          double r = -mean*std::log (v);
+          if (bound == 0 || r <= bound)
+            {
+              values[accepted++] = r;
+            }
+        }
+      done = accepted;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED (ParetoRandomVariable);
 
@@ -549,6 +611,36 @@ ParetoRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_scale, m_shape, m_bound);
 }
+void
+ParetoRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  bool antithetic = IsAntithetic ();
+  double scale = m_scale;
+  double exponent = 1.0 / m_shape;
+  double bound = m_bound;
+  std::size_t done = 0;
+  while (done < n)
+    {
+      // See ExponentialRandomVariable::GetValues
+      Peek ()->RandU01 (values + done, n - done);
+      std::size_t accepted = done;
+      for (std::size_t i = done; i < n; ++i)
+        {
+          double v = values[i];
+          if (antithetic)
+            {
+              v = (1 - v);
+            }
+          double r = (scale * ( 1.0 / std::pow (v, exponent)));
+          if (bound == 0 || r <= bound)
+            {
+              values[accepted++] = r;
+            }
+        }
+      done = accepted;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED (WeibullRandomVariable);
 
@@ -643,6 +735,36 @@ WeibullRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_scale, m_shape, m_bound);
 }
+void
+WeibullRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  bool antithetic = IsAntithetic ();
+  double scale = m_scale;
+  double exponent = 1.0 / m_shape;
+  double bound = m_bound;
+  std::size_t done = 0;
+  while (done < n)
+    {
+      // See ExponentialRandomVariable::GetValues
+      Peek ()->RandU01 (values + done, n - done);
+      std::size_t accepted = done;
+      for (std::size_t i = done; i < n; ++i)
+        {
+          double v = values[i];
+          if (antithetic)
+            {
+              v = (1 - v);
+            }
+          double r = scale * std::pow ( -std::log (v), exponent);
+          if (bound == 0 || r <= bound)
+            {
+              values[accepted++] = r;
+            }
+        }
+      done = accepted;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED (NormalRandomVariable);
 
@@ -768,6 +890,72 @@ NormalRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_variance, m_bound);
 }
+void
+NormalRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // Number of uniform pairs drawn at a time.
+  static const std::size_t N_PAIRS = 64;
+  double u[2 * N_PAIRS];
+  bool antithetic = IsAntithetic ();
+  double mean = m_mean;
+  double sd = std::sqrt (m_variance);
+  double bound = m_bound;
+  std::size_t done = 0;
+  while (done < n)
+    {
+      if (m_nextValid)
+        { // use previously generated
+          m_nextValid = false;
+          double x2 = mean + m_v2 * m_y * sd;
+          if (std::fabs (x2 - mean) <= bound)
+            {
+              values[done++] = x2;
+              continue;
+            }
+        }
+      // Each pair gives at most two values: draw no more pairs than
+      // GetValue would.
+      std::size_t pairs = std::min ((n - done + 1) / 2, N_PAIRS);
+      Peek ()->RandU01 (u, 2 * pairs);
+      for (std::size_t i = 0; i < pairs; ++i)
+        {
+          double u1 = u[2 * i];
+          double u2 = u[2 * i + 1];
+          if (antithetic)
+            {
+              u1 = (1 - u1);
+              u2 = (1 - u2);
+            }
+          double v1 = 2 * u1 - 1;
+          double v2 = 2 * u2 - 1;
+          double w = v1 * v1 + v2 * v2;
+          if (w > 1.0)
+            {
+              continue;
+            }
+          double y = std::sqrt ((-2 * std::log (w)) / w);
+          double x1 = mean + v1 * y * sd;
+          if (std::fabs (x1 - mean) <= bound)
+            {
+              values[done++] = x1;
+              if (done == n)
+                {
+                  // keep the other one for the next call
+                  m_nextValid = true;
+                  m_y = y;
+                  m_v2 = v2;
+                  break;
+                }
+            }
+          double x2 = mean + v2 * y * sd;
+          if (std::fabs (x2 - mean) <= bound)
+            {
+              values[done++] = x2;
+            }
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED (LogNormalRandomVariable);
 
@@ -30,6 +30,7 @@
 #include "object.h"
 #include "attribute-helper.h"
 #include <stdint.h>
+#include <cstddef>
 
 /**
  * \file
@@ -149,6 +150,19 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next random values drawn from the distribution.
+   *
+   * The values, and the state of the stream afterwards, are the same
+   * as from \pname{n} calls to GetValue(void).  The distributions which
+   * turn one uniform value into one random value override this to draw
+   * all the uniform values from the RngStream in one go.
+   *
+   * \param [out] values The random values.
+   * \param [in] n The number of random values.
+   */
+  virtual void GetValues (double *values, std::size_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RngStream.
@@ -294,6 +308,7 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -586,6 +601,7 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
@@ -784,6 +800,7 @@ public:
    * which now involves the distance \f$u\f$ is from 1 in the denominator.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The mean parameter for the Pareto distribution returned by this RNG stream. */
@@ -993,6 +1010,7 @@ public:
    * which now involves the log of the distance \f$u\f$ is from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The scale parameter for the Weibull distribution returned by this RNG stream. */
@@ -1226,6 +1244,7 @@ public:
    * which now involves the distances \f$u1\f$ and \f$u2\f$ are from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, std::size_t n);
 
 private:
   /** The mean value for the normal distribution returned by this RNG stream. */
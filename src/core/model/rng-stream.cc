@@ -367,6 +367,56 @@ double RngStream::RandU01 ()
   return u;
 }
 
+void
+RngStream::RandU01 (double *u, std::size_t n)
+{
+  // The same steps as RandU01 (void), on local copies of the state.
+  double s0 = m_currentState[0];
+  double s1 = m_currentState[1];
+  double s2 = m_currentState[2];
+  double s3 = m_currentState[3];
+  double s4 = m_currentState[4];
+  double s5 = m_currentState[5];
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      int32_t k;
+      double p1, p2;
+
+      /* Component 1 */
+      p1 = a12 * s1 - a13n * s0;
+      k = static_cast<int32_t> (p1 / m1);
+      p1 -= k * m1;
+      if (p1 < 0.0)
+        {
+          p1 += m1;
+        }
+      s0 = s1;
+      s1 = s2;
+      s2 = p1;
+
+      /* Component 2 */
+      p2 = a21 * s5 - a23n * s3;
+      k = static_cast<int32_t> (p2 / m2);
+      p2 -= k * m2;
+      if (p2 < 0.0)
+        {
+          p2 += m2;
+        }
+      s3 = s4;
+      s4 = s5;
+      s5 = p2;
+
+      /* Combination */
+      u[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+    }
+  m_currentState[0] = s0;
+  m_currentState[1] = s1;
+  m_currentState[2] = s2;
+  m_currentState[3] = s3;
+  m_currentState[4] = s4;
+  m_currentState[5] = s5;
+}
+
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
@@ -20,6 +20,7 @@
 #ifndef RNGSTREAM_H
 #define RNGSTREAM_H
 #include <string>
+#include <cstddef>
 #include <stdint.h>
 
 /**
@@ -70,6 +71,18 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next random numbers for this stream.
+   * Uniformly distributed between 0 and 1.
+   *
+   * This gives the same numbers, and leaves the stream in the same
+   * state, as \pname{n} calls to RandU01(), but keeps the state in
+   * registers between numbers.
+   *
+   * \param [out] u The random numbers.
+   * \param [in] n The number of random numbers.
+   */
+  void RandU01 (double *u, std::size_t n);
 
 private:
   /**
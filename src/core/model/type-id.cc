@@ -23,7 +23,7 @@
 #include "singleton.h"
 #include "trace-source-accessor.h"
 
-#include <map>
+#include <deque>
 #include <vector>
 #include <sstream>
 #include <iomanip>
@@ -51,7 +51,13 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
  * \brief TypeId information manager
  *
  * Information records are stored in a vector.  Name and hash lookup
- * are performed by maps to the vector index.
+ * are performed by open addressing indices into the vector.
+ *
+ * Each record also keeps flattened tables of the attributes and trace
+ * sources of the type and of all of its parents, indexed by name, so
+ * that looking one up by name does not walk the parent chain.  The
+ * tables are rebuilt when a type is registered, never when a lookup is
+ * done, so lookups do not write to shared state.
  *
  * \internal
  * <b>Hash Chaining</b>
@@ -229,6 +235,20 @@ public:
    * \returns The information associated to attribute whose index is \pname{i}.
    */
   struct TypeId::AttributeInformation GetAttribute (uint16_t uid, std::size_t i) const;
+  /**
+   * Get Attribute information by index, without copying it.
+   * \param [in] uid The id.
+   * \param [in] i Index into attribute array
+   * \returns The information associated to attribute whose index is \pname{i}.
+   */
+  const struct TypeId::AttributeInformation & PeekAttribute (uint16_t uid, std::size_t i) const;
+  /**
+   * Find an Attribute of a type id or of one of its parents.
+   * \param [in] uid The id.
+   * \param [in] name The Attribute name.
+   * \returns The Attribute information, or 0 if not found.
+   */
+  const struct TypeId::AttributeInformation * FindAttribute (uint16_t uid, const std::string &name) const;
   /**
    * Record a new TraceSource.
    * \param [in] uid The id.
@@ -264,6 +284,13 @@ public:
    * \returns Detailed information about the requested trace source.
    */
   struct TypeId::TraceSourceInformation GetTraceSource (uint16_t uid, std::size_t i) const;
+  /**
+   * Find a TraceSource of a type id or of one of its parents.
+   * \param [in] uid The id.
+   * \param [in] name The TraceSource name.
+   * \returns The TraceSource information, or 0 if not found.
+   */
+  const struct TypeId::TraceSourceInformation * FindTraceSource (uint16_t uid, const std::string &name) const;
   /**
    * Check if this TypeId should not be listed in documentation.
    * \param [in] uid The id.
@@ -292,6 +319,37 @@ private:
    * \returns The hashed value of \pname{name}.
    */
   static TypeId::hash_t Hasher (const std::string name);
+  /**
+   * Cheap hashing function for the indices.
+   * \param [in] name The name.
+   * \returns The hashed value of \pname{name}.
+   */
+  static uint32_t NameHash (const std::string &name);
+
+  /** An entry of a flattened table. */
+  struct FlatEntry
+  {
+    /** The NameHash of the entry name. */
+    uint32_t hash;
+    /** The type id which declares the entry. */
+    uint16_t uid;
+    /** The index of the entry in that type id. */
+    std::size_t index;
+  };
+  /**
+   * The attributes or trace sources of a type id and of its parents,
+   * by name.
+   */
+  struct FlatTable
+  {
+    /** The entries, those of the type id first, then those of its parents. */
+    std::vector<struct FlatEntry> entries;
+    /**
+     * Open addressing index by name into \c entries, offset by one
+     * so that zero marks an empty slot.  The size is a power of two.
+     */
+    std::vector<uint32_t> slots;
+  };
 
   /** The information record about a single type id. */
   struct IidInformation
@@ -320,9 +378,17 @@ private:
     TypeId::SupportLevel supportLevel;
     /** Support message. */
     std::string supportMsg;
+    /** The NameHash of the name. */
+    uint32_t nameHash;
+    /** \c true if another type id has this one as parent. */
+    bool hasChildren;
+    /** The Attributes of this type id and of its parents. */
+    struct FlatTable flatAttributes;
+    /** The TraceSources of this type id and of its parents. */
+    struct FlatTable flatTraceSources;
   };
   /** Iterator type. */
-  typedef std::vector<struct IidInformation>::const_iterator Iterator;
+  typedef std::deque<struct IidInformation>::const_iterator Iterator;
 
   /**
    * Retrieve the information record for a type.
@@ -331,18 +397,56 @@ private:
    */
   struct IidManager::IidInformation * LookupInformation (uint16_t uid) const;
 
-  /** The container of all type id records. */
-  std::vector<struct IidInformation> m_information;
+  /**
+   * Add a type id to the by-name and by-hash indices, growing them
+   * if needed.
+   * \param [in] uid The id.
+   */
+  void Index (uint16_t uid);
+  /** Rebuild the by-name and by-hash indices from scratch. */
+  void Reindex (void);
+  /**
+   * Rebuild the flattened tables of a type id, and of its children.
+   * \param [in] uid The id.
+   */
+  void Flatten (uint16_t uid);
+  /**
+   * Rebuild one flattened table of a type id.
+   * \param [in] uid The id.
+   * \param [in] items The Attributes or TraceSources member.
+   * \param [in] table The matching flattened table member.
+   */
+  template <typename T>
+  void Flatten (uint16_t uid,
+                std::vector<T> IidInformation::*items,
+                struct FlatTable IidInformation::*table);
+  /**
+   * Find an entry in a flattened table.
+   * \param [in] uid The id.
+   * \param [in] name The name of the entry.
+   * \param [in] items The Attributes or TraceSources member.
+   * \param [in] table The matching flattened table member.
+   * \returns The entry, or 0 if not found.
+   */
+  template <typename T>
+  const T * Find (uint16_t uid, const std::string &name,
+                  std::vector<T> IidInformation::*items,
+                  struct FlatTable IidInformation::*table) const;
 
-  /** Type of the by-name index. */
-  typedef std::map<std::string, uint16_t> namemap_t;
-  /** The by-name index. */
-  namemap_t m_namemap;
+  /**
+   * The container of all type id records.  Records never move, so that
+   * the information returned by PeekAttribute and FindAttribute stays
+   * valid while other types get registered.
+   */
+  std::deque<struct IidInformation> m_information;
 
-  /** Type of the by-hash index. */
-  typedef std::map<TypeId::hash_t, uint16_t> hashmap_t;
-  /** The by-hash index. */
-  hashmap_t m_hashmap;
+  /**
+   * The by-name index: open addressing on NameHash, holding type ids,
+   * with zero marking an empty slot.  The size is a power of two.
+   */
+  std::vector<uint16_t> m_nameIndex;
+  /** The by-hash index, as \c m_nameIndex but on the type id hash. */
+  std::vector<uint16_t> m_hashIndex;
 
 
   /** IidManager constants. */
@@ -367,6 +471,20 @@ IidManager::Hasher (const std::string name)
   return hasher.clear ().GetHash32 (name);
 }
 
+//static
+uint32_t
+IidManager::NameHash (const std::string &name)
+{
+  // 32 bit FNV-1a
+  uint32_t hash = 2166136261u;
+  for (std::string::const_iterator i = name.begin (); i != name.end (); ++i)
+    {
+      hash ^= static_cast<uint8_t> (*i);
+      hash *= 16777619u;
+    }
+  return hash;
+}
+
 /**
  * \ingroup object
  * \internal
@@ -385,12 +503,14 @@ IidManager::AllocateUid (std::string name)
 {
   NS_LOG_FUNCTION (IID << name);
   // Type names are definitive: equal names are equal types
-  NS_ASSERT_MSG (m_namemap.count (name) == 0,
+  NS_ASSERT_MSG (GetUid (name) == 0,
                  "Trying to allocate twice the same uid: " << name);
 
   TypeId::hash_t hash = Hasher (name) & (~HashChainFlag);
-  if (m_hashmap.count (hash) == 1)
+  bool chained = false;
+  if (GetUid (hash) != 0)
     {
+      chained = true;
       NS_LOG_ERROR ("Hash chaining TypeId for '" << name << "'.  "
                                                  << "This is not a bug, but is extremely unlikely.  "
                                                  << "Please contact the ns3 developers.");
@@ -406,7 +526,7 @@ IidManager::AllocateUid (std::string name)
       //  Oh, by the way, I owe you a beer, since I bet Mathieu that
       //  this would never happen..  -- Peter Barnes, LLNL
 
-      NS_ASSERT_MSG (m_hashmap.count (hash | HashChainFlag) == 0,
+      NS_ASSERT_MSG (GetUid (hash | HashChainFlag) == 0,
                      "Triplicate hash detected while chaining TypeId for '"
                      << name
                      << "'. Please contact the ns3 developers for assistance.");
@@ -426,10 +546,7 @@ IidManager::AllocateUid (std::string name)
       else
         { // chain old type
           NS_LOG_LOGIC (IIDL << "Old TypeId '" << hinfo->name << "' getting chained.");
-          uint16_t oldUid = GetUid (hinfo->hash);
-          m_hashmap.erase (m_hashmap.find (hinfo->hash));
           hinfo->hash = hash | HashChainFlag;
-          m_hashmap.insert (std::make_pair (hinfo->hash, oldUid));
           // leave new hash unchained
         }
     }
@@ -443,18 +560,185 @@ IidManager::AllocateUid (std::string name)
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
   information.supportLevel = TypeId::SUPPORTED;
+  information.nameHash = NameHash (name);
+  information.hasChildren = false;
   m_information.push_back (information);
   std::size_t tuid = m_information.size ();
   NS_ASSERT (tuid <= 0xffff);
   uint16_t uid = static_cast<uint16_t> (tuid);
 
-  // Add to both maps:
-  m_namemap.insert (std::make_pair (name, uid));
-  m_hashmap.insert (std::make_pair (hash, uid));
+  // Add to both indices:
+  if (chained)
+    {
+      // the hash of an old type may have changed
+      Reindex ();
+    }
+  else
+    {
+      Index (uid);
+    }
   NS_LOG_LOGIC (IIDL << uid);
   return uid;
 }
 
+void
+IidManager::Index (uint16_t uid)
+{
+  NS_LOG_FUNCTION (IID << uid);
+  // keep the load factor at or below one half
+  if (m_information.size () * 2 > m_nameIndex.size ())
+    {
+      Reindex ();
+      return;
+    }
+  const struct IidInformation &information = m_information[uid - 1];
+  std::size_t mask = m_nameIndex.size () - 1;
+  std::size_t slot = information.nameHash & mask;
+  while (m_nameIndex[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+  m_nameIndex[slot] = uid;
+  slot = information.hash & mask;
+  while (m_hashIndex[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+  m_hashIndex[slot] = uid;
+}
+
+void
+IidManager::Reindex (void)
+{
+  NS_LOG_FUNCTION (IID);
+  std::size_t size = 64;
+  while (size < m_information.size () * 4)
+    {
+      size *= 2;
+    }
+  m_nameIndex.assign (size, 0);
+  m_hashIndex.assign (size, 0);
+  for (std::size_t i = 0; i < m_information.size (); ++i)
+    {
+      Index (static_cast<uint16_t> (i + 1));
+    }
+}
+
+template <typename T>
+void
+IidManager::Flatten (uint16_t uid,
+                     std::vector<T> IidInformation::*items,
+                     struct FlatTable IidInformation::*table)
+{
+  NS_LOG_FUNCTION (IID << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  const struct FlatTable *parentTable = 0;
+  if (information->parent != 0 && information->parent != uid)
+    {
+      parentTable = &(LookupInformation (information->parent)->*table);
+    }
+
+  struct FlatTable flat;
+  const std::vector<T> &own = information->*items;
+  for (std::size_t i = 0; i < own.size (); ++i)
+    {
+      struct FlatEntry entry;
+      entry.hash = NameHash (own[i].name);
+      entry.uid = uid;
+      entry.index = i;
+      flat.entries.push_back (entry);
+    }
+  if (parentTable != 0)
+    {
+      flat.entries.insert (flat.entries.end (),
+                           parentTable->entries.begin (), parentTable->entries.end ());
+    }
+
+  std::size_t size = 8;
+  while (size < flat.entries.size () * 2)
+    {
+      size *= 2;
+    }
+  flat.slots.assign (size, 0);
+  std::size_t mask = size - 1;
+  std::vector<struct FlatEntry> entries;
+  entries.swap (flat.entries);
+  for (std::size_t i = 0; i < entries.size (); ++i)
+    {
+      const struct FlatEntry &entry = entries[i];
+      const std::string &name = (LookupInformation (entry.uid)->*items)[entry.index].name;
+      std::size_t slot = entry.hash & mask;
+      bool shadowed = false;
+      while (flat.slots[slot] != 0)
+        {
+          const struct FlatEntry &other = flat.entries[flat.slots[slot] - 1];
+          if (other.hash == entry.hash
+              && (LookupInformation (other.uid)->*items)[other.index].name == name)
+            {
+              // the closest type id wins, as when walking the parents
+              shadowed = true;
+              break;
+            }
+          slot = (slot + 1) & mask;
+        }
+      if (!shadowed)
+        {
+          flat.entries.push_back (entry);
+          flat.slots[slot] = static_cast<uint32_t> (flat.entries.size ());
+        }
+    }
+  information->*table = flat;
+}
+
+void
+IidManager::Flatten (uint16_t uid)
+{
+  NS_LOG_FUNCTION (IID << uid);
+  Flatten (uid, &IidInformation::attributes, &IidInformation::flatAttributes);
+  Flatten (uid, &IidInformation::traceSources, &IidInformation::flatTraceSources);
+  if (LookupInformation (uid)->hasChildren)
+    {
+      // the parent changed after its children were registered
+      for (std::size_t i = 0; i < m_information.size (); ++i)
+        {
+          uint16_t child = static_cast<uint16_t> (i + 1);
+          if (child != uid && m_information[i].parent == uid)
+            {
+              Flatten (child);
+            }
+        }
+    }
+}
+
+template <typename T>
+const T *
+IidManager::Find (uint16_t uid, const std::string &name,
+                  std::vector<T> IidInformation::*items,
+                  struct FlatTable IidInformation::*table) const
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  const struct FlatTable &flat = LookupInformation (uid)->*table;
+  if (flat.slots.empty ())
+    {
+      return 0;
+    }
+  uint32_t hash = NameHash (name);
+  std::size_t mask = flat.slots.size () - 1;
+  for (std::size_t slot = hash & mask; flat.slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+      const struct FlatEntry &entry = flat.entries[flat.slots[slot] - 1];
+      if (entry.hash == hash)
+        {
+          const T &item = (m_information[entry.uid - 1].*items)[entry.index];
+          if (item.name == name)
+            {
+              return &item;
+            }
+        }
+    }
+  return 0;
+}
+
 struct IidManager::IidInformation *
 IidManager::LookupInformation (uint16_t uid) const
 {
@@ -471,6 +755,11 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
+  if (parent != 0 && parent != uid)
+    {
+      LookupInformation (parent)->hasChildren = true;
+    }
+  Flatten (uid);
 }
 void
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -512,10 +801,19 @@ IidManager::GetUid (std::string name) const
 {
   NS_LOG_FUNCTION (IID << name);
   uint16_t uid = 0;
-  namemap_t::const_iterator it = m_namemap.find (name);
-  if (it != m_namemap.end ())
+  if (!m_nameIndex.empty ())
     {
-      uid = it->second;
+      uint32_t hash = NameHash (name);
+      std::size_t mask = m_nameIndex.size () - 1;
+      for (std::size_t slot = hash & mask; m_nameIndex[slot] != 0; slot = (slot + 1) & mask)
+        {
+          const struct IidInformation &information = m_information[m_nameIndex[slot] - 1];
+          if (information.nameHash == hash && information.name == name)
+            {
+              uid = m_nameIndex[slot];
+              break;
+            }
+        }
     }
   NS_LOG_LOGIC (IIDL << uid);
   return uid;
@@ -524,11 +822,18 @@ uint16_t
 IidManager::GetUid (TypeId::hash_t hash) const
 {
   NS_LOG_FUNCTION (IID << hash);
-  hashmap_t::const_iterator it = m_hashmap.find (hash);
   uint16_t uid = 0;
-  if (it != m_hashmap.end ())
+  if (!m_hashIndex.empty ())
     {
-      uid = it->second;
+      std::size_t mask = m_hashIndex.size () - 1;
+      for (std::size_t slot = hash & mask; m_hashIndex[slot] != 0; slot = (slot + 1) & mask)
+        {
+          if (m_information[m_hashIndex[slot] - 1].hash == hash)
+            {
+              uid = m_hashIndex[slot];
+              break;
+            }
+        }
     }
   NS_LOG_LOGIC (IIDL << uid);
   return uid;
@@ -617,30 +922,9 @@ IidManager::HasAttribute (uint16_t uid,
                           std::string name)
 {
   NS_LOG_FUNCTION (IID << uid << name);
-  struct IidInformation *information  = LookupInformation (uid);
-  while (true)
-    {
-      for (std::vector<struct TypeId::AttributeInformation>::const_iterator i = information->attributes.begin ();
-           i != information->attributes.end (); ++i)
-        {
-          if (i->name == name)
-            {
-              NS_LOG_LOGIC (IIDL << true);
-              return true;
-            }
-        }
-      struct IidInformation *parent = LookupInformation (information->parent);
-      if (parent == information)
-        {
-          // top of inheritance tree
-          NS_LOG_LOGIC (IIDL << false);
-          return false;
-        }
-      // check parent
-      information = parent;
-    }
-  NS_LOG_LOGIC (IIDL << false);
-  return false;
+  bool found = FindAttribute (uid, name) != 0;
+  NS_LOG_LOGIC (IIDL << found);
+  return found;
 }
 
 void
@@ -682,6 +966,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.supportMsg = supportMsg;
   information->attributes.push_back (info);
   NS_LOG_LOGIC (IIDL << information->attributes.size () - 1);
+  Flatten (uid);
 }
 void
 IidManager::SetAttributeInitialValue (uint16_t uid,
@@ -714,36 +999,29 @@ IidManager::GetAttribute (uint16_t uid, std::size_t i) const
   NS_LOG_LOGIC (IIDL << information->name);
   return information->attributes[i];
 }
+const struct TypeId::AttributeInformation &
+IidManager::PeekAttribute (uint16_t uid, std::size_t i) const
+{
+  NS_LOG_FUNCTION (IID << uid << i);
+  struct IidInformation *information = LookupInformation (uid);
+  NS_ASSERT (i < information->attributes.size ());
+  return information->attributes[i];
+}
+const struct TypeId::AttributeInformation *
+IidManager::FindAttribute (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  return Find (uid, name, &IidInformation::attributes, &IidInformation::flatAttributes);
+}
 
 bool
 IidManager::HasTraceSource (uint16_t uid,
                             std::string name)
 {
   NS_LOG_FUNCTION (IID << uid << name);
-  struct IidInformation *information  = LookupInformation (uid);
-  while (true)
-    {
-      for (std::vector<struct TypeId::TraceSourceInformation>::const_iterator i = information->traceSources.begin ();
-           i != information->traceSources.end (); ++i)
-        {
-          if (i->name == name)
-            {
-              NS_LOG_LOGIC (IIDL << true);
-              return true;
-            }
-        }
-      struct IidInformation *parent = LookupInformation (information->parent);
-      if (parent == information)
-        {
-          // top of inheritance tree
-          NS_LOG_LOGIC (IIDL << false);
-          return false;
-        }
-      // check parent
-      information = parent;
-    }
-  NS_LOG_LOGIC (IIDL << false);
-  return false;
+  bool found = FindTraceSource (uid, name) != 0;
+  NS_LOG_LOGIC (IIDL << found);
+  return found;
 }
 
 void
@@ -774,6 +1052,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.supportMsg = supportMsg;
   information->traceSources.push_back (source);
   NS_LOG_LOGIC (IIDL << information->traceSources.size () - 1);
+  Flatten (uid);
 }
 std::size_t
 IidManager::GetTraceSourceN (uint16_t uid) const
@@ -793,6 +1072,12 @@ IidManager::GetTraceSource (uint16_t uid, std::size_t i) const
   NS_LOG_LOGIC (IIDL << information->name);
   return information->traceSources[i];
 }
+const struct TypeId::TraceSourceInformation *
+IidManager::FindTraceSource (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  return Find (uid, name, &IidInformation::traceSources, &IidInformation::flatTraceSources);
+}
 bool
 IidManager::MustHideFromDocumentation (uint16_t uid) const
 {
@@ -883,40 +1168,24 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do
+  const struct TypeId::AttributeInformation *tmp = IidManager::Get ()->FindAttribute (m_tid, name);
+  if (tmp == 0)
     {
-      tid = nextTid;
-      for (std::size_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute (i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "Attribute '" << name << "' is deprecated: "
-                            << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("Attribute '" << name <<
-                                  "' is obsolete, with no fallback: " <<
-                                  tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
+      return false;
+    }
+  if (tmp->supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "Attribute '" << name << "' is deprecated: "
+                << tmp->supportMsg << std::endl;
+    }
+  else if (tmp->supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("Attribute '" << name <<
+                      "' is obsolete, with no fallback: " <<
+                      tmp->supportMsg);
     }
-  while (nextTid != tid);
-  return false;
+  *info = *tmp;
+  return true;
 }
 
 TypeId
@@ -1086,6 +1355,12 @@ TypeId::GetAttribute (std::size_t i) const
   NS_LOG_FUNCTION (this << i);
   return IidManager::Get ()->GetAttribute (m_tid, i);
 }
+const struct TypeId::AttributeInformation &
+TypeId::PeekAttribute (std::size_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  return IidManager::Get ()->PeekAttribute (m_tid, i);
+}
 std::string
 TypeId::GetAttributeFullName (std::size_t i) const
 {
@@ -1137,41 +1412,24 @@ TypeId::LookupTraceSourceByName (std::string name,
                                  struct TraceSourceInformation *info) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  struct TypeId::TraceSourceInformation tmp;
-  do
+  const struct TypeId::TraceSourceInformation *tmp = IidManager::Get ()->FindTraceSource (m_tid, name);
+  if (tmp == 0)
     {
-      tid = nextTid;
-      for (std::size_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          tmp = tid.GetTraceSource (i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                  return tmp.accessor;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "TraceSource '" << name << "' is deprecated: "
-                            << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return tmp.accessor;
-                }
-              else if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("TraceSource '" << name <<
-                                  "' is obsolete, with no fallback: " <<
-                                  tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
+      return 0;
     }
-  while (nextTid != tid);
-  return 0;
+  if (tmp->supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "TraceSource '" << name << "' is deprecated: "
+                << tmp->supportMsg << std::endl;
+    }
+  else if (tmp->supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("TraceSource '" << name <<
+                      "' is obsolete, with no fallback: " <<
+                      tmp->supportMsg);
+    }
+  *info = *tmp;
+  return tmp->accessor;
 }
 
 Ptr<const TraceSourceAccessor>
@@ -1181,12 +1439,6 @@ TypeId::LookupTraceSourceByName (std::string name) const
   return LookupTraceSourceByName (name, &info);
 }
 
-uint16_t
-TypeId::GetUid (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return m_tid;
-}
 void
 TypeId::SetUid (uint16_t uid)
 {
@@ -258,6 +258,16 @@ public:
    * \returns The information associated to attribute whose index is \pname{i}.
    */
   struct TypeId::AttributeInformation GetAttribute (std::size_t i) const;
+  /**
+   * Get Attribute information by index, without copying it.
+   *
+   * The reference stays valid while other TypeIds are registered,
+   * but not when an Attribute is added to this TypeId.
+   *
+   * \param [in] i Index into attribute array
+   * \returns The information associated to attribute whose index is \pname{i}.
+   */
+  const struct TypeId::AttributeInformation & PeekAttribute (std::size_t i) const;
   /**
    * Get the Attribute name by index.
    *
@@ -504,7 +514,7 @@ public:
    * This is really an internal method which users are not expected
    * to use.
    */
-  uint16_t GetUid (void) const;
+  inline uint16_t GetUid (void) const;
   /**
    * Set the internal id of this TypeId.
    *
@@ -611,6 +621,11 @@ TypeId &TypeId::operator = (const TypeId &o)
 }
 TypeId::~TypeId ()
 {}
+uint16_t
+TypeId::GetUid (void) const
+{
+  return m_tid;
+}
 inline bool operator == (TypeId a, TypeId b)
 {
   return a.m_tid == b.m_tid;
@@ -840,6 +840,144 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup config-tests
+ * Test for compiled paths and batches of operations.
+ */
+class BatchConfigTestCase : public TestCase
+{
+public:
+  /** Constructor. */
+  BatchConfigTestCase ();
+  /** Destructor. */
+  virtual ~BatchConfigTestCase ()
+  {}
+
+  /**
+   * Trace callback without context.
+   * \param oldValue The old value.
+   * \param newValue The new value.
+   */
+  void Trace (int16_t oldValue, int16_t newValue)
+  {
+    NS_UNUSED (oldValue);
+    m_newValue = newValue;
+  }
+  /**
+   * Trace callback with context path.
+   * \param path The context path.
+   * \param old The old value.
+   * \param newValue The new value.
+   */
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue)
+  {
+    NS_UNUSED (old);
+    m_newValue = newValue;
+    m_path = path;
+  }
+
+private:
+  virtual void DoRun (void);
+
+  int16_t m_newValue; //!< Flag to detect tracing result.
+  std::string m_path; //!< The context path.
+};
+
+BatchConfigTestCase::BatchConfigTestCase ()
+  : TestCase ("Check compiled paths and batches of operations")
+{}
+
+void
+BatchConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+
+  //
+  // Create a root namespace object, with four objects in the ObjectVector
+  // Attribute of an object under the root.
+  //
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeB (a);
+  std::vector<Ptr<ConfigTestObject> > objs;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      objs.push_back (CreateObject<ConfigTestObject> ());
+      a->AddNodeA (objs.back ());
+    }
+
+  //
+  // A compiled path matches the same objects as the path string, and is
+  // looked up again each time it is used.
+  //
+  Config::CompiledPath path ("/NodeB/NodesA/2");
+  Config::CompiledPath wildcard ("NodeB/NodesA/*");
+  Config::CompiledPath missing ("/NodeB/NodesA/4");
+  NS_TEST_ASSERT_MSG_EQ (path.GetPath (), "/NodeB/NodesA/2", "Unexpected path");
+  Config::MatchContainer matches = path.LookupMatches ();
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "Unexpected number of matches");
+  NS_TEST_ASSERT_MSG_EQ (matches.Get (0), objs[2], "Unexpected match");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetMatchedPath (0), "/NodeB/NodesA/2/", "Unexpected matched path");
+  matches = wildcard.LookupMatches ();
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 4, "Unexpected number of matches");
+  NS_TEST_ASSERT_MSG_EQ (matches.Get (3), objs[3], "Unexpected match");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetMatchedPath (3), "/NodeB/NodesA/3/", "Unexpected matched path");
+  NS_TEST_ASSERT_MSG_EQ (missing.LookupMatches ().GetN (), 0, "Unexpected match");
+  objs.push_back (CreateObject<ConfigTestObject> ());
+  a->AddNodeA (objs.back ());
+  NS_TEST_ASSERT_MSG_EQ (missing.LookupMatches ().GetN (), 1, "New object not matched");
+  NS_TEST_ASSERT_MSG_EQ (wildcard.LookupMatches ().GetN (), 5, "New object not matched");
+
+  //
+  // A batch applies its operations as the Config functions would.
+  //
+  Config::Batch batch;
+  batch.Set ("/NodeB/NodesA/1/A", IntegerValue (-14));
+  batch.Set ("/NodeB/NodesA/[2-3]/B", IntegerValue (-15));
+  batch.Set ("/NodeB/NodesA/*/A", IntegerValue (-16));
+  batch.ConnectWithoutContext ("/NodeB/NodesA/0/Source",
+                               MakeCallback (&BatchConfigTestCase::Trace, this));
+  batch.Connect ("/NodeB/NodesA/3/Source",
+                 MakeCallback (&BatchConfigTestCase::TraceWithPath, this));
+  NS_TEST_ASSERT_MSG_EQ (batch.GetN (), 5, "Unexpected number of operations");
+  batch.Apply ();
+  NS_TEST_ASSERT_MSG_EQ (batch.GetN (), 0, "Operations not removed");
+
+  for (uint32_t i = 0; i < objs.size (); ++i)
+    {
+      objs[i]->GetAttribute ("A", iv);
+      NS_TEST_ASSERT_MSG_EQ (iv.Get (), -16, "Object Attribute \"A\" not set in order");
+      objs[i]->GetAttribute ("B", iv);
+      int expected = (i == 2 || i == 3) ? -15 : 9;
+      NS_TEST_ASSERT_MSG_EQ (iv.Get (), expected, "Object Attribute \"B\" not set as expected");
+    }
+
+  m_newValue = 0;
+  objs[0]->SetAttribute ("Source", IntegerValue (-5));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -5, "Trace 0 did not fire as expected");
+  m_newValue = 0;
+  objs[1]->SetAttribute ("Source", IntegerValue (-2));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, 0, "Trace 1 fired unexpectedly");
+  m_newValue = 0;
+  m_path = "";
+  objs[3]->SetAttribute ("Source", IntegerValue (-4));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -4, "Trace 3 did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeB/NodesA/3/Source", "Trace 3 did not provide expected context");
+
+  //
+  // An operation which matches nothing makes the batch fail.
+  //
+  batch.ConnectWithoutContext ("/NodeB/NodesA/9/Source",
+                               MakeCallback (&BatchConfigTestCase::Trace, this));
+  batch.Set ("/NodeB/NodesA/4/A", IntegerValue (-17));
+  NS_TEST_ASSERT_MSG_EQ (batch.ApplyFailSafe (), false, "Missing trace source not reported");
+  objs[4]->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), -17, "Object Attribute \"A\" not set as expected");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 /**
  * \ingroup config-tests
  * The Test Suite that glues all of the Test Cases together.
@@ -858,6 +996,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase);
   AddTestCase (new ObjectVectorConfigTestCase);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase);
+  AddTestCase (new BatchConfigTestCase);
 }
 
 /**
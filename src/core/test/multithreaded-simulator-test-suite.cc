@@ -0,0 +1,509 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup simulator-tests
+ *
+ * Pass tokens around a ring of nodes, each node also scheduling local
+ * events, and record what every node sees.  Each node only touches its
+ * own record, so that partitions never share data.
+ */
+class MultithreadedSimulatorRingTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param threads Number of threads.
+   * \param partitions Number of partitions.
+   */
+  MultithreadedSimulatorRingTestCase (uint32_t threads, uint32_t partitions);
+
+private:
+  virtual void DoRun (void);
+
+  /** What a node saw. */
+  struct Record
+  {
+    uint64_t ts;     ///< Time of the event.
+    uint32_t hop;    ///< Hop count, or 0 for local events.
+    uint32_t value;  ///< The token value.
+    /**
+     * \param o The other record.
+     * \returns true if this record sorts before \p o.
+     */
+    bool operator< (const Record &o) const
+    {
+      return ts < o.ts || (ts == o.ts && (hop < o.hop || (hop == o.hop && value < o.value)));
+    }
+    /**
+     * \param o The other record.
+     * \returns true if the records are equal.
+     */
+    bool operator== (const Record &o) const
+    {
+      return ts == o.ts && hop == o.hop && value == o.value;
+    }
+  };
+  /** The records of every node. */
+  typedef std::vector<std::vector<Record> > Log;
+
+  /**
+   * Run the ring with a simulator implementation.
+   * \param type The simulator implementation type.
+   * \param [out] log The records.
+   * \returns The simulation time at the end.
+   */
+  Time RunRing (std::string type, Log &log);
+  /**
+   * Receive a token from the previous node.
+   * \param node The node.
+   * \param hop The hop count.
+   * \param value The token value.
+   */
+  void Receive (uint32_t node, uint32_t hop, uint32_t value);
+  /**
+   * A local event.
+   * \param node The node.
+   * \param value The token value.
+   */
+  void Local (uint32_t node, uint32_t value);
+
+  uint32_t m_threads;        ///< Number of threads.
+  uint32_t m_partitions;     ///< Number of partitions.
+  Log *m_log;                ///< Log of the current run.
+  std::vector<uint32_t> m_badContext; ///< Events run with a wrong context, per node.
+};
+
+/// Number of nodes in the ring.
+static const uint32_t N_NODES = 16;
+/// Number of hops of each token.
+static const uint32_t N_HOPS = 200;
+/// Lookahead, also the smallest delay between nodes.
+static const Time LOOKAHEAD = MicroSeconds (10);
+
+MultithreadedSimulatorRingTestCase::MultithreadedSimulatorRingTestCase (uint32_t threads, uint32_t partitions)
+  : TestCase ("Check that a ring of " + std::to_string (N_NODES) + " nodes gives the same results with "
+              + std::to_string (threads) + " threads and " + std::to_string (partitions) + " partitions"),
+    m_threads (threads),
+    m_partitions (partitions),
+    m_log (0)
+{}
+
+void
+MultithreadedSimulatorRingTestCase::Receive (uint32_t node, uint32_t hop, uint32_t value)
+{
+  if (Simulator::GetContext () != node)
+    {
+      m_badContext[node]++;
+    }
+  Record r = {static_cast<uint64_t> (Simulator::Now ().GetTimeStep ()), hop, value};
+  (*m_log)[node].push_back (r);
+  Simulator::Schedule (NanoSeconds (value % 1000), &MultithreadedSimulatorRingTestCase::Local, this, node, value);
+  if (hop < N_HOPS)
+    {
+      uint32_t next = (node + 1) % N_NODES;
+      Simulator::ScheduleWithContext (next, LOOKAHEAD + NanoSeconds (value % 5000),
+                                      &MultithreadedSimulatorRingTestCase::Receive, this,
+                                      next, hop + 1, value * 1103515245u + 12345u);
+    }
+}
+
+void
+MultithreadedSimulatorRingTestCase::Local (uint32_t node, uint32_t value)
+{
+  if (Simulator::GetContext () != node)
+    {
+      m_badContext[node]++;
+    }
+  Record r = {static_cast<uint64_t> (Simulator::Now ().GetTimeStep ()), 0, value};
+  (*m_log)[node].push_back (r);
+}
+
+Time
+MultithreadedSimulatorRingTestCase::RunRing (std::string type, Log &log)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (type));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Threads", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (m_partitions));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (LOOKAHEAD));
+  log.assign (N_NODES, std::vector<Record> ());
+  m_log = &log;
+  for (uint32_t node = 0; node < N_NODES; ++node)
+    {
+      for (uint32_t token = 0; token < 3; ++token)
+        {
+          Simulator::ScheduleWithContext (node, NanoSeconds (token * 7 + node),
+                                          &MultithreadedSimulatorRingTestCase::Receive, this,
+                                          node, 1, node * 100 + token);
+        }
+    }
+  // a public event in the middle of the simulation
+  Simulator::Stop (MilliSeconds (1));
+  Simulator::Run ();
+  Time end = Simulator::Now ();
+  Simulator::Destroy ();
+  m_log = 0;
+  return end;
+}
+
+void
+MultithreadedSimulatorRingTestCase::DoRun (void)
+{
+  m_badContext.assign (N_NODES, 0);
+  Log reference;
+  Time referenceEnd = RunRing ("ns3::DefaultSimulatorImpl", reference);
+  Log serial;
+  uint32_t threads = m_threads;
+  m_threads = 1;
+  Time serialEnd = RunRing ("ns3::MultithreadedSimulatorImpl", serial);
+  m_threads = threads;
+  Log parallel;
+  Time parallelEnd = RunRing ("ns3::MultithreadedSimulatorImpl", parallel);
+
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  NS_TEST_ASSERT_MSG_EQ (referenceEnd, MilliSeconds (1), "Bad stop time");
+  NS_TEST_ASSERT_MSG_EQ (serialEnd, MilliSeconds (1), "Bad stop time");
+  NS_TEST_ASSERT_MSG_EQ (parallelEnd, MilliSeconds (1), "Bad stop time");
+  for (uint32_t node = 0; node < N_NODES; ++node)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_badContext[node], 0, "Bad context on node " << node);
+      // the order of simultaneous events is deterministic but differs
+      // from DefaultSimulatorImpl
+      std::vector<Record> sorted = parallel[node];
+      std::sort (sorted.begin (), sorted.end ());
+      std::sort (reference[node].begin (), reference[node].end ());
+      NS_TEST_EXPECT_MSG_EQ (reference[node].size (), sorted.size (), "Bad event count on node " << node);
+      NS_TEST_EXPECT_MSG_EQ ((reference[node] == sorted), true, "Bad events on node " << node);
+      NS_TEST_EXPECT_MSG_EQ ((serial[node] == parallel[node]), true, "Non deterministic events on node " << node);
+    }
+}
+
+/**
+ * \ingroup simulator-tests
+ *
+ * Check the lookahead derived from the channels when no channel exists.
+ */
+class MultithreadedSimulatorSequentialTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorSequentialTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Schedule an event on another node at the same time.
+   * \param node The node.
+   * \param count Remaining events.
+   */
+  void Hop (uint32_t node, uint32_t count);
+
+  uint32_t m_hops;  ///< Number of hops done.
+};
+
+MultithreadedSimulatorSequentialTestCase::MultithreadedSimulatorSequentialTestCase ()
+  : TestCase ("Check that partitions without lookahead run one after the other"),
+    m_hops (0)
+{}
+
+void
+MultithreadedSimulatorSequentialTestCase::Hop (uint32_t node, uint32_t count)
+{
+  m_hops++;
+  if (count > 0)
+    {
+      Simulator::ScheduleWithContext (node + 1, Seconds (0),
+                                      &MultithreadedSimulatorSequentialTestCase::Hop, this,
+                                      node + 1, count - 1);
+    }
+}
+
+void
+MultithreadedSimulatorSequentialTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Threads", UintegerValue (4));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (4));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (0)));
+  Simulator::ScheduleWithContext (0, Seconds (1), &MultithreadedSimulatorSequentialTestCase::Hop, this, 0, 99);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_hops, 100, "Lost events");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (1), "Bad time");
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * \ingroup simulator-tests
+ *
+ * Cancel and remove events of another partition while partitions run
+ * in parallel, and check that event uids are unique.
+ */
+class MultithreadedSimulatorCrossPartitionTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorCrossPartitionTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Schedule the events of node 0. */
+  void Setup (void);
+  /**
+   * Schedule local events and record their uids.
+   * \param node The node.
+   */
+  void Local (uint32_t node);
+  /** Cancel and remove events of node 0 from node 1. */
+  void Cross (void);
+  /** Check the events of node 0 from node 0. */
+  void Check (void);
+  /**
+   * An event of node 0.
+   * \param index The event index.
+   */
+  void Mark (uint32_t index);
+  /** An empty event. */
+  static void Nothing (void);
+
+  EventId m_cancelled;                 ///< Event cancelled by node 1.
+  EventId m_removed;                   ///< Event removed by node 1.
+  EventId m_kept;                      ///< Event left alone.
+  EventId m_early;                     ///< Event before the window of node 1.
+  bool m_ran[4];                       ///< Whether each event of node 0 ran.
+  bool m_earlyExpired;                 ///< m_early as seen from node 1.
+  bool m_expired[3];                   ///< The other events as seen from node 0 after Cross.
+  std::vector<std::vector<uint32_t> > m_uids;  ///< Event uids, per node.
+};
+
+/// Number of nodes, one per partition.
+static const uint32_t N_CROSS_NODES = 4;
+
+MultithreadedSimulatorCrossPartitionTestCase::MultithreadedSimulatorCrossPartitionTestCase ()
+  : TestCase ("Check Cancel and Remove across partitions and unique event uids"),
+    m_earlyExpired (false)
+{}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Nothing (void)
+{}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Mark (uint32_t index)
+{
+  m_ran[index] = true;
+}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Setup (void)
+{
+  m_cancelled = Simulator::Schedule (MicroSeconds (100), &MultithreadedSimulatorCrossPartitionTestCase::Mark, this, 0);
+  m_removed = Simulator::Schedule (MicroSeconds (100), &MultithreadedSimulatorCrossPartitionTestCase::Mark, this, 1);
+  m_kept = Simulator::Schedule (MicroSeconds (100), &MultithreadedSimulatorCrossPartitionTestCase::Mark, this, 2);
+  m_early = Simulator::Schedule (MicroSeconds (5), &MultithreadedSimulatorCrossPartitionTestCase::Mark, this, 3);
+  m_uids[0].push_back (m_cancelled.GetUid ());
+  m_uids[0].push_back (m_removed.GetUid ());
+  m_uids[0].push_back (m_kept.GetUid ());
+  m_uids[0].push_back (m_early.GetUid ());
+}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Local (uint32_t node)
+{
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      EventId id = Simulator::Schedule (NanoSeconds (i), &MultithreadedSimulatorCrossPartitionTestCase::Nothing);
+      m_uids[node].push_back (id.GetUid ());
+    }
+}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Cross (void)
+{
+  // node 0 runs in parallel: m_early is before the window, the others
+  // are after it
+  m_earlyExpired = m_early.IsExpired ();
+  m_cancelled.Cancel ();
+  Simulator::Remove (m_removed);
+}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::Check (void)
+{
+  m_expired[0] = m_cancelled.IsExpired ();
+  m_expired[1] = m_removed.IsExpired ();
+  m_expired[2] = m_kept.IsExpired ();
+}
+
+void
+MultithreadedSimulatorCrossPartitionTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Threads", UintegerValue (N_CROSS_NODES));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (N_CROSS_NODES));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MicroSeconds (10)));
+  std::fill (m_ran, m_ran + 4, false);
+  std::fill (m_expired, m_expired + 3, false);
+  m_uids.assign (N_CROSS_NODES, std::vector<uint32_t> ());
+
+  Simulator::ScheduleWithContext (0, Seconds (0), &MultithreadedSimulatorCrossPartitionTestCase::Setup, this);
+  for (uint32_t node = 0; node < N_CROSS_NODES; ++node)
+    {
+      Simulator::ScheduleWithContext (node, Seconds (0), &MultithreadedSimulatorCrossPartitionTestCase::Local, this, node);
+    }
+  Simulator::ScheduleWithContext (1, MicroSeconds (20), &MultithreadedSimulatorCrossPartitionTestCase::Cross, this);
+  Simulator::ScheduleWithContext (0, MicroSeconds (50), &MultithreadedSimulatorCrossPartitionTestCase::Check, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  NS_TEST_EXPECT_MSG_EQ (m_earlyExpired, true, "Event before the window not expired");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[0], true, "Cancel from another partition not applied");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[1], true, "Remove from another partition not applied");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[2], false, "Untouched event expired");
+  NS_TEST_EXPECT_MSG_EQ (m_ran[0], false, "Event cancelled from another partition ran");
+  NS_TEST_EXPECT_MSG_EQ (m_ran[1], false, "Event removed from another partition ran");
+  NS_TEST_EXPECT_MSG_EQ (m_ran[2], true, "Untouched event did not run");
+  NS_TEST_EXPECT_MSG_EQ (m_ran[3], true, "Early event did not run");
+
+  std::vector<uint32_t> uids;
+  for (uint32_t node = 0; node < N_CROSS_NODES; ++node)
+    {
+      uids.insert (uids.end (), m_uids[node].begin (), m_uids[node].end ());
+    }
+  std::sort (uids.begin (), uids.end ());
+  bool unique = std::adjacent_find (uids.begin (), uids.end ()) == uids.end ();
+  NS_TEST_EXPECT_MSG_EQ (uids.size (), 44, "Lost uids");
+  NS_TEST_EXPECT_MSG_EQ (unique, true, "Same uid given out by two partitions");
+}
+
+/**
+ * \ingroup simulator-tests
+ *
+ * Stop the simulation from a node while partitions run in parallel.
+ */
+class MultithreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param threads Number of threads.
+   * \param delayed Call Simulator::Stop with a delay.
+   */
+  MultithreadedSimulatorStopTestCase (uint32_t threads, bool delayed);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Tick every microsecond; node 0 stops the simulation at 25us.
+   * \param node The node.
+   */
+  void Tick (uint32_t node);
+
+  uint32_t m_threads;                  ///< Number of threads.
+  bool m_delayed;                      ///< Stop with a delay.
+  std::vector<uint32_t> m_ticks;       ///< Ticks per node.
+};
+
+MultithreadedSimulatorStopTestCase::MultithreadedSimulatorStopTestCase (uint32_t threads, bool delayed)
+  : TestCase ("Check that Stop" + std::string (delayed ? " with a delay" : "") + " from a node is deterministic with "
+              + std::to_string (threads) + " threads"),
+    m_threads (threads),
+    m_delayed (delayed)
+{}
+
+void
+MultithreadedSimulatorStopTestCase::Tick (uint32_t node)
+{
+  m_ticks[node]++;
+  if (node == 0 && Simulator::Now () == MicroSeconds (25))
+    {
+      if (m_delayed)
+        {
+          Simulator::Stop (MicroSeconds (15));
+        }
+      else
+        {
+          Simulator::Stop ();
+        }
+    }
+  Simulator::Schedule (MicroSeconds (1), &MultithreadedSimulatorStopTestCase::Tick, this, node);
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Threads", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (4));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MicroSeconds (10)));
+  m_ticks.assign (4, 0);
+  for (uint32_t node = 0; node < 4; ++node)
+    {
+      Simulator::ScheduleWithContext (node, Seconds (0), &MultithreadedSimulatorStopTestCase::Tick, this, node);
+    }
+  Simulator::Stop (MilliSeconds (1));
+  Simulator::Run ();
+  Time end = Simulator::Now ();
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  // Stop() at 25us ends the window [20us, 30us); Stop(15us) is a public
+  // event at 40us, which runs before the events of the nodes at 40us
+  uint32_t ticks = m_delayed ? 40 : 30;
+  NS_TEST_EXPECT_MSG_EQ (end, MicroSeconds (ticks - (m_delayed ? 0 : 1)), "Bad stop time");
+  for (uint32_t node = 0; node < 4; ++node)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ticks[node], ticks, "Node " << node << " did not stop with the others");
+    }
+}
+
+/**
+ * \ingroup simulator-tests
+ *
+ * MultithreadedSimulatorImpl test suite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorRingTestCase (2, 2), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (4, 4), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (4, 16), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorSequentialTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorCrossPartitionTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase (1, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase (4, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase (4, true), TestCase::QUICK);
+  }
+};
+
+/// Static variable for test initialization
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite;
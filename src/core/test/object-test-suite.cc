@@ -400,6 +400,21 @@ AggregateObjectTestCase::DoRun (void)
 
   baseA = baseB->GetObject<BaseA> ();
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
+
+  //
+  // Failed lookups are cached too: make sure aggregating an object of the
+  // type looked up makes it visible, through either side of the aggregation.
+  //
+  baseA = CreateObject<BaseA> ();
+  baseB = CreateObject<DerivedB> ();
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB through baseA");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB through baseA");
+  NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (), 0, "Unexpectedly found a BaseA through baseB");
+  baseA->AggregateObject (baseB);
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), baseB, "Cannot GetObject (through baseA) for BaseB Object");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), baseB, "Cannot GetObject (through baseA) for DerivedB Object");
+  NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (), baseA, "Cannot GetObject (through baseB) for BaseA Object");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedA> (), 0, "Unexpectedly found a DerivedA through baseA");
 }
 
 /**
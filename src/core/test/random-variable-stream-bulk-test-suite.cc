@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup randomvariable
+ * \ingroup randomvariable-tests
+ * RandomVariableStream::GetValues test suite.
+ */
+
+namespace ns3 {
+
+namespace tests {
+
+
+/**
+ * \ingroup randomvariable-tests
+ * Check that RandomVariableStream::GetValues gives the same values as
+ * GetValue, and leaves the stream in the same state.
+ */
+class RandomVariableStreamBulkTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] factory The factory of the random variable, with its attributes.
+   * \param [in] name The name of the test case.
+   */
+  RandomVariableStreamBulkTestCase (ObjectFactory factory, std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Create a random variable on a fixed stream.
+   * \param [in] antithetic Whether to generate antithetic values.
+   * \returns The random variable.
+   */
+  Ptr<RandomVariableStream> Create (bool antithetic) const;
+
+  ObjectFactory m_factory;  //!< The factory of the random variable.
+};
+
+RandomVariableStreamBulkTestCase::RandomVariableStreamBulkTestCase (ObjectFactory factory, std::string name)
+  : TestCase ("Check GetValues against GetValue for " + name),
+    m_factory (factory)
+{}
+
+Ptr<RandomVariableStream>
+RandomVariableStreamBulkTestCase::Create (bool antithetic) const
+{
+  Ptr<RandomVariableStream> rv = m_factory.Create<RandomVariableStream> ();
+  rv->SetStream (17);
+  rv->SetAntithetic (antithetic);
+  return rv;
+}
+
+void
+RandomVariableStreamBulkTestCase::DoRun (void)
+{
+  // Sizes of the batches, including empty and odd ones.
+  const std::size_t sizes[] = {1, 0, 2, 7, 1, 64, 129, 1000, 3};
+
+  for (int antithetic = 0; antithetic < 2; ++antithetic)
+    {
+      Ptr<RandomVariableStream> scalar = Create (antithetic);
+      Ptr<RandomVariableStream> bulk = Create (antithetic);
+      std::vector<double> values;
+      for (std::size_t size : sizes)
+        {
+          values.assign (size, 0);
+          bulk->GetValues (values.data (), size);
+          for (std::size_t i = 0; i < size; ++i)
+            {
+              NS_TEST_ASSERT_MSG_EQ (values[i], scalar->GetValue (),
+                                     "Different value " << i << " of " << size
+                                     << " antithetic " << antithetic);
+            }
+          // interleaved calls must see the same stream
+          NS_TEST_ASSERT_MSG_EQ (bulk->GetValue (), scalar->GetValue (),
+                                 "Different stream after " << size << " values"
+                                 << " antithetic " << antithetic);
+        }
+    }
+}
+
+
+/**
+ * \ingroup randomvariable-tests
+ * RandomVariableStream::GetValues test suite.
+ */
+class RandomVariableStreamBulkTestSuite : public TestSuite
+{
+public:
+  /** Constructor. */
+  RandomVariableStreamBulkTestSuite ();
+
+private:
+  /**
+   * Add a test case.
+   * \param [in] tid The random variable TypeId name.
+   * \param [in] n1 The name of an attribute, or empty.
+   * \param [in] v1 The value of attribute \pname{n1}.
+   * \param [in] n2 The name of another attribute, or empty.
+   * \param [in] v2 The value of attribute \pname{n2}.
+   */
+  void Add (std::string tid,
+            std::string n1 = "", double v1 = 0,
+            std::string n2 = "", double v2 = 0);
+};
+
+void
+RandomVariableStreamBulkTestSuite::Add (std::string tid,
+                                        std::string n1, double v1,
+                                        std::string n2, double v2)
+{
+  ObjectFactory factory (tid);
+  std::string name = tid;
+  if (!n1.empty ())
+    {
+      factory.Set (n1, DoubleValue (v1));
+      name += " " + n1 + "=" + std::to_string (v1);
+    }
+  if (!n2.empty ())
+    {
+      factory.Set (n2, DoubleValue (v2));
+      name += " " + n2 + "=" + std::to_string (v2);
+    }
+  AddTestCase (new RandomVariableStreamBulkTestCase (factory, name), TestCase::QUICK);
+}
+
+RandomVariableStreamBulkTestSuite::RandomVariableStreamBulkTestSuite ()
+  : TestSuite ("random-variable-stream-bulk", UNIT)
+{
+  Add ("ns3::UniformRandomVariable", "Min", -3, "Max", 5);
+  Add ("ns3::ExponentialRandomVariable");
+  // bounds low enough to reject many values
+  Add ("ns3::ExponentialRandomVariable", "Mean", 2, "Bound", 1);
+  Add ("ns3::ParetoRandomVariable", "Scale", 1, "Shape", 2);
+  Add ("ns3::ParetoRandomVariable", "Bound", 1.5);
+  Add ("ns3::WeibullRandomVariable", "Scale", 2, "Shape", 1.5);
+  Add ("ns3::WeibullRandomVariable", "Bound", 0.5);
+  Add ("ns3::NormalRandomVariable", "Mean", 3, "Variance", 4);
+  Add ("ns3::NormalRandomVariable", "Variance", 4, "Bound", 1);
+  // uses RandomVariableStream::GetValues
+  Add ("ns3::GammaRandomVariable", "Alpha", 2, "Beta", 3);
+}
+
+/**
+ * \ingroup randomvariable-tests
+ * RandomVariableStreamBulkTestSuite instance variable.
+ */
+static RandomVariableStreamBulkTestSuite g_randomVariableStreamBulkTestSuite;
+
+
+}  // namespace tests
+
+}  // namespace ns3
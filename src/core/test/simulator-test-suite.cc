@@ -24,6 +24,7 @@
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
 #include "ns3/priority-queue-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 
 using namespace ns3;
 
@@ -170,6 +171,60 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+/**
+ * Check that a LadderScheduler rung spawned from an overgrown Bottom
+ * covers all of Bottom's range, so that later inserts between its last
+ * event and the next rung land within its buckets.
+ */
+class LadderSchedulerBottomRungTestCase : public TestCase
+{
+public:
+  LadderSchedulerBottomRungTestCase ();
+  virtual void DoRun (void);
+  void Insert (uint64_t ts);
+  Ptr<LadderScheduler> m_scheduler;
+  uint32_t m_uid;
+};
+
+LadderSchedulerBottomRungTestCase::LadderSchedulerBottomRungTestCase ()
+  : TestCase ("Check inserts past the events of a rung spawned from Bottom in ns3::LadderScheduler"),
+    m_uid (0)
+{}
+void
+LadderSchedulerBottomRungTestCase::Insert (uint64_t ts)
+{
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_ts = ts;
+  ev.key.m_uid = m_uid++;
+  ev.key.m_context = 0;
+  m_scheduler->Insert (ev);
+}
+void
+LadderSchedulerBottomRungTestCase::DoRun (void)
+{
+  m_scheduler = CreateObject<LadderScheduler> ();
+  Insert (0);
+  Insert (1000000);
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->RemoveNext ().key.m_ts, 0, "wrong first event");
+  // more than Threshold events overflow Bottom into a new rung
+  for (uint64_t ts = 10; ts < 70; ts++)
+    {
+      Insert (ts);
+    }
+  Insert (100000);
+  Insert (200000);
+  for (uint64_t ts = 10; ts < 70; ts++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_scheduler->RemoveNext ().key.m_ts, ts, "wrong event order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->RemoveNext ().key.m_ts, 100000, "wrong event order");
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->RemoveNext ().key.m_ts, 200000, "wrong event order");
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->RemoveNext ().key.m_ts, 1000000, "wrong event order");
+  NS_TEST_EXPECT_MSG_EQ (m_scheduler->IsEmpty (), true, "scheduler should be empty");
+  m_scheduler = 0;
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -483,5 +538,8 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (PriorityQueueScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new LadderSchedulerBottomRungTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
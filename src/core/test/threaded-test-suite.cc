@@ -23,6 +23,7 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
@@ -40,7 +41,8 @@ using namespace ns3;
 class ThreadedSimulatorEventsTestCase : public TestCase
 {
 public:
-  ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads);
+  ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads,
+                                   const std::string &inbox = "");
   void EventA (int a);
   void EventB (int b);
   void EventC (int c);
@@ -57,6 +59,7 @@ public:
   bool m_stop;
   ObjectFactory m_schedulerFactory;
   std::string m_simulatorType;
+  std::string m_inbox;
   std::string m_error;
   std::list<Ptr<SystemThread> > m_threadlist;
 
@@ -66,14 +69,16 @@ private:
   virtual void DoTeardown (void);
 };
 
-ThreadedSimulatorEventsTestCase::ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads)
+ThreadedSimulatorEventsTestCase::ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads,
+                                                                  const std::string &inbox)
   : TestCase ("Check threaded event handling with " +
               std::to_string (threads) + " threads, " +
               schedulerFactory.GetTypeId ().GetName () + " scheduler, in " +
-              simulatorType),
+              simulatorType + (inbox.empty () ? "" : " with " + inbox + " inbox")),
     m_threads (threads),
     m_schedulerFactory (schedulerFactory),
-    m_simulatorType (simulatorType)
+    m_simulatorType (simulatorType),
+    m_inbox (inbox)
 {}
 
 void
@@ -178,6 +183,10 @@ ThreadedSimulatorEventsTestCase::DoSetup (void)
     {
       Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
     }
+  if (!m_inbox.empty ())
+    {
+      Config::SetDefault ("ns3::DefaultSimulatorImpl::Inbox", StringValue (m_inbox));
+    }
 
   m_error = "";
 
@@ -200,6 +209,7 @@ ThreadedSimulatorEventsTestCase::DoTeardown (void)
   m_threadlist.clear ();
 
   Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::Inbox", StringValue ("LockFree"));
 }
 void
 ThreadedSimulatorEventsTestCase::DoRun (void)
@@ -241,7 +251,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +273,14 @@ public:
               }
           }
       }
+    // the default inbox is LockFree, also cover the mutex-protected one
+    for (unsigned int j = 0; j < (sizeof(threadcounts) / sizeof(threadcounts[0])); ++j)
+      {
+        for (unsigned int k = 0; k < (sizeof(schedulerTypes) / sizeof(schedulerTypes[0])); ++k)
+          {
+            factory.SetTypeId (schedulerTypes[k]);
+            AddTestCase (new ThreadedSimulatorEventsTestCase (factory, "ns3::DefaultSimulatorImpl", threadcounts[j], "Locked"), TestCase::QUICK);
+          }
+      }
   }
 } g_threadedSimulatorTestSuite;
@@ -334,6 +334,105 @@ DeprecatedAttributeTestCase::DoRun (void)
 }
 
 
+//----------------------------
+//
+// Inherited Attribute and TraceSource lookup test
+
+class InheritedLookupTestCase : public TestCase
+{
+public:
+  InheritedLookupTestCase ();
+  virtual ~InheritedLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+InheritedLookupTestCase::InheritedLookupTestCase ()
+  : TestCase ("Check lookup of inherited Attributes and TraceSources")
+{}
+
+InheritedLookupTestCase::~InheritedLookupTestCase ()
+{}
+
+void
+InheritedLookupTestCase::DoRun (void)
+{
+  // Every attribute and trace source of a type or of its parents
+  // can be found by name, and the closest one wins.
+  uint32_t nids = TypeId::GetRegisteredN ();
+  for (uint16_t i = 0; i < nids; ++i)
+    {
+      const TypeId tid = TypeId::GetRegistered (i);
+      TypeId cur = tid;
+      while (true)
+        {
+          for (std::size_t j = 0; j < cur.GetAttributeN (); ++j)
+            {
+              struct TypeId::AttributeInformation expected = cur.GetAttribute (j);
+              if (expected.supportLevel != TypeId::SUPPORTED)
+                {
+                  continue;
+                }
+              struct TypeId::AttributeInformation info;
+              NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName (expected.name, &info), true,
+                                     "Attribute " << expected.name << " not found on " << tid.GetName ());
+              NS_TEST_ASSERT_MSG_EQ (info.accessor, expected.accessor,
+                                     "Wrong Attribute " << expected.name << " on " << tid.GetName ());
+            }
+          for (std::size_t j = 0; j < cur.GetTraceSourceN (); ++j)
+            {
+              struct TypeId::TraceSourceInformation expected = cur.GetTraceSource (j);
+              if (expected.supportLevel != TypeId::SUPPORTED)
+                {
+                  continue;
+                }
+              struct TypeId::TraceSourceInformation info;
+              NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName (expected.name, &info), expected.accessor,
+                                     "Wrong TraceSource " << expected.name << " on " << tid.GetName ());
+            }
+          // types registered without a parent have uid 0 as parent
+          if (!cur.HasParent () || cur.GetParent ().GetUid () == 0)
+            {
+              break;
+            }
+          cur = cur.GetParent ();
+        }
+      struct TypeId::AttributeInformation info;
+      NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName ("NoSuchAttribute", &info), false,
+                             "Unexpected Attribute on " << tid.GetName ());
+      NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName ("NoSuchTraceSource"), 0,
+                             "Unexpected TraceSource on " << tid.GetName ());
+    }
+
+  // Attributes added to a parent after its children were registered
+  // are inherited too.
+  struct TypeId::AttributeInformation attribute;
+  DeprecatedAttribute::GetTypeId ().LookupAttributeByName ("attribute", &attribute);
+  TypeId parent = TypeId ("InheritedLookupParent")
+    .SetParent<Object> ();
+  TypeId child = TypeId ("InheritedLookupChild")
+    .SetParent (parent);
+  TypeId grandChild = TypeId ("InheritedLookupGrandChild")
+    .SetParent (child)
+    .AddAttribute ("grandChild", "", IntegerValue (1),
+                   attribute.accessor, attribute.checker);
+  parent.AddAttribute ("parent", "", IntegerValue (1),
+                       attribute.accessor, attribute.checker);
+  struct TypeId::AttributeInformation info;
+  NS_TEST_ASSERT_MSG_EQ (grandChild.LookupAttributeByName ("parent", &info), true,
+                         "Late parent Attribute not inherited");
+  NS_TEST_ASSERT_MSG_EQ (grandChild.LookupAttributeByName ("grandChild", &info), true,
+                         "Own Attribute not found");
+  NS_TEST_ASSERT_MSG_EQ (parent.LookupAttributeByName ("grandChild", &info), false,
+                         "Child Attribute found on parent");
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByName ("InheritedLookupChild"), child,
+                         "New TypeId not found by name");
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByHash (child.GetHash ()), child,
+                         "New TypeId not found by hash");
+}
+
+
 //----------------------------
 //
 // Performance test
@@ -447,6 +546,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
   AddTestCase (new DeprecatedAttributeTestCase, QUICK);
+  AddTestCase (new InheritedLookupTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "spatial-index.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/callback.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SpatialIndex");
+
+bool
+SpatialIndex::Cell::operator < (const Cell &o) const
+{
+  if (x != o.x)
+    {
+      return x < o.x;
+    }
+  if (y != o.y)
+    {
+      return y < o.y;
+    }
+  return z < o.z;
+}
+
+SpatialIndex::SpatialIndex (double cellSize)
+  : m_cellSize (cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+}
+
+SpatialIndex::~SpatialIndex ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+SpatialIndex::Reset (double cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+  Clear ();
+  m_cellSize = cellSize;
+}
+
+double
+SpatialIndex::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+void
+SpatialIndex::Add (uint32_t id, Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << id << mobility);
+  if (mobility == 0)
+    {
+      m_unplaced.push_back (id);
+      return;
+    }
+  std::pair<EntryMap::iterator, bool> ret =
+    m_entries.insert (std::make_pair (PeekPointer (mobility), Entry ()));
+  struct Entry &entry = ret.first->second;
+  if (ret.second)
+    {
+      entry.mobility = mobility;
+      Insert (entry);
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&SpatialIndex::CourseChanged, this));
+    }
+  entry.ids.push_back (id);
+}
+
+void
+SpatialIndex::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (EntryMap::iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      i->second.mobility->TraceDisconnectWithoutContext ("CourseChange",
+                                                         MakeCallback (&SpatialIndex::CourseChanged, this));
+    }
+  m_entries.clear ();
+  m_cells.clear ();
+  m_moving.clear ();
+  m_unplaced.clear ();
+}
+
+bool
+SpatialIndex::IsEmpty (void) const
+{
+  return m_entries.empty () && m_unplaced.empty ();
+}
+
+void
+SpatialIndex::GetInRange (const Vector &position, double range, std::vector<uint32_t> &ids) const
+{
+  NS_LOG_FUNCTION (this << position << range);
+  ids.assign (m_unplaced.begin (), m_unplaced.end ());
+
+  Cell low = GetCell (Vector (position.x - range, position.y - range, position.z - range));
+  Cell high = GetCell (Vector (position.x + range, position.y + range, position.z + range));
+  double nCells = double (high.x - low.x + 1) * double (high.y - low.y + 1) * double (high.z - low.z + 1);
+  std::vector<const struct Entry *> candidates (m_moving);
+  if (nCells > m_cells.size ())
+    {
+      // the range spans more cells than are occupied
+      for (CellMap::const_iterator i = m_cells.begin (); i != m_cells.end (); ++i)
+        {
+          candidates.insert (candidates.end (), i->second.begin (), i->second.end ());
+        }
+    }
+  else
+    {
+      Cell cell;
+      for (cell.x = low.x; cell.x <= high.x; ++cell.x)
+        {
+          for (cell.y = low.y; cell.y <= high.y; ++cell.y)
+            {
+              for (cell.z = low.z; cell.z <= high.z; ++cell.z)
+                {
+                  CellMap::const_iterator i = m_cells.find (cell);
+                  if (i != m_cells.end ())
+                    {
+                      candidates.insert (candidates.end (), i->second.begin (), i->second.end ());
+                    }
+                }
+            }
+        }
+    }
+
+  for (std::vector<const struct Entry *>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      const struct Entry *entry = *i;
+      Vector other = entry->moving ? entry->mobility->GetPosition () : entry->position;
+      if (CalculateDistance (position, other) <= range)
+        {
+          ids.insert (ids.end (), entry->ids.begin (), entry->ids.end ());
+        }
+    }
+  std::sort (ids.begin (), ids.end ());
+}
+
+SpatialIndex::Cell
+SpatialIndex::GetCell (const Vector &position) const
+{
+  Cell cell;
+  cell.x = static_cast<int64_t> (std::floor (position.x / m_cellSize));
+  cell.y = static_cast<int64_t> (std::floor (position.y / m_cellSize));
+  cell.z = static_cast<int64_t> (std::floor (position.z / m_cellSize));
+  return cell;
+}
+
+void
+SpatialIndex::Insert (struct Entry &entry)
+{
+  entry.position = entry.mobility->GetPosition ();
+  Vector velocity = entry.mobility->GetVelocity ();
+  entry.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+  if (entry.moving)
+    {
+      m_moving.push_back (&entry);
+    }
+  else
+    {
+      entry.cell = GetCell (entry.position);
+      m_cells[entry.cell].push_back (&entry);
+    }
+}
+
+void
+SpatialIndex::Erase (const struct Entry &entry)
+{
+  std::vector<const struct Entry *> *list = &m_moving;
+  CellMap::iterator cell = m_cells.end ();
+  if (!entry.moving)
+    {
+      cell = m_cells.find (entry.cell);
+      NS_ASSERT (cell != m_cells.end ());
+      list = &cell->second;
+    }
+  std::vector<const struct Entry *>::iterator i = std::find (list->begin (), list->end (), &entry);
+  NS_ASSERT (i != list->end ());
+  *i = list->back ();
+  list->pop_back ();
+  if (cell != m_cells.end () && list->empty ())
+    {
+      m_cells.erase (cell);
+    }
+}
+
+void
+SpatialIndex::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  EntryMap::iterator i = m_entries.find (PeekPointer (mobility));
+  NS_ASSERT (i != m_entries.end ());
+  Erase (i->second);
+  Insert (i->second);
+}
+
+} // namespace ns3
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include "ns3/non-copyable.h"
+#include "mobility-model.h"
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief a uniform grid of MobilityModel positions
+ *
+ * Items, identified by an integer chosen by the user, are added with
+ * the MobilityModel giving their position; several items may share a
+ * MobilityModel.  GetInRange then returns the items within a range of a
+ * position without looking at the items far from it.
+ *
+ * The grid follows the CourseChange notifications of the mobility
+ * models.  An item whose mobility model is not moving is kept in the
+ * cell of its position; an item whose mobility model is moving is kept
+ * aside, and its current position is checked on every query.  Mobility
+ * models are thus expected to notify a course change whenever they
+ * start moving or are moved, which the models of this module do.
+ *
+ * The cells are cubes whose side is the cell size, so a query looks at
+ * 27 cells when its range equals the cell size.
+ */
+class SpatialIndex : private NonCopyable
+{
+public:
+  /**
+   * Create an empty grid.
+   * \param cellSize the side of the cells, in meters.
+   */
+  SpatialIndex (double cellSize = 1000.0);
+  ~SpatialIndex ();
+
+  /**
+   * Remove all the items, and set the cell size.
+   * \param cellSize the side of the cells, in meters.
+   */
+  void Reset (double cellSize);
+  /**
+   * \returns the side of the cells, in meters.
+   */
+  double GetCellSize (void) const;
+  /**
+   * Add an item.
+   * \param id the identifier of the item.
+   * \param mobility the position of the item.  If null, the item is
+   *        returned by all the queries.
+   */
+  void Add (uint32_t id, Ptr<MobilityModel> mobility);
+  /**
+   * Remove all the items.
+   */
+  void Clear (void);
+  /**
+   * \returns true if there are no items.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * Find the items within a range of a position.
+   * \param position the center of the query.
+   * \param range the range, in meters.
+   * \param [out] ids the identifiers of the items within \p range of
+   *        \p position and of the items without position, sorted.
+   */
+  void GetInRange (const Vector &position, double range, std::vector<uint32_t> &ids) const;
+
+private:
+  /** The coordinates of a cell. */
+  struct Cell
+  {
+    int64_t x; //!< x coordinate
+    int64_t y; //!< y coordinate
+    int64_t z; //!< z coordinate
+    /**
+     * Order the cells.
+     * \param o the other cell.
+     * \returns true if this cell is lower than \p o.
+     */
+    bool operator < (const Cell &o) const;
+  };
+  /** The items which share a mobility model. */
+  struct Entry
+  {
+    Ptr<MobilityModel> mobility; //!< the mobility model
+    std::vector<uint32_t> ids;   //!< the items
+    Vector position;             //!< position at the last course change
+    bool moving;                 //!< velocity not zero at the last course change
+    Cell cell;                   //!< cell of position, unless moving
+  };
+  /** Container: mobility model, Entry */
+  typedef std::map<const MobilityModel *, struct Entry> EntryMap;
+  /** Container: cell, entries in the cell */
+  typedef std::map<Cell, std::vector<const struct Entry *> > CellMap;
+
+  /**
+   * \param position a position.
+   * \returns the cell of \p position.
+   */
+  Cell GetCell (const Vector &position) const;
+  /**
+   * Put an entry in the grid, or in the moving entries.
+   * \param entry the entry.
+   */
+  void Insert (struct Entry &entry);
+  /**
+   * Take an entry out of the grid, or out of the moving entries.
+   * \param entry the entry.
+   */
+  void Erase (const struct Entry &entry);
+  /**
+   * Follow the course change of a mobility model.
+   * \param mobility the mobility model.
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  double m_cellSize;                              //!< side of the cells
+  EntryMap m_entries;                             //!< entries by mobility model
+  CellMap m_cells;                                //!< entries not moving, by cell
+  std::vector<const struct Entry *> m_moving;     //!< entries moving
+  std::vector<uint32_t> m_unplaced;               //!< items without mobility model
+};
+
+} // namespace ns3
+
+#endif /* SPATIAL_INDEX_H */
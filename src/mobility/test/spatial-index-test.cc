@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/spatial-index.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief SpatialIndex queries against a linear scan of static positions
+ */
+class SpatialIndexStaticTest : public TestCase
+{
+public:
+  SpatialIndexStaticTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SpatialIndexStaticTest::SpatialIndexStaticTest ()
+  : TestCase ("Check SpatialIndex queries against a linear scan")
+{
+}
+
+void
+SpatialIndexStaticTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  u->SetStream (5);
+  u->SetAttribute ("Min", DoubleValue (-500));
+  u->SetAttribute ("Max", DoubleValue (500));
+
+  std::vector<Ptr<MobilityModel> > models;
+  SpatialIndex index (100);
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      Ptr<MobilityModel> model = CreateObject<ConstantPositionMobilityModel> ();
+      model->SetPosition (Vector (u->GetValue (), u->GetValue (), u->GetValue () / 10));
+      models.push_back (model);
+      index.Add (i, model);
+    }
+  // an item without position, and an item sharing a position
+  index.Add (500, 0);
+  index.Add (501, models[7]);
+
+  const double ranges[] = {10, 100, 250, 5000};
+  for (double range : ranges)
+    {
+      for (uint32_t q = 0; q < 20; ++q)
+        {
+          Vector center (u->GetValue (), u->GetValue (), 0);
+          std::vector<uint32_t> expected;
+          for (uint32_t i = 0; i < models.size (); ++i)
+            {
+              if (CalculateDistance (center, models[i]->GetPosition ()) <= range)
+                {
+                  expected.push_back (i);
+                }
+            }
+          expected.push_back (500);
+          if (CalculateDistance (center, models[7]->GetPosition ()) <= range)
+            {
+              expected.push_back (501);
+            }
+          std::vector<uint32_t> found;
+          index.GetInRange (center, range, found);
+          NS_TEST_ASSERT_MSG_EQ (found.size (), expected.size (), "Wrong number of items in range " << range);
+          NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Wrong items in range " << range);
+        }
+    }
+}
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief SpatialIndex following course changes
+ */
+class SpatialIndexCourseChangeTest : public TestCase
+{
+public:
+  SpatialIndexCourseChangeTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the items within 10 m of a position.
+   * \param position the position
+   * \param expected the number of items expected
+   */
+  void Check (Vector position, std::size_t expected);
+
+  SpatialIndex m_index; //!< the index under test
+};
+
+SpatialIndexCourseChangeTest::SpatialIndexCourseChangeTest ()
+  : TestCase ("Check SpatialIndex following course changes"),
+    m_index (10)
+{
+}
+
+void
+SpatialIndexCourseChangeTest::Check (Vector position, std::size_t expected)
+{
+  std::vector<uint32_t> found;
+  m_index.GetInRange (position, 10, found);
+  NS_TEST_EXPECT_MSG_EQ (found.size (), expected, "Wrong number of items near " << position
+                         << " at " << Simulator::Now ().As (Time::S));
+}
+
+void
+SpatialIndexCourseChangeTest::DoRun (void)
+{
+  Ptr<ConstantPositionMobilityModel> fixed = CreateObject<ConstantPositionMobilityModel> ();
+  fixed->SetPosition (Vector (0, 0, 0));
+  Ptr<ConstantVelocityMobilityModel> mobile = CreateObject<ConstantVelocityMobilityModel> ();
+  mobile->SetPosition (Vector (1000, 0, 0));
+  m_index.Add (0, fixed);
+  m_index.Add (1, mobile);
+
+  Check (Vector (0, 0, 0), 1);
+  Check (Vector (1000, 0, 0), 1);
+
+  // a static model moved
+  fixed->SetPosition (Vector (500, 500, 0));
+  Check (Vector (0, 0, 0), 0);
+  Check (Vector (500, 505, 0), 1);
+
+  // a model starting to move is found where it is
+  mobile->SetVelocity (Vector (-100, 0, 0));
+  Simulator::Schedule (Seconds (5), &SpatialIndexCourseChangeTest::Check, this, Vector (500, 0, 0), 1);
+  Simulator::Schedule (Seconds (5), &SpatialIndexCourseChangeTest::Check, this, Vector (1000, 0, 0), 0);
+  Simulator::Schedule (Seconds (6), &ConstantVelocityMobilityModel::SetVelocity, mobile, Vector (0, 0, 0));
+  Simulator::Schedule (Seconds (7), &SpatialIndexCourseChangeTest::Check, this, Vector (400, 0, 0), 1);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  m_index.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (m_index.IsEmpty (), true, "Index not empty after Clear");
+  fixed->SetPosition (Vector (0, 0, 0));
+  Check (Vector (0, 0, 0), 0);
+}
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief SpatialIndex Test Suite
+ */
+class SpatialIndexTestSuite : public TestSuite
+{
+public:
+  SpatialIndexTestSuite ();
+};
+
+SpatialIndexTestSuite::SpatialIndexTestSuite ()
+  : TestSuite ("spatial-index", UNIT)
+{
+  AddTestCase (new SpatialIndexStaticTest, TestCase::QUICK);
+  AddTestCase (new SpatialIndexCourseChangeTest, TestCase::QUICK);
+}
+
+static SpatialIndexTestSuite g_spatialIndexTestSuite; ///< the test suite
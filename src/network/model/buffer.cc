@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "packet-allocator.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -51,98 +52,6 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
-
-void
-Buffer::Recycle (struct Buffer::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
-}
-
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
-{
-  NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
-}
-#else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -157,7 +66,6 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -168,10 +76,15 @@ Buffer::Allocate (uint32_t reqSize)
       reqSize = 1;
     }
   NS_ASSERT (reqSize >= 1);
-  uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
-  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  std::size_t size = reqSize - 1 + sizeof (struct Buffer::Data);
+#ifdef BUFFER_FREE_LIST
+  /* the block of the size class may hold more than requested */
+  void *b = PacketAllocator::Allocate (size);
+#else /* BUFFER_FREE_LIST */
+  void *b = ::operator new (size);
+#endif /* BUFFER_FREE_LIST */
+  struct Buffer::Data *data = static_cast<struct Buffer::Data*>(b);
+  data->m_size = static_cast<uint32_t> (size + 1 - sizeof (struct Buffer::Data));
   data->m_count = 1;
   return data;
 }
@@ -181,8 +94,88 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+#ifdef BUFFER_FREE_LIST
+  PacketAllocator::Deallocate (data, data->m_size - 1 + sizeof (struct Buffer::Data));
+#else /* BUFFER_FREE_LIST */
+  ::operator delete (data);
+#endif /* BUFFER_FREE_LIST */
+}
+
+struct Buffer::Chain *
+Buffer::CreateChain (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  NS_ASSERT (n >= 1);
+  std::size_t size = sizeof (struct Buffer::Chain) + (n - 1) * sizeof (struct Buffer::Segment);
+#ifdef BUFFER_FREE_LIST
+  void *b = PacketAllocator::Allocate (size);
+#else /* BUFFER_FREE_LIST */
+  void *b = ::operator new (size);
+#endif /* BUFFER_FREE_LIST */
+  struct Buffer::Chain *chain = static_cast<struct Buffer::Chain *> (b);
+  chain->m_count = 1;
+  chain->m_n = 0;
+  chain->m_capacity = n;
+  chain->m_size = 0;
+  return chain;
+}
+
+void
+Buffer::AppendSegment (struct Buffer::Chain *chain, const struct Buffer::Segment &segment)
+{
+  NS_LOG_FUNCTION (chain);
+  uint32_t size = segment.m_end - segment.m_start;
+  if (size == 0)
+    {
+      return;
+    }
+  NS_ASSERT (chain->m_n < chain->m_capacity);
+  struct Buffer::Segment *last = &chain->m_segments[chain->m_n];
+  *last = segment;
+  last->m_offset = chain->m_size;
+  last->m_data->m_count++;
+  chain->m_size += size;
+  chain->m_n++;
+}
+
+void
+Buffer::ReleaseChain (struct Buffer::Chain *chain)
+{
+  NS_LOG_FUNCTION (chain);
+  chain->m_count--;
+  if (chain->m_count > 0)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < chain->m_n; i++)
+    {
+      struct Buffer::Data *data = chain->m_segments[i].m_data;
+      data->m_count--;
+      if (data->m_count == 0)
+        {
+          Recycle (data);
+        }
+    }
+#ifdef BUFFER_FREE_LIST
+  PacketAllocator::Deallocate (chain, sizeof (struct Buffer::Chain) +
+                               (chain->m_capacity - 1) * sizeof (struct Buffer::Segment));
+#else /* BUFFER_FREE_LIST */
+  ::operator delete (chain);
+#endif /* BUFFER_FREE_LIST */
+}
+
+struct Buffer::Segment
+Buffer::GetFirstSegment (void) const
+{
+  NS_LOG_FUNCTION (this);
+  struct Buffer::Segment segment;
+  segment.m_data = m_data;
+  segment.m_zeroAreaStart = m_zeroAreaStart;
+  segment.m_zeroAreaEnd = m_zeroAreaEnd;
+  segment.m_start = m_start;
+  segment.m_end = m_end;
+  segment.m_offset = 0;
+  return segment;
 }
 
 Buffer::Buffer ()
@@ -200,6 +193,7 @@ Buffer::Buffer (uint32_t dataSize)
 Buffer::Buffer (uint32_t dataSize, bool initialize)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
+  m_chain = 0;
   if (initialize == true)
     {
       Initialize (dataSize);
@@ -244,7 +238,9 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  /* reserve room for the headers which the previous buffers received */
+  m_data = Buffer::Create (g_recommendedStart);
+  m_chain = 0;
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -259,6 +255,18 @@ Buffer &
 Buffer::operator = (Buffer const&o)
 {
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != o.m_chain)
+    {
+      if (o.m_chain != 0)
+        {
+          o.m_chain->m_count++;
+        }
+      if (m_chain != 0)
+        {
+          ReleaseChain (m_chain);
+        }
+      m_chain = o.m_chain;
+    }
   if (m_data != o.m_data) 
     {
       // not assignment to self.
@@ -290,6 +298,10 @@ Buffer::~Buffer ()
     {
       Recycle (m_data);
     }
+  if (m_chain != 0)
+    {
+      ReleaseChain (m_chain);
+    }
 }
 
 uint32_t
@@ -355,6 +367,37 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0)
+    {
+      /* the segments of the chain are never extended: append a
+       * new segment.
+       */
+      if (end == 0)
+        {
+          return;
+        }
+      struct Buffer::Segment segment;
+      segment.m_data = Buffer::Create (end);
+      segment.m_start = 0;
+      segment.m_zeroAreaStart = end;
+      segment.m_zeroAreaEnd = end;
+      segment.m_end = end;
+      segment.m_data->m_dirtyStart = 0;
+      segment.m_data->m_dirtyEnd = end;
+      struct Buffer::Chain *chain = CreateChain (m_chain->m_n + 1);
+      for (uint32_t i = 0; i < m_chain->m_n; i++)
+        {
+          AppendSegment (chain, m_chain->m_segments[i]);
+        }
+      AppendSegment (chain, segment);
+      // the chain now holds the only reference to the new data
+      segment.m_data->m_count--;
+      ReleaseChain (m_chain);
+      m_chain = chain;
+      LOG_INTERNAL_STATE ("add end=" << end << ", ");
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
@@ -400,7 +443,8 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (m_chain == 0 && o.m_chain == 0 &&
+      m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
@@ -426,11 +470,61 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
-  *this = CreateFullCopy ();
-  AddAtEnd (o.GetSize ());
-  Buffer::Iterator destStart = End ();
-  destStart.Prev (o.GetSize ());
-  destStart.Write (o.Begin (), o.End ());
+  if (o.GetSize () == 0)
+    {
+      return;
+    }
+  if (GetSize () == 0)
+    {
+      *this = o;
+      return;
+    }
+
+  uint32_t n = 2;
+  if (m_chain != 0)
+    {
+      n += m_chain->m_n;
+    }
+  if (o.m_chain != 0)
+    {
+      n += o.m_chain->m_n;
+    }
+  if (n > BUFFER_MAX_SEGMENTS)
+    {
+      /* too many segments: copy both buffers into a single one */
+      Buffer tmp = CreateFullCopy ();
+      tmp.AddAtEnd (o.GetSize ());
+      Buffer::Iterator destStart = tmp.End ();
+      destStart.Prev (o.GetSize ());
+      destStart.Write (o.Begin (), o.End ());
+      *this = tmp;
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
+
+  /* share the segments of o */
+  struct Buffer::Chain *chain = CreateChain (n - 1);
+  if (m_chain != 0)
+    {
+      for (uint32_t i = 0; i < m_chain->m_n; i++)
+        {
+          AppendSegment (chain, m_chain->m_segments[i]);
+        }
+    }
+  AppendSegment (chain, o.GetFirstSegment ());
+  if (o.m_chain != 0)
+    {
+      for (uint32_t i = 0; i < o.m_chain->m_n; i++)
+        {
+          AppendSegment (chain, o.m_chain->m_segments[i]);
+        }
+    }
+  if (m_chain != 0)
+    {
+      ReleaseChain (m_chain);
+    }
+  m_chain = chain;
+  LOG_INTERNAL_STATE ("add buffer=" << &o << ", ");
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -439,6 +533,42 @@ Buffer::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0 && start >= m_end - m_start)
+    {
+      /* remove the first segment: the segment of the chain which
+       * holds the new start becomes the first one.
+       */
+      start -= m_end - m_start;
+      struct Buffer::Chain *chain = m_chain;
+      uint32_t i = 0;
+      while (i + 1 < chain->m_n && chain->m_segments[i + 1].m_offset <= start)
+        {
+          i++;
+        }
+      const struct Buffer::Segment &segment = chain->m_segments[i];
+      start -= segment.m_offset;
+      segment.m_data->m_count++;
+      m_data->m_count--;
+      if (m_data->m_count == 0)
+        {
+          Buffer::Recycle (m_data);
+        }
+      m_data = segment.m_data;
+      m_zeroAreaStart = segment.m_zeroAreaStart;
+      m_zeroAreaEnd = segment.m_zeroAreaEnd;
+      m_start = segment.m_start;
+      m_end = segment.m_end;
+      m_chain = 0;
+      if (i + 1 < chain->m_n)
+        {
+          m_chain = CreateChain (chain->m_n - i - 1);
+          for (uint32_t j = i + 1; j < chain->m_n; j++)
+            {
+              AppendSegment (m_chain, chain->m_segments[j]);
+            }
+        }
+      ReleaseChain (chain);
+    }
   uint32_t newStart = m_start + start;
   if (newStart <= m_zeroAreaStart)
     {
@@ -484,6 +614,41 @@ Buffer::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0 && end > 0)
+    {
+      struct Buffer::Chain *chain = m_chain;
+      if (end < chain->m_size)
+        {
+          /* remove the end of the chain only: keep the segments
+           * which start before the new end, and trim the last one.
+           */
+          uint32_t size = chain->m_size - end;
+          uint32_t n = 0;
+          while (n < chain->m_n && chain->m_segments[n].m_offset < size)
+            {
+              n++;
+            }
+          m_chain = CreateChain (n);
+          for (uint32_t i = 0; i + 1 < n; i++)
+            {
+              AppendSegment (m_chain, chain->m_segments[i]);
+            }
+          struct Buffer::Segment segment = chain->m_segments[n - 1];
+          uint32_t newEnd = segment.m_start + size - segment.m_offset;
+          segment.m_end = newEnd;
+          segment.m_zeroAreaEnd = std::min (segment.m_zeroAreaEnd, newEnd);
+          segment.m_zeroAreaStart = std::min (segment.m_zeroAreaStart, newEnd);
+          AppendSegment (m_chain, segment);
+          ReleaseChain (chain);
+          LOG_INTERNAL_STATE ("rem end=" << end << ", ");
+          NS_ASSERT (CheckInternalState ());
+          return;
+        }
+      /* remove the whole chain */
+      end -= chain->m_size;
+      m_chain = 0;
+      ReleaseChain (chain);
+    }
   uint32_t newEnd = m_end - std::min (end, m_end - m_start);
   if (newEnd > m_zeroAreaEnd)
     {
@@ -532,6 +697,14 @@ Buffer::CreateFullCopy (void) const
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
+  if (m_chain != 0)
+    {
+      Buffer tmp;
+      tmp.AddAtStart (GetSize ());
+      tmp.Begin ().Write (Begin (), End ());
+      NS_ASSERT (tmp.CheckInternalState ());
+      return tmp;
+    }
   if (m_zeroAreaEnd - m_zeroAreaStart != 0) 
     {
       Buffer tmp;
@@ -556,6 +729,10 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -576,6 +753,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -715,28 +896,30 @@ void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &os << size);
-  if (size > 0)
-    {
-      uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
-      os->write ((const char*)(m_data->m_data + m_start), tmpsize);
-      if (size > tmpsize) 
-        { 
-          size -= m_zeroAreaStart-m_start;
-          tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              os->write (g_zeroes.buffer, toWrite);
-              left -= toWrite;
-            }
-          if (size > tmpsize)
-            {
-              size -= tmpsize;
-              tmpsize = std::min (m_end - m_zeroAreaEnd, size);
-              os->write ((const char*)(m_data->m_data + m_zeroAreaStart), tmpsize); 
-            }
+  struct Buffer::Segment segment = GetFirstSegment ();
+  uint32_t i = 0;
+  while (size > 0)
+    {
+      uint32_t tmpsize = std::min (segment.m_zeroAreaStart - segment.m_start, size);
+      os->write ((const char*)(segment.m_data->m_data + segment.m_start), tmpsize);
+      size -= tmpsize;
+      tmpsize = std::min (segment.m_zeroAreaEnd - segment.m_zeroAreaStart, size);
+      uint32_t left = tmpsize;
+      while (left > 0)
+        {
+          uint32_t toWrite = std::min (left, g_zeroes.size);
+          os->write (g_zeroes.buffer, toWrite);
+          left -= toWrite;
         }
+      size -= tmpsize;
+      tmpsize = std::min (segment.m_end - segment.m_zeroAreaEnd, size);
+      os->write ((const char*)(segment.m_data->m_data + segment.m_zeroAreaStart), tmpsize);
+      size -= tmpsize;
+      if (m_chain == 0 || i == m_chain->m_n)
+        {
+          break;
+        }
+      segment = m_chain->m_segments[i++];
     }
 }
 
@@ -745,31 +928,33 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &buffer << size);
   uint32_t originalSize = size;
-  if (size > 0)
+  struct Buffer::Segment segment = GetFirstSegment ();
+  uint32_t i = 0;
+  while (size > 0)
     {
-      uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
-      memcpy (buffer, (const char*)(m_data->m_data + m_start), tmpsize);
+      uint32_t tmpsize = std::min (segment.m_zeroAreaStart - segment.m_start, size);
+      memcpy (buffer, (const char*)(segment.m_data->m_data + segment.m_start), tmpsize);
       buffer += tmpsize;
       size -= tmpsize;
-      if (size > 0) 
-        { 
-          tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              memcpy (buffer, g_zeroes.buffer, toWrite);
-              left -= toWrite;
-              buffer += toWrite;
-            }
-          size -= tmpsize;
-          if (size > 0)
-            {
-              tmpsize = std::min (m_end - m_zeroAreaEnd, size);
-              memcpy (buffer, (const char*)(m_data->m_data + m_zeroAreaStart), tmpsize);
-              size -= tmpsize;
-            }
+      tmpsize = std::min (segment.m_zeroAreaEnd - segment.m_zeroAreaStart, size);
+      uint32_t left = tmpsize;
+      while (left > 0)
+        {
+          uint32_t toWrite = std::min (left, g_zeroes.size);
+          memcpy (buffer, g_zeroes.buffer, toWrite);
+          left -= toWrite;
+          buffer += toWrite;
         }
+      size -= tmpsize;
+      tmpsize = std::min (segment.m_end - segment.m_zeroAreaEnd, size);
+      memcpy (buffer, (const char*)(segment.m_data->m_data + segment.m_zeroAreaStart), tmpsize);
+      buffer += tmpsize;
+      size -= tmpsize;
+      if (m_chain == 0 || i == m_chain->m_n)
+        {
+          break;
+        }
+      segment = m_chain->m_segments[i++];
     }
   return originalSize - size;
 }
@@ -783,7 +968,7 @@ uint32_t
 Buffer::Iterator::GetDistanceFrom (Iterator const &o) const
 {
   NS_LOG_FUNCTION (this << &o);
-  NS_ASSERT (m_data == o.m_data);
+  NS_ASSERT (m_dataStart == o.m_dataStart && m_dataEnd == o.m_dataEnd);
   int32_t diff = m_current - o.m_current;
   if (diff < 0)
     {
@@ -835,35 +1020,57 @@ void
 Buffer::Iterator::Write (Iterator start, Iterator end)
 {
   NS_LOG_FUNCTION (this << &start << &end);
-  NS_ASSERT (start.m_data == end.m_data);
+  NS_ASSERT (start.m_dataStart == end.m_dataStart && start.m_dataEnd == end.m_dataEnd);
   NS_ASSERT (start.m_current <= end.m_current);
-  NS_ASSERT (start.m_zeroStart == end.m_zeroStart);
-  NS_ASSERT (start.m_zeroEnd == end.m_zeroEnd);
-  NS_ASSERT (m_data != start.m_data);
+  NS_ASSERT (m_buffer != start.m_buffer);
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
-  if (start.m_current <= start.m_zeroStart)
-    {
-      uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
-      start.m_current += toCopy;
-      m_current += toCopy;
-      size -= toCopy;
-    }
-  if (start.m_current <= start.m_zeroEnd)
+  while (size > 0)
     {
-      uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      if (start.m_current < start.m_segmentStart || start.m_current >= start.m_segmentEnd)
+        {
+          start.LoadSegment ();
+        }
+      if (m_current < m_segmentStart || m_current >= m_segmentEnd)
+        {
+          LoadSegment ();
+        }
+      if (start.m_current >= start.m_segmentEnd || m_current >= m_segmentEnd)
+        {
+          // out of bounds
+          break;
+        }
+      uint32_t toCopy = std::min (size, m_segmentEnd - m_current);
+      uint8_t *to;
+      if (m_current < m_zeroStart)
+        {
+          toCopy = std::min (toCopy, m_zeroStart - m_current);
+          to = &m_data[m_current];
+        }
+      else
+        {
+          to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+        }
+      if (start.m_current < start.m_zeroStart)
+        {
+          toCopy = std::min (toCopy, start.m_zeroStart - start.m_current);
+          memcpy (to, &start.m_data[start.m_current], toCopy);
+        }
+      else if (start.m_current < start.m_zeroEnd)
+        {
+          toCopy = std::min (toCopy, start.m_zeroEnd - start.m_current);
+          memset (to, 0, toCopy);
+        }
+      else
+        {
+          toCopy = std::min (toCopy, start.m_segmentEnd - start.m_current);
+          memcpy (to, &start.m_data[start.m_current - (start.m_zeroEnd - start.m_zeroStart)], toCopy);
+        }
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
     }
-  uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
-  uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
-  memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
@@ -955,6 +1162,24 @@ Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
   NS_LOG_FUNCTION (this << &buffer << size);
   NS_ASSERT_MSG (CheckNoZero (m_current, size),
                  GetWriteErrorMessage ());
+  while (m_current < m_segmentStart || m_current + size > m_segmentEnd)
+    {
+      /* write the bytes of each segment */
+      LoadSegment ();
+      if (m_current >= m_segmentEnd)
+        {
+          // out of bounds
+          return;
+        }
+      uint32_t toCopy = std::min (size, m_segmentEnd - m_current);
+      if (toCopy == size)
+        {
+          break;
+        }
+      Write (buffer, toCopy);
+      buffer += toCopy;
+      size -= toCopy;
+    }
   uint8_t *to;
   if (m_current <= m_zeroStart)
     {
@@ -1039,6 +1264,105 @@ Buffer::Iterator::SlowReadNtohU32 (void)
   retval |= ReadU8 ();
   return retval;
 }
+void
+Buffer::Iterator::LoadSegment (void)
+{
+  NS_LOG_FUNCTION (this);
+  const Buffer *buffer = m_buffer;
+  const struct Buffer::Chain *chain = buffer->m_chain;
+  if (chain == 0 || m_current < buffer->m_end)
+    {
+      m_zeroStart = buffer->m_zeroAreaStart;
+      m_zeroEnd = buffer->m_zeroAreaEnd;
+      m_segmentStart = buffer->m_start;
+      m_segmentEnd = buffer->m_end;
+      m_data = buffer->m_data->m_data;
+      return;
+    }
+  uint32_t offset = m_current - buffer->m_end;
+  uint32_t i = 0;
+  while (i + 1 < chain->m_n && chain->m_segments[i + 1].m_offset <= offset)
+    {
+      i++;
+    }
+  const struct Buffer::Segment &segment = chain->m_segments[i];
+  uint32_t start = buffer->m_end + segment.m_offset;
+  m_zeroStart = start + (segment.m_zeroAreaStart - segment.m_start);
+  m_zeroEnd = start + (segment.m_zeroAreaEnd - segment.m_start);
+  m_segmentStart = start;
+  m_segmentEnd = start + (segment.m_end - segment.m_start);
+  // offsets in the segment are relative to the start of the buffer
+  m_data = segment.m_data->m_data + (static_cast<int64_t> (segment.m_start) - start);
+}
+uint8_t *
+Buffer::Iterator::FindByte (const Buffer *buffer, uint32_t current)
+{
+  NS_LOG_FUNCTION (buffer << current);
+  const struct Buffer::Chain *chain = buffer->m_chain;
+  struct Buffer::Segment segment;
+  if (chain == 0 || current < buffer->m_end)
+    {
+      segment = buffer->GetFirstSegment ();
+    }
+  else
+    {
+      uint32_t offset = current - buffer->m_end;
+      uint32_t i = 0;
+      while (i + 1 < chain->m_n && chain->m_segments[i + 1].m_offset <= offset)
+        {
+          i++;
+        }
+      segment = chain->m_segments[i];
+      current = segment.m_start + offset - segment.m_offset;
+    }
+  if (current < segment.m_zeroAreaStart)
+    {
+      return &segment.m_data->m_data[current];
+    }
+  else if (current < segment.m_zeroAreaEnd)
+    {
+      return 0;
+    }
+  else
+    {
+      return &segment.m_data->m_data[current - (segment.m_zeroAreaEnd - segment.m_zeroAreaStart)];
+    }
+}
+uint8_t
+Buffer::Iterator::SlowPeekU8 (const Buffer *buffer, uint32_t current)
+{
+  NS_LOG_FUNCTION (buffer << current);
+  uint8_t *byte = FindByte (buffer, current);
+  if (byte == 0)
+    {
+      return 0;
+    }
+  return *byte;
+}
+void
+Buffer::Iterator::SlowWriteU8 (const Buffer *buffer, uint32_t current,
+                               uint8_t data, uint32_t len)
+{
+  NS_LOG_FUNCTION (buffer << current << static_cast<uint32_t> (data) << len);
+  for (uint32_t i = 0; i < len; i++)
+    {
+      uint8_t *byte = FindByte (buffer, current + i);
+      NS_ASSERT (byte != 0);
+      *byte = data;
+    }
+}
+void
+Buffer::Iterator::SlowWriteHton (const Buffer *buffer, uint32_t current,
+                                 uint32_t data, uint32_t len)
+{
+  NS_LOG_FUNCTION (buffer << current << data << len);
+  for (uint32_t i = 0; i < len; i++)
+    {
+      uint8_t *byte = FindByte (buffer, current + i);
+      NS_ASSERT (byte != 0);
+      *byte = (data >> (8 * (len - 1 - i))) & 0xff;
+    }
+}
 uint64_t 
 Buffer::Iterator::ReadNtohU64 (void)
 {
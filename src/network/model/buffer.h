@@ -27,6 +27,13 @@
 
 #define BUFFER_FREE_LIST 1
 
+/**
+ * \ingroup packet
+ * The maximum number of segments of a Buffer: appending a Buffer
+ * which would make more turns the result into a single segment.
+ */
+#define BUFFER_MAX_SEGMENTS 16
+
 namespace ns3 {
 
 /**
@@ -88,6 +95,21 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * A Buffer may also be made of several segments: the one described
+ * above, to which headers are added, followed by a chain of segments
+ * shared with other Buffer instances. Buffer::AddAtEnd (Buffer const&)
+ * appends the segments of its argument to the chain instead of
+ * copying its bytes, and Buffer::RemoveAtStart, Buffer::RemoveAtEnd
+ * and Buffer::CreateFragment drop or trim segments, so that these
+ * operations cost O(segments) and never copy payload bytes. The
+ * segments of a chain are never modified in place: each segment
+ * holds a reference to its BufferData, and the chain is rebuilt
+ * whenever a segment is added, removed or trimmed. Iterators move
+ * across segments transparently. Buffer::PeekData and serialization
+ * turn the Buffer into a single segment first, as does
+ * Buffer::AddAtEnd (Buffer const&) when the chain would grow beyond
+ * BUFFER_MAX_SEGMENTS segments.
  */
 class Buffer 
 {
@@ -438,6 +460,53 @@ private:
      * \warning this is the slow version, please use ReadNtohU32 (void)
      */
     uint32_t SlowReadNtohU32 (void);
+    /**
+     * \brief Load the segment which holds the current position.
+     *
+     * Sets the zero area, segment bounds and data pointer of this
+     * iterator to those of the segment of the buffer which holds
+     * m_current. If no segment holds it, loads the first segment.
+     */
+    void LoadSegment (void);
+    /**
+     * \param buffer the buffer to access
+     * \param current the offset of the byte in the buffer
+     * \return a pointer to the byte, or zero if it is in a zero area.
+     *
+     * Find the byte at an offset of the buffer, in whichever segment
+     * holds it. The slow paths below take the iterator state by value
+     * so that the inline fast paths can keep it in registers.
+     */
+    static uint8_t *FindByte (const Buffer *buffer, uint32_t current);
+    /**
+     * \param buffer the buffer to read
+     * \param current the offset of the byte in the buffer
+     * \return the byte read in the buffer.
+     *
+     * Read a byte outside of the current segment.
+     */
+    static uint8_t SlowPeekU8 (const Buffer *buffer, uint32_t current);
+    /**
+     * \param buffer the buffer to write
+     * \param current the offset of the first byte in the buffer
+     * \param data data to write in buffer
+     * \param len number of times data must be written in buffer
+     *
+     * Write the data len times outside of the current segment.
+     */
+    static void SlowWriteU8 (const Buffer *buffer, uint32_t current,
+                             uint8_t data, uint32_t len);
+    /**
+     * \param buffer the buffer to write
+     * \param current the offset of the first byte in the buffer
+     * \param data data to write in buffer
+     * \param len number of bytes of data to write, in network order
+     *
+     * Write the len lowest bytes of data in network order outside
+     * of the current segment.
+     */
+    static void SlowWriteHton (const Buffer *buffer, uint32_t current,
+                               uint32_t data, uint32_t len);
     /**
      * \brief Returns an appropriate message indicating a read error
      * \returns the error message
@@ -454,14 +523,24 @@ private:
 
     /**
      * offset in virtual bytes from the start of the data buffer to the
-     * start of the "virtual zero area".
+     * start of the "virtual zero area" of the current segment.
      */
     uint32_t m_zeroStart;
     /**
      * offset in virtual bytes from the start of the data buffer to the
-     * end of the "virtual zero area".
+     * end of the "virtual zero area" of the current segment.
      */
     uint32_t m_zeroEnd;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * start of the current segment.
+     */
+    uint32_t m_segmentStart;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * end of the current segment.
+     */
+    uint32_t m_segmentEnd;
     /**
      * offset in virtual bytes from the start of the data buffer to the
      * start of the data which can be read by this iterator
@@ -478,10 +557,14 @@ private:
      */
     uint32_t m_current;
     /**
-     * a pointer to the underlying byte buffer. All offsets are relative
-     * to this pointer.
+     * a pointer to the underlying byte buffer of the current segment.
+     * All offsets are relative to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the buffer iterated, used to find the other segments.
+     */
+    const Buffer *m_buffer;
   };
 
   /**
@@ -497,6 +580,8 @@ private:
    * memory which is ns3::Buffer::GetSize () bytes big.
    * Please, try to never ever use this method. It is really
    * evil and is present only for a few specific uses.
+   * A buffer made of several segments is turned into a single
+   * segment first, which copies all its bytes.
    */
   uint8_t const*PeekData (void) const;
 
@@ -524,7 +609,9 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer. The segments of o are
+   * shared, not copied, unless this buffer would hold more than
+   * BUFFER_MAX_SEGMENTS segments.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -552,6 +639,8 @@ private:
    *
    * \return a fragment of size length starting at offset
    * start.
+   *
+   * The fragment shares the bytes of this buffer.
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
@@ -685,10 +774,82 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * A segment of a chain: a range of the bytes of a BufferData, with
+   * its own virtual zero area, described as the first segment of a
+   * Buffer is by the Buffer fields of the same names.
+   */
+  struct Segment
+  {
+    /**
+     * the BufferData of this segment, of which the segment holds a
+     * reference.
+     */
+    struct Data *m_data;
+    /**
+     * offset to the start of the virtual zero area from the start
+     * of m_data->m_data
+     */
+    uint32_t m_zeroAreaStart;
+    /**
+     * offset to the end of the virtual zero area from the start
+     * of m_data->m_data
+     */
+    uint32_t m_zeroAreaEnd;
+    /**
+     * offset to the start of the segment from the start of
+     * m_data->m_data
+     */
+    uint32_t m_start;
+    /**
+     * offset to the end of the segment from the start of
+     * m_data->m_data
+     */
+    uint32_t m_end;
+    /**
+     * offset in virtual bytes of the start of the segment from
+     * the start of the chain.
+     */
+    uint32_t m_offset;
+  };
+
+  /**
+   * The segments which follow the first segment of a Buffer. This
+   * data structure is variable-sized through its last member, and
+   * shared by the copies of a Buffer: it is never modified once
+   * built.
+   */
+  struct Chain
+  {
+    /**
+     * The reference count of an instance of this data structure.
+     * Each buffer which references an instance holds a count.
+     */
+    uint32_t m_count;
+    /**
+     * the number of segments in the m_segments field below.
+     */
+    uint32_t m_n;
+    /**
+     * the number of segments the m_segments field can hold.
+     */
+    uint32_t m_capacity;
+    /**
+     * the number of virtual bytes of all the segments.
+     */
+    uint32_t m_size;
+    /**
+     * The segments, none of which is empty.
+     */
+    struct Segment m_segments[1];
+  };
+
   /**
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
    *
+   * The copy is made of a single segment.
+   *
    * \returns a copy of the buffer
    */
   Buffer CreateFullCopy (void) const;
@@ -748,8 +909,38 @@ private:
    * \param data the buffer data storage
    */
   static void Deallocate (struct Buffer::Data *data);
+  /**
+   * \brief Create an empty chain
+   * \param n the number of segments the chain will hold
+   * \returns a pointer to the chain
+   */
+  static struct Buffer::Chain *CreateChain (uint32_t n);
+  /**
+   * \brief Append a segment to a chain being built
+   *
+   * Empty segments are not appended.
+   *
+   * \param chain the chain, returned by CreateChain
+   * \param segment the segment, of which the chain takes a reference
+   */
+  static void AppendSegment (struct Buffer::Chain *chain, const struct Buffer::Segment &segment);
+  /**
+   * \brief Release a reference to a chain, and the chain and its
+   * segments with the last one.
+   * \param chain the chain
+   */
+  static void ReleaseChain (struct Buffer::Chain *chain);
+  /**
+   * \returns the first segment of this buffer, without a reference
+   */
+  struct Buffer::Segment GetFirstSegment (void) const;
 
   struct Data *m_data; //!< the buffer data storage
+  /**
+   * the segments which follow the one in m_data, zero if this buffer
+   * is made of a single segment.
+   */
+  struct Chain *m_chain;
 
   /**
    * keep track of the maximum value of m_zeroAreaStart across
@@ -790,18 +981,6 @@ private:
    */
   uint32_t m_end;
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -814,10 +993,13 @@ namespace ns3 {
 Buffer::Iterator::Iterator ()
   : m_zeroStart (0),
     m_zeroEnd (0),
+    m_segmentStart (0),
+    m_segmentEnd (0),
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_buffer (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -836,9 +1018,16 @@ Buffer::Iterator::Construct (const Buffer *buffer)
 {
   m_zeroStart = buffer->m_zeroAreaStart;
   m_zeroEnd = buffer->m_zeroAreaEnd;
+  m_segmentStart = buffer->m_start;
+  m_segmentEnd = buffer->m_end;
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
+  if (buffer->m_chain != 0)
+    {
+      m_dataEnd += buffer->m_chain->m_size;
+    }
   m_data = buffer->m_data->m_data;
+  m_buffer = buffer;
 }
 
 void 
@@ -871,7 +1060,12 @@ Buffer::Iterator::WriteU8 (uint8_t data)
   NS_ASSERT_MSG (Check (m_current),
                  GetWriteErrorMessage ());
 
-  if (m_current < m_zeroStart)
+  if (m_current < m_segmentStart || m_current >= m_segmentEnd)
+    {
+      SlowWriteU8 (m_buffer, m_current, data, 1);
+      m_current++;
+    }
+  else if (m_current < m_zeroStart)
     {
       m_data[m_current] = data;
       m_current++;
@@ -888,7 +1082,12 @@ Buffer::Iterator::WriteU8 (uint8_t  data, uint32_t len)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + len),
                  GetWriteErrorMessage ());
-  if (m_current <= m_zeroStart)
+  if (m_current < m_segmentStart || m_current + len > m_segmentEnd)
+    {
+      SlowWriteU8 (m_buffer, m_current, data, len);
+      m_current += len;
+    }
+  else if (m_current <= m_zeroStart)
     {
       std::memset (&(m_data[m_current]), data, len);
       m_current += len;
@@ -907,7 +1106,13 @@ Buffer::Iterator::WriteHtonU16 (uint16_t data)
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 2),
                  GetWriteErrorMessage ());
   uint8_t *buffer;
-  if (m_current + 2 <= m_zeroStart)
+  if (m_current < m_segmentStart || m_current + 2 > m_segmentEnd)
+    {
+      SlowWriteHton (m_buffer, m_current, data, 2);
+      m_current += 2;
+      return;
+    }
+  else if (m_current + 2 <= m_zeroStart)
     {
       buffer = &m_data[m_current];
     }
@@ -927,7 +1132,13 @@ Buffer::Iterator::WriteHtonU32 (uint32_t data)
                  GetWriteErrorMessage ());
 
   uint8_t *buffer;
-  if (m_current + 4 <= m_zeroStart)
+  if (m_current < m_segmentStart || m_current + 4 > m_segmentEnd)
+    {
+      SlowWriteHton (m_buffer, m_current, data, 4);
+      m_current += 4;
+      return;
+    }
+  else if (m_current + 4 <= m_zeroStart)
     {
       buffer = &m_data[m_current];
     }
@@ -946,11 +1157,11 @@ uint16_t
 Buffer::Iterator::ReadNtohU16 (void)
 {
   uint8_t *buffer;
-  if (m_current + 2 <= m_zeroStart)
+  if (m_current >= m_segmentStart && m_current + 2 <= m_zeroStart)
     {
       buffer = &m_data[m_current];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 2 <= m_segmentEnd)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
@@ -970,11 +1181,11 @@ uint32_t
 Buffer::Iterator::ReadNtohU32 (void)
 {
   uint8_t *buffer;
-  if (m_current + 4 <= m_zeroStart)
+  if (m_current >= m_segmentStart && m_current + 4 <= m_zeroStart)
     {
       buffer = &m_data[m_current];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 4 <= m_segmentEnd)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
@@ -1001,7 +1212,11 @@ Buffer::Iterator::PeekU8 (void)
                  m_current < m_dataEnd,
                  GetReadErrorMessage ());
 
-  if (m_current < m_zeroStart)
+  if (m_current < m_segmentStart || m_current >= m_segmentEnd)
+    {
+      return SlowPeekU8 (m_buffer, m_current);
+    }
+  else if (m_current < m_zeroStart)
     {
       uint8_t data = m_data[m_current];
       return data;
@@ -1049,6 +1264,7 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
 
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
+    m_chain (o.m_chain),
     m_maxZeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
@@ -1056,12 +1272,20 @@ Buffer::Buffer (Buffer const&o)
     m_end (o.m_end)
 {
   m_data->m_count++;
+  if (m_chain != 0)
+    {
+      m_chain->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
 uint32_t 
 Buffer::GetSize (void) const
 {
+  if (m_chain != 0)
+    {
+      return m_end - m_start + m_chain->m_size;
+    }
   return m_end - m_start;
 }
 
@@ -18,13 +18,14 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "packet-allocator.h"
 #include "ns3/log.h"
-#include <vector>
+#include <algorithm>
 #include <cstring>
 #include <limits>
 
 #define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
+#define INITIAL_CAPACITY 4
 #define OFFSET_MAX (std::numeric_limits<int32_t>::max ())
 
 namespace ns3 {
@@ -37,41 +38,57 @@ NS_LOG_COMPONENT_DEFINE ("ByteTagList");
  * \brief Internal representation of the byte tags stored in a packet.
  *
  * This structure is only used by ByteTagList and should not be accessed directly.
+ * It is followed, in the same block, by the arrays of the start offsets,
+ * end offsets, TypeIds, data sizes and data positions of the tags, each
+ * of capacity entries, and by size bytes of tag data.
  */
 struct ByteTagListData {
-  uint32_t size;   //!< size of the data
-  uint32_t count;  //!< use counter (for smart deallocation)
-  uint32_t dirty;  //!< number of bytes actually in use
-  uint8_t data[4]; //!< data
+  uint32_t count;    //!< use counter (for smart deallocation)
+  uint32_t dirty;    //!< number of tags actually in use
+  uint32_t capacity; //!< number of tags which fit in the arrays
+  uint32_t size;     //!< number of bytes of tag data which fit
+
+  /** \returns the start offsets of the tags */
+  int32_t *GetStarts (void)
+  {
+    return reinterpret_cast<int32_t *> (this + 1);
+  }
+  /** \returns the end offsets of the tags */
+  int32_t *GetEnds (void)
+  {
+    return GetStarts () + capacity;
+  }
+  /** \returns the TypeId uids of the tags */
+  uint32_t *GetTids (void)
+  {
+    return reinterpret_cast<uint32_t *> (GetEnds () + capacity);
+  }
+  /** \returns the sizes of the data of the tags */
+  uint32_t *GetSizes (void)
+  {
+    return GetTids () + capacity;
+  }
+  /** \returns the positions of the data of the tags */
+  uint32_t *GetPositions (void)
+  {
+    return GetSizes () + capacity;
+  }
+  /** \returns the data of the tags */
+  uint8_t *GetData (void)
+  {
+    return reinterpret_cast<uint8_t *> (GetPositions () + capacity);
+  }
+  /**
+   * \param capacity a number of tags
+   * \returns the size of a block whose arrays hold \p capacity tags,
+   *          without the tag data
+   */
+  static std::size_t GetHeaderSize (uint32_t capacity)
+  {
+    return sizeof (struct ByteTagListData) + capacity * (2 * sizeof (int32_t) + 3 * sizeof (uint32_t));
+  }
 };
 
-#ifdef USE_FREE_LIST
-/**
- * \ingroup packet
- *
- * \brief Container class for struct ByteTagListData
- *
- * Internal use only.
- */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
-{
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
-
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
-}
-#endif /* USE_FREE_LIST */
-
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
   : buf (buf_)
 {
@@ -88,13 +105,14 @@ struct ByteTagList::Iterator::Item
 ByteTagList::Iterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  struct Item item = Item (TagBuffer (m_current+16, m_end));
-  item.tid.SetUid (m_nextTid);
-  item.size = m_nextSize;
-  item.start = std::max (m_nextStart, m_offsetStart);
-  item.end = std::min (m_nextEnd, m_offsetEnd);
-  m_current += 4 + 4 + 4 + 4 + item.size;
-  item.buf.TrimAtEnd (m_end - m_current);
+  uint32_t size = m_data->GetSizes ()[m_current];
+  uint8_t *buf = m_data->GetData () + m_data->GetPositions ()[m_current];
+  struct Item item = Item (TagBuffer (buf, buf + size));
+  item.tid.SetUid (m_data->GetTids ()[m_current]);
+  item.size = size;
+  item.start = std::max (m_data->GetStarts ()[m_current] + m_adjustment, m_offsetStart);
+  item.end = std::min (m_data->GetEnds ()[m_current] + m_adjustment, m_offsetEnd);
+  m_current++;
   PrepareForNext ();
   return item;
 }
@@ -102,31 +120,29 @@ void
 ByteTagList::Iterator::PrepareForNext (void)
 {
   NS_LOG_FUNCTION (this);
-  while (m_current < m_end)
+  if (m_current >= m_end)
     {
-      TagBuffer buf = TagBuffer (m_current, m_end);
-      m_nextTid = buf.ReadU32 ();
-      m_nextSize = buf.ReadU32 ();
-      m_nextStart = buf.ReadU32 () + m_adjustment;
-      m_nextEnd = buf.ReadU32 () + m_adjustment;
-      if (m_nextStart >= m_offsetEnd || m_nextEnd <= m_offsetStart)
-        {
-          m_current += 4 + 4 + 4 + 4 + m_nextSize;
-        }
-      else
-        {
-          break;
-        }
+      return;
+    }
+  // only the offsets are read to skip the tags outside of the range
+  const int32_t *starts = m_data->GetStarts ();
+  const int32_t *ends = m_data->GetEnds ();
+  while (m_current < m_end
+         && (starts[m_current] + m_adjustment >= m_offsetEnd
+             || ends[m_current] + m_adjustment <= m_offsetStart))
+    {
+      m_current++;
     }
 }
-ByteTagList::Iterator::Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment)
-  : m_current (start),
+ByteTagList::Iterator::Iterator (struct ByteTagListData *data, uint32_t start, uint32_t end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment)
+  : m_data (data),
+    m_current (start),
     m_end (end),
     m_offsetStart (offsetStart),
     m_offsetEnd (offsetEnd),
     m_adjustment (adjustment)
 {
-  NS_LOG_FUNCTION (this << &start << &end << offsetStart << offsetEnd << adjustment);
+  NS_LOG_FUNCTION (this << data << start << end << offsetStart << offsetEnd << adjustment);
   PrepareForNext ();
 }
 
@@ -192,27 +208,35 @@ TagBuffer
 ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
 {
   NS_LOG_FUNCTION (this << tid << bufferSize << start << end);
-  uint32_t spaceNeeded = m_used + bufferSize + 4 + 4 + 4 + 4;
-  NS_ASSERT (m_used <= spaceNeeded);
+  // the data of the tags in use ends with the data of the last one
+  uint32_t position = 0;
+  if (m_used != 0)
+    {
+      position = m_data->GetPositions ()[m_used - 1] + m_data->GetSizes ()[m_used - 1];
+    }
+  uint32_t spaceNeeded = position + bufferSize;
+  NS_ASSERT (position <= spaceNeeded);
   if (m_data == 0)
     {
-      m_data = Allocate (spaceNeeded);
+      m_data = Allocate (INITIAL_CAPACITY, spaceNeeded);
       m_used = 0;
     } 
-  else if (m_data->size < spaceNeeded ||
+  else if (m_data->capacity == m_used || m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
     {
-      struct ByteTagListData *newData = Allocate (spaceNeeded);
-      std::memcpy (&newData->data, &m_data->data, m_used);
-      Deallocate (m_data);
-      m_data = newData;
+      Reallocate (std::max<uint32_t> (INITIAL_CAPACITY, 2 * m_used), 2 * spaceNeeded);
+      // the copy packs the data of the tags
+      position = 0;
+      if (m_used != 0)
+        {
+          position = m_data->GetPositions ()[m_used - 1] + m_data->GetSizes ()[m_used - 1];
+        }
     }
-  TagBuffer tag = TagBuffer (&m_data->data[m_used], 
-                             &m_data->data[spaceNeeded]);
-  tag.WriteU32 (tid.GetUid ());
-  tag.WriteU32 (bufferSize);
-  tag.WriteU32 (start - m_adjustment);
-  tag.WriteU32 (end - m_adjustment);
+  m_data->GetStarts ()[m_used] = start - m_adjustment;
+  m_data->GetEnds ()[m_used] = end - m_adjustment;
+  m_data->GetTids ()[m_used] = tid.GetUid ();
+  m_data->GetSizes ()[m_used] = bufferSize;
+  m_data->GetPositions ()[m_used] = position;
   if (start - m_adjustment < m_minStart)
     {
       m_minStart = start - m_adjustment;
@@ -221,9 +245,10 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
     {
       m_maxEnd = end - m_adjustment;
     }
-  m_used = spaceNeeded;
+  m_used++;
   m_data->dirty = m_used;
-  return tag;
+  uint8_t *buf = m_data->GetData () + position;
+  return TagBuffer (buf, buf + bufferSize);
 }
 
 void 
@@ -264,13 +289,15 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
+  if (m_used == 0
+      || m_minStart + m_adjustment >= offsetEnd
+      || m_maxEnd + m_adjustment <= offsetStart)
     {
-      return Iterator (0, 0, offsetStart, offsetEnd, 0);
+      return Iterator (0, 0, 0, offsetStart, offsetEnd, 0);
     }
   else
     {
-      return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd, m_adjustment);
+      return Iterator (m_data, 0, m_used, offsetStart, offsetEnd, m_adjustment);
     }
 }
 
@@ -282,28 +309,7 @@ ByteTagList::AddAtEnd (int32_t appendOffset)
     {
       return;
     }
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
-    {
-      ByteTagList::Iterator::Item item = i.Next ();
-
-      if (item.start >= appendOffset)
-        {
-          continue;
-        }
-      if (item.end > appendOffset)
-        {
-          item.end = appendOffset;
-        }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.end > m_maxEnd)
-        {
-          m_maxEnd = item.end;
-        }
-    }
-  *this = list;
+  Trim (0, appendOffset);
 }
 
 void 
@@ -314,95 +320,89 @@ ByteTagList::AddAtStart (int32_t prependOffset)
     {
       return;
     }
-  m_minStart = INT32_MAX;
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
-    {
-      ByteTagList::Iterator::Item item = i.Next ();
-
-      if (item.end <= prependOffset)
-        {
-          continue;
-        }
-      if (item.start < prependOffset)
-        {
-          item.start = prependOffset;
-        }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.start < m_minStart)
-        {
-          m_minStart = item.start;
-        }
-    }
-  *this = list;
+  Trim (prependOffset, OFFSET_MAX);
 }
 
-#ifdef USE_FREE_LIST
-
-struct ByteTagListData *
-ByteTagList::Allocate (uint32_t size)
+void
+ByteTagList::Trim (int32_t start, int32_t end)
 {
-  NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  NS_LOG_FUNCTION (this << start << end);
+  if (m_data->count != 1)
+    {
+      Reallocate (m_data->capacity, m_data->size);
+    }
+  // the stored offsets do not include the adjustment
+  int64_t first = static_cast<int64_t> (start) - m_adjustment;
+  int64_t last = static_cast<int64_t> (end) - m_adjustment;
+  int32_t *starts = m_data->GetStarts ();
+  int32_t *ends = m_data->GetEnds ();
+  uint32_t *tids = m_data->GetTids ();
+  uint32_t *sizes = m_data->GetSizes ();
+  uint32_t *positions = m_data->GetPositions ();
+  m_minStart = INT32_MAX;
+  m_maxEnd = INT32_MIN;
+  uint32_t used = 0;
+  for (uint32_t i = 0; i < m_used; ++i)
     {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
-      if (data->size >= size)
+      if (ends[i] <= first || starts[i] >= last)
         {
-          data->count = 1;
-          data->dirty = 0;
-          return data;
+          continue;
         }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+      starts[used] = static_cast<int32_t> (std::max<int64_t> (starts[i], first));
+      ends[used] = static_cast<int32_t> (std::min<int64_t> (ends[i], last));
+      tids[used] = tids[i];
+      sizes[used] = sizes[i];
+      positions[used] = positions[i];
+      m_minStart = std::min (m_minStart, starts[used]);
+      m_maxEnd = std::max (m_maxEnd, ends[used]);
+      used++;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
-  data->count = 1;
-  data->size = size;
-  data->dirty = 0;
-  return data;
+  m_used = used;
+  m_data->dirty = m_used;
 }
 
-void 
-ByteTagList::Deallocate (struct ByteTagListData *data)
+void
+ByteTagList::Reallocate (uint32_t capacity, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << data);
-  if (data == 0)
-    {
-      return;
-    }
-  g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  NS_LOG_FUNCTION (this << capacity << size);
+  NS_ASSERT (capacity >= m_used);
+  struct ByteTagListData *data = Allocate (capacity, size);
+  uint32_t position = 0;
+  for (uint32_t i = 0; i < m_used; ++i)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
-        {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
-        }
-      else
-        {
-          g_freeList.push_back (data);
-        }
+      uint32_t tagSize = m_data->GetSizes ()[i];
+      NS_ASSERT (position + tagSize <= data->size);
+      std::memcpy (data->GetData () + position,
+                   m_data->GetData () + m_data->GetPositions ()[i],
+                   tagSize);
+      data->GetPositions ()[i] = position;
+      position += tagSize;
     }
+  std::memcpy (data->GetStarts (), m_data->GetStarts (), m_used * sizeof (int32_t));
+  std::memcpy (data->GetEnds (), m_data->GetEnds (), m_used * sizeof (int32_t));
+  std::memcpy (data->GetTids (), m_data->GetTids (), m_used * sizeof (uint32_t));
+  std::memcpy (data->GetSizes (), m_data->GetSizes (), m_used * sizeof (uint32_t));
+  data->dirty = m_used;
+  Deallocate (m_data);
+  m_data = data;
 }
 
-#else /* USE_FREE_LIST */
-
 struct ByteTagListData *
-ByteTagList::Allocate (uint32_t size)
+ByteTagList::Allocate (uint32_t capacity, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << size);
-  uint8_t *buffer = new uint8_t [size + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  NS_LOG_FUNCTION (this << capacity << size);
+  std::size_t bytes = ByteTagListData::GetHeaderSize (capacity) + size;
+#ifdef USE_FREE_LIST
+  /* the block of the size class may hold more tag data than requested */
+  void *buffer = PacketAllocator::Allocate (bytes);
+#else /* USE_FREE_LIST */
+  void *buffer = ::operator new (bytes);
+#endif /* USE_FREE_LIST */
+  struct ByteTagListData *data = static_cast<struct ByteTagListData *> (buffer);
   data->count = 1;
-  data->size = size;
   data->dirty = 0;
+  data->capacity = capacity;
+  data->size = static_cast<uint32_t> (bytes - ByteTagListData::GetHeaderSize (capacity));
   return data;
 }
 
@@ -417,13 +417,14 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+#ifdef USE_FREE_LIST
+      PacketAllocator::Deallocate (data, ByteTagListData::GetHeaderSize (data->capacity) + data->size);
+#else /* USE_FREE_LIST */
+      ::operator delete (data);
+#endif /* USE_FREE_LIST */
     }
 }
 
-#endif /* USE_FREE_LIST */
-
 uint32_t
 ByteTagList::GetSerializedSize (void) const
 {
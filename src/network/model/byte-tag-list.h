@@ -41,9 +41,12 @@ struct ByteTagListData;
  * The implementation of this class is a bit tricky so, there are a couple
  * of things to keep in mind here:
  *
- *   - It stores all tags in a single byte buffer: each tag is stored
- *     as 4 32bit integers (TypeId, tag data size, start, end) followed 
- *     by the tag data as generated by Tag::Serialize.
+ *   - It stores the tags in a single block, as a structure of arrays:
+ *     the start offsets, end offsets, TypeIds, data sizes and data
+ *     positions of the tags, each in an array of its own, followed by
+ *     the tag data as generated by Tag::Serialize.  A range query scans
+ *     only the start and end offsets and reads the data of the tags in
+ *     the range only.
  *
  *   - The struct ByteTagListData structure which contains the tag byte buffer
  *     is shared and, thus, reference-counted. This data structure is unshared
@@ -52,13 +55,18 @@ struct ByteTagListData;
  *   - Each tag tags a unique set of bytes identified by the pair of offsets
  *     (start,end). These offsets are relative to the start of the packet
  *     Whenever the origin of the offset changes, the Packet adjusts all
- *     byte tags using ByteTagList::Adjust method.
+ *     byte tags using ByteTagList::Adjust method, which only records the
+ *     change: the stored offsets are relative to the sum of the
+ *     adjustments.
  *
  *   - When packet is reduced in size, byte tags that span outside the packet
  *     boundaries remain in ByteTagList. It is not a problem as iterator fixes
  *     the boundaries before returning item. However, when packet is extending,
  *     it calls ByteTagList::AddAtStart or ByteTagList::AddAtEnd to cut byte
- *     tags that will otherwise cover new bytes.
+ *     tags that will otherwise cover new bytes.  The range of offsets
+ *     covered by the tags is kept, so that this costs nothing when no tag
+ *     covers the new bytes, and so that a query outside of that range
+ *     returns at once.
  */
 class ByteTagList
 {
@@ -122,27 +130,25 @@ private:
 
     /**
      * \brief Constructor
-     * \param start Starting tag
-     * \param end End tag
+     * \param data the tags
+     * \param start index of the first tag
+     * \param end index past the last tag
      * \param offsetStart offset to the start of the tag from the virtual byte buffer
      * \param offsetEnd offset to the end of the tag from the virtual byte buffer
      * \param adjustment adjustment to byte tag offsets
      */
-    Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment);
+    Iterator (struct ByteTagListData *data, uint32_t start, uint32_t end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment);
 
     /**
      * \brief Prepare the iterator for the next tag
      */
     void PrepareForNext (void);
-    uint8_t *m_current;     //!< Current tag
-    uint8_t *m_end;         //!< End tag
+    struct ByteTagListData *m_data; //!< the tags
+    uint32_t m_current;     //!< Index of the current tag
+    uint32_t m_end;         //!< Index past the last tag
     int32_t m_offsetStart;  //!< Offset to the start of the tag from the virtual byte buffer
     int32_t m_offsetEnd;    //!< Offset to the end of the tag from the virtual byte buffer
     int32_t m_adjustment;   //!< Adjustment to byte tag offsets
-    uint32_t m_nextTid;     //!< TypeId of the next tag
-    uint32_t m_nextSize;    //!< Size of the next tag
-    int32_t m_nextStart;    //!< Start of the next tag
-    int32_t m_nextEnd;      //!< End of the next tag
   };
 
   ByteTagList ();
@@ -264,10 +270,11 @@ private:
 
   /**
    * \brief Allocate the memory for the ByteTagListData
-   * \param size the memory to allocate
+   * \param capacity the number of tags to hold
+   * \param size the number of bytes of tag data to hold
    * \returns the ByteTagListData structure
    */
-  struct ByteTagListData *Allocate (uint32_t size);
+  struct ByteTagListData *Allocate (uint32_t capacity, uint32_t size);
 
   /**
    * \brief Deallocates a ByteTagListData
@@ -275,10 +282,25 @@ private:
    */
   void Deallocate (struct ByteTagListData *data);
 
+  /**
+   * \brief Copy the tags in use to a new ByteTagListData
+   * \param capacity the number of tags the copy must hold
+   * \param size the number of bytes of tag data the copy must hold
+   */
+  void Reallocate (uint32_t capacity, uint32_t size);
+
+  /**
+   * \brief Remove the tags outside of a range of offsets, and cut the
+   * tags which cross its boundaries.
+   * \param start offset of the first byte of the range
+   * \param end offset past the last byte of the range
+   */
+  void Trim (int32_t start, int32_t end);
+
   int32_t m_minStart; //!< minimal start offset
   int32_t m_maxEnd; //!< maximal end offset
   int32_t m_adjustment; //!< adjustment to byte tag offsets
-  uint32_t m_used; //!< the number of used bytes in the buffer
+  uint32_t m_used; //!< the number of tags in use
   struct ByteTagListData *m_data; //!< the ByteTagListData structure
 };
 
@@ -0,0 +1,357 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-allocator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketAllocator");
+
+NS_OBJECT_ENSURE_REGISTERED (PacketAllocator);
+
+namespace {
+
+/** Size of the smallest size class, in bytes. */
+const std::size_t POOL_MIN_SIZE = 64;
+/** Number of size classes; larger blocks use the global allocator. */
+const std::size_t POOL_CLASSES = 11;
+/** Maximum number of free blocks kept per size class and thread. */
+const uint32_t POOL_MAX_FREE = 4096;
+/** Maximum number of free bytes kept per size class and thread. */
+const std::size_t POOL_MAX_FREE_BYTES = 4 * 1024 * 1024;
+
+/** The states of the free lists of a thread. */
+enum PoolsState
+{
+  POOLS_UNUSED = 0,  //!< No allocation yet, the guard is not constructed.
+  POOLS_ACTIVE,      //!< The guard is constructed.
+  POOLS_RELEASED     //!< The guard has been destroyed.
+};
+
+/** A free block. */
+struct FreeBlock
+{
+  FreeBlock *next;  //!< Next free block of the same size class.
+};
+
+/**
+ * A statistics counter, written by its thread only and read by any.
+ */
+typedef std::atomic<uint64_t> Counter;
+
+/**
+ * Add to a counter of the current thread.
+ * \param counter the counter.
+ * \param delta the value to add.
+ */
+inline void
+Add (Counter &counter, int64_t delta)
+{
+  // only the owning thread writes, so this needs no atomic addition
+  counter.store (counter.load (std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * Per-thread free lists.  This is trivially destructible so that it
+ * stays usable while other thread_local and static objects are
+ * destroyed; the memory is released by PoolsGuard.
+ */
+struct Pools
+{
+  FreeBlock *head[POOL_CLASSES];   //!< Free blocks of each size class.
+  uint32_t count[POOL_CLASSES];    //!< Length of each free list.
+  Counter allocations;             //!< Blocks allocated.
+  Counter reuses;                  //!< Blocks allocated from the free lists.
+  Counter freeBlocks;              //!< Blocks in the free lists.
+  Counter freeBytes;               //!< Bytes in the free lists.
+  uint8_t state;                   //!< A PoolsState.
+};
+
+/** The statistics of all the threads. */
+struct Registry
+{
+  std::mutex mutex;                //!< Protects this registry.
+  std::vector<Pools *> pools;      //!< Pools of the running threads.
+  uint64_t allocations;            //!< Blocks allocated by the exited threads.
+  uint64_t reuses;                 //!< Reuses by the exited threads.
+};
+
+/**
+ * \returns the registry, never destroyed so that threads exiting
+ *          late can still use it.
+ */
+Registry *
+GetRegistry (void)
+{
+  static Registry *registry = new Registry ();
+  return registry;
+}
+
+/*
+ * The free lists are reached on every packet allocation.  The default
+ * TLS model of a shared library costs a call to __tls_get_addr on each
+ * access, which is as much as the malloc they replace; the initial-exec
+ * model, as malloc itself uses, costs a load.  Pools is small enough to
+ * fit in the static TLS surplus even when the library is loaded with
+ * dlopen, as the python bindings do.
+ */
+#if defined (__GNUC__)
+#define POOLS_TLS_MODEL __attribute__ ((tls_model ("initial-exec")))
+#else
+#define POOLS_TLS_MODEL
+#endif
+
+/** The free lists of the current thread. */
+thread_local Pools g_pools POOLS_TLS_MODEL;
+
+/** Release the free lists when the thread exits. */
+struct PoolsGuard
+{
+  ~PoolsGuard ()
+  {
+    Pools &pools = g_pools;
+    for (std::size_t c = 0; c < POOL_CLASSES; ++c)
+      {
+        while (pools.head[c] != 0)
+          {
+            FreeBlock *block = pools.head[c];
+            pools.head[c] = block->next;
+            ::operator delete (block);
+          }
+        pools.count[c] = 0;
+      }
+    Registry *registry = GetRegistry ();
+    std::lock_guard<std::mutex> lock (registry->mutex);
+    registry->allocations += pools.allocations.load (std::memory_order_relaxed);
+    registry->reuses += pools.reuses.load (std::memory_order_relaxed);
+    registry->pools.erase (std::find (registry->pools.begin (), registry->pools.end (), &pools));
+    // blocks released from now on go back to the global allocator
+    pools.state = POOLS_RELEASED;
+  }
+};
+
+/** Constructed on the first allocation of each thread. */
+thread_local PoolsGuard g_poolsGuard;
+
+/**
+ * \param size a number of bytes.
+ * \returns the size class of \p size, POOL_CLASSES if too large.
+ */
+inline std::size_t
+GetClass (std::size_t size)
+{
+  std::size_t c = 0;
+  std::size_t classSize = POOL_MIN_SIZE;
+  while (classSize < size && c < POOL_CLASSES)
+    {
+      classSize <<= 1;
+      c++;
+    }
+  return c;
+}
+
+/**
+ * \param c a size class.
+ * \returns the number of bytes of the blocks of \p c.
+ */
+inline std::size_t
+GetClassSize (std::size_t c)
+{
+  return POOL_MIN_SIZE << c;
+}
+
+/**
+ * \param c a size class.
+ * \returns the maximum number of free blocks of \p c per thread.
+ */
+inline uint32_t
+GetMaxFree (std::size_t c)
+{
+  return std::min<std::size_t> (POOL_MAX_FREE, (POOL_MAX_FREE_BYTES / POOL_MIN_SIZE) >> c);
+}
+
+/**
+ * Allocate a block when the free list of its class is empty.
+ * \param pools the free lists of the current thread.
+ * \param size the size of the block.
+ * \returns the block.
+ */
+void *
+AllocateSlow (Pools &pools, std::size_t size)
+{
+  if (pools.state == POOLS_UNUSED)
+    {
+      // odr-use the guard to register its destructor for this thread
+      (void) &g_poolsGuard;
+      pools.state = POOLS_ACTIVE;
+      Registry *registry = GetRegistry ();
+      std::lock_guard<std::mutex> lock (registry->mutex);
+      registry->pools.push_back (&pools);
+    }
+  if (pools.state == POOLS_ACTIVE)
+    {
+      Add (pools.allocations, 1);
+    }
+  return ::operator new (size);
+}
+
+} // unnamed namespace
+
+TypeId
+PacketAllocator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PacketAllocator")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<PacketAllocator> ()
+    .AddAttribute ("Allocations",
+                   "The number of blocks allocated.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PacketAllocator::GetAllocations),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Reuses",
+                   "The number of blocks allocated from the free lists.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PacketAllocator::GetReuses),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("FreeBlocks",
+                   "The number of blocks in the free lists.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PacketAllocator::GetFreeBlocks),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("FreeBytes",
+                   "The number of bytes in the free lists.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PacketAllocator::GetFreeBytes),
+                   MakeUintegerChecker<uint64_t> ())
+  ;
+  return tid;
+}
+
+void *
+PacketAllocator::Allocate (std::size_t &size)
+{
+  std::size_t c = GetClass (size);
+  if (c >= POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  // the block may end up in any free list of its class
+  size = GetClassSize (c);
+  Pools &pools = g_pools;
+  FreeBlock *block = pools.head[c];
+  if (block == 0)
+    {
+      return AllocateSlow (pools, size);
+    }
+  pools.head[c] = block->next;
+  pools.count[c]--;
+  Add (pools.allocations, 1);
+  Add (pools.reuses, 1);
+  Add (pools.freeBlocks, -1);
+  Add (pools.freeBytes, -static_cast<int64_t> (size));
+  return block;
+}
+
+void
+PacketAllocator::Deallocate (void *p, std::size_t size)
+{
+  std::size_t c = GetClass (size);
+  if (c >= POOL_CLASSES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  Pools &pools = g_pools;
+  // A block released by a thread which never allocated has no guard
+  // to release it, so it goes back to the global allocator.
+  if (pools.state != POOLS_ACTIVE || pools.count[c] >= GetMaxFree (c))
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = pools.head[c];
+  pools.head[c] = block;
+  pools.count[c]++;
+  Add (pools.freeBlocks, 1);
+  Add (pools.freeBytes, GetClassSize (c));
+}
+
+uint64_t
+PacketAllocator::GetAllocations (void) const
+{
+  Registry *registry = GetRegistry ();
+  std::lock_guard<std::mutex> lock (registry->mutex);
+  uint64_t total = registry->allocations;
+  for (std::vector<Pools *>::const_iterator i = registry->pools.begin (); i != registry->pools.end (); ++i)
+    {
+      total += (*i)->allocations.load (std::memory_order_relaxed);
+    }
+  return total;
+}
+
+uint64_t
+PacketAllocator::GetReuses (void) const
+{
+  Registry *registry = GetRegistry ();
+  std::lock_guard<std::mutex> lock (registry->mutex);
+  uint64_t total = registry->reuses;
+  for (std::vector<Pools *>::const_iterator i = registry->pools.begin (); i != registry->pools.end (); ++i)
+    {
+      total += (*i)->reuses.load (std::memory_order_relaxed);
+    }
+  return total;
+}
+
+uint64_t
+PacketAllocator::GetFreeBlocks (void) const
+{
+  Registry *registry = GetRegistry ();
+  std::lock_guard<std::mutex> lock (registry->mutex);
+  uint64_t total = 0;
+  for (std::vector<Pools *>::const_iterator i = registry->pools.begin (); i != registry->pools.end (); ++i)
+    {
+      total += (*i)->freeBlocks.load (std::memory_order_relaxed);
+    }
+  return total;
+}
+
+uint64_t
+PacketAllocator::GetFreeBytes (void) const
+{
+  Registry *registry = GetRegistry ();
+  std::lock_guard<std::mutex> lock (registry->mutex);
+  uint64_t total = 0;
+  for (std::vector<Pools *>::const_iterator i = registry->pools.begin (); i != registry->pools.end (); ++i)
+    {
+      total += (*i)->freeBytes.load (std::memory_order_relaxed);
+    }
+  return total;
+}
+
+} // namespace ns3
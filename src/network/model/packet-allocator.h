@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PACKET_ALLOCATOR_H
+#define PACKET_ALLOCATOR_H
+
+#include "ns3/object.h"
+#include <cstddef>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief the memory pools of the Packet and Buffer objects
+ *
+ * Packet objects and the byte storage of Buffer objects are allocated
+ * from size classes: powers of two from 64 bytes to 64 KiB.  Each
+ * thread keeps a free list per size class, so that a block released by
+ * a thread is reused by the next allocation of its size class on that
+ * thread without locking.  A block may be released on another thread
+ * than the one which allocated it; it then joins the free lists of the
+ * releasing thread.  The free lists are bounded, and released when
+ * their thread exits.  Larger blocks use the global allocator.
+ *
+ * The allocation functions are static; an instance of this class only
+ * reports the statistics of the pools, summed over all the threads,
+ * through its read-only attributes:
+ *
+ * \code
+ *   UintegerValue reuses;
+ *   CreateObject<PacketAllocator> ()->GetAttribute ("Reuses", reuses);
+ * \endcode
+ */
+class PacketAllocator : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Allocate a block.
+   * \param [in,out] size the number of bytes needed, set to the number
+   *        of bytes of the block returned, which may be larger.
+   * \returns the block.
+   */
+  static void * Allocate (std::size_t &size);
+  /**
+   * Release a block.
+   * \param p the block, returned by Allocate.
+   * \param size the number of bytes of the block, as set by Allocate,
+   *        or the number of bytes requested.
+   */
+  static void Deallocate (void *p, std::size_t size);
+
+  /**
+   * \returns the number of blocks allocated.
+   */
+  uint64_t GetAllocations (void) const;
+  /**
+   * \returns the number of blocks allocated from the free lists.
+   */
+  uint64_t GetReuses (void) const;
+  /**
+   * \returns the number of blocks in the free lists.
+   */
+  uint64_t GetFreeBlocks (void) const;
+  /**
+   * \returns the number of bytes in the free lists.
+   */
+  uint64_t GetFreeBytes (void) const;
+};
+
+} // namespace ns3
+
+#endif /* PACKET_ALLOCATOR_H */
@@ -26,6 +26,7 @@
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
+#include "packet-allocator.h"
 
 namespace ns3 {
 
@@ -33,6 +34,7 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_deferred = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
@@ -70,6 +72,14 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::EnableDeferred (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Enable ();
+  m_deferred = true;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -644,12 +654,168 @@ PacketMetadata
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 {
   NS_LOG_FUNCTION (this << start << end);
+  // the fragments share the list of items rather than each apply the
+  // recorded operations again
+  Materialize ();
   PacketMetadata fragment = *this;
   fragment.RemoveAtStart (start);
   fragment.RemoveAtEnd (end);
   return fragment;
 }
 
+void
+PacketMetadata::Record (uint8_t type, uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) type << uid << size);
+  if (m_operations == 0)
+    {
+      AllocateOperations ();
+    }
+  // Materialize and Apply only reset the log, they do not free it
+  struct OperationLog *log = m_operations;
+  if (log->n > 0)
+    {
+      const struct Operation &last = log->operations[log->n - 1];
+      bool cancels = false;
+      switch (type)
+        {
+        case REMOVE_HEADER:
+          cancels = last.type == ADD_HEADER && last.uid == uid && last.size == size;
+          break;
+        case REMOVE_TRAILER:
+          cancels = last.type == ADD_TRAILER && last.uid == uid && last.size == size;
+          break;
+        case REMOVE_AT_START:
+          cancels = last.type == ADD_HEADER && last.size == size;
+          break;
+        case REMOVE_AT_END:
+          cancels = last.type == ADD_TRAILER && last.size == size;
+          break;
+        default:
+          break;
+        }
+      if (cancels)
+        {
+          log->n--;
+          return;
+        }
+    }
+  if (log->n == MAX_OPERATIONS)
+    {
+      Materialize ();
+    }
+  struct Operation operation;
+  operation.type = type;
+  operation.uid = uid;
+  operation.size = size;
+  operation.chunkUid = 0;
+  if (type == ADD_HEADER || type == ADD_TRAILER)
+    {
+      operation.chunkUid = m_chunkUid;
+      m_chunkUid++;
+    }
+  if (m_enableChecking && (type == REMOVE_HEADER || type == REMOVE_TRAILER))
+    {
+      // report an unexpected header or trailer where it is removed
+      Materialize ();
+      Apply (operation);
+      return;
+    }
+  log->operations[log->n] = operation;
+  log->n++;
+}
+
+void
+PacketMetadata::Materialize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_operations == 0 || m_operations->n == 0)
+    {
+      return;
+    }
+  // applying the operations changes the representation of the
+  // metadata, not the packet it describes
+  PacketMetadata *self = const_cast<PacketMetadata *> (this);
+  struct Operation operations[MAX_OPERATIONS];
+  uint8_t nOperations = m_operations->n;
+  std::copy (m_operations->operations, m_operations->operations + nOperations, operations);
+  // RemoveAtStart and RemoveAtEnd may assign a new list to this object
+  self->m_operations->n = 0;
+  for (uint8_t i = 0; i < nOperations; i++)
+    {
+      self->Apply (operations[i]);
+    }
+}
+
+void
+PacketMetadata::AllocateOperations (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::size_t size = sizeof (struct OperationLog);
+  m_operations = static_cast<struct OperationLog *> (PacketAllocator::Allocate (size));
+  m_operations->n = 0;
+}
+
+void
+PacketMetadata::CopyOperations (const PacketMetadata &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  uint8_t n = o.m_operations != 0 ? o.m_operations->n : 0;
+  if (n == 0)
+    {
+      // keep our log, if any, for the next recorded operation
+      if (m_operations != 0)
+        {
+          m_operations->n = 0;
+        }
+      return;
+    }
+  if (m_operations == 0)
+    {
+      AllocateOperations ();
+    }
+  std::copy (o.m_operations->operations, o.m_operations->operations + n, m_operations->operations);
+  m_operations->n = n;
+}
+
+void
+PacketMetadata::FreeOperations (void)
+{
+  NS_LOG_FUNCTION (this);
+  PacketAllocator::Deallocate (m_operations, sizeof (struct OperationLog));
+  m_operations = 0;
+}
+
+void
+PacketMetadata::Apply (const struct Operation &operation)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) operation.type << operation.uid << operation.size);
+  switch (operation.type)
+    {
+    case ADD_HEADER:
+      ApplyAddHeader (operation.uid, operation.size, operation.chunkUid);
+      break;
+    case REMOVE_HEADER:
+      ApplyRemoveHeader (operation.uid, operation.size);
+      break;
+    case ADD_TRAILER:
+      ApplyAddTrailer (operation.uid, operation.size, operation.chunkUid);
+      break;
+    case REMOVE_TRAILER:
+      ApplyRemoveTrailer (operation.uid, operation.size);
+      break;
+    case REMOVE_AT_START:
+      ApplyRemoveAtStart (operation.size);
+      break;
+    case REMOVE_AT_END:
+      ApplyRemoveAtEnd (operation.size);
+      break;
+    default:
+      NS_ASSERT (false);
+      break;
+    }
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
@@ -668,14 +834,24 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-
+  if (m_deferred)
+    {
+      Record (ADD_HEADER, uid, size);
+      return;
+    }
+  ApplyAddHeader (uid, size, m_chunkUid);
+  m_chunkUid++;
+}
+void
+PacketMetadata::ApplyAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
@@ -690,6 +866,17 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_deferred)
+    {
+      Record (REMOVE_HEADER, uid, size);
+      return;
+    }
+  ApplyRemoveHeader (uid, size);
+}
+void
+PacketMetadata::ApplyRemoveHeader (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -738,13 +925,24 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_deferred)
+    {
+      Record (ADD_TRAILER, uid, size);
+      return;
+    }
+  ApplyAddTrailer (uid, size, m_chunkUid);
+  m_chunkUid++;
+}
+void
+PacketMetadata::ApplyAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
@@ -760,6 +958,17 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_deferred)
+    {
+      Record (REMOVE_TRAILER, uid, size);
+      return;
+    }
+  ApplyRemoveTrailer (uid, size);
+}
+void
+PacketMetadata::ApplyRemoveTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -807,6 +1016,8 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  Materialize ();
+  o.Materialize ();
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -895,6 +1106,20 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
+  if (m_deferred)
+    {
+      if (start > 0)
+        {
+          Record (REMOVE_AT_START, 0, start);
+        }
+      return;
+    }
+  ApplyRemoveAtStart (start);
+}
+void
+PacketMetadata::ApplyRemoveAtStart (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -958,6 +1183,20 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
+  if (m_deferred)
+    {
+      if (end > 0)
+        {
+          Record (REMOVE_AT_END, 0, end);
+        }
+      return;
+    }
+  ApplyRemoveAtEnd (end);
+}
+void
+PacketMetadata::ApplyRemoveAtEnd (uint32_t end)
+{
+  NS_LOG_FUNCTION (this << end);
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -1046,6 +1285,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1145,6 +1385,7 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1178,6 +1419,7 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  Materialize ();
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1279,6 +1521,7 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  Materialize ();
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
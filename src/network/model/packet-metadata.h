@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#include <algorithm>
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
@@ -74,6 +75,17 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Maintaining this list on every operation costs a lot more than the
+ * operations themselves, while the list of most packets is never read.
+ * In deferred mode (see EnableDeferred), the operations which add or
+ * remove headers, trailers and bytes are only recorded, in a small
+ * array of the PacketMetadata itself.  The removal of a header or
+ * trailer which was the last operation recorded cancels it, as is the
+ * case when a packet is forwarded: the array then stays short.  The
+ * operations recorded are applied to the list when it is read, by
+ * BeginItem, AddAtEnd or the serialization methods, or when the array
+ * is full.
  */
 class PacketMetadata 
 {
@@ -160,6 +172,13 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata, in deferred mode
+   *
+   * The operations on the packets are recorded, and the list of items
+   * is computed only when it is read.
+   */
+  static void EnableDeferred (void);
 
   /**
    * \brief Constructor
@@ -620,6 +639,117 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+
+  /// Type of a recorded operation
+  enum OperationType
+  {
+    ADD_HEADER,      //!< AddHeader
+    REMOVE_HEADER,   //!< RemoveHeader
+    ADD_TRAILER,     //!< AddTrailer
+    REMOVE_TRAILER,  //!< RemoveTrailer
+    REMOVE_AT_START, //!< RemoveAtStart
+    REMOVE_AT_END    //!< RemoveAtEnd
+  };
+  /**
+   * \brief An operation recorded in deferred mode, not yet applied
+   * to the list of items
+   */
+  struct Operation
+  {
+    /** typeUid of the header or trailer, as in SmallItem */
+    uint32_t uid;
+    /** size of the header or trailer, or number of bytes removed */
+    uint32_t size;
+    /** chunkUid of the header or trailer added */
+    uint16_t chunkUid;
+    /** an OperationType */
+    uint8_t type;
+  };
+  /**
+   * the maximum number of operations recorded, after which they are
+   * applied to the list
+   */
+  static const uint8_t MAX_OPERATIONS = 6;
+  /**
+   * \brief The operations recorded in deferred mode.
+   *
+   * It is allocated on the first recorded operation, so that packets
+   * only carry a pointer when the deferred mode is not used.
+   */
+  struct OperationLog
+  {
+    uint8_t n; //!< number of operations recorded
+    struct Operation operations[MAX_OPERATIONS]; //!< operations recorded
+  };
+  /**
+   * \brief Record an operation, or cancel the last one recorded if
+   * this one undoes it.
+   * \param type the OperationType
+   * \param uid typeUid of the header or trailer
+   * \param size size of the header or trailer, or number of bytes removed
+   */
+  void Record (uint8_t type, uint32_t uid, uint32_t size);
+  /**
+   * \brief Apply the recorded operations to the list of items.
+   *
+   * This does not change the packet described, hence the method is
+   * const.
+   */
+  void Materialize (void) const;
+  /**
+   * \brief Allocate an empty log of recorded operations
+   */
+  void AllocateOperations (void);
+  /**
+   * \brief Copy the recorded operations of another metadata
+   * \param o the other metadata
+   */
+  void CopyOperations (const PacketMetadata &o);
+  /**
+   * \brief Release the log of recorded operations
+   */
+  void FreeOperations (void);
+  /**
+   * \brief Apply an operation to the list of items
+   * \param operation the operation
+   */
+  void Apply (const struct Operation &operation);
+  /**
+   * \brief Add an header to the list of items
+   * \param uid header's uid to add
+   * \param size header serialized size
+   * \param chunkUid the chunkUid of the header
+   */
+  void ApplyAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Remove an header from the list of items
+   * \param uid header's uid to remove
+   * \param size header serialized size
+   */
+  void ApplyRemoveHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer to the list of items
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   * \param chunkUid the chunkUid of the trailer
+   */
+  void ApplyAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Remove a trailer from the list of items
+   * \param uid trailer's uid to remove
+   * \param size trailer serialized size
+   */
+  void ApplyRemoveTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove bytes at the start of the list of items
+   * \param start the number of bytes to remove
+   */
+  void ApplyRemoveAtStart (uint32_t start);
+  /**
+   * \brief Remove bytes at the end of the list of items
+   * \param end the number of bytes to remove
+   */
+  void ApplyRemoveAtEnd (uint32_t end);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -664,6 +794,7 @@ public:
   static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_deferred; //!< Record the operations rather than apply them
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -685,6 +816,7 @@ public:
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
   uint64_t m_packetUid; //!< packet Uid
+  struct OperationLog *m_operations; //!< operations recorded, 0 if none ever was
 };
 
 } // namespace ns3
@@ -696,7 +828,8 @@ PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_operations (0)
 {
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
@@ -709,11 +842,16 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_operations (0)
 {
   NS_ASSERT (m_data != 0);
   NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
   m_data->m_count++;
+  if (o.m_operations != 0)
+    {
+      CopyOperations (o);
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -735,6 +873,10 @@ PacketMetadata::operator = (PacketMetadata const& o)
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  if (this != &o && (m_operations != 0 || o.m_operations != 0))
+    {
+      CopyOperations (o);
+    }
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
@@ -745,6 +887,10 @@ PacketMetadata::~PacketMetadata ()
     {
       PacketMetadata::Recycle (m_data);
     }
+  if (m_operations != 0)
+    {
+      FreeOperations ();
+    }
 }
 
 } // namespace ns3
@@ -20,284 +20,243 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a list of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
+#include "packet-allocator.h"
 #include "tag-buffer.h"
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
 #include <cstring>
 
+#define INITIAL_CAPACITY 6
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-PacketTagList::TagData *
-PacketTagList::CreateTagData (size_t dataSize)
+struct PacketTagListData *
+PacketTagList::Allocate (uint32_t capacity, uint32_t size)
 {
-  NS_ASSERT_MSG (dataSize
-                 < std::numeric_limits<decltype(TagData::size)>::max (),
-                 "Requested TagData size " << dataSize
-                 << " exceeds maximum "
-                 << std::numeric_limits<decltype(TagData::size)>::max () );
-
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
-
-  TagData * tag = new (p) TagData;
-  tag->size = dataSize;
-  return tag;
+  std::size_t header = sizeof (struct PacketTagListData) + capacity * sizeof (struct TagData);
+  std::size_t bytes = header + size;
+  /* the block of the size class may hold a larger arena than requested */
+  void *buffer = PacketAllocator::Allocate (bytes);
+  struct PacketTagListData *data = static_cast<struct PacketTagListData *> (buffer);
+  data->count = 1;
+  data->dirty = 0;
+  data->capacity = capacity;
+  data->size = static_cast<uint32_t> (bytes - header);
+  data->used = 0;
+  data->mask = 0;
+  return data;
 }
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+void
+PacketTagList::Deallocate (struct PacketTagListData *data)
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
-
-  // trivial case when list is empty
-  if (m_next == 0)
+  data->count--;
+  if (data->count == 0)
     {
-      return false;
+      PacketAllocator::Deallocate (data, sizeof (struct PacketTagListData)
+                                   + data->capacity * sizeof (struct TagData)
+                                   + data->size);
     }
+}
 
-  bool found = false;
-
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
-
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+void
+PacketTagList::Reallocate (uint32_t capacity, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << capacity << size);
+  NS_ASSERT (capacity >= m_used);
+  struct PacketTagListData *data = Allocate (capacity, size);
+  struct TagData *from = m_data->GetTags ();
+  struct TagData *to = data->GetTags ();
+  for (uint32_t i = 0; i < m_used; ++i)
     {
-      if (cur->count > 1)
+      to[i] = from[i];
+      if (from[i].size > PACKET_TAG_INLINE_SIZE)
         {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
+          NS_ASSERT (data->used + from[i].size <= data->size);
+          std::memcpy (data->GetArena () + data->used,
+                       m_data->GetArena () + from[i].offset,
+                       from[i].size);
+          to[i].offset = data->used;
+          data->used += from[i].size;
         }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
-
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
-    {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
     }
+  data->dirty = m_used;
+  Deallocate (m_data);
+  m_data = data;
+  UpdateMask ();
+}
 
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+uint32_t
+PacketTagList::GetArenaSize (void) const
+{
+  uint32_t size = 0;
+  const struct TagData *tags = Begin ();
+  for (uint32_t i = 0; i < m_used; ++i)
     {
-      if (it->tid == tid)
+      if (tags[i].size > PACKET_TAG_INLINE_SIZE)
         {
-          break;
+          size += tags[i].size;
         }
     }
-  if (it == 0)
-    {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
-    }
+  return size;
+}
 
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+void
+PacketTagList::UpdateMask (void)
+{
+  // the filter of a shared block must cover the tags of all its lists
+  uint64_t mask = m_data->count == 1 ? 0 : m_data->mask;
+  const struct TagData *tags = m_data->GetTags ();
+  for (uint32_t i = 0; i < m_used; ++i)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = CreateTagData (cur->size);
-      copy->tid = cur->tid;
-      copy->count = 1;
-      copy->size = cur->size;
-      memcpy (copy->data, cur->data, copy->size);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      mask |= PacketTagListData::GetMask (tags[i].tid);
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
+  m_data->mask = mask;
 }
 
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
-}
-
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_used)
     {
-      // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      NS_LOG_INFO ("tid not found");
+      return false;
     }
-  else
+  struct TagData *tags = m_data->GetTags ();
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (GetData (tags + i)),
+                              const_cast<uint8_t *> (GetData (tags + i)) + tags[i].size));
+  if (i + 1 == m_used)
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
+      // the last tag added, which other lists may still use
+      NS_LOG_INFO ("found tid at the head");
+      m_used--;
+      if (m_data->count == 1)
         {
-          // there's a next, so make it a merge
-          cur->next->count++;
+          m_data->dirty = m_used;
+          UpdateMask ();
         }
+      return true;
+    }
+  if (m_data->count != 1)
+    {
+      NS_LOG_INFO ("found tid in a shared block, copying");
+      Reallocate (m_data->capacity, GetArenaSize ());
+      tags = m_data->GetTags ();
     }
-  return found;
+  // the data of a large tag is left in the arena until the next copy
+  std::copy (tags + i + 1, tags + m_used, tags + i);
+  m_used--;
+  m_data->dirty = m_used;
+  UpdateMask ();
+  return true;
 }
 
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_used)
     {
       Add (tag);
+      return false;
     }
-  return found;
-}
-
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
+  uint32_t size = tag.GetSerializedSize ();
+  uint32_t bytes = size > PACKET_TAG_INLINE_SIZE ? size : 0;
+  struct TagData *tags = m_data->GetTags ();
+  if (m_data->count != 1
+      || (bytes > tags[i].size && m_data->used + bytes > m_data->size))
     {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data, cur->data + cur->size));
+      NS_LOG_INFO ("found tid in a shared or full block, copying");
+      Reallocate (m_data->capacity, 2 * (GetArenaSize () + bytes));
+      tags = m_data->GetTags ();
     }
-  else
+  // a tag larger than before moves to the end of the arena
+  if (bytes > tags[i].size)
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = CreateTagData (tag.GetSerializedSize ());
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data, copy->data + copy->size));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      tags[i].offset = m_data->used;
+      m_data->used += bytes;
     }
-  return found;
+  tags[i].size = size;
+  uint8_t *buffer = const_cast<uint8_t *> (GetData (tags + i));
+  tag.Serialize (TagBuffer (buffer, buffer + size));
+  m_data->dirty = m_used;
+  return true;
 }
 
 void
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  NS_ASSERT_MSG (Find (tid) == m_used,
+                 "Error: cannot add the same kind of tag twice.");
+  uint32_t size = tag.GetSerializedSize ();
+  uint32_t bytes = size > PACKET_TAG_INLINE_SIZE ? size : 0;
+
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  if (m_data == 0)
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
-                     "Error: cannot add the same kind of tag twice.");
+      self->m_data = Allocate (INITIAL_CAPACITY, bytes);
     }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
-  tag.Serialize (TagBuffer (head->data, head->data + head->size));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  else if (m_data->dirty != m_used
+           || m_used == m_data->capacity
+           || m_data->used + bytes > m_data->size)
+    {
+      // another list added to the block, or the block is full
+      uint32_t capacity = std::max<uint32_t> (m_data->capacity, m_used + 1);
+      if (m_used == m_data->capacity)
+        {
+          capacity = 2 * m_used;
+        }
+      uint32_t arena = GetArenaSize () + bytes;
+      if (bytes != 0)
+        {
+          arena *= 2;
+        }
+      self->Reallocate (capacity, arena);
+    }
+  struct TagData *entry = m_data->GetTags () + m_used;
+  entry->tid = tid;
+  entry->size = size;
+  entry->offset = m_data->used;
+  m_data->used += bytes;
+  uint8_t *buffer = const_cast<uint8_t *> (GetData (entry));
+  tag.Serialize (TagBuffer (buffer, buffer + size));
+  m_data->mask |= PacketTagListData::GetMask (tid);
+  self->m_used++;
+  m_data->dirty = m_used;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_used)
     {
-      if (cur->tid == tid)
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
-}
-
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
-{
-  return m_next;
+  /* found tag */
+  const struct TagData *entry = m_data->GetTags () + i;
+  uint8_t *buffer = const_cast<uint8_t *> (GetData (entry));
+  tag.Deserialize (TagBuffer (buffer, buffer + entry->size));
+  return true;
 }
 
 uint32_t
@@ -309,7 +268,7 @@ PacketTagList::GetSerializedSize (void) const
 
   size = 4; // numberOfTags
 
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  for (const struct TagData *cur = Begin (); cur != End (); ++cur)
     {
       size += 4; // TagData -> size
 
@@ -346,8 +305,10 @@ PacketTagList::Serialize (uint32_t* buffer, uint32_t maxSize) const
       return 0;
     }
 
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  // from the head of the list, the last tag added
+  for (const struct TagData *cur = End (); cur != Begin (); )
     {
+      --cur;
       if (size + 4 <= maxSize)
         {
           *p++ = cur->size;
@@ -378,7 +339,7 @@ PacketTagList::Serialize (uint32_t* buffer, uint32_t maxSize) const
       uint32_t tagWordSize = (cur->size+3) & (~3);
       if (size + tagWordSize <= maxSize)
         {
-          memcpy (p, cur->data, cur->size);
+          memcpy (p, GetData (cur), cur->size);
           size += tagWordSize;
           p += tagWordSize / 4;
         }
@@ -407,14 +368,36 @@ PacketTagList::Deserialize (const uint32_t* buffer, uint32_t size)
 
   NS_LOG_INFO("Deserializing number of tags " << numberOfTags);
 
-  struct TagData * prevTag = 0;
+  RemoveAll ();
+  if (numberOfTags == 0)
+    {
+      NS_ASSERT (sizeCheck == 0);
+      return (sizeCheck != 0) ? 0 : 1;
+    }
+
+  // the arena is sized from the sizes of the tags
+  uint32_t hashSize = (sizeof (TypeId::hash_t)+3) & (~3);
+  uint32_t arena = 0;
+  const uint32_t* q = p;
+  for (uint32_t i = 0; i < numberOfTags; ++i)
+    {
+      uint32_t tagSize = *q++;
+      if (tagSize > PACKET_TAG_INLINE_SIZE)
+        {
+          arena += tagSize;
+        }
+      q += (hashSize + ((tagSize+3) & (~3))) / 4;
+    }
+  m_data = Allocate (numberOfTags, arena);
+  m_used = numberOfTags;
+
+  // the head of the list, the last tag added, comes first
   for (uint32_t i = 0; i < numberOfTags; ++i)
     {
       NS_ASSERT (sizeCheck >= 4);
       uint32_t tagSize = *p++;
       sizeCheck -= 4;
 
-      uint32_t hashSize = (sizeof (TypeId::hash_t)+3) & (~3);
       NS_ASSERT (sizeCheck >= hashSize);
       TypeId::hash_t hash;
       memcpy (&hash, p, sizeof (TypeId::hash_t));
@@ -425,31 +408,25 @@ PacketTagList::Deserialize (const uint32_t* buffer, uint32_t size)
 
       NS_LOG_INFO ("Deserializing tag of type " << tid);
 
-      struct TagData * newTag = CreateTagData (tagSize);
-      newTag->count = 1;
-      newTag->next = 0;
+      struct TagData * newTag = m_data->GetTags () + numberOfTags - 1 - i;
       newTag->tid = tid;
+      newTag->size = tagSize;
+      newTag->offset = m_data->used;
+      if (tagSize > PACKET_TAG_INLINE_SIZE)
+        {
+          m_data->used += tagSize;
+        }
 
       NS_ASSERT (sizeCheck >= tagSize);
-      memcpy (newTag->data, p, tagSize);
+      memcpy (const_cast<uint8_t *> (GetData (newTag)), p, tagSize);
 
       // ensure 4 byte boundary
       uint32_t tagWordSize = (tagSize+3) & (~3);
       p += tagWordSize / 4;
       sizeCheck -= tagWordSize;
-
-      // Set link list pointers.
-      if (i==0)
-        {
-          m_next = newTag;
-        }
-      else
-        {
-          prevTag->next = newTag;
-        }
-
-      prevTag = newTag;
     }
+  m_data->dirty = m_used;
+  UpdateMask ();
 
   NS_ASSERT (sizeCheck == 0);
 
@@ -460,4 +437,3 @@ PacketTagList::Deserialize (const uint32_t* buffer, uint32_t size)
 
 
 } /* namespace ns3 */
-
@@ -22,16 +22,24 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a list of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
 #include <ostream>
 #include "ns3/type-id.h"
 
+/**
+ * \ingroup packet
+ * Number of bytes of tag data stored along with the TypeId of a tag;
+ * the data of larger tags is stored in the arena of the list.
+ */
+#define PACKET_TAG_INLINE_SIZE 20
+
 namespace ns3 {
 
 class Tag;
+struct PacketTagListData;
 
 /**
  * \ingroup packet
@@ -43,88 +51,42 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
- *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
- *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
- *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
- *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
+ * The tags are stored in a single block, a PacketTagListData, which
+ * holds a fixed-capacity array of TagData entries, one per tag, in the
+ * order in which they were added.  The serialized data of a tag of up
+ * to #PACKET_TAG_INLINE_SIZE bytes is stored in its entry; the data of
+ * larger tags is stored in the arena which follows the array in the
+ * same block.  The blocks are allocated by PacketAllocator.
  *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
+ *   - The block also holds a 64-bit filter of the TypeIds of its tags,
+ *     bit <tt>uid % 64</tt> being set for each tag.  A lookup of a tag
+ *     type which is not in the filter, the common case of a Peek which
+ *     fails, returns at once; otherwise it scans the entries of the list,
+ *     without following any pointer.
  *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
- *
- * \par <b> Copy-on-write </b> is implemented as follows:
+ *   - Copy constructor (PacketTagList(const PacketTagList & o))
+ *     and assignment (#operator=(const PacketTagList & o)) share the
+ *     block of \c o, incrementing its \c count.
  *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
+ *   - Each list uses the first \c m_used entries of its block, and may
+ *     thus share it with lists holding more tags.  #Add appends the new
+ *     tag in place when the list is the last one which added to the
+ *     block (<tt>dirty == m_used</tt>), which leaves the tags of the
+ *     other lists alone; otherwise, or when the block is full, the
+ *     entries of the list are copied into a new block first.
  *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
+ *   - #Remove of the last tag added only shrinks the list.  #Remove of
+ *     another tag, and #Replace, modify the block in place when the list
+ *     is the only one using it, and copy it first otherwise.
  *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ * The head of the list, as returned by PacketTagIterator, is the last
+ * tag added.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
+   * Entry of a tag in the block of a PacketTagList.
    *
    * See PacketTagList for a discussion of the data structure.
    *
@@ -133,18 +95,13 @@ public:
    * PacketTagIterator::Item::GetTag() needs the data and size values.
    * The Item nested class can't be forward declared, so friending isn't
    * possible.
-   *
-   * We use placement new so we can allocate enough room for the Tag
-   * type which will be serialized into data.  See Object::Aggregates
-   * for a similar construction.
    */
   struct TagData
   {
-    struct TagData * next;      /**< Pointer to next in list */
-    uint32_t count;             /**< Number of incoming links */
-    TypeId tid;                 /**< Type of the tag serialized into #data */
-    uint32_t size;              /**< Size of the \c data buffer */
-    uint8_t data[1];            /**< Serialization buffer */
+    TypeId tid;                           /**< Type of the tag serialized into #data */
+    uint32_t size;                        /**< Size of the serialized tag */
+    uint32_t offset;                      /**< Position of the serialized tag in the arena, if larger than #data */
+    uint8_t data[PACKET_TAG_INLINE_SIZE]; /**< Serialization buffer of the small tags */
   };  /* struct TagData */
 
   /**
@@ -156,8 +113,7 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This makes a light-weight copy by sharing the block of \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,18 +123,18 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * sharing the block of \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * #RemoveAll's the tags.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the head of this list.
    *
    * \param [in] tag The tag to add
    */
@@ -210,13 +166,22 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the first tag added, 0 if the list is empty
+   */
+  inline const struct PacketTagList::TagData *Begin (void) const;
+  /**
+   * \returns pointer past the last tag added, the head of the list
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  inline const struct PacketTagList::TagData *End (void) const;
+  /**
+   * \param [in] tag A tag of this list.
+   * \returns the serialized data of \pname{tag}
+   */
+  inline const uint8_t *GetData (const struct PacketTagList::TagData *tag) const;
   /**
    * Returns number of bytes required for packet serialization.
    *
@@ -244,68 +209,88 @@ public:
 
 private:
   /**
-   * Allocate and construct a TagData struct, sizing the data area
-   * large enough to serialize dataSize bytes from a Tag.
+   * Allocate a block.
    *
-   * \param [in] dataSize The serialized size of the Tag.
-   * \returns The newly constructed TagData object.
+   * \param [in] capacity The number of tags of the block.
+   * \param [in] size The number of bytes of its arena.
+   * \returns The newly allocated block, its arena possibly larger.
    */
-  static
-  TagData * CreateTagData (size_t dataSize);
-  
+  static struct PacketTagListData * Allocate (uint32_t capacity, uint32_t size);
   /**
-   * Typedef of method function pointer for copy-on-write operations
+   * Release a reference to a block, and the block if it was the last.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * \param [in] data The block.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  static void Deallocate (struct PacketTagListData *data);
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
+   * Copy the tags of this list into a new block.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] capacity The number of tags of the new block.
+   * \param [in] size The number of bytes of its arena.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  void Reallocate (uint32_t capacity, uint32_t size);
   /**
-   * Copy-on-write implementing Remove.
-   *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \returns the number of bytes of the arena used by this list
    */
-  bool RemoveWriter  (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  uint32_t GetArenaSize (void) const;
   /**
-   * Copy-on-write implementing Replace
+   * Find a tag.
    *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \param [in] tid The type of the tag.
+   * \returns The index of the tag, \c m_used if not found.
+   */
+  inline uint32_t Find (TypeId tid) const;
+  /**
+   * Set the TypeId filter of the block from the tags of this list.
+   */
+  void UpdateMask (void);
+
+  /**
+   * The block of the tags, 0 if there is none
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  struct PacketTagListData *m_data;
+  /**
+   * The number of tags of the block used by this list
+   */
+  uint32_t m_used;
+};
+
+/**
+ * \ingroup packet
+ *
+ * \brief The block of the tags of a PacketTagList.
+ *
+ * This structure is only used by PacketTagList and should not be accessed
+ * directly.  It is followed, in the same block, by the array of the
+ * \c capacity entries of the tags, and by the \c size bytes of the arena.
+ */
+struct PacketTagListData
+{
+  uint32_t count;    //!< Number of PacketTagList using this block
+  uint32_t dirty;    //!< Number of tags of the list which added last
+  uint32_t capacity; //!< Number of tags which fit in the array
+  uint32_t size;     //!< Number of bytes of the arena
+  uint32_t used;     //!< Number of bytes of the arena used
+  uint64_t mask;     //!< Filter of the TypeIds of the tags
 
+  /** \returns the array of the tags */
+  struct PacketTagList::TagData *GetTags (void)
+  {
+    return reinterpret_cast<struct PacketTagList::TagData *> (this + 1);
+  }
+  /** \returns the arena */
+  uint8_t *GetArena (void)
+  {
+    return reinterpret_cast<uint8_t *> (GetTags () + capacity);
+  }
   /**
-   * Pointer to first \ref TagData on the list
+   * \param [in] tid The type of a tag.
+   * \returns the bit of \pname{tid} in the filter
    */
-  struct TagData *m_next;
+  static uint64_t GetMask (TypeId tid)
+  {
+    return static_cast<uint64_t> (1) << (tid.GetUid () % 64);
+  }
 };
 
 } // namespace ns3
@@ -317,16 +302,18 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_data (0),
+    m_used (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_data (o.m_data),
+    m_used (o.m_used)
 {
-  if (m_next != 0)
+  if (m_data != 0)
     {
-      m_next->count++;
+      m_data->count++;
     }
 }
 
@@ -334,16 +321,17 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (o.m_data != 0)
     {
-      m_next->count++;
+      o.m_data->count++;
     }
+  RemoveAll ();
+  m_data = o.m_data;
+  m_used = o.m_used;
   return *this;
 }
 
@@ -355,27 +343,52 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  if (m_data != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
-        {
-          prev->~TagData ();
-          std::free (prev);
-        }
-      prev = cur;
+      Deallocate (m_data);
+    }
+  m_data = 0;
+  m_used = 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Begin (void) const
+{
+  return m_data != 0 ? m_data->GetTags () : 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::End (void) const
+{
+  return m_data != 0 ? m_data->GetTags () + m_used : 0;
+}
+
+const uint8_t *
+PacketTagList::GetData (const struct PacketTagList::TagData *tag) const
+{
+  if (tag->size <= PACKET_TAG_INLINE_SIZE)
+    {
+      return tag->data;
     }
-  if (prev != 0) 
+  return m_data->GetArena () + tag->offset;
+}
+
+uint32_t
+PacketTagList::Find (TypeId tid) const
+{
+  if (m_data == 0 || (m_data->mask & PacketTagListData::GetMask (tid)) == 0)
     {
-      prev->~TagData ();
-      std::free (prev);
+      return m_used;
+    }
+  const struct TagData *tags = m_data->GetTags ();
+  for (uint32_t i = 0; i < m_used; ++i)
+    {
+      if (tags[i].tid == tid)
+        {
+          return i;
+        }
     }
-  m_next = 0;
+  return m_used;
 }
 
 } // namespace ns3
@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -156,9 +157,11 @@ private:
     /**
      * Constructor
      * \param data the data to copy.
+     * \param buffer the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
+    Item (const struct PacketTagList::TagData *data, const uint8_t *buffer);
     const struct PacketTagList::TagData *m_data; //!< the tag data
+    const uint8_t *m_buffer;                     //!< the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -173,10 +176,11 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of a packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;                     //!< the tags of the packet
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet, past the next one
 };
 
 /**
@@ -199,7 +203,9 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. Packet::EnableDeferredPrinting provides the
+ * same output as Packet::EnablePrinting at a lower cost for the packets
+ * which are never printed.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -231,6 +237,20 @@ private:
 class Packet : public SimpleRefCount<Packet>
 {
 public:
+  /**
+   * Allocate a packet from the free list of the current thread.
+   *
+   * \param [in] size The size of the packet.
+   * \returns The memory for the packet.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return a packet to the free list of the current thread.
+   *
+   * \param [in] p The memory of the packet.
+   * \param [in] size The size of the packet.
+   */
+  static void operator delete (void *p, std::size_t size);
 
   /**
    * \brief Create an empty packet with a new uid (as returned
@@ -530,6 +550,18 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable printing packets metadata, computed on demand.
+   *
+   * This is equivalent to EnablePrinting, except that the metadata of
+   * a packet only records the headers and trailers added and removed;
+   * the description used by the Print methods is computed from these
+   * operations when it is needed.  A header or trailer removed right
+   * after it was added costs almost nothing, which is the common case
+   * when packets are forwarded.  This mode must also be selected at the
+   * beginning of the simulation.
+   */
+  static void EnableDeferredPrinting (void);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -787,7 +819,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid, shared by the simulation threads
 };
 
 /**
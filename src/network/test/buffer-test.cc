@@ -387,6 +387,88 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // test buffers made of several segments
+  Buffer a = Buffer (3);
+  a.AddAtStart (2);
+  i = a.Begin ();
+  i.WriteU8 (0x1);
+  i.WriteU8 (0x2);
+  a.AddAtEnd (1);
+  i = a.End ();
+  i.Prev (1);
+  i.WriteU8 (0x3);
+  Buffer b;
+  b.AddAtStart (4);
+  b.Begin ().WriteHtonU32 (0x04050607);
+  Buffer c = a;
+  c.AddAtEnd (b);
+  NS_TEST_ASSERT_MSG_EQ (c.GetSize (), 10, "Bad size of a segmented buffer");
+  ENSURE_WRITTEN_BYTES (c, 10, 0x1, 0x2, 0, 0, 0, 0x3, 0x4, 0x5, 0x6, 0x7);
+  ENSURE_WRITTEN_BYTES (a, 6, 0x1, 0x2, 0, 0, 0, 0x3);
+  ENSURE_WRITTEN_BYTES (b, 4, 0x4, 0x5, 0x6, 0x7);
+  i = c.Begin ();
+  i.Next (4);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU32 (), 0x00030405, "Bad read across segments");
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU16 (), 0x0607, "Bad read in the last segment");
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Bad end of a segmented buffer");
+  i.Prev (10);
+  NS_TEST_ASSERT_MSG_EQ (i.IsStart (), true, "Bad start of a segmented buffer");
+  c.AddAtStart (1);
+  c.Begin ().WriteU8 (0x9);
+  c.AddAtEnd (1);
+  c.AddAtEnd (1);
+  i = c.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0xabcd);
+  NS_TEST_ASSERT_MSG_EQ (i.GetDistanceFrom (c.Begin ()), 13, "Bad distance in a segmented buffer");
+  ENSURE_WRITTEN_BYTES (c, 13, 0x9, 0x1, 0x2, 0, 0, 0, 0x3, 0x4, 0x5, 0x6, 0x7, 0xab, 0xcd);
+  ENSURE_WRITTEN_BYTES (b, 4, 0x4, 0x5, 0x6, 0x7);
+  uint8_t copy[13];
+  NS_TEST_ASSERT_MSG_EQ (c.CopyData (copy, 20), 13, "Bad size copied from a segmented buffer");
+  NS_TEST_ASSERT_MSG_EQ (copy[3], 0, "Bad zero byte copied from a segmented buffer");
+  NS_TEST_ASSERT_MSG_EQ (copy[9], 0x6, "Bad byte copied from a segmented buffer");
+  NS_TEST_ASSERT_MSG_EQ (copy[12], 0xcd, "Bad byte copied from a segmented buffer");
+  std::ostringstream oss;
+  c.CopyData (&oss, 13);
+  NS_TEST_ASSERT_MSG_EQ (oss.str (), std::string (reinterpret_cast<char *> (copy), 13),
+                         "Bad bytes written from a segmented buffer");
+  ENSURE_WRITTEN_BYTES (c.CreateFragment (5, 6), 6, 0, 0x3, 0x4, 0x5, 0x6, 0x7);
+  ENSURE_WRITTEN_BYTES (c.CreateFragment (8, 4), 4, 0x5, 0x6, 0x7, 0xab);
+  Buffer d = c;
+  d.RemoveAtStart (8);
+  ENSURE_WRITTEN_BYTES (d, 5, 0x5, 0x6, 0x7, 0xab, 0xcd);
+  d.AddAtStart (1);
+  d.Begin ().WriteU8 (0x8);
+  ENSURE_WRITTEN_BYTES (d, 6, 0x8, 0x5, 0x6, 0x7, 0xab, 0xcd);
+  d.RemoveAtEnd (3);
+  ENSURE_WRITTEN_BYTES (d, 3, 0x8, 0x5, 0x6);
+  d.RemoveAtEnd (4);
+  NS_TEST_ASSERT_MSG_EQ (d.GetSize (), 0, "Buffer size not zero");
+  d = c;
+  d.RemoveAtEnd (9);
+  ENSURE_WRITTEN_BYTES (d, 4, 0x9, 0x1, 0x2, 0);
+  ENSURE_WRITTEN_BYTES (c, 13, 0x9, 0x1, 0x2, 0, 0, 0, 0x3, 0x4, 0x5, 0x6, 0x7, 0xab, 0xcd);
+  std::vector<uint8_t> serialized (c.GetSerializedSize ());
+  NS_TEST_ASSERT_MSG_EQ (c.Serialize (&serialized[0], serialized.size ()), 1, "Could not serialize a segmented buffer");
+  Buffer deserialized (0, false);
+  // the size includes the size field which Packet::Serialize writes first
+  deserialized.Deserialize (&serialized[0], serialized.size () + 4);
+  ENSURE_WRITTEN_BYTES (deserialized, 13, 0x9, 0x1, 0x2, 0, 0, 0, 0x3, 0x4, 0x5, 0x6, 0x7, 0xab, 0xcd);
+  d = Buffer ();
+  for (uint32_t j = 0; j < 2 * BUFFER_MAX_SEGMENTS; j++)
+    {
+      Buffer e;
+      e.AddAtStart (1);
+      e.Begin ().WriteU8 (j);
+      d.AddAtEnd (e);
+    }
+  NS_TEST_ASSERT_MSG_EQ (d.GetSize (), 2 * BUFFER_MAX_SEGMENTS, "Bad size of a long segmented buffer");
+  i = d.Begin ();
+  for (uint32_t j = 0; j < 2 * BUFFER_MAX_SEGMENTS; j++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), j, "Bad byte in a long segmented buffer");
+    }
 }
 
 /**
@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/simple-channel.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * A channel without a "Delay" attribute, like the wireless channels
+ * whose propagation delay depends on the distance.
+ */
+class NoDelayChannel : public Channel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  virtual std::size_t GetNDevices (void) const;
+  virtual Ptr<NetDevice> GetDevice (std::size_t i) const;
+};
+
+TypeId
+NoDelayChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NoDelayChannel")
+    .SetParent<Channel> ()
+    .SetGroupName ("Network")
+    .HideFromDocumentation ()
+    .AddConstructor<NoDelayChannel> ()
+  ;
+  return tid;
+}
+
+std::size_t
+NoDelayChannel::GetNDevices (void) const
+{
+  return 0;
+}
+
+Ptr<NetDevice>
+NoDelayChannel::GetDevice (std::size_t i) const
+{
+  return 0;
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the lookahead MultithreadedSimulatorImpl derives from the
+ * channels, and that an event scheduled on another partition closer
+ * than the smallest channel Delay runs when some channel has no Delay.
+ */
+class MultithreadedSimulatorLookaheadTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param noDelay Whether to add a channel without a Delay attribute.
+   */
+  MultithreadedSimulatorLookaheadTestCase (bool noDelay);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Schedule an event on the next node, a microsecond later.
+   * \param node The node.
+   */
+  void Send (uint32_t node);
+  /** Count a received event. */
+  void Receive (void);
+
+  bool m_noDelay;       ///< Whether to add a channel without Delay.
+  uint32_t m_received;  ///< Number of received events.
+};
+
+MultithreadedSimulatorLookaheadTestCase::MultithreadedSimulatorLookaheadTestCase (bool noDelay)
+  : TestCase (noDelay ? "Check that a channel without Delay disables the lookahead"
+              : "Check that the lookahead is the smallest channel Delay"),
+    m_noDelay (noDelay),
+    m_received (0)
+{}
+
+void
+MultithreadedSimulatorLookaheadTestCase::Send (uint32_t node)
+{
+  Simulator::ScheduleWithContext (node + 1, MicroSeconds (1),
+                                  &MultithreadedSimulatorLookaheadTestCase::Receive, this);
+}
+
+void
+MultithreadedSimulatorLookaheadTestCase::Receive (void)
+{
+  m_received++;
+}
+
+void
+MultithreadedSimulatorLookaheadTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Threads", UintegerValue (2));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (2));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (0)));
+
+  Ptr<SimpleChannel> wired = CreateObject<SimpleChannel> ();
+  wired->SetAttribute ("Delay", TimeValue (MilliSeconds (2)));
+  if (m_noDelay)
+    {
+      CreateObject<NoDelayChannel> ();
+      // a wireless delivery to the other partition, well within the
+      // delay of the wired channel
+      Simulator::ScheduleWithContext (0, Seconds (1),
+                                      &MultithreadedSimulatorLookaheadTestCase::Send, this, 0);
+    }
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> impl =
+    DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not running MultithreadedSimulatorImpl");
+  if (m_noDelay)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), Seconds (0), "Lookahead despite a channel without Delay");
+      NS_TEST_EXPECT_MSG_EQ (m_received, 1, "Lost event");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MilliSeconds (2), "Lookahead is not the channel Delay");
+    }
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * MultithreadedSimulatorImpl lookahead from the channels test suite.
+ */
+class MultithreadedSimulatorLookaheadTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorLookaheadTestSuite ()
+    : TestSuite ("multithreaded-simulator-lookahead", UNIT)
+  {
+    AddTestCase (new MultithreadedSimulatorLookaheadTestCase (false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorLookaheadTestCase (true), TestCase::QUICK);
+  }
+};
+
+/// Static variable for test initialization
+static MultithreadedSimulatorLookaheadTestSuite g_multithreadedSimulatorLookaheadTestSuite;
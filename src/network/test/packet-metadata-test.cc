@@ -318,7 +318,11 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
  */
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  /**
+   * Constructor
+   * \param deferred whether to test the deferred mode
+   */
+  PacketMetadataTest (bool deferred);
   virtual ~PacketMetadataTest ();
   /**
    * Checks the packet header and trailer history
@@ -337,10 +341,13 @@ private:
    * \return The packet with the header added.
    */
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
+
+  bool m_deferred; //!< whether to test the deferred mode
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (bool deferred)
+  : TestCase (deferred ? "Packet metadata, deferred" : "Packet metadata"),
+    m_deferred (deferred)
 {
 }
 
@@ -477,7 +484,14 @@ PacketMetadataTest::DoAddHeader (Ptr<Packet> p)
 void
 PacketMetadataTest::DoRun (void)
 {
-  PacketMetadata::Enable ();
+  if (m_deferred)
+    {
+      PacketMetadata::EnableDeferred ();
+    }
+  else
+    {
+      PacketMetadata::Enable ();
+    }
 
   Ptr<Packet> p = Create<Packet> (0);
   Ptr<Packet> p1 = Create<Packet> (0);
@@ -900,6 +914,30 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // more operations than recorded in deferred mode, some of which
+  // cancel each other, before the history is read
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  ADD_HEADER (p, 3);
+  ADD_HEADER (p, 4);
+  ADD_TRAILER (p, 5);
+  REM_TRAILER (p, 5);
+  ADD_HEADER (p, 5);
+  ADD_HEADER (p, 6);
+  ADD_HEADER (p, 7);
+  ADD_TRAILER (p, 8);
+  REM_HEADER (p, 7);
+  ADD_HEADER (p, 9);
+  p->RemoveAtStart (9);
+  p->RemoveAtEnd (8);
+  p->RemoveAtStart (7);
+  p1 = p->Copy ();
+  ADD_HEADER (p1, 2);
+  p->RemoveAtEnd (3);
+  CHECK_HISTORY (p, 6, 4, 4, 3, 2, 1, 7);
+  CHECK_HISTORY (p1, 7, 2, 4, 4, 3, 2, 1, 10);
 }
 
 
@@ -918,7 +956,9 @@ public:
 PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
-  AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (false), TestCase::QUICK);
+  // last, since the deferred mode cannot be disabled
+  AddTestCase (new PacketMetadataTest (true), TestCase::QUICK);
 }
 
 static PacketMetadataTestSuite g_packetMetadataTest; //!< Static variable for test initialization
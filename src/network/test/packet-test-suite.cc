@@ -19,6 +19,9 @@
  */
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
+#include "ns3/byte-tag-list.h"
+#include "ns3/packet-allocator.h"
+#include "ns3/uinteger.h"
 #include "ns3/test.h"
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
@@ -27,6 +30,8 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
+#include <thread>
 
 using namespace ns3;
 
@@ -1116,7 +1121,72 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (6);
     ReplaceCheck (7);
   }
-  
+
+  { // Large tags, stored out of the tag entries
+    std::cout << GetName () << "check large tags" << std::endl;
+    ATestTag<30> l1 (1);
+    ATestTag<40> l2 (1);
+    PacketTagList ptl = ref;
+    ptl.Add (l1);
+    ptl.Add (l2);
+    CheckRefList (ref, "large orig");
+    CheckRef (ref, l1, "large orig", true);
+    CheckRefList (ptl, "large copy");
+    CheckRef (ptl, l1, "large copy");
+    CheckRef (ptl, l2, "large copy");
+    NS_TEST_EXPECT_MSG_EQ (l2.m_error, false, "large tag data");
+
+    PacketTagList rpl = ptl;
+    l1.m_data = 2;
+    rpl.Replace (l1);
+    CheckRef (rpl, l1, "large replace copy");
+    CheckRef (rpl, l2, "large replace copy");
+    l1.m_data = 1;
+    CheckRef (ptl, l1, "large replace orig");
+
+    ptl.Remove (l1);
+    CheckRefList (ptl, "large remove");
+    CheckRef (ptl, l1, "large remove", true);
+    CheckRef (ptl, l2, "large remove");
+    NS_TEST_EXPECT_MSG_EQ (l2.m_error, false, "large tag data after remove");
+    ptl.Add (l1);
+    CheckRef (ptl, l1, "large add after remove");
+    NS_TEST_EXPECT_MSG_EQ (l1.m_error, false, "large tag data after add");
+
+    // the head of the list is the last tag added
+    TypeId order[] = { l1.GetInstanceTypeId (), l2.GetInstanceTypeId (),
+                       t7.GetInstanceTypeId (), t6.GetInstanceTypeId (),
+                       t5.GetInstanceTypeId (), t4.GetInstanceTypeId (),
+                       t3.GetInstanceTypeId (), t2.GetInstanceTypeId (),
+                       t1.GetInstanceTypeId () };
+    uint32_t n = 0;
+    for (const struct PacketTagList::TagData *cur = ptl.End (); cur != ptl.Begin (); ++n)
+      {
+        --cur;
+        NS_TEST_ASSERT_MSG_LT (n, 9, "too many tags");
+        NS_TEST_EXPECT_MSG_EQ (cur->tid, order[n], "tag " << n << " out of order");
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, 9, "wrong number of tags");
+
+    // serialization keeps the tags and their order
+    uint32_t size = ptl.GetSerializedSize ();
+    std::vector<uint32_t> buffer (size / 4);
+    NS_TEST_EXPECT_MSG_EQ (ptl.Serialize (&buffer[0], size), 1, "serialize");
+    PacketTagList des;
+    NS_TEST_EXPECT_MSG_EQ (des.Deserialize (&buffer[0], size + 4), 1, "deserialize");
+    CheckRefList (des, "large deserialized");
+    CheckRef (des, l1, "large deserialized");
+    CheckRef (des, l2, "large deserialized");
+    NS_TEST_EXPECT_MSG_EQ (l2.m_error, false, "large tag data after deserialize");
+    n = 0;
+    for (const struct PacketTagList::TagData *cur = des.End (); cur != des.Begin (); ++n)
+      {
+        --cur;
+        NS_TEST_ASSERT_MSG_LT (n, 9, "too many deserialized tags");
+        NS_TEST_EXPECT_MSG_EQ (cur->tid, order[n], "deserialized tag " << n << " out of order");
+      }
+  }
+
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max ();
@@ -1158,6 +1228,267 @@ PacketTagListTest::DoRun (void)
     
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * ByteTagList unit tests.
+ */
+class ByteTagListTest : public TestCase
+{
+public:
+  ByteTagListTest ();
+  virtual ~ByteTagListTest ();
+private:
+  void DoRun (void);
+
+  /** A tag expected in a ByteTagList */
+  struct Expected
+  {
+    TypeId tid;     //!< type of the tag
+    int32_t start;  //!< offset of the first byte tagged
+    int32_t end;    //!< offset past the last byte tagged
+    uint8_t value;  //!< value of each byte of the tag data
+    uint32_t size;  //!< size of the tag data
+  };
+
+  /**
+   * Add a tag to a list and to the expected tags.
+   * \param list the list
+   * \param expected the expected tags
+   * \param i the index of the tag, which sets its type and data
+   * \param start offset of the first byte tagged
+   * \param end offset past the last byte tagged
+   */
+  void Add (ByteTagList &list, std::vector<Expected> &expected, uint32_t i, int32_t start, int32_t end);
+  /**
+   * Check the tags of a list within a range of offsets.
+   * \param list the list
+   * \param expected the tags expected in the list
+   * \param start offset of the first byte of the range
+   * \param end offset past the last byte of the range
+   */
+  void Check (const ByteTagList &list, const std::vector<Expected> &expected, int32_t start, int32_t end);
+};
+
+ByteTagListTest::ByteTagListTest ()
+  : TestCase ("ByteTagList")
+{
+}
+
+ByteTagListTest::~ByteTagListTest ()
+{
+}
+
+void
+ByteTagListTest::Add (ByteTagList &list, std::vector<Expected> &expected, uint32_t i, int32_t start, int32_t end)
+{
+  Expected tag;
+  tag.tid = (i % 2) ? ATestTag<1>::GetTypeId () : ATestTag<2>::GetTypeId ();
+  tag.start = start;
+  tag.end = end;
+  tag.value = i % 251;
+  tag.size = 1 + i % 13;
+  TagBuffer buf = list.Add (tag.tid, tag.size, start, end);
+  for (uint32_t j = 0; j < tag.size; j++)
+    {
+      buf.WriteU8 (tag.value);
+    }
+  expected.push_back (tag);
+}
+
+void
+ByteTagListTest::Check (const ByteTagList &list, const std::vector<Expected> &expected, int32_t start, int32_t end)
+{
+  ByteTagList::Iterator i = list.Begin (start, end);
+  for (const Expected &tag : expected)
+    {
+      if (tag.end <= start || tag.start >= end)
+        {
+          continue;
+        }
+      NS_TEST_ASSERT_MSG_EQ (i.HasNext (), true, "Missing tag in [" << start << ", " << end << ")");
+      ByteTagList::Iterator::Item item = i.Next ();
+      NS_TEST_EXPECT_MSG_EQ (item.tid, tag.tid, "Wrong tag type");
+      NS_TEST_EXPECT_MSG_EQ (item.start, std::max (tag.start, start), "Wrong tag start");
+      NS_TEST_EXPECT_MSG_EQ (item.end, std::min (tag.end, end), "Wrong tag end");
+      NS_TEST_ASSERT_MSG_EQ (item.size, tag.size, "Wrong tag size");
+      for (uint32_t j = 0; j < tag.size; j++)
+        {
+          uint8_t value = item.buf.ReadU8 ();
+          NS_TEST_EXPECT_MSG_EQ ((uint32_t) value, (uint32_t) tag.value, "Wrong tag data");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "Extra tag in [" << start << ", " << end << ")");
+}
+
+void
+ByteTagListTest::DoRun (void)
+{
+  ByteTagList list;
+  std::vector<Expected> expected;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      int32_t start = (i * 37) % 1000;
+      Add (list, expected, i, start, start + 1 + (i * 11) % 200);
+    }
+  const int32_t ranges[][2] = {{0, 2000}, {0, 1}, {500, 510}, {999, 1200}, {1199, 1300}, {1300, 1400}};
+  for (const int32_t *range : ranges)
+    {
+      Check (list, expected, range[0], range[1]);
+    }
+
+  // a copy shares the tags until one of them changes
+  ByteTagList copy = list;
+  std::vector<Expected> copyExpected = expected;
+  Add (list, expected, 300, 10, 20);
+  Add (copy, copyExpected, 301, 30, 40);
+  Check (list, expected, 0, 2000);
+  Check (copy, copyExpected, 0, 2000);
+
+  // a header of 100 bytes is added to the copy: its tags move and are
+  // cut so as not to cover the header
+  copy.Adjust (100);
+  copy.AddAtStart (100);
+  for (Expected &tag : copyExpected)
+    {
+      tag.start = std::max (tag.start + 100, 100);
+      tag.end += 100;
+    }
+  Check (copy, copyExpected, 0, 2000);
+  Check (copy, copyExpected, 50, 150);
+  Check (list, expected, 0, 2000);
+
+  // the header is removed, and a trailer added after byte 500
+  copy.Adjust (-100);
+  copy.AddAtEnd (500);
+  std::vector<Expected> cut;
+  for (Expected tag : copyExpected)
+    {
+      tag.start -= 100;
+      tag.end -= 100;
+      if (tag.start < 500 && tag.end > 0)
+        {
+          tag.start = std::max (tag.start, 0);
+          tag.end = std::min (tag.end, 500);
+          cut.push_back (tag);
+        }
+    }
+  Check (copy, cut, 0, 2000);
+  Check (copy, cut, 400, 600);
+  Check (list, expected, 0, 2000);
+
+  // tags added after the cut, and the aggregation of two lists
+  Add (copy, cut, 302, 450, 500);
+  Check (copy, cut, 0, 2000);
+  ByteTagList sum;
+  std::vector<Expected> sumExpected;
+  sum.Add (copy);
+  sum.Add (list);
+  sumExpected.insert (sumExpected.end (), cut.begin (), cut.end ());
+  sumExpected.insert (sumExpected.end (), expected.begin (), expected.end ());
+  Check (sum, sumExpected, 0, 2000);
+
+  list.RemoveAll ();
+  Check (list, std::vector<Expected> (), 0, 2000);
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * PacketAllocator unit tests.
+ */
+class PacketAllocatorTest : public TestCase
+{
+public:
+  PacketAllocatorTest ();
+  virtual ~PacketAllocatorTest ();
+private:
+  void DoRun (void);
+  /**
+   * \param name the name of an attribute of the PacketAllocator
+   * \returns the value of the attribute
+   */
+  uint64_t GetStatistic (std::string name);
+
+  Ptr<PacketAllocator> m_allocator; //!< the statistics
+};
+
+PacketAllocatorTest::PacketAllocatorTest ()
+  : TestCase ("PacketAllocator")
+{
+}
+
+PacketAllocatorTest::~PacketAllocatorTest ()
+{
+}
+
+uint64_t
+PacketAllocatorTest::GetStatistic (std::string name)
+{
+  UintegerValue value;
+  m_allocator->GetAttribute (name, value);
+  return value.Get ();
+}
+
+void
+PacketAllocatorTest::DoRun (void)
+{
+  m_allocator = CreateObject<PacketAllocator> ();
+
+  // blocks of every size class are reused
+  const uint32_t sizes[] = {0, 100, 1500, 9000, 60000};
+  for (uint32_t size : sizes)
+    {
+      Ptr<Packet> p = Create<Packet> (size);
+      p = 0;
+      uint64_t reuses = GetStatistic ("Reuses");
+      uint64_t allocations = GetStatistic ("Allocations");
+      p = Create<Packet> (size);
+      NS_TEST_EXPECT_MSG_EQ ((GetStatistic ("Allocations") > allocations), true, "No allocation for " << size << " bytes");
+      NS_TEST_EXPECT_MSG_EQ (GetStatistic ("Reuses") - reuses, GetStatistic ("Allocations") - allocations,
+                             "Free block not reused for " << size << " bytes");
+      NS_TEST_EXPECT_MSG_EQ (p->GetSize (), size, "Wrong packet size");
+    }
+  NS_TEST_EXPECT_MSG_GT (GetStatistic ("FreeBlocks"), 0, "No free blocks");
+  NS_TEST_EXPECT_MSG_GT (GetStatistic ("FreeBytes"), GetStatistic ("FreeBlocks") * 63, "Wrong free bytes");
+
+  // a packet larger than the size classes
+  uint8_t data[100000];
+  for (uint32_t i = 0; i < sizeof (data); i++)
+    {
+      data[i] = i % 251;
+    }
+  Ptr<Packet> large = Create<Packet> (data, sizeof (data));
+  Ptr<Packet> fragment = large->CreateFragment (99000, 1000);
+  large = 0;
+  uint8_t copy[1000];
+  fragment->CopyData (copy, sizeof (copy));
+  NS_TEST_EXPECT_MSG_EQ (memcmp (copy, data + 99000, sizeof (copy)), 0, "Wrong fragment data");
+
+  // packets released on another thread than the one which allocated them
+  std::vector<Ptr<Packet> > packets;
+  std::thread producer ([&packets] ()
+    {
+      for (uint32_t i = 0; i < 100; i++)
+        {
+          packets.push_back (Create<Packet> (i * 10));
+        }
+    });
+  producer.join ();
+  uint64_t allocations = GetStatistic ("Allocations");
+  packets.clear ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      packets.push_back (Create<Packet> (i * 10));
+    }
+  NS_TEST_EXPECT_MSG_EQ ((GetStatistic ("Reuses") > 0), true, "No reuse");
+  NS_TEST_EXPECT_MSG_GT (GetStatistic ("Allocations"), allocations, "Allocations of an exited thread lost");
+  packets.clear ();
+  m_allocator = 0;
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1175,6 +1506,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new ByteTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketAllocatorTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "cached-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachedPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+TypeId
+CachedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CachedPropagationLossModel> ()
+    .AddAttribute ("Model",
+                   "The deterministic loss model whose results are cached.",
+                   PointerValue (),
+                   MakePointerAccessor (&CachedPropagationLossModel::SetModel,
+                                        &CachedPropagationLossModel::GetModel),
+                   MakePointerChecker<PropagationLossModel> ())
+    .AddAttribute ("MaxEntries",
+                   "The maximum number of paths in the cache, 0 for no limit.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&CachedPropagationLossModel::SetMaxEntries,
+                                         &CachedPropagationLossModel::GetMaxEntries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxDisplacement",
+                   "The distance (m) a moving node may travel before the results "
+                   "computed for its paths are recomputed.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&CachedPropagationLossModel::m_maxDisplacement),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+CachedPropagationLossModel::PathData::PathData ()
+{
+  state[0] = 0;
+  state[1] = 0;
+  direction[0].valid = false;
+  direction[1].valid = false;
+}
+
+CachedPropagationLossModel::CachedPropagationLossModel ()
+  : m_maxDisplacement (0.0),
+    m_maxEntries (0),
+    m_hits (0),
+    m_misses (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CachedPropagationLossModel::~CachedPropagationLossModel ()
+{
+  NS_LOG_FUNCTION (this);
+  Forget ();
+}
+
+void
+CachedPropagationLossModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("hits=" << m_hits << ", misses=" << m_misses << ", hit rate=" << GetHitRate ());
+  Forget ();
+  m_model = 0;
+  PropagationLossModel::DoDispose ();
+}
+
+void
+CachedPropagationLossModel::SetModel (Ptr<PropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  Clear ();
+}
+
+Ptr<PropagationLossModel>
+CachedPropagationLossModel::GetModel (void) const
+{
+  return m_model;
+}
+
+void
+CachedPropagationLossModel::SetMaxEntries (uint32_t maxEntries)
+{
+  NS_LOG_FUNCTION (this << maxEntries);
+  m_maxEntries = maxEntries;
+  m_cache.SetMaxSize (maxEntries);
+}
+
+uint32_t
+CachedPropagationLossModel::GetMaxEntries (void) const
+{
+  return m_maxEntries;
+}
+
+void
+CachedPropagationLossModel::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_cache.Clear ();
+}
+
+uint64_t
+CachedPropagationLossModel::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachedPropagationLossModel::GetMisses (void) const
+{
+  return m_misses;
+}
+
+double
+CachedPropagationLossModel::GetHitRate (void) const
+{
+  uint64_t calls = m_hits + m_misses;
+  if (calls == 0)
+    {
+      return 0.0;
+    }
+  return static_cast<double> (m_hits) / calls;
+}
+
+void
+CachedPropagationLossModel::ResetStatistics (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hits = 0;
+  m_misses = 0;
+}
+
+void
+CachedPropagationLossModel::Forget (void)
+{
+  // the callbacks were made by Follow, on a const object
+  const CachedPropagationLossModel *self = this;
+  for (MobilityStates::iterator i = m_states.begin (); i != m_states.end (); ++i)
+    {
+      i->second.mobility->TraceDisconnectWithoutContext ("CourseChange",
+                                                         MakeCallback (&CachedPropagationLossModel::CourseChanged, self));
+    }
+  m_cache.Clear ();
+  m_states.clear ();
+}
+
+const struct CachedPropagationLossModel::MobilityState *
+CachedPropagationLossModel::Follow (Ptr<MobilityModel> mobility) const
+{
+  std::pair<MobilityStates::iterator, bool> ret =
+    m_states.insert (std::make_pair (PeekPointer (mobility), MobilityState ()));
+  struct MobilityState &state = ret.first->second;
+  if (ret.second)
+    {
+      NS_LOG_LOGIC ("following " << mobility);
+      Vector velocity = mobility->GetVelocity ();
+      state.mobility = mobility;
+      state.generation = 0;
+      state.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&CachedPropagationLossModel::CourseChanged, this));
+    }
+  return &state;
+}
+
+void
+CachedPropagationLossModel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+  MobilityStates::iterator i = m_states.find (PeekPointer (mobility));
+  NS_ASSERT (i != m_states.end ());
+  Vector velocity = mobility->GetVelocity ();
+  i->second.generation++;
+  i->second.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+}
+
+bool
+CachedPropagationLossModel::IsValid (const struct MobilityState *state, const Vector &position, uint32_t generation) const
+{
+  if (state->generation != generation)
+    {
+      return false;
+    }
+  return !state->moving
+         || CalculateDistance (state->mobility->GetPosition (), position) <= m_maxDisplacement;
+}
+
+double
+CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                           Ptr<MobilityModel> a,
+                                           Ptr<MobilityModel> b) const
+{
+  NS_ASSERT_MSG (m_model != 0, "No model to cache");
+  Ptr<PathData> path = m_cache.GetPathData (a, b, 0 /**Spectrum model uid is not used in PropagationLossModel*/);
+  if (path == 0)
+    {
+      path = Create<PathData> ();
+      path->state[0] = Follow (std::min (a, b));
+      path->state[1] = Follow (std::max (a, b));
+      m_cache.AddPathData (path, a, b, 0 /**Spectrum model uid is not used in PropagationLossModel*/);
+    }
+  // a path from the lower mobility model uses the first direction
+  bool reverse = !(a < b) && a != b;
+  const struct MobilityState *source = path->state[reverse ? 1 : 0];
+  const struct MobilityState *destination = path->state[reverse ? 0 : 1];
+  struct Direction &direction = path->direction[reverse ? 1 : 0];
+  if (direction.valid
+      && direction.txPowerDbm == txPowerDbm
+      && IsValid (source, direction.position[0], direction.generation[0])
+      && IsValid (destination, direction.position[1], direction.generation[1]))
+    {
+      m_hits++;
+      return direction.rxPowerDbm;
+    }
+
+  m_misses++;
+  direction.valid = true;
+  direction.txPowerDbm = txPowerDbm;
+  direction.rxPowerDbm = m_model->CalcRxPower (txPowerDbm, a, b);
+  direction.generation[0] = source->generation;
+  direction.generation[1] = destination->generation;
+  direction.position[0] = a->GetPosition ();
+  direction.position[1] = b->GetPosition ();
+  NS_LOG_DEBUG ("computed rxPower=" << direction.rxPowerDbm << "dbm for " << a << " to " << b);
+  return direction.rxPowerDbm;
+}
+
+int64_t
+CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_model == 0)
+    {
+      return 0;
+    }
+  return m_model->AssignStreams (stream);
+}
+
+} // namespace ns3
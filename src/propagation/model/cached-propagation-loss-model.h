@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CACHED_PROPAGATION_LOSS_MODEL_H
+#define CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-cache.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Cache the result of a deterministic propagation loss model
+ *
+ * The model set with the Model attribute, and the models chained to it,
+ * compute the reception power of a path only when one of its ends has
+ * moved or the transmission power has changed since the last
+ * computation for that path; otherwise the power computed then is
+ * returned.  These models must therefore depend on the positions of the
+ * nodes only, as Friis, LogDistance or ThreeLogDistance do.  The
+ * stochastic models, such as Nakagami, belong after this model in the
+ * chain (see SetNext), where they are still evaluated on every call:
+ *
+ * \code
+ *   Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+ *   cached->SetModel (CreateObject<LogDistancePropagationLossModel> ());
+ *   cached->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+ * \endcode
+ *
+ * The cached results of the paths of a node are invalidated by the
+ * CourseChange notifications of its mobility model.  A node which is
+ * moving does not notify its position continuously, so the results
+ * involving it are used only while it stays within MaxDisplacement of
+ * the position where they were computed; by default, only as long as it
+ * does not move at all.
+ *
+ * The paths are held in a PropagationCache of MaxEntries paths, the
+ * least recently used being evicted first.  GetHits and GetMisses report
+ * how useful the cache is.
+ */
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  CachedPropagationLossModel ();
+  virtual ~CachedPropagationLossModel ();
+
+  /**
+   * \param model the deterministic loss model whose results are cached
+   *
+   * This removes all the paths from the cache.
+   */
+  void SetModel (Ptr<PropagationLossModel> model);
+  /**
+   * \returns the deterministic loss model whose results are cached
+   */
+  Ptr<PropagationLossModel> GetModel (void) const;
+  /**
+   * \param maxEntries the maximum number of paths in the cache, 0 for
+   *        no limit
+   *
+   * This removes all the paths from the cache.
+   */
+  void SetMaxEntries (uint32_t maxEntries);
+  /**
+   * \returns the maximum number of paths in the cache, 0 for no limit
+   */
+  uint32_t GetMaxEntries (void) const;
+  /**
+   * Remove all the paths from the cache, for example after changing the
+   * attributes of the cached model.
+   */
+  void Clear (void);
+
+  /**
+   * \returns the number of calls answered from the cache
+   */
+  uint64_t GetHits (void) const;
+  /**
+   * \returns the number of calls computed by the cached model
+   */
+  uint64_t GetMisses (void) const;
+  /**
+   * \returns the fraction of the calls answered from the cache, 0 if
+   *          there was no call
+   */
+  double GetHitRate (void) const;
+  /**
+   * Reset the hit and miss counts.
+   */
+  void ResetStatistics (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CachedPropagationLossModel (const CachedPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CachedPropagationLossModel & operator = (const CachedPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /** The state of a mobility model, as of its last course change */
+  struct MobilityState
+  {
+    Ptr<MobilityModel> mobility; //!< the mobility model
+    uint32_t generation;         //!< number of course changes
+    bool moving;                 //!< velocity not zero
+  };
+  /** The result cached for one direction of a path */
+  struct Direction
+  {
+    bool valid;                  //!< whether a result was computed
+    double txPowerDbm;           //!< transmission power of the result
+    double rxPowerDbm;           //!< the result
+    uint32_t generation[2];      //!< generations of the source and destination
+    Vector position[2];          //!< positions of the source and destination
+  };
+  /** The results cached for a path, in both directions */
+  struct PathData : public SimpleRefCount<PathData>
+  {
+    PathData ();
+    const struct MobilityState *state[2]; //!< states of the lower and higher mobility models
+    struct Direction direction[2];        //!< from the lower and from the higher mobility model
+  };
+
+  /**
+   * Start following the course changes of a mobility model.
+   * \param mobility the mobility model
+   * \returns the state of \p mobility
+   */
+  const struct MobilityState * Follow (Ptr<MobilityModel> mobility) const;
+  /**
+   * Invalidate the results involving a mobility model.
+   * \param mobility the mobility model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+  /**
+   * \param state the state of a mobility model
+   * \param position a position computed before
+   * \param generation the generation of \p state when \p position was computed
+   * \returns whether the results computed at \p position are still valid
+   */
+  bool IsValid (const struct MobilityState *state, const Vector &position, uint32_t generation) const;
+  /**
+   * Stop following the course changes, and empty the cache.
+   */
+  void Forget (void);
+
+  /** Container: mobility model, its state */
+  typedef std::unordered_map<const MobilityModel *, struct MobilityState> MobilityStates;
+
+  Ptr<PropagationLossModel> m_model;                  //!< the cached model
+  double m_maxDisplacement;                           //!< tolerance for moving nodes, in meters
+  uint32_t m_maxEntries;                              //!< maximum number of paths
+  mutable PropagationCache<PathData> m_cache;         //!< the paths
+  mutable MobilityStates m_states;                    //!< the mobility models followed
+  mutable uint64_t m_hits;                            //!< number of results from the cache
+  mutable uint64_t m_misses;                          //!< number of results computed
+};
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_LOSS_MODEL_H */
@@ -21,7 +21,10 @@
 #define PROPAGATION_CACHE_H_
 
 #include "ns3/mobility-model.h"
-#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <list>
 
 namespace ns3
 {
@@ -30,12 +33,16 @@ namespace ns3
  * \brief Constructs a cache of objects, where each object is responsible for a single propagation path loss calculations.
  * Propagation path a-->b and b-->a is the same thing. Propagation path is identified by
  * a couple of MobilityModels and a spectrum model UID
+ *
+ * The cache is a hash table.  It is unbounded by default; when a maximum
+ * size is set, adding a path to a full cache evicts the least recently
+ * used one.
  */
 template<class T>
 class PropagationCache
 {
 public:
-  PropagationCache () {};
+  PropagationCache () : m_maxSize (0) {};
   ~PropagationCache () {};
 
   /**
@@ -53,7 +60,11 @@ public:
       {
         return 0;
       }
-    return it->second;
+    if (m_maxSize != 0)
+      {
+        m_lru.splice (m_lru.begin (), m_lru, it->second.second);
+      }
+    return it->second.first;
   };
 
   /**
@@ -67,7 +78,54 @@ public:
   {
     PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
     NS_ASSERT (m_pathCache.find (key) == m_pathCache.end ());
-    m_pathCache.insert (std::make_pair (key, data)); 
+    typename std::list<PropagationPathIdentifier>::iterator lru = m_lru.end ();
+    if (m_maxSize != 0)
+      {
+        if (m_pathCache.size () >= m_maxSize)
+          {
+            m_pathCache.erase (m_lru.back ());
+            m_lru.pop_back ();
+          }
+        lru = m_lru.insert (m_lru.begin (), key);
+      }
+    m_pathCache.insert (std::make_pair (key, std::make_pair (data, lru)));
+  };
+
+  /**
+   * Set the maximum number of paths in the cache
+   * \param maxSize the maximum number of paths, 0 for no limit
+   *
+   * This removes all the paths from the cache.
+   */
+  void SetMaxSize (std::size_t maxSize)
+  {
+    Clear ();
+    m_maxSize = maxSize;
+  };
+
+  /**
+   * \return the maximum number of paths in the cache, 0 for no limit
+   */
+  std::size_t GetMaxSize (void) const
+  {
+    return m_maxSize;
+  };
+
+  /**
+   * \return the number of paths in the cache
+   */
+  std::size_t GetSize (void) const
+  {
+    return m_pathCache.size ();
+  };
+
+  /**
+   * Remove all the paths from the cache
+   */
+  void Clear (void)
+  {
+    m_pathCache.clear ();
+    m_lru.clear ();
   };
 private:
   /// Each path is identified by
@@ -87,40 +145,47 @@ private:
     uint32_t m_spectrumModelUid; //!< model UID
 
     /**
-     * Less-than operator.
+     * Equality operator.
      *
-     * The goal of this operator is just to provide a stable comparison
-     * to be used in containers requiring a order (of any kind).
-     *
-     * If the models are different, the comparison is based on their Uid.
-     * Otherwise, the comparison is based on the pointers of the Mobility models.
+     * Links are supposed to be symmetrical, so the order of the
+     * mobility models does not matter.
      *
      * \param other Right value of the operator.
-     * \returns True if the Left value is less than the Right value.
+     * \returns True if both identify the same path.
+     */
+    bool operator == (const PropagationPathIdentifier & other) const
+    {
+      return m_spectrumModelUid == other.m_spectrumModelUid
+             && std::min (m_dstMobility, m_srcMobility) == std::min (other.m_dstMobility, other.m_srcMobility)
+             && std::max (m_dstMobility, m_srcMobility) == std::max (other.m_dstMobility, other.m_srcMobility);
+    }
+  };
+
+  /// Hash of a PropagationPathIdentifier, independent of the order of the mobility models
+  struct PropagationPathHash
+  {
+    /**
+     * \param key the path
+     * \returns the hash of \p key
      */
-    bool operator < (const PropagationPathIdentifier & other) const
+    std::size_t operator () (const PropagationPathIdentifier & key) const
     {
-      if (m_spectrumModelUid != other.m_spectrumModelUid)
-        {
-          return m_spectrumModelUid < other.m_spectrumModelUid;
-        }
-      /// Links are supposed to be symmetrical!
-      if (std::min (m_dstMobility, m_srcMobility) != std::min (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::min (m_dstMobility, m_srcMobility) < std::min (other.m_dstMobility, other.m_srcMobility);
-        }
-      if (std::max (m_dstMobility, m_srcMobility) != std::max (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::max (m_dstMobility, m_srcMobility) < std::max (other.m_dstMobility, other.m_srcMobility);
-        }
-      return false;
+      std::hash<const MobilityModel *> hasher;
+      std::size_t low = hasher (PeekPointer (std::min (key.m_dstMobility, key.m_srcMobility)));
+      std::size_t high = hasher (PeekPointer (std::max (key.m_dstMobility, key.m_srcMobility)));
+      std::size_t h = low ^ (high + 0x9e3779b9 + (low << 6) + (low >> 2));
+      return h ^ (key.m_spectrumModelUid + 0x9e3779b9 + (h << 6) + (h >> 2));
     }
   };
 
-  /// Typedef: PropagationPathIdentifier, Ptr<T>
-  typedef std::map<PropagationPathIdentifier, Ptr<T> > PathCache;
+  /// Typedef: PropagationPathIdentifier, (Ptr<T>, position in the LRU list)
+  typedef std::unordered_map<PropagationPathIdentifier,
+                             std::pair<Ptr<T>, typename std::list<PropagationPathIdentifier>::iterator>,
+                             PropagationPathHash> PathCache;
 private:
   PathCache m_pathCache; //!< Path cache
+  std::list<PropagationPathIdentifier> m_lru; //!< paths, most recently used first, if bounded
+  std::size_t m_maxSize; //!< maximum number of paths, 0 for no limit
 };
 } // namespace ns3
 
@@ -21,8 +21,12 @@
 #include "ns3/test.h"
 #include "ns3/config.h"
 #include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/cached-propagation-loss-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/simulator.h"
 
 using namespace ns3;
@@ -436,6 +440,108 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class CachedPropagationLossModelTestCase : public TestCase
+{
+public:
+  CachedPropagationLossModelTestCase ();
+  virtual ~CachedPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachedPropagationLossModelTestCase::CachedPropagationLossModelTestCase ()
+  : TestCase ("Test CachedPropagationLossModel")
+{
+}
+
+CachedPropagationLossModelTestCase::~CachedPropagationLossModelTestCase ()
+{
+}
+
+void
+CachedPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0,0,0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (100,0,0));
+  Ptr<ConstantVelocityMobilityModel> c = CreateObject<ConstantVelocityMobilityModel> ();
+  c->SetPosition (Vector (0,50,0));
+  c->SetVelocity (Vector (1,0,0));
+
+  Ptr<LogDistancePropagationLossModel> direct = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  cached->SetModel (CreateObject<LogDistancePropagationLossModel> ());
+
+  double txPwrdBm = 10.0;
+  double tolerance = 1e-9;
+  double expected = direct->CalcRxPower (txPwrdBm, a, b);
+  // the test macros evaluate their arguments more than once
+  double resultdBm = cached->CalcRxPower (txPwrdBm, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got unexpected rcv power");
+  resultdBm = cached->CalcRxPower (txPwrdBm, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got unexpected cached rcv power");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 1, "Path not computed once");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetHits (), 1, "Path not cached");
+
+  // each direction and each transmission power is computed
+  resultdBm = cached->CalcRxPower (txPwrdBm, b, a);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, direct->CalcRxPower (txPwrdBm, b, a), tolerance, "Got unexpected rcv power");
+  resultdBm = cached->CalcRxPower (0.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, direct->CalcRxPower (0.0, a, b), tolerance, "Got unexpected rcv power");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 3, "Path not computed");
+
+  // a course change invalidates the paths of the node
+  b->SetPosition (Vector (200,0,0));
+  expected = direct->CalcRxPower (txPwrdBm, a, b);
+  resultdBm = cached->CalcRxPower (txPwrdBm, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got stale rcv power after course change");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 4, "Path not computed after course change");
+
+  // a moving node is followed without course change
+  cached->ResetStatistics ();
+  cached->CalcRxPower (txPwrdBm, a, c);
+  cached->CalcRxPower (txPwrdBm, a, c);
+  NS_TEST_EXPECT_MSG_EQ (cached->GetHits (), 1, "Path of a node not moved yet not cached");
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  expected = direct->CalcRxPower (txPwrdBm, a, c);
+  resultdBm = cached->CalcRxPower (txPwrdBm, a, c);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got stale rcv power of a moving node");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 2, "Path of a moving node not computed");
+  cached->SetAttribute ("MaxDisplacement", DoubleValue (5.0));
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  resultdBm = cached->CalcRxPower (txPwrdBm, a, c);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Path of a slow node not cached");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 2, "Path of a slow node computed");
+  NS_TEST_EXPECT_MSG_EQ_TOL (cached->GetHitRate (), 0.5, tolerance, "Got unexpected hit rate");
+
+  // the least recently used path is evicted
+  cached->SetAttribute ("MaxEntries", UintegerValue (2));
+  cached->ResetStatistics ();
+  cached->CalcRxPower (txPwrdBm, a, b);
+  cached->CalcRxPower (txPwrdBm, a, c);
+  cached->CalcRxPower (txPwrdBm, a, b);
+  cached->CalcRxPower (txPwrdBm, b, c);
+  cached->CalcRxPower (txPwrdBm, a, b);
+  NS_TEST_EXPECT_MSG_EQ (cached->GetHits (), 2, "Recently used path evicted");
+  cached->CalcRxPower (txPwrdBm, a, c);
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 4, "Least recently used path not evicted");
+
+  // the models chained after the cache are still evaluated on every call
+  Ptr<RandomPropagationLossModel> random = CreateObject<RandomPropagationLossModel> ();
+  random->SetAttribute ("Variable", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"));
+  cached->SetNext (random);
+  double first = cached->CalcRxPower (txPwrdBm, a, b);
+  double second = cached->CalcRxPower (txPwrdBm, a, b);
+  NS_TEST_EXPECT_MSG_NE (first, second, "Random loss cached");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (first, cached->GetModel ()->CalcRxPower (txPwrdBm, a, b), "Random loss not applied");
+
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +556,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CachedPropagationLossModelTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
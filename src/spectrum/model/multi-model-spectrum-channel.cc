@@ -79,7 +79,8 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
-  : m_numDevices {0}
+  : m_numDevices {0},
+    m_rxIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -90,6 +91,9 @@ MultiModelSpectrumChannel::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_rxIndexPhys.clear ();
+  m_rxIndex.Clear ();
+  m_rxIndexValid = false;
   SpectrumChannel::DoDispose ();
 }
 
@@ -115,6 +119,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
   NS_ASSERT_MSG ((0 != rxSpectrumModel), "phy->GetRxSpectrumModel () returned 0. Please check that the RxSpectrumModel is already set for the phy before calling MultiModelSpectrumChannel::AddRx (phy)");
 
   SpectrumModelUid_t rxSpectrumModelUid = rxSpectrumModel->GetUid ();
+  m_rxIndexValid = false;
 
   // remove a previous entry of this phy if it exists
   // we need to scan for all rxSpectrumModel values since we don't
@@ -224,8 +229,7 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   m_txSigParamsTrace (txParamsTrace);
 
   Ptr<MobilityModel> txMobility = txParams->txPhy->GetMobility ();
-  SpectrumModelUid_t txSpectrumModelUid = txParams->psd->GetSpectrumModelUid ();
-  NS_LOG_LOGIC ("txSpectrumModelUid " << txSpectrumModelUid);
+  NS_LOG_LOGIC ("txSpectrumModelUid " << txParams->psd->GetSpectrumModelUid ());
 
   //
   TxSpectrumModelInfoMap_t::const_iterator txInfoIteratorerator = FindAndEventuallyAddTxSpectrumModel (txParams->psd->GetSpectrumModel ());
@@ -235,6 +239,36 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  if (m_maxRange > 0 && txMobility)
+    {
+      // only look at the receivers in range, in the order of
+      // m_rxSpectrumModelInfoMap, and convert the transmitted power
+      // spectral density once per RX SpectrumModel
+      UpdateRxIndex ();
+      std::vector<uint32_t> inRange;
+      m_rxIndex.GetInRange (txMobility->GetPosition (), m_maxRange, inRange);
+      bool converted = false;
+      SpectrumModelUid_t rxSpectrumModelUid = 0;
+      Ptr<SpectrumValue> convertedTxPowerSpectrum;
+      for (std::vector<uint32_t>::const_iterator i = inRange.begin (); i != inRange.end (); ++i)
+        {
+          Ptr<SpectrumPhy> rxPhy = m_rxIndexPhys[*i];
+          SpectrumModelUid_t uid = rxPhy->GetRxSpectrumModel ()->GetUid ();
+          if (!converted || uid != rxSpectrumModelUid)
+            {
+              NS_LOG_LOGIC ("rxSpectrumModelUids " << uid);
+              rxSpectrumModelUid = uid;
+              convertedTxPowerSpectrum = ConvertTxPowerSpectrum (txInfoIteratorerator, txParams, uid);
+              converted = true;
+            }
+          if (convertedTxPowerSpectrum != 0 && rxPhy != txParams->txPhy)
+            {
+              StartTxToRx (txParams, txMobility, rxPhy, convertedTxPowerSpectrum);
+            }
+        }
+      return;
+    }
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -242,22 +276,11 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
       SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
       NS_LOG_LOGIC ("rxSpectrumModelUids " << rxSpectrumModelUid);
 
-      Ptr <SpectrumValue> convertedTxPowerSpectrum;
-      if (txSpectrumModelUid == rxSpectrumModelUid)
-        {
-          NS_LOG_LOGIC ("no spectrum conversion needed");
-          convertedTxPowerSpectrum = txParams->psd;
-        }
-      else
+      Ptr <SpectrumValue> convertedTxPowerSpectrum = ConvertTxPowerSpectrum (txInfoIteratorerator, txParams, rxSpectrumModelUid);
+      if (convertedTxPowerSpectrum == 0)
         {
-          NS_LOG_LOGIC ("converting txPowerSpectrum SpectrumModelUids " << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
-          SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
-          if (rxConverterIterator == txInfoIteratorerator->second.m_spectrumConverterMap.end ())
-            {
-              // No converter means TX SpectrumModel is orthogonal to RX SpectrumModel
-              continue;
-            }
-          convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
+          // TX SpectrumModel is orthogonal to RX SpectrumModel
+          continue;
         }
 
       for (auto rxPhyIterator = rxInfoIterator->second.m_rxPhys.begin ();
@@ -269,78 +292,7 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
           if ((*rxPhyIterator) != txParams->txPhy)
             {
-              NS_LOG_LOGIC ("copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
-
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
-
-              if (txMobility && receiverMobility)
-                {
-                  double txAntennaGain = 0;
-                  double rxAntennaGain = 0;
-                  double propagationGainDb = 0;
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
-                  // Gain trace
-                  m_gainTrace (txMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
-                  // Pathloss trace
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if (pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
-
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
-                {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
-                }
+              StartTxToRx (txParams, txMobility, *rxPhyIterator, convertedTxPowerSpectrum);
             }
         }
 
@@ -348,6 +300,137 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
 }
 
+Ptr<SpectrumValue>
+MultiModelSpectrumChannel::ConvertTxPowerSpectrum (TxSpectrumModelInfoMap_t::const_iterator txInfo,
+                                                   Ptr<SpectrumSignalParameters> txParams,
+                                                   SpectrumModelUid_t rxSpectrumModelUid) const
+{
+  SpectrumModelUid_t txSpectrumModelUid = txParams->psd->GetSpectrumModelUid ();
+  if (txSpectrumModelUid == rxSpectrumModelUid)
+    {
+      NS_LOG_LOGIC ("no spectrum conversion needed");
+      return txParams->psd;
+    }
+  NS_LOG_LOGIC ("converting txPowerSpectrum SpectrumModelUids " << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
+  SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfo->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
+  if (rxConverterIterator == txInfo->second.m_spectrumConverterMap.end ())
+    {
+      // No converter means TX SpectrumModel is orthogonal to RX SpectrumModel
+      return 0;
+    }
+  return rxConverterIterator->second.Convert (txParams->psd);
+}
+
+void
+MultiModelSpectrumChannel::StartTxToRx (Ptr<SpectrumSignalParameters> txParams,
+                                        Ptr<MobilityModel> txMobility,
+                                        Ptr<SpectrumPhy> receiver,
+                                        Ptr<SpectrumValue> convertedTxPowerSpectrum)
+{
+  Time delay = MicroSeconds (0);
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+  Ptr<SpectrumSignalParameters> rxParams;
+
+  if (txMobility && receiverMobility)
+    {
+      double txAntennaGain = 0;
+      double rxAntennaGain = 0;
+      double propagationGainDb = 0;
+      double pathLossDb = 0;
+      if (txParams->txAntenna != 0)
+        {
+          Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+          txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
+          NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+          pathLossDb -= txAntennaGain;
+        }
+      Ptr<AntennaModel> rxAntenna = receiver->GetRxAntenna ();
+      if (rxAntenna != 0)
+        {
+          Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+          rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+          NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+          pathLossDb -= rxAntennaGain;
+        }
+      if (m_propagationLoss)
+        {
+          propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+          NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+          pathLossDb -= propagationGainDb;
+        }
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+      // Gain trace
+      m_gainTrace (txMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
+      // Pathloss trace
+      m_pathLossTrace (txParams->txPhy, receiver, pathLossDb);
+      if (pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+      NS_LOG_LOGIC ("copying signal parameters " << txParams);
+      rxParams = txParams->Copy ();
+      rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;
+
+      if (m_spectrumPropagationLoss)
+        {
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+        }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+  else
+    {
+      NS_LOG_LOGIC ("copying signal parameters " << txParams);
+      rxParams = txParams->Copy ();
+      rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+    }
+
+  Ptr<NetDevice> netDev = receiver->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, receiver);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, receiver);
+    }
+}
+
+void
+MultiModelSpectrumChannel::UpdateRxIndex (void)
+{
+  if (m_rxIndexValid && m_rxIndex.GetCellSize () == m_maxRange)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_rxIndex.Reset (m_maxRange);
+  m_rxIndexPhys.clear ();
+  for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+       rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+       ++rxInfoIterator)
+    {
+      for (const auto &phy : rxInfoIterator->second.m_rxPhys)
+        {
+          m_rxIndex.Add (static_cast<uint32_t> (m_rxIndexPhys.size ()), phy->GetMobility ());
+          m_rxIndexPhys.push_back (phy);
+        }
+    }
+  m_rxIndexValid = true;
+}
+
 void
 MultiModelSpectrumChannel::StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
 {
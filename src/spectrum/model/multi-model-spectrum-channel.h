@@ -27,6 +27,7 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/spatial-index.h>
 #include <map>
 #include <set>
 
@@ -149,6 +150,41 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Convert the power spectral density of a transmission to the
+   * SpectrumModel of a set of receivers.
+   *
+   * \param txInfo the TX SpectrumModel entry of the transmission
+   * \param txParams the parameters of the transmitted signal
+   * \param rxSpectrumModelUid the RX SpectrumModel
+   * \return the converted power spectral density, or 0 if the
+   * SpectrumModels are orthogonal
+   */
+  Ptr<SpectrumValue> ConvertTxPowerSpectrum (TxSpectrumModelInfoMap_t::const_iterator txInfo,
+                                             Ptr<SpectrumSignalParameters> txParams,
+                                             SpectrumModelUid_t rxSpectrumModelUid) const;
+
+  /**
+   * Propagate a transmission to one receiver, and schedule its
+   * reception unless it is out of range.
+   *
+   * \param txParams the parameters of the transmitted signal
+   * \param txMobility the mobility model of the transmitter
+   * \param receiver the receiver
+   * \param convertedTxPowerSpectrum the transmitted power spectral
+   * density, in the SpectrumModel of the receiver
+   */
+  void StartTxToRx (Ptr<SpectrumSignalParameters> txParams,
+                    Ptr<MobilityModel> txMobility,
+                    Ptr<SpectrumPhy> receiver,
+                    Ptr<SpectrumValue> convertedTxPowerSpectrum);
+
+  /**
+   * Rebuild m_rxIndex if receivers were added or MaxRange changed
+   * since it was last built.
+   */
+  void UpdateRxIndex (void);
+
   /**
    * Data structure holding, for each TX SpectrumModel,  all the
    * converters to any RX SpectrumModel, and all the corresponding
@@ -169,6 +205,23 @@ private:
    */
   std::size_t m_numDevices;
 
+  /**
+   * The receivers, in the order of m_rxSpectrumModelInfoMap, so those
+   * of a RX SpectrumModel are consecutive.  Only used if MaxRange is set.
+   */
+  std::vector<Ptr<SpectrumPhy> > m_rxIndexPhys;
+
+  /**
+   * The receivers by position, identified by their index in
+   * m_rxIndexPhys.  Only used if MaxRange is set.
+   */
+  SpatialIndex m_rxIndex;
+
+  /**
+   * True if m_rxIndex holds all the receivers.
+   */
+  bool m_rxIndexValid;
+
 };
 
 
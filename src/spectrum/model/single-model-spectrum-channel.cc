@@ -45,6 +45,7 @@ NS_LOG_COMPONENT_DEFINE ("SingleModelSpectrumChannel");
 NS_OBJECT_ENSURE_REGISTERED (SingleModelSpectrumChannel);
 
 SingleModelSpectrumChannel::SingleModelSpectrumChannel ()
+  : m_rxIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -54,6 +55,8 @@ SingleModelSpectrumChannel::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   m_phyList.clear ();
+  m_rxIndex.Clear ();
+  m_rxIndexValid = false;
   m_spectrumModel = 0;
   SpectrumChannel::DoDispose ();
 }
@@ -76,6 +79,23 @@ SingleModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
   m_phyList.push_back (phy);
+  m_rxIndexValid = false;
+}
+
+void
+SingleModelSpectrumChannel::UpdateRxIndex (void)
+{
+  if (m_rxIndexValid && m_rxIndex.GetCellSize () == m_maxRange)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_rxIndex.Reset (m_maxRange);
+  for (std::size_t i = 0; i < m_phyList.size (); ++i)
+    {
+      m_rxIndex.Add (static_cast<uint32_t> (i), m_phyList[i]->GetMobility ());
+    }
+  m_rxIndexValid = true;
 }
 
 
@@ -106,84 +126,113 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
   Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
 
+  if (m_maxRange > 0 && senderMobility)
+    {
+      // only look at the receivers in range, in the order of m_phyList
+      UpdateRxIndex ();
+      std::vector<uint32_t> inRange;
+      m_rxIndex.GetInRange (senderMobility->GetPosition (), m_maxRange, inRange);
+      for (std::vector<uint32_t>::const_iterator i = inRange.begin (); i != inRange.end (); ++i)
+        {
+          if (m_phyList[*i] != txParams->txPhy)
+            {
+              StartTxToRx (txParams, senderMobility, m_phyList[*i]);
+            }
+        }
+      return;
+    }
+
   for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
        rxPhyIterator != m_phyList.end ();
        ++rxPhyIterator)
     {
       if ((*rxPhyIterator) != txParams->txPhy)
         {
-          Time delay  = MicroSeconds (0);
+          StartTxToRx (txParams, senderMobility, *rxPhyIterator);
+        }
+    }
+}
 
-          Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
-          NS_LOG_LOGIC ("copying signal parameters " << txParams);
-          Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+void
+SingleModelSpectrumChannel::StartTxToRx (Ptr<SpectrumSignalParameters> txParams,
+                                         Ptr<MobilityModel> senderMobility,
+                                         Ptr<SpectrumPhy> receiver)
+{
+  Time delay  = MicroSeconds (0);
 
-          if (senderMobility && receiverMobility)
-            {
-              double txAntennaGain = 0;
-              double rxAntennaGain = 0;
-              double propagationGainDb = 0;
-              double pathLossDb = 0;
-              if (rxParams->txAntenna != 0)
-                {
-                  Angles txAngles (receiverMobility->GetPosition (), senderMobility->GetPosition ());
-                  txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                  pathLossDb -= txAntennaGain;
-                }
-              Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-              if (rxAntenna != 0)
-                {
-                  Angles rxAngles (senderMobility->GetPosition (), receiverMobility->GetPosition ());
-                  rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                  pathLossDb -= rxAntennaGain;
-                }
-              if (m_propagationLoss)
-                {
-                  propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
-                  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                  pathLossDb -= propagationGainDb;
-                }                    
-              NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
-              // Gain trace
-              m_gainTrace (senderMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
-              // Pathloss trace
-              m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-              if ( pathLossDb > m_maxLossDb)
-                {
-                  // beyond range
-                  continue;
-                }
-              double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-              *(rxParams->psd) *= pathGainLinear;              
-
-              if (m_spectrumPropagationLoss)
-                {
-                  rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, senderMobility, receiverMobility);
-                }
-
-              if (m_propagationDelay)
-                {
-                  delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
-                }
-            }
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+  Ptr<SpectrumSignalParameters> rxParams;
 
+  if (senderMobility && receiverMobility)
+    {
+      double txAntennaGain = 0;
+      double rxAntennaGain = 0;
+      double propagationGainDb = 0;
+      double pathLossDb = 0;
+      if (txParams->txAntenna != 0)
+        {
+          Angles txAngles (receiverMobility->GetPosition (), senderMobility->GetPosition ());
+          txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
+          NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+          pathLossDb -= txAntennaGain;
+        }
+      Ptr<AntennaModel> rxAntenna = receiver->GetRxAntenna ();
+      if (rxAntenna != 0)
+        {
+          Angles rxAngles (senderMobility->GetPosition (), receiverMobility->GetPosition ());
+          rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+          NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+          pathLossDb -= rxAntennaGain;
+        }
+      if (m_propagationLoss)
+        {
+          propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
+          NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+          pathLossDb -= propagationGainDb;
+        }
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+      // Gain trace
+      m_gainTrace (senderMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
+      // Pathloss trace
+      m_pathLossTrace (txParams->txPhy, receiver, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+      NS_LOG_LOGIC ("copying signal parameters " << txParams);
+      rxParams = txParams->Copy ();
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;
 
-          Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-          if (netDev)
-            {
-              // the receiver has a NetDevice, so we expect that it is attached to a Node
-              uint32_t dstNode =  netDev->GetNode ()->GetId ();
-              Simulator::ScheduleWithContext (dstNode, delay, &SingleModelSpectrumChannel::StartRx, this, rxParams, *rxPhyIterator);
-            }
-          else
-            {
-              // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-              Simulator::Schedule (delay, &SingleModelSpectrumChannel::StartRx, this,
-                                   rxParams, *rxPhyIterator);
-            }
+      if (m_spectrumPropagationLoss)
+        {
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, senderMobility, receiverMobility);
         }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
+        }
+    }
+  else
+    {
+      NS_LOG_LOGIC ("copying signal parameters " << txParams);
+      rxParams = txParams->Copy ();
+    }
+
+  Ptr<NetDevice> netDev = receiver->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &SingleModelSpectrumChannel::StartRx, this, rxParams, receiver);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &SingleModelSpectrumChannel::StartRx, this,
+                           rxParams, receiver);
     }
 }
 
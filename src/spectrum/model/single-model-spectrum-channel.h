@@ -25,6 +25,7 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-model.h>
 #include <ns3/traced-callback.h>
+#include <ns3/spatial-index.h>
 
 namespace ns3 {
 
@@ -72,11 +73,40 @@ private:
    */
   void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Propagate a transmission to one receiver, and schedule its
+   * reception unless it is out of range.
+   *
+   * \param txParams the parameters of the transmitted signal
+   * \param senderMobility the mobility model of the transmitter
+   * \param receiver the receiver
+   */
+  void StartTxToRx (Ptr<SpectrumSignalParameters> txParams,
+                    Ptr<MobilityModel> senderMobility,
+                    Ptr<SpectrumPhy> receiver);
+
+  /**
+   * Rebuild m_rxIndex if receivers were added or MaxRange changed
+   * since it was last built.
+   */
+  void UpdateRxIndex (void);
+
   /**
    * List of SpectrumPhy instances attached to the channel.
    */
   PhyList m_phyList;
 
+  /**
+   * The receivers by position, identified by their index in m_phyList.
+   * Only used if MaxRange is set.
+   */
+  SpatialIndex m_rxIndex;
+
+  /**
+   * True if m_rxIndex holds all of m_phyList.
+   */
+  bool m_rxIndexValid;
+
   /**
    * SpectrumModel that this channel instance is supporting.
    */
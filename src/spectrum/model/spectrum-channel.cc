@@ -70,6 +70,23 @@ SpectrumChannel::GetTypeId (void)
                    MakeDoubleAccessor (&SpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
 
+    .AddAttribute ("MaxRange",
+                   "If not zero, the distance in meters beyond which "
+                   "transmissions are not passed to the receiving PHY. "
+                   "The receivers are then kept in a grid of this size "
+                   "indexed by position, and the receivers beyond this "
+                   "distance of the transmitter are skipped without "
+                   "evaluating any loss model, nor firing the Gain and "
+                   "PathLoss traces for them. Receivers without a "
+                   "MobilityModel are never skipped. The MobilityModel "
+                   "of a receiver is read when the first signal is "
+                   "transmitted after the receiver is added to the "
+                   "channel, and its course changes are followed from "
+                   "then on. Note that the default value disables the grid.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&SpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
+
     .AddAttribute ("PropagationLossModel",
                    "A pointer to the propagation loss model attached to this channel.",
                    PointerValue (0),
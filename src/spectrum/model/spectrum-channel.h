@@ -183,6 +183,14 @@ protected:
    */
   double m_maxLossDb;
 
+  /**
+   * Maximum range [m].
+   *
+   * Any device beyond this distance is considered out of range, and
+   * skipped.  Zero disables the range check.
+   */
+  double m_maxRange;
+
   /**
    * Single-frequency propagation loss model to be used with this channel.
    */
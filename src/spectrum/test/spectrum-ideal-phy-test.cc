@@ -44,6 +44,7 @@
 #include <ns3/mobility-helper.h>
 #include <ns3/data-rate.h>
 #include <ns3/uinteger.h>
+#include <ns3/double.h>
 #include <ns3/packet-socket-helper.h>
 #include <ns3/packet-socket-address.h>
 #include <ns3/packet-socket-client.h>
@@ -70,26 +71,32 @@ public:
   SpectrumIdealPhyTestCase (double snrLinear,
 			    uint64_t phyRate,
 			    bool rateIsAchievable,
-			    std::string channelType);
+			    std::string channelType,
+			    double maxRange = 0);
   virtual ~SpectrumIdealPhyTestCase ();
 
 private:
   virtual void DoRun (void);
-  static std::string Name (std::string channelType, double snrLinear, uint64_t phyRate);
+  static std::string Name (std::string channelType, double snrLinear, uint64_t phyRate, double maxRange);
   
   double      m_snrLinear;
   uint64_t    m_phyRate;
   bool        m_rateIsAchievable;
   std::string m_channelType;
+  double      m_maxRange;
 };
 
 std::string 
-SpectrumIdealPhyTestCase::Name (std::string channelType, double snrLinear, uint64_t phyRate)
+SpectrumIdealPhyTestCase::Name (std::string channelType, double snrLinear, uint64_t phyRate, double maxRange)
 {
   std::ostringstream oss;
   oss << channelType
       << " snr = " << snrLinear << " (linear), "
       << " phyRate = " << phyRate << " bps";
+  if (maxRange > 0)
+    {
+      oss << ", maxRange = " << maxRange << " m";
+    }
   return oss.str();
 }
 
@@ -97,12 +104,14 @@ SpectrumIdealPhyTestCase::Name (std::string channelType, double snrLinear, uint6
 SpectrumIdealPhyTestCase::SpectrumIdealPhyTestCase (double snrLinear,
 						    uint64_t phyRate,
 						    bool rateIsAchievable,
-						    std::string channelType)
-  : TestCase (Name (channelType, snrLinear, phyRate)),
+						    std::string channelType,
+						    double maxRange)
+  : TestCase (Name (channelType, snrLinear, phyRate, maxRange)),
     m_snrLinear (snrLinear),
     m_phyRate (phyRate),
     m_rateIsAchievable (rateIsAchievable),
-    m_channelType (channelType)
+    m_channelType (channelType),
+    m_maxRange (maxRange)
 {
 }
 
@@ -154,6 +163,7 @@ SpectrumIdealPhyTestCase::DoRun (void)
   propLoss->SetLoss (c.Get(0)->GetObject<MobilityModel> (), c.Get(1)->GetObject<MobilityModel> (), lossDb, true);
   channelHelper.AddPropagationLoss (propLoss);
   Ptr<SpectrumChannel> channel = channelHelper.Create ();
+  channel->SetAttribute ("MaxRange", DoubleValue (m_maxRange));
 
 
   WifiSpectrumValue5MhzFactory sf;
@@ -243,6 +253,12 @@ SpectrumIdealPhyTestSuite::SpectrumIdealPhyTestSuite ()
       AddTestCase (new SpectrumIdealPhyTestCase (snr, static_cast<uint64_t> (achievableRate*2),    false,  "ns3::MultiModelSpectrumChannel"), TestCase::QUICK);
       AddTestCase (new SpectrumIdealPhyTestCase (snr, static_cast<uint64_t> (achievableRate*4),    false,  "ns3::MultiModelSpectrumChannel"), TestCase::QUICK);
     }
+  // the nodes are 5 m apart
+  double achievableRate = g_bandwidth*log2(1+1.0);
+  AddTestCase (new SpectrumIdealPhyTestCase (1.0, static_cast<uint64_t> (achievableRate*0.5), true,  "ns3::SingleModelSpectrumChannel", 10), TestCase::QUICK);
+  AddTestCase (new SpectrumIdealPhyTestCase (1.0, static_cast<uint64_t> (achievableRate*0.5), false, "ns3::SingleModelSpectrumChannel", 2), TestCase::QUICK);
+  AddTestCase (new SpectrumIdealPhyTestCase (1.0, static_cast<uint64_t> (achievableRate*0.5), true,  "ns3::MultiModelSpectrumChannel", 10), TestCase::QUICK);
+  AddTestCase (new SpectrumIdealPhyTestCase (1.0, static_cast<uint64_t> (achievableRate*0.5), false, "ns3::MultiModelSpectrumChannel", 2), TestCase::QUICK);
 }
 
 static SpectrumIdealPhyTestSuite g_spectrumIdealPhyTestSuite;
@@ -1089,6 +1089,7 @@ WifiPhy::ConfigureStandardAndBand (WifiPhyStandard standard, WifiPhyBand band)
                               m_standard, m_band);
     }
   m_operatingChannel.SetPrimary20Index (m_initialPrimary20Index);
+  FinalizeChannelSwitch ();
 
   switch (standard)
     {
@@ -1293,6 +1294,13 @@ WifiPhy::SetOperatingChannel (uint8_t number, uint16_t frequency, uint16_t width
           m_capabilitiesChangedCallback ();
         }
     }
+  FinalizeChannelSwitch ();
+}
+
+void
+WifiPhy::FinalizeChannelSwitch (void)
+{
+  NS_LOG_FUNCTION (this);
 }
 
 Time
@@ -1104,6 +1104,12 @@ protected:
    */
   Time DoChannelSwitch (void);
 
+  /**
+   * Perform any actions necessary once the operating channel has been
+   * set, either at configuration time or after a channel switch.
+   */
+  virtual void FinalizeChannelSwitch (void);
+
   /**
    * Check if PHY state should move to CCA busy state based on current
    * state of interference tracker.  In this model, CCA becomes busy when
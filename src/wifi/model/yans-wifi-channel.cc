@@ -21,6 +21,7 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/propagation-loss-model.h"
@@ -53,11 +54,24 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "If not zero, the distance in meters beyond which PPDUs are "
+                   "not propagated to the receiving PHYs. The PHYs are then "
+                   "kept in a grid of this size indexed by position, and "
+                   "the PHYs beyond this distance of the sender are skipped "
+                   "without evaluating the propagation models. With a random "
+                   "propagation loss model, this changes the random values "
+                   "drawn, so tune this value with care.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_bucketsValid (false),
+    m_bucketsRange (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,6 +80,7 @@ YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION (this);
   m_phyList.clear ();
+  m_buckets.clear ();
 }
 
 void
@@ -88,38 +103,101 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const WifiPpdu> ppdu, double
   NS_LOG_FUNCTION (this << sender << ppdu << txPowerDbm);
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  //For now don't account for inter channel interference nor channel bonding:
+  //only the PHYs on the channel number of the sender receive the PPDU
+  UpdateBuckets ();
+  std::map<uint8_t, struct Bucket>::const_iterator bucket = m_buckets.find (sender->GetChannelNumber ());
+  if (bucket == m_buckets.end ())
     {
-      if (sender != (*i))
+      return;
+    }
+  //The receivers do not modify the PPDU, so they can share one copy
+  Ptr<WifiPpdu> copy = ppdu->Copy ();
+  const PhyList &phys = bucket->second.phys;
+  if (m_maxRange > 0)
+    {
+      std::vector<uint32_t> inRange;
+      bucket->second.index.GetInRange (senderMobility->GetPosition (), m_maxRange, inRange);
+      for (std::vector<uint32_t>::const_iterator i = inRange.begin (); i != inRange.end (); ++i)
         {
-          //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
-            {
-              continue;
-            }
+          Propagate (sender, senderMobility, phys[*i], copy, txPowerDbm);
+        }
+    }
+  else
+    {
+      for (PhyList::const_iterator i = phys.begin (); i != phys.end (); ++i)
+        {
+          Propagate (sender, senderMobility, *i, copy, txPowerDbm);
+        }
+    }
+}
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<WifiPpdu> copy = ppdu->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
-            {
-              dstNode = 0xffffffff;
-            }
-          else
+void
+YansWifiChannel::Propagate (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility,
+                            Ptr<YansWifiPhy> receiver, Ptr<WifiPpdu> ppdu, double txPowerDbm) const
+{
+  if (sender == receiver)
+    {
+      return;
+    }
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  // Do not schedule the reception of a signal that Receive would drop
+  if ((rxPowerDbm + receiver->GetRxGain ()) < receiver->GetRxSensitivity ())
+    {
+      NS_LOG_INFO ("Received signal too weak to process: " << rxPowerDbm << " dBm");
+      return;
+    }
+  Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive,
+                                  receiver, ppdu, rxPowerDbm);
+}
+
+void
+YansWifiChannel::UpdateBuckets (void) const
+{
+  if (m_bucketsValid && m_bucketsRange == m_maxRange)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_buckets.clear ();
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); ++i)
+    {
+      struct Bucket &bucket = m_buckets[(*i)->GetChannelNumber ()];
+      if (m_maxRange > 0)
+        {
+          if (bucket.phys.empty ())
             {
-              dstNode = dstNetDevice->GetNode ()->GetId ();
+              bucket.index.Reset (m_maxRange);
             }
-
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive,
-                                          (*i), copy, rxPowerDbm);
+          bucket.index.Add (static_cast<uint32_t> (bucket.phys.size ()), (*i)->GetMobility ());
         }
+      bucket.phys.push_back (*i);
     }
+  m_bucketsValid = true;
+  m_bucketsRange = m_maxRange;
+}
+
+void
+YansWifiChannel::NotifyChannelSwitch (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_bucketsValid = false;
 }
 
 void
@@ -155,6 +233,7 @@ YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
   m_phyList.push_back (phy);
+  m_bucketsValid = false;
 }
 
 int64_t
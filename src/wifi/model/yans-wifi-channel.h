@@ -22,6 +22,8 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include "ns3/channel.h"
+#include "ns3/spatial-index.h"
+#include <map>
 
 namespace ns3 {
 
@@ -32,6 +34,7 @@ class YansWifiPhy;
 class Packet;
 class Time;
 class WifiPpdu;
+class MobilityModel;
 
 /**
  * \brief a channel to interconnect ns3::YansWifiPhy objects.
@@ -85,6 +88,14 @@ public:
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const WifiPpdu> ppdu, double txPowerDbm) const;
 
+  /**
+   * This method should not be invoked by normal users. It is
+   * currently invoked only from YansWifiPhy::FinalizeChannelSwitch,
+   * to notify the channel that the channel number of one of its
+   * YansWifiPhy objects may have changed.
+   */
+  void NotifyChannelSwitch (void);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -114,9 +125,41 @@ private:
    */
   static void Receive (Ptr<YansWifiPhy> receiver, Ptr<WifiPpdu> ppdu, double txPowerDbm);
 
+  /**
+   * Compute the propagation of a PPDU to one YansWifiPhy, and schedule
+   * its reception unless the signal is too weak to be detected.
+   *
+   * \param sender the PHY object from which the PPDU is originating
+   * \param senderMobility the mobility model of the sender
+   * \param receiver the device to which the PPDU is propagated
+   * \param ppdu the copy of the PPDU shared by all the receivers
+   * \param txPowerDbm the TX power associated to the PPDU (dBm)
+   */
+  void Propagate (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility,
+                  Ptr<YansWifiPhy> receiver, Ptr<WifiPpdu> ppdu, double txPowerDbm) const;
+
+  /**
+   * Rebuild m_buckets if PHYs were added, switched channel, or if
+   * MaxRange changed since they were last built.
+   */
+  void UpdateBuckets (void) const;
+
+  /**
+   * The YansWifiPhys using one channel number.
+   */
+  struct Bucket
+  {
+    PhyList phys;        //!< the PHYs, in the order of m_phyList
+    SpatialIndex index;  //!< the PHYs by position, identified by their index in phys, if MaxRange is set
+  };
+
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_maxRange;                   //!< Distance beyond which PHYs are skipped, if not zero
+  mutable std::map<uint8_t, struct Bucket> m_buckets; //!< The PHYs, by channel number
+  mutable bool m_bucketsValid;         //!< True if m_buckets is up to date
+  mutable double m_bucketsRange;       //!< The MaxRange used to build m_buckets
 };
 
 } //namespace ns3
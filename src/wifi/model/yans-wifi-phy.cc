@@ -64,6 +64,16 @@ YansWifiPhy::DoDispose (void)
   WifiPhy::DoDispose ();
 }
 
+void
+YansWifiPhy::FinalizeChannelSwitch (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_channel != 0)
+    {
+      m_channel->NotifyChannelSwitch ();
+    }
+}
+
 Ptr<Channel>
 YansWifiPhy::GetChannel (void) const
 {
@@ -71,6 +71,7 @@ public:
 
 protected:
   void DoDispose (void) override;
+  void FinalizeChannelSwitch (void) override;
 
 
 private:
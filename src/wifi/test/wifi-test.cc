@@ -22,6 +22,7 @@
  */
 
 #include "ns3/string.h"
+#include "ns3/double.h"
 #include "ns3/yans-wifi-helper.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/wifi-net-device.h"
@@ -3062,6 +3063,136 @@ IdealRateManagerMimoTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief YansWifiChannel receivers by channel number and range
+ *
+ * A PPDU must reach the PHYs on the channel number of the sender only,
+ * including after they switch channel, and, when the MaxRange attribute
+ * of the channel is set, the PHYs within that range only, including
+ * after they move.
+ */
+class YansWifiChannelReceiversTest : public TestCase
+{
+public:
+  YansWifiChannelReceiversTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Send a broadcast packet.
+   * \param dev the device sending the packet
+   */
+  void SendOnePacket (Ptr<NetDevice> dev);
+  /**
+   * Count the PSDUs received.
+   * \param index the index of the receiving node
+   * \param p the packet
+   * \param rxPowersW the received power per channel band in watts
+   */
+  void RxBegin (std::size_t index, Ptr<const Packet> p, RxPowerWattPerChannelBand rxPowersW);
+  /**
+   * Check the number of PSDUs received by each node.
+   * \param expected the expected counts, one per node
+   */
+  void CheckCounts (std::vector<uint32_t> expected);
+
+  std::vector<uint32_t> m_counts; ///< number of PSDUs received by each node
+};
+
+YansWifiChannelReceiversTest::YansWifiChannelReceiversTest ()
+  : TestCase ("Test the receivers of a YansWifiChannel")
+{
+}
+
+void
+YansWifiChannelReceiversTest::SendOnePacket (Ptr<NetDevice> dev)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  dev->Send (p, dev->GetBroadcast (), 1);
+}
+
+void
+YansWifiChannelReceiversTest::RxBegin (std::size_t index, Ptr<const Packet> p, RxPowerWattPerChannelBand rxPowersW)
+{
+  m_counts[index]++;
+}
+
+void
+YansWifiChannelReceiversTest::CheckCounts (std::vector<uint32_t> expected)
+{
+  for (std::size_t i = 0; i < m_counts.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_counts[i], expected[i], "Unexpected number of PSDUs received by node " << i
+                             << " at " << Simulator::Now ().As (Time::S));
+    }
+}
+
+void
+YansWifiChannelReceiversTest::DoRun (void)
+{
+  // node 0 sends, node 1 is near, node 2 is far, node 3 is near on another channel
+  NodeContainer nodes;
+  nodes.Create (4);
+  m_counts.assign (nodes.GetN (), 0);
+
+  YansWifiChannelHelper channelHelper;
+  channelHelper.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  // every node would receive the packets at the same power
+  channelHelper.AddPropagationLoss ("ns3::FixedRssLossModel", "Rss", DoubleValue (-60));
+  Ptr<YansWifiChannel> channel = channelHelper.Create ();
+  channel->SetAttribute ("MaxRange", DoubleValue (100));
+
+  YansWifiPhyHelper phy;
+  phy.SetChannel (channel);
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  positionAlloc->Add (Vector (0.0, 0.0, 0.0));
+  positionAlloc->Add (Vector (10.0, 0.0, 0.0));
+  positionAlloc->Add (Vector (500.0, 0.0, 0.0));
+  positionAlloc->Add (Vector (0.0, 10.0, 0.0));
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  std::vector<Ptr<WifiPhy> > phys;
+  for (std::size_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiPhy> p = DynamicCast<WifiNetDevice> (devices.Get (i))->GetPhy ();
+      p->TraceConnectWithoutContext ("PhyRxBegin", MakeCallback (&YansWifiChannelReceiversTest::RxBegin, this).Bind (i));
+      phys.push_back (p);
+    }
+  uint8_t channelNumber = phys[0]->GetChannelNumber ();
+  phys[3]->SetChannelNumber (channelNumber + 4);
+
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelReceiversTest::SendOnePacket, this, devices.Get (0));
+  Simulator::Schedule (Seconds (1.5), &YansWifiChannelReceiversTest::CheckCounts, this, std::vector<uint32_t> {0, 1, 0, 0});
+
+  // node 3 switches to the channel of the sender
+  Simulator::Schedule (Seconds (1.9), &WifiPhy::SetChannelNumber, phys[3], channelNumber);
+  Simulator::Schedule (Seconds (2.0), &YansWifiChannelReceiversTest::SendOnePacket, this, devices.Get (0));
+  Simulator::Schedule (Seconds (2.5), &YansWifiChannelReceiversTest::CheckCounts, this, std::vector<uint32_t> {0, 2, 0, 1});
+
+  // node 2 comes within range
+  Simulator::Schedule (Seconds (2.9), &MobilityModel::SetPosition, nodes.Get (2)->GetObject<MobilityModel> (), Vector (50.0, 0.0, 0.0));
+  Simulator::Schedule (Seconds (3.0), &YansWifiChannelReceiversTest::SendOnePacket, this, devices.Get (0));
+  Simulator::Schedule (Seconds (3.5), &YansWifiChannelReceiversTest::CheckCounts, this, std::vector<uint32_t> {0, 3, 1, 2});
+
+  Simulator::Stop (Seconds (4.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 /**
  * \ingroup wifi-test
@@ -3180,6 +3311,7 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new IdealRateManagerChannelWidthTest, TestCase::QUICK);
   AddTestCase (new IdealRateManagerMimoTest, TestCase::QUICK);
   AddTestCase (new HeRuMcsDataRateTestCase, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelReceiversTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite; ///< the test suite
@@ -0,0 +1,79 @@
+#include <ns3/core-module.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+// 对每种聚合器，在 1e3 ~ 1e7 个参数的模型上测聚合耗时
+
+static double
+RunOnce (Ptr<WsnAggregator> aggregator, const std::vector<Ptr<const WsnModel> > &models)
+{
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (auto it : models)
+    {
+      aggregator->Add (it);
+    }
+  Ptr<WsnModel> global = aggregator->Aggregate ();
+  int64_t ms = clock.End ();
+  NS_ASSERT (global->GetSize () == models[0]->GetSize ());
+  return ms;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nModels = 5;
+  uint32_t minParams = 1000;
+  uint32_t maxParams = 10000000;
+  uint32_t runs = 3;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nModels", "number of models aggregated per round", nModels);
+  cmd.AddValue ("minParams", "smallest model size", minParams);
+  cmd.AddValue ("maxParams", "largest model size", maxParams);
+  cmd.AddValue ("runs", "rounds per measurement", runs);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> types = {"ns3::WsnFedAvgAggregator",
+                                    "ns3::WsnMedianAggregator",
+                                    "ns3::WsnTrimmedMeanAggregator"};
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+
+  std::cout << std::setw (28) << "aggregator" << std::setw (12) << "params"
+            << std::setw (12) << "ms/round" << std::setw (14) << "Mparam/s" << std::endl;
+
+  for (uint32_t size = minParams; size <= maxParams; size *= 10)
+    {
+      std::vector<Ptr<const WsnModel> > models;
+      for (uint32_t j = 0; j < nModels; ++j)
+        {
+          std::vector<double> params (size);
+          for (uint32_t i = 0; i < size; ++i)
+            {
+              params[i] = rng->GetValue (-1.0, 1.0);
+            }
+          models.push_back (Create<WsnModel> (std::move (params), 1.0 + j));
+        }
+
+      for (auto type : types)
+        {
+          ObjectFactory factory;
+          factory.SetTypeId (type);
+          Ptr<WsnAggregator> aggregator = factory.Create<WsnAggregator> ();
+          double total = 0;
+          for (uint32_t r = 0; r < runs; ++r)
+            {
+              total += RunOnce (aggregator, models);
+            }
+          double ms = total / runs;
+          double rate = ms > 0 ? (double)size * nModels / (ms * 1000.0) : 0.0;
+          std::cout << std::setw (28) << type << std::setw (12) << size
+                    << std::setw (12) << ms << std::setw (14) << rate << std::endl;
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include <ns3/core-module.h>
+#include <ns3/lr-wpan-module.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/single-model-spectrum-channel.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+// 对每种模型编解码器：
+//   1. 测编码 + 解码的吞吐量
+//   2. 在一个协调器 + 一个终端的网络上跑一轮联邦学习，
+//      统计从终端上传模型到收到全局模型的仿真时间
+
+static uint32_t g_params = 1000;
+static Time g_sent;
+static Time g_round;
+
+static std::vector<double>
+GetLocalModel (void)
+{
+  g_sent = Simulator::Now ();
+  std::vector<double> model (g_params);
+  for (uint32_t i = 0; i < g_params; ++i)
+    {
+      model[i] = std::sin (0.001 * i);
+    }
+  return model;
+}
+
+static void
+RecvGlobalModel (std::vector<double> model)
+{
+  g_round = Simulator::Now () - g_sent;
+  Simulator::Stop ();
+}
+
+static double
+CodecThroughput (std::string type, uint32_t runs)
+{
+  Ptr<WsnModelCodec> codec;
+  if (!type.empty ())
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (type);
+      codec = factory.Create<WsnModelCodec> ();
+    }
+  else
+    {
+      return 0.0;
+    }
+  Ptr<WsnModel> model = Create<WsnModel> (GetLocalModel ());
+  std::vector<uint8_t> buffer;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t r = 0; r < runs; ++r)
+    {
+      codec->Encode (model, buffer);
+      codec->Decode (buffer);
+    }
+  int64_t ms = clock.End ();
+  return ms > 0 ? (double)model->GetSerializedSize () * runs / (ms * 1000.0) : 0.0;
+}
+
+static uint32_t
+EncodedSize (std::string type)
+{
+  Ptr<WsnModel> model = Create<WsnModel> (GetLocalModel ());
+  if (type.empty ())
+    {
+      return model->GetSerializedSize ();
+    }
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  Ptr<WsnModelCodec> codec = factory.Create<WsnModelCodec> ();
+  std::vector<uint8_t> buffer;
+  codec->Encode (model, buffer);
+  return buffer.size ();
+}
+
+static Time
+RoundTime (std::string type)
+{
+  Config::SetDefault ("ns3::WsnNwkProtocol::ModelCodec", StringValue (type));
+  Config::SetDefault ("ns3::WsnNwkProtocol::Quorum", UintegerValue (1));
+  WsnAddressAllocator::Get ()->SetWsnAddressAllocator (10, 5, 5);
+
+  Ptr<SingleModelSpectrumChannel> channel = CreateObject<SingleModelSpectrumChannel> ();
+  channel->AddPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  WsnNwkProtocolHelper helper;
+  std::vector<Ptr<WsnNwkProtocol> > nwk;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<LrWpanNetDevice> dev = CreateObject<LrWpanNetDevice> ();
+      std::string mac48 = WsnAddressAllocator::Get ()->AllocateRandMac48Address ();
+      std::string mac64 = WsnAddressAllocator::Get ()->AnalysisMac48AddresstoEUI64 (mac48);
+      dev->GetMac ()->SetExtendedAddress (Mac64Address (mac64.c_str ()));
+      dev->SetChannel (channel);
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10.0 * i, 0, 0));
+      dev->GetPhy ()->SetMobility (mobility);
+
+      helper.CreateAndAggregateObjectFromTypeId (node, "ns3::WsnNwkProtocol");
+      Ptr<WsnNwkProtocol> protocol = node->GetObject<WsnNwkProtocol> ();
+      protocol->SetNodeType (i == 0 ? NODE_TYPE::COOR : NODE_TYPE::EDGE);
+      protocol->Assign (dev);
+      protocol->Install (node);
+      node->AddDevice (dev);
+      nwk.push_back (protocol);
+    }
+  nwk[1]->SetGetModelCallBack (MakeCallback (&GetLocalModel));
+  nwk[1]->SetRecvModelCallBack (MakeCallback (&RecvGlobalModel));
+
+  g_round = Seconds (0);
+  Simulator::Schedule (Seconds (0.0), &WsnNwkProtocol::JoinRequest, nwk[0], Ptr<WsnNwkProtocol> ());
+  Simulator::Schedule (Seconds (1.0), &WsnNwkProtocol::JoinRequest, nwk[1], nwk[0]);
+  Simulator::Schedule (Seconds (5.0), &WsnNwkProtocol::GetModel, nwk[1]);
+  Simulator::Stop (Seconds (1000.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return g_round;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t runs = 2000;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("params", "number of model parameters", g_params);
+  cmd.AddValue ("runs", "encode/decode repetitions for the throughput measurement", runs);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> types = {"",
+                                    "ns3::WsnRawCodec",
+                                    "ns3::WsnQuantizationCodec",
+                                    "ns3::WsnTopKCodec",
+                                    "ns3::WsnDeltaCodec"};
+
+  std::cout << std::setw (28) << "codec" << std::setw (10) << "bytes"
+            << std::setw (14) << "codec MB/s" << std::setw (16) << "round time (s)" << std::endl;
+  for (auto type : types)
+    {
+      uint32_t bytes = EncodedSize (type);
+      double rate = CodecThroughput (type, runs);
+      Time round = RoundTime (type);
+      std::cout << std::setw (28) << (type.empty () ? "none" : type) << std::setw (10) << bytes
+                << std::setw (14) << rate << std::setw (16) << round.GetSeconds () << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include <ns3/core-module.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+// 邻居表微基准：N 个邻居下的
+//   add     逐个插入
+//   short   按网络地址查找
+//   ext     按 MAC 地址查找
+//   child   遍历所有孩子
+//   remove  逐个删除
+// 每一项给出平均每次操作的纳秒数
+
+static Mac64Address
+MakeMac64 (uint32_t i)
+{
+  uint8_t buffer[8] = {0x00, 0x12, 0x4b, 0x00, 0, 0, 0, 0};
+  buffer[4] = (i >> 24) & 0xff;
+  buffer[5] = (i >> 16) & 0xff;
+  buffer[6] = (i >> 8) & 0xff;
+  buffer[7] = i & 0xff;
+  Mac64Address addr;
+  addr.CopyFrom (buffer);
+  return addr;
+}
+
+static double
+NsPerOp (int64_t ms, uint64_t ops)
+{
+  return ops ? ms * 1e6 / ops : 0.0;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t maxNeighbors = 10000;
+  uint32_t lookups = 1000000;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("maxNeighbors", "largest neighbor table size", maxNeighbors);
+  cmd.AddValue ("lookups", "lookups per measurement", lookups);
+  cmd.Parse (argc, argv);
+
+  std::cout << std::setw (10) << "neighbors"
+            << std::setw (12) << "add ns"
+            << std::setw (12) << "short ns"
+            << std::setw (12) << "ext ns"
+            << std::setw (12) << "child ns"
+            << std::setw (12) << "remove ns" << std::endl;
+
+  for (uint32_t n = 10; n <= maxNeighbors; n *= 10)
+    {
+      std::vector<NeighborTable::NeighborEntry> entries (n);
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          entries[i].extendedAddr = MakeMac64 (i);
+          entries[i].networkAddr = NwkShortAddress ((uint16_t)(i + 1));
+          entries[i].deviceType = DeviceTypes::END_DEVICE;
+          entries[i].relationship = (i % 4 == 0) ? Relationship::SIBLING : Relationship::CHILD;
+          entries[i].rxOnWhenIdle = true;
+          entries[i].linkQuality = 0;
+        }
+
+      // 插入要多做几轮，不然 10 个邻居时计时精度不够
+      uint32_t rounds = std::max<uint32_t> (1, lookups / n / 10);
+      NeighborTable table;
+      SystemWallClockMs clock;
+      clock.Start ();
+      for (uint32_t r = 0; r < rounds; ++r)
+        {
+          table.Clear ();
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              table.AddNeighborEntry (entries[i]);
+            }
+        }
+      double add = NsPerOp (clock.End (), (uint64_t)rounds * n);
+
+      uint32_t sum = 0;
+      clock.Start ();
+      for (uint32_t k = 0; k < lookups; ++k)
+        {
+          sum += table.GetLinkQuality (entries[k % n].networkAddr);
+        }
+      double byShort = NsPerOp (clock.End (), lookups);
+
+      clock.Start ();
+      for (uint32_t k = 0; k < lookups; ++k)
+        {
+          sum += table.FindNeighborEntry (entries[k % n].extendedAddr) != 0;
+        }
+      double byExt = NsPerOp (clock.End (), lookups);
+
+      uint64_t visited = 0;
+      clock.Start ();
+      while (visited < lookups)
+        {
+          for (const auto &entry : table.GetNeighborEntries (Relationship::CHILD))
+            {
+              sum += entry.linkQuality;
+              visited++;
+            }
+        }
+      double child = NsPerOp (clock.End (), visited);
+
+      clock.Start ();
+      for (uint32_t r = 0; r < rounds; ++r)
+        {
+          if (r)
+            {
+              table.AddNeighborEntries (entries);
+            }
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              table.RemoveNeighborEntry (entries[i].networkAddr);
+            }
+        }
+      double remove = NsPerOp (clock.End (), (uint64_t)rounds * n);
+
+      std::cout << std::setw (10) << n
+                << std::setw (12) << add
+                << std::setw (12) << byShort
+                << std::setw (12) << byExt
+                << std::setw (12) << child
+                << std::setw (12) << remove
+                << (sum == 0xffffffff ? " " : "") << std::endl;
+    }
+  return 0;
+}
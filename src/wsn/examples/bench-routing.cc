@@ -0,0 +1,104 @@
+#include <ns3/core-module.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+// 路由查找微基准：在一棵满 Cskip 树上，
+// 协调器对所有节点地址做下一跳查找，比较
+//   table  路由表（BuildRtable 批量建好）
+//   tree   按 Cskip 地址直接计算
+// 并检查两种方式算出的下一跳一致
+
+struct TreeNode
+{
+  uint16_t addr;
+  uint8_t depth;
+  uint16_t firstHop;  // 协调器到该节点的第一跳
+};
+
+int main (int argc, char *argv[])
+{
+  uint16_t n = 6;
+  uint16_t r = 4;
+  uint16_t d = 5;
+  uint32_t lookups = 1000000;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("n", "maximum children per parent", n);
+  cmd.AddValue ("r", "maximum routers per parent", r);
+  cmd.AddValue ("d", "maximum tree depth", d);
+  cmd.AddValue ("lookups", "lookups per measurement", lookups);
+  cmd.Parse (argc, argv);
+
+  WsnAddressAllocator *allocator = WsnAddressAllocator::Get ();
+  allocator->SetWsnAddressAllocator (n, r, d);
+
+  // 广度优先建满树：每个路由器 r 个路由器孩子和 n - r 个终端孩子
+  std::vector<TreeNode> nodes;
+  std::vector<TreeNode> routers;
+  routers.push_back ({0, 0, 0});
+  for (uint32_t i = 0; i < routers.size (); ++i)
+    {
+      TreeNode parent = routers[i];
+      if (parent.depth + 1 >= d)
+        {
+          continue;
+        }
+      for (uint16_t c = 0; c < n; ++c)
+        {
+          bool isRouter = c < r;
+          TreeNode child;
+          child.addr = allocator->AllocateNwkAddress (parent.depth, isRouter, parent.addr);
+          child.depth = parent.depth + 1;
+          child.firstHop = parent.depth == 0 ? child.addr : parent.firstHop;
+          nodes.push_back (child);
+          if (isRouter)
+            {
+              routers.push_back (child);
+            }
+        }
+    }
+
+  std::vector<StaticRoute> routes;
+  for (const auto &node : nodes)
+    {
+      routes.push_back (StaticRoute (NwkShortAddress (node.addr), NwkShortAddress (node.firstHop)));
+    }
+  RoutingTable table;
+  table.AddRoutes (routes);
+
+  uint32_t mismatch = 0;
+  for (const auto &node : nodes)
+    {
+      if (allocator->GetTreeNextHop (0, 0, node.addr) != table.Lookup (NwkShortAddress (node.addr)).GetAddressU16 ())
+        {
+          mismatch++;
+        }
+    }
+
+  uint32_t sum = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t k = 0; k < lookups; ++k)
+    {
+      sum += table.Lookup (NwkShortAddress (nodes[k % nodes.size ()].addr)).GetAddressU16 ();
+    }
+  int64_t tableMs = clock.End ();
+
+  clock.Start ();
+  for (uint32_t k = 0; k < lookups; ++k)
+    {
+      sum += allocator->GetTreeNextHop (0, 0, nodes[k % nodes.size ()].addr);
+    }
+  int64_t treeMs = clock.End ();
+
+  std::cout << "nodes " << nodes.size () << " routes " << table.GetN ()
+            << " mismatches " << mismatch << std::endl;
+  std::cout << std::setw (8) << "table" << std::setw (12) << tableMs * 1e6 / lookups << " ns/lookup" << std::endl;
+  std::cout << std::setw (8) << "tree" << std::setw (12) << treeMs * 1e6 / lookups << " ns/lookup"
+            << (sum == 0xffffffff ? " " : "") << std::endl;
+  return 0;
+}
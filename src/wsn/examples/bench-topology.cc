@@ -0,0 +1,67 @@
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/lr-wpan-module.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace ns3;
+
+// 用 WsnHelper::InstallTree 批量建树，统计建树的墙上时间、
+// 入网节点数、最大深度，并跑一小段仿真确认网络能正常启动
+
+int main (int argc, char *argv[])
+{
+  uint32_t nNodes = 5000;
+  double area = 400.0;
+  double range = 50.0;
+  uint16_t maxChildren = 10;
+  uint16_t maxRouters = 5;
+  uint16_t maxDepth = 5;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nNodes", "number of nodes", nNodes);
+  cmd.AddValue ("area", "side of the square area in meters", area);
+  cmd.AddValue ("range", "maximum parent-child distance in meters", range);
+  cmd.AddValue ("maxChildren", "maximum children per parent", maxChildren);
+  cmd.AddValue ("maxRouters", "maximum router children per parent", maxRouters);
+  cmd.AddValue ("maxDepth", "maximum tree depth", maxDepth);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+
+  WsnHelper helper;
+  SystemWallClockMs clock;
+  clock.Start ();
+  NetDeviceContainer devices = helper.InstallTree (nodes, area, range, maxChildren, maxRouters, maxDepth);
+  int64_t buildMs = clock.End ();
+
+  uint32_t joined = 0;
+  uint32_t routers = 0;
+  uint32_t deepest = 0;
+  uint32_t routes = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<WsnNwkProtocol> nwk = nodes.Get (i)->GetObject<WsnNwkProtocol> ();
+      if (nwk->GetDepth () == (uint8_t) -1)
+        {
+          continue;
+        }
+      joined++;
+      routers += nwk->IsRoute ();
+      deepest = std::max<uint32_t> (deepest, nwk->GetDepth ());
+      routes += nwk->GetRoutingTable ()->GetN ();
+    }
+
+  clock.Start ();
+  Simulator::Stop (Seconds (1.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  int64_t runMs = clock.End ();
+
+  std::cout << "nodes " << nNodes << " joined " << joined << " routers " << routers
+            << " depth " << deepest << " routes " << routes << std::endl;
+  std::cout << "build " << buildMs << " ms, first second of simulation " << runMs << " ms" << std::endl;
+  return 0;
+}
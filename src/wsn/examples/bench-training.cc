@@ -0,0 +1,165 @@
+#include <ns3/core-module.h>
+#include <ns3/lr-wpan-module.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/single-model-spectrum-channel.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/wsn-module.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <cmath>
+
+using namespace ns3;
+
+// 一个协调器 + nNodes 个终端的星形网络，每个终端的本地训练是一段
+// 纯计算（work 次迭代），比较
+//   sync   SetGetModelCallBack，训练在仿真事件里同步执行
+//   async  SetTrainCallBack，训练在线程池里执行，仿真继续跑
+// 两种方式下的墙上时间和完成的轮数
+// 指定 --trace 时用 WsnTraceRing 记录异步训练那一次的事件，
+// 写成二进制文件并打印每一轮的耗时
+
+static uint32_t g_params = 100;
+static uint32_t g_work = 2000000;
+static uint32_t g_rounds = 0;
+
+static std::vector<double>
+Train (uint32_t id)
+{
+  // 只用参数和局部变量，可以在工作线程上执行
+  std::vector<double> model (g_params);
+  double acc = id;
+  for (uint32_t k = 0; k < g_work; ++k)
+    {
+      acc = std::sin (acc) + 1e-3 * k;
+    }
+  for (uint32_t i = 0; i < g_params; ++i)
+    {
+      model[i] = id + 1e-9 * acc + 0.01 * i;
+    }
+  return model;
+}
+
+static void
+RecvGlobalModel (std::vector<double> model)
+{
+  g_rounds++;
+}
+
+static int64_t
+Run (bool async, uint32_t nNodes, double stop, Ptr<WsnTraceRing> ring)
+{
+  Config::SetDefault ("ns3::WsnNwkProtocol::Quorum", UintegerValue (nNodes));
+  WsnAddressAllocator::Get ()->SetWsnAddressAllocator (std::max<uint32_t> (nNodes, 10), 5, 5);
+
+  Ptr<SingleModelSpectrumChannel> channel = CreateObject<SingleModelSpectrumChannel> ();
+  channel->AddPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  WsnNwkProtocolHelper helper;
+  std::vector<Ptr<WsnNwkProtocol> > nwk;
+  for (uint32_t i = 0; i <= nNodes; ++i)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<LrWpanNetDevice> dev = CreateObject<LrWpanNetDevice> ();
+      std::string mac48 = WsnAddressAllocator::Get ()->AllocateRandMac48Address ();
+      std::string mac64 = WsnAddressAllocator::Get ()->AnalysisMac48AddresstoEUI64 (mac48);
+      dev->GetMac ()->SetExtendedAddress (Mac64Address (mac64.c_str ()));
+      dev->SetChannel (channel);
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      double angle = 2 * M_PI * i / nNodes;
+      mobility->SetPosition (i == 0 ? Vector (0, 0, 0) : Vector (10 * std::cos (angle), 10 * std::sin (angle), 0));
+      dev->GetPhy ()->SetMobility (mobility);
+
+      helper.CreateAndAggregateObjectFromTypeId (node, "ns3::WsnNwkProtocol");
+      Ptr<WsnNwkProtocol> protocol = node->GetObject<WsnNwkProtocol> ();
+      protocol->SetNodeType (i == 0 ? NODE_TYPE::COOR : NODE_TYPE::EDGE);
+      protocol->Assign (dev);
+      protocol->Install (node);
+      node->AddDevice (dev);
+      if (i > 0)
+        {
+          if (async)
+            {
+              protocol->SetTrainCallBack (MakeBoundCallback (&Train, i));
+            }
+          else
+            {
+              protocol->SetGetModelCallBack (MakeBoundCallback (&Train, i));
+            }
+          protocol->SetRecvModelCallBack (MakeCallback (&RecvGlobalModel));
+        }
+      nwk.push_back (protocol);
+      if (ring != 0)
+        {
+          ring->Install (protocol);
+        }
+    }
+
+  Simulator::Schedule (Seconds (0.0), &WsnNwkProtocol::JoinRequest, nwk[0], Ptr<WsnNwkProtocol> ());
+  for (uint32_t i = 1; i <= nNodes; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0 + 0.05 * i), &WsnNwkProtocol::JoinRequest, nwk[i], nwk[0]);
+      Simulator::Schedule (Seconds (5.0), &WsnNwkProtocol::GetModel, nwk[i]);
+    }
+
+  g_rounds = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Stop (Seconds (stop));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return clock.End ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nNodes = 8;
+  uint32_t threads = 0;
+  double stop = 60.0;
+  std::string trace = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nNodes", "number of training end devices", nNodes);
+  cmd.AddValue ("params", "number of model parameters", g_params);
+  cmd.AddValue ("work", "iterations of local training per round", g_work);
+  cmd.AddValue ("threads", "training threads, 0 for the hardware thread count", threads);
+  cmd.AddValue ("stop", "simulation stop time in seconds", stop);
+  cmd.AddValue ("trace", "binary trace file for the async run, empty for none", trace);
+  cmd.Parse (argc, argv);
+
+  if (threads)
+    {
+      WsnTrainingPool::Get ()->SetThreads (threads);
+    }
+
+  std::cout << std::setw (8) << "mode" << std::setw (10) << "threads"
+            << std::setw (12) << "wall ms" << std::setw (10) << "models" << std::endl;
+  int64_t ms = Run (false, nNodes, stop, 0);
+  std::cout << std::setw (8) << "sync" << std::setw (10) << 0
+            << std::setw (12) << ms << std::setw (10) << g_rounds << std::endl;
+  Ptr<WsnTraceRing> ring = trace.empty () ? 0 : CreateObject<WsnTraceRing> ();
+  ms = Run (true, nNodes, stop, ring);
+  std::cout << std::setw (8) << "async" << std::setw (10) << WsnTrainingPool::Get ()->GetThreads ()
+            << std::setw (12) << ms << std::setw (10) << g_rounds << std::endl;
+
+  if (ring != 0)
+    {
+      std::ofstream file (trace.c_str (), std::ios::binary);
+      ring->Write (file);
+      std::cout << ring->GetN () << " trace records written to " << trace << std::endl;
+      std::cout << std::setw (8) << "round" << std::setw (14) << "collect (s)" << std::setw (14) << "round (s)" << std::endl;
+      for (uint32_t i = 0; i < ring->GetN (); ++i)
+        {
+          const WsnTraceRing::Record &record = ring->Get (i);
+          if (record.type == WsnTraceRing::ROUND)
+            {
+              std::cout << std::setw (8) << record.count << std::setw (14) << record.value[0]
+                        << std::setw (14) << record.value[1] << std::endl;
+            }
+        }
+    }
+  return 0;
+}
@@ -7,8 +7,15 @@
 #include <ns3/multi-model-spectrum-channel.h>
 #include <ns3/propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/double.h>
 #include <ns3/log.h>
 #include "ns3/names.h"
+#include "ns3/wsn-network.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -166,6 +173,191 @@ WsnHelper::Install (NodeContainer c)
   return devices;
 }
 
+// 批量建树
+
+NetDeviceContainer
+WsnHelper::InstallTree (NodeContainer c, double area, double range,
+                        uint16_t maxChildren, uint16_t maxRouters, uint8_t maxDepth)
+{
+  NS_LOG_FUNCTION (this << c.GetN () << area << range << maxChildren << maxRouters << (uint32_t) maxDepth);
+  NetDeviceContainer devices;
+  uint32_t n = c.GetN ();
+  if (n == 0)
+    {
+      return devices;
+    }
+  WsnAddressAllocator *allocator = WsnAddressAllocator::Get ();
+  allocator->SetWsnAddressAllocator (maxChildren, maxRouters, maxDepth);
+
+  // 1. 安装设备和协议，记下每个节点的位置
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetAttribute ("Min", DoubleValue (0.0));
+  uniform->SetAttribute ("Max", DoubleValue (area));
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::WsnNwkProtocol");
+  std::vector<Vector> pos (n);
+  std::vector<Ptr<WsnNwkProtocol> > nwk (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Ptr<Node> node = c.Get (i);
+      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+      if (mobility == 0)
+        {
+          mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (i == 0 ? Vector (area / 2, area / 2, 0)
+                                        : Vector (uniform->GetValue (), uniform->GetValue (), 0));
+          node->AggregateObject (mobility);
+        }
+      pos[i] = mobility->GetPosition ();
+
+      // 扩展地址直接由节点编号生成，保证唯一
+      uint32_t id = node->GetId ();
+      uint8_t buffer[8] = {0x00, 0x12, 0x4b, 0x00,
+                           (uint8_t)(id >> 24), (uint8_t)(id >> 16), (uint8_t)(id >> 8), (uint8_t) id};
+      Mac64Address extendedAddr;
+      extendedAddr.CopyFrom (buffer);
+
+      Ptr<LrWpanNetDevice> netDevice = CreateObject<LrWpanNetDevice> ();
+      netDevice->SetChannel (m_channel);
+      netDevice->GetPhy ()->SetMobility (mobility);
+      netDevice->GetMac ()->SetExtendedAddress (extendedAddr);
+      node->AddDevice (netDevice);
+      netDevice->SetNode (node);
+      devices.Add (netDevice);
+
+      nwk[i] = factory.Create<WsnNwkProtocol> ();
+      node->AggregateObject (nwk[i]);
+      nwk[i]->Assign (netDevice);
+      nwk[i]->Install (node);
+    }
+
+  // 2. 网格索引：格子边长不小于 range，只需要查周围 3x3 个格子
+  double minX = pos[0].x, maxX = pos[0].x, minY = pos[0].y, maxY = pos[0].y;
+  for (const auto &p : pos)
+    {
+      minX = std::min (minX, p.x);
+      maxX = std::max (maxX, p.x);
+      minY = std::min (minY, p.y);
+      maxY = std::max (maxY, p.y);
+    }
+  // 节点很稀疏的时候放大格子，格子数不超过节点数的 4 倍
+  double cell = std::max (range, std::sqrt ((maxX - minX) * (maxY - minY) / (4.0 * n)));
+  cell = std::max (cell, 1e-9);
+  uint32_t cols = (uint32_t)((maxX - minX) / cell) + 1;
+  uint32_t rows = (uint32_t)((maxY - minY) / cell) + 1;
+  std::vector<std::vector<uint32_t> > grid (cols * rows);
+  for (uint32_t i = 1; i < n; ++i)
+    {
+      uint32_t cx = (uint32_t)((pos[i].x - minX) / cell);
+      uint32_t cy = (uint32_t)((pos[i].y - minY) / cell);
+      grid[cy * cols + cx].push_back (i);
+    }
+
+  // 3. 从协调器开始按层扩展
+  std::vector<int32_t> parent (n, -1);
+  std::vector<uint8_t> depth (n, 0);
+  std::vector<bool> joined (n, false);
+  std::vector<bool> router (n, false);
+  std::vector<uint32_t> order;          // 入网顺序，父节点总在孩子前面
+  std::vector<std::pair<double, uint32_t> > candidates;
+  double range2 = range * range;
+  uint16_t maxEdges = maxChildren > maxRouters ? maxChildren - maxRouters : 0;
+
+  joined[0] = true;
+  router[0] = true;
+  order.push_back (0);
+  for (uint32_t k = 0; k < order.size (); ++k)
+    {
+      uint32_t p = order[k];
+      if (!router[p] || depth[p] >= maxDepth)
+        {
+          continue;
+        }
+      candidates.clear ();
+      int32_t cx = (int32_t)((pos[p].x - minX) / cell);
+      int32_t cy = (int32_t)((pos[p].y - minY) / cell);
+      for (int32_t y = std::max (cy - 1, 0); y <= std::min (cy + 1, (int32_t) rows - 1); ++y)
+        {
+          for (int32_t x = std::max (cx - 1, 0); x <= std::min (cx + 1, (int32_t) cols - 1); ++x)
+            {
+              std::vector<uint32_t> &bucket = grid[y * cols + x];
+              // 顺便把已经入网的节点从格子里删掉
+              bucket.erase (std::remove_if (bucket.begin (), bucket.end (),
+                                            [&joined] (uint32_t i) { return (bool) joined[i]; }),
+                            bucket.end ());
+              for (uint32_t i : bucket)
+                {
+                  double dx = pos[i].x - pos[p].x;
+                  double dy = pos[i].y - pos[p].y;
+                  double d2 = dx * dx + dy * dy;
+                  if (d2 <= range2)
+                    {
+                      candidates.push_back (std::make_pair (d2, i));
+                    }
+                }
+            }
+        }
+      std::sort (candidates.begin (), candidates.end ());
+
+      // 最远的候选节点当路由器，往外扩展覆盖；最深一层只能有终端
+      uint32_t routers = depth[p] + 1 < maxDepth ? maxRouters : 0;
+      uint32_t far = candidates.size ();
+      for (uint32_t r = 0; r < routers && far > 0; ++r)
+        {
+          uint32_t i = candidates[--far].second;
+          joined[i] = true;
+          router[i] = true;
+          parent[i] = p;
+          depth[i] = depth[p] + 1;
+          order.push_back (i);
+        }
+      for (uint32_t j = 0; j < far && j < maxEdges; ++j)
+        {
+          uint32_t i = candidates[j].second;
+          joined[i] = true;
+          parent[i] = p;
+          depth[i] = depth[p] + 1;
+          order.push_back (i);
+        }
+    }
+
+  // 4. 按入网顺序分配地址并加入父节点，同时算出每个祖先到该节点的下一跳
+  std::vector<uint16_t> addr (n, 0);
+  std::vector<std::vector<StaticRoute> > routes (n);
+  for (uint32_t i : order)
+    {
+      if (i == 0)
+        {
+          nwk[i]->SetNodeType (NODE_TYPE::COOR);
+          nwk[i]->Join (0, NwkShortAddress ((uint16_t) 0));
+          continue;
+        }
+      nwk[i]->SetNodeType (router[i] ? NODE_TYPE::ROUTE : NODE_TYPE::EDGE);
+      addr[i] = allocator->AllocateNwkAddress (depth[parent[i]], router[i], addr[parent[i]]);
+      nwk[i]->Join (nwk[parent[i]], NwkShortAddress (addr[i]));
+      for (int32_t child = i, a = parent[i]; a != -1; child = a, a = parent[a])
+        {
+          routes[a].push_back (StaticRoute (NwkShortAddress (addr[i]), NwkShortAddress (addr[child])));
+        }
+    }
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (!routes[i].empty ())
+        {
+          nwk[i]->BuildRtable (routes[i]);
+        }
+      else if (!joined[i])
+        {
+          nwk[i]->SetNodeType (NODE_TYPE::EDGE);
+        }
+    }
+  if (order.size () < n)
+    {
+      NS_LOG_WARN (n - order.size () << " of " << n << " nodes found no parent within " << range << " m");
+    }
+  NS_LOG_INFO ("tree built: " << order.size () << " nodes joined");
+  return devices;
+}
 
 Ptr<SpectrumChannel>
 WsnHelper::GetChannel (void)
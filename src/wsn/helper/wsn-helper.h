@@ -32,6 +32,27 @@ public:
 
   NetDeviceContainer Install (NodeContainer c);
 
+  /**
+   * 批量建树：一次性完成设备安装、入网、地址分配、邻居表和路由表，
+   * 不需要逐个调度 JoinRequest，也不需要广播路由更新。
+   *
+   * 第 0 个节点是协调器。节点没有移动模型时，协调器放在区域中心，
+   * 其余节点在 area x area 的区域里均匀随机放置。
+   * 从协调器开始按层扩展，每个父节点在 range 范围内（用网格索引查找）
+   * 最远的候选节点当路由器孩子，最近的候选节点当终端孩子。
+   * 找不到父节点的节点不入网。
+   *
+   * @param c 节点
+   * @param area 区域边长（米）
+   * @param range 父子节点的最大距离（米）
+   * @param maxChildren 每个父节点最多的孩子数
+   * @param maxRouters 每个父节点最多的路由器孩子数
+   * @param maxDepth 树的最大深度
+   * @return 与 c 一一对应的设备，每个节点上聚合了 WsnNwkProtocol
+   */
+  NetDeviceContainer InstallTree (NodeContainer c, double area, double range,
+                                  uint16_t maxChildren, uint16_t maxRouters, uint8_t maxDepth);
+
   void AssociateToPan (NetDeviceContainer c, uint16_t panId);
 
 
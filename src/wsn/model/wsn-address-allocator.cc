@@ -40,16 +40,16 @@ WsnAddressAllocator::AllocateNwkAddress(uint8_t depth, bool node_type, uint16_t
     }
     uint16_t cSkip = CalcCSkip(depth);    
     uint16_t address = 0;
+    // 孩子的序号按父节点分别计数，这样每个孩子都落在父节点的地址块里，
+    // 树路由才能按地址算出下一跳
     if(node_type == 0)
     {
-        if(!m_node.count(depth)) m_node[depth] = 0;
-        NS_LOG_FUNCTION(this << " address is " << Aparent << "+" << cSkip << "*" << m_r << "+" << (m_node[depth]+1));
-        address = Aparent + cSkip * m_r + (++m_node[depth]);
+        NS_LOG_FUNCTION(this << " address is " << Aparent << "+" << cSkip << "*" << m_r << "+" << (m_node[Aparent]+1));
+        address = Aparent + cSkip * m_r + (++m_node[Aparent]);
     }
     else 
     {
-        if(!m_route.count(depth)) m_route[depth] = 0;
-        address = Aparent + 1 + cSkip*(++m_route[depth]-1); 
+        address = Aparent + 1 + cSkip*(++m_route[Aparent]-1); 
     }
     if (address > m_maxAddr) 
     {
@@ -73,7 +73,7 @@ WsnAddressAllocator::AllocateRandMac48Address()
     mac << std::setfill('0') << std::setw(2) << std::hex << ((x->GetInteger ()) % 256);
     if(m_macSet.find(mac.str()) != m_macSet.end()) return AllocateRandMac48Address();
     m_macSet.insert(mac.str());
-    std::cout << mac.str() << " \n";
+    NS_LOG_INFO("allocate mac " << mac.str());
     return mac.str();
 }
 
@@ -98,6 +98,47 @@ WsnAddressAllocator::FormatOutPut(uint64_t value, uint8_t offset) const
     return eui64.FormatOutPut(value,offset);
 }
 
+bool
+WsnAddressAllocator::IsDescendant(uint8_t depth, uint16_t self, uint16_t dest) const
+{
+    if(depth == 0)
+    {
+        // 协调器的子树是整个网络
+        return dest != self;
+    }
+    // 从协调器沿地址块往下找到 self 的父节点；self 在父节点的终端地址段里时它是终端，没有子树
+    uint32_t parent = 0;
+    for(uint8_t k = 0; k < depth; ++k)
+    {
+        uint32_t cSkip = CalcCSkip(k);
+        if(cSkip == 0 || (uint32_t)self <= parent || (uint32_t)self > parent + (uint32_t)m_r * cSkip)
+        {
+            return false;
+        }
+        if(k + 1 < depth)
+        {
+            parent += 1 + (self - parent - 1) / cSkip * cSkip;
+        }
+    }
+    return dest > self && (uint32_t)dest < (uint32_t)self + CalcCSkip(depth - 1);
+}
+
+uint16_t
+WsnAddressAllocator::GetTreeNextHop(uint8_t depth, uint16_t self, uint16_t dest) const
+{
+    if(depth >= m_d || !IsDescendant(depth, self, dest))
+    {
+        return 0;
+    }
+    uint16_t cSkip = CalcCSkip(depth);
+    // 路由器孩子的地址块之后是终端孩子，终端直接发过去
+    if(cSkip == 0 || (uint32_t)dest > (uint32_t)self + (uint32_t)m_r * cSkip)
+    {
+        return dest;
+    }
+    return self + 1 + (dest - self - 1) / cSkip * cSkip;
+}
+
 uint16_t 
 WsnAddressAllocator::GetMaxAddress() const 
 {
@@ -120,6 +161,10 @@ WsnAddressAllocator::Reset()
 uint16_t 
 WsnAddressAllocator::CalcCSkip(uint8_t depth) const 
 {
+    if(depth >= m_d)
+    {
+        return 0;
+    }
     if(m_r == 1) 
     {
         return 1 + m_n * (m_d - depth - 1);
@@ -88,6 +88,19 @@ public:
 
     std::string FormatOutPut(uint64_t value, uint8_t offset) const;
 
+    /**
+     * Cskip 树路由：深度为 depth、地址为 self 的节点发往 dest 的下一跳。
+     * dest 在自己的子树里时返回对应的孩子地址，否则返回 0，表示交给父节点。
+     * 只依赖 SetWsnAddressAllocator 设置的 n/r/d，不需要路由表。
+     */
+    uint16_t GetTreeNextHop(uint8_t depth, uint16_t self, uint16_t dest) const;
+
+    /**
+     * dest 是否在深度为 depth、地址为 self 的节点的子树里；终端节点没有子树，
+     * 要从协调器往下走 depth 层判断 self 是不是终端
+     */
+    bool IsDescendant(uint8_t depth, uint16_t self, uint16_t dest) const;
+
     uint16_t GetMaxAddress() const;
     
     uint16_t GetMinAddress() const;
@@ -105,9 +118,9 @@ private:
     uint16_t m_baseAddr;    // 该节点的地址起始值
     uint16_t m_maxAddr;     // 可分配的最大地址
     
-    std::unordered_map<uint8_t,uint16_t> m_node;
+    std::unordered_map<uint16_t,uint16_t> m_node;   // 每个父节点已分配的终端个数
     
-    std::unordered_map<uint8_t,uint16_t> m_route;
+    std::unordered_map<uint16_t,uint16_t> m_route;  // 每个父节点已分配的路由器个数
 
     std::unordered_set<std::string> m_macSet;
 
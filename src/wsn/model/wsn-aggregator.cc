@@ -0,0 +1,330 @@
+#include "wsn-aggregator.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WsnAggregator");
+
+NS_OBJECT_ENSURE_REGISTERED (WsnAggregator);
+NS_OBJECT_ENSURE_REGISTERED (WsnFedAvgAggregator);
+NS_OBJECT_ENSURE_REGISTERED (WsnOrderStatisticAggregator);
+NS_OBJECT_ENSURE_REGISTERED (WsnMedianAggregator);
+NS_OBJECT_ENSURE_REGISTERED (WsnTrimmedMeanAggregator);
+
+// 转置时每次处理的坐标个数
+static const uint32_t WSN_AGGREGATOR_BLOCK = 64;
+
+TypeId
+WsnAggregator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnAggregator")
+    .SetParent<Object> ()
+    .SetGroupName ("Wsn")
+  ;
+  return tid;
+}
+
+WsnAggregator::WsnAggregator ()
+  : m_n (0),
+    m_size (0),
+    m_totalWeight (0.0)
+{
+}
+
+WsnAggregator::~WsnAggregator ()
+{
+}
+
+void
+WsnAggregator::Add (Ptr<const WsnModel> model)
+{
+  NS_LOG_FUNCTION (this << model->GetSize () << model->GetWeight ());
+  if (m_n == 0)
+    {
+      m_size = model->GetSize ();
+    }
+  else if (model->GetSize () != m_size)
+    {
+      NS_LOG_ERROR ("model size " << model->GetSize () << " does not match " << m_size << ", dropped");
+      return;
+    }
+  DoAdd (model);
+  m_n++;
+  m_totalWeight += model->GetWeight ();
+}
+
+uint32_t
+WsnAggregator::GetN (void) const
+{
+  return m_n;
+}
+
+double
+WsnAggregator::GetTotalWeight (void) const
+{
+  return m_totalWeight;
+}
+
+uint32_t
+WsnAggregator::GetModelSize (void) const
+{
+  return m_size;
+}
+
+Ptr<WsnModel>
+WsnAggregator::Aggregate (void)
+{
+  NS_LOG_FUNCTION (this << m_n);
+  std::vector<double> result;
+  if (m_n != 0)
+    {
+      result.resize (m_size);
+      DoAggregate (result);
+    }
+  Ptr<WsnModel> model = Create<WsnModel> (std::move (result), m_totalWeight);
+  Reset ();
+  return model;
+}
+
+void
+WsnAggregator::Reset (void)
+{
+  DoReset ();
+  m_n = 0;
+  m_size = 0;
+  m_totalWeight = 0.0;
+}
+
+void
+WsnAggregator::DoDispose (void)
+{
+  Reset ();
+  Object::DoDispose ();
+}
+
+//------------------WsnFedAvgAggregator---------------//
+
+TypeId
+WsnFedAvgAggregator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnFedAvgAggregator")
+    .SetParent<WsnAggregator> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnFedAvgAggregator> ()
+    .AddAttribute ("Weighted",
+                   "Weight every model by its sample count instead of averaging uniformly.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&WsnFedAvgAggregator::m_weighted),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+WsnFedAvgAggregator::WsnFedAvgAggregator ()
+  : m_weighted (true),
+    m_weightSum (0.0)
+{
+}
+
+WsnFedAvgAggregator::~WsnFedAvgAggregator ()
+{
+}
+
+void
+WsnFedAvgAggregator::DoAdd (Ptr<const WsnModel> model)
+{
+  uint32_t n = model->GetSize ();
+  if (m_sum.size () != n)
+    {
+      m_sum.assign (n, 0.0);
+      m_comp.assign (n, 0.0);
+    }
+  double w = m_weighted ? model->GetWeight () : 1.0;
+  m_weightSum += w;
+
+  const double *x = model->GetData ();
+  double *s = m_sum.data ();
+  double *c = m_comp.data ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double y = w * x[i] - c[i];
+      double t = s[i] + y;
+      c[i] = (t - s[i]) - y;
+      s[i] = t;
+    }
+}
+
+void
+WsnFedAvgAggregator::DoAggregate (std::vector<double> &result)
+{
+  if (m_weightSum == 0.0)
+    {
+      NS_LOG_ERROR ("total weight is zero");
+      return;
+    }
+  double inv = 1.0 / m_weightSum;
+  const double *s = m_sum.data ();
+  double *r = result.data ();
+  uint32_t n = result.size ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      r[i] = s[i] * inv;
+    }
+}
+
+void
+WsnFedAvgAggregator::DoReset (void)
+{
+  // 缓冲区保留下来给下一轮用
+  std::fill (m_sum.begin (), m_sum.end (), 0.0);
+  std::fill (m_comp.begin (), m_comp.end (), 0.0);
+  m_weightSum = 0.0;
+}
+
+//------------------WsnOrderStatisticAggregator---------------//
+
+TypeId
+WsnOrderStatisticAggregator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnOrderStatisticAggregator")
+    .SetParent<WsnAggregator> ()
+    .SetGroupName ("Wsn")
+  ;
+  return tid;
+}
+
+WsnOrderStatisticAggregator::WsnOrderStatisticAggregator ()
+{
+}
+
+WsnOrderStatisticAggregator::~WsnOrderStatisticAggregator ()
+{
+}
+
+void
+WsnOrderStatisticAggregator::DoAdd (Ptr<const WsnModel> model)
+{
+  m_models.push_back (model);
+}
+
+void
+WsnOrderStatisticAggregator::DoAggregate (std::vector<double> &result)
+{
+  uint32_t k = m_models.size ();
+  uint32_t n = result.size ();
+  m_block.resize (k * WSN_AGGREGATOR_BLOCK);
+
+  for (uint32_t start = 0; start < n; start += WSN_AGGREGATOR_BLOCK)
+    {
+      uint32_t len = std::min (WSN_AGGREGATOR_BLOCK, n - start);
+      // 转置：第 i 个坐标的 k 个取值连续存放
+      for (uint32_t j = 0; j < k; ++j)
+        {
+          const double *x = m_models[j]->GetData () + start;
+          for (uint32_t i = 0; i < len; ++i)
+            {
+              m_block[i * k + j] = x[i];
+            }
+        }
+      for (uint32_t i = 0; i < len; ++i)
+        {
+          result[start + i] = ReduceColumn (&m_block[i * k], k);
+        }
+    }
+}
+
+void
+WsnOrderStatisticAggregator::DoReset (void)
+{
+  m_models.clear ();
+}
+
+//------------------WsnMedianAggregator---------------//
+
+TypeId
+WsnMedianAggregator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnMedianAggregator")
+    .SetParent<WsnOrderStatisticAggregator> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnMedianAggregator> ()
+  ;
+  return tid;
+}
+
+WsnMedianAggregator::WsnMedianAggregator ()
+{
+}
+
+WsnMedianAggregator::~WsnMedianAggregator ()
+{
+}
+
+double
+WsnMedianAggregator::ReduceColumn (double *column, uint32_t n) const
+{
+  uint32_t mid = n / 2;
+  std::nth_element (column, column + mid, column + n);
+  double upper = column[mid];
+  if (n % 2)
+    {
+      return upper;
+    }
+  double lower = *std::max_element (column, column + mid);
+  return lower + (upper - lower) / 2;
+}
+
+//------------------WsnTrimmedMeanAggregator---------------//
+
+TypeId
+WsnTrimmedMeanAggregator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnTrimmedMeanAggregator")
+    .SetParent<WsnOrderStatisticAggregator> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnTrimmedMeanAggregator> ()
+    .AddAttribute ("TrimFraction",
+                   "Fraction of the values dropped at each end of every coordinate.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&WsnTrimmedMeanAggregator::m_trim),
+                   MakeDoubleChecker<double> (0.0, 0.5))
+  ;
+  return tid;
+}
+
+WsnTrimmedMeanAggregator::WsnTrimmedMeanAggregator ()
+  : m_trim (0.1)
+{
+}
+
+WsnTrimmedMeanAggregator::~WsnTrimmedMeanAggregator ()
+{
+}
+
+double
+WsnTrimmedMeanAggregator::ReduceColumn (double *column, uint32_t n) const
+{
+  uint32_t cut = static_cast<uint32_t> (m_trim * n);
+  if (2 * cut >= n)
+    {
+      cut = (n - 1) / 2;
+    }
+  std::sort (column, column + n);
+
+  double sum = 0.0;
+  double comp = 0.0;
+  for (uint32_t i = cut; i < n - cut; ++i)
+    {
+      double y = column[i] - comp;
+      double t = sum + y;
+      comp = (t - sum) - y;
+      sum = t;
+    }
+  return sum / (n - 2 * cut);
+}
+
+}
@@ -0,0 +1,173 @@
+#ifndef WSN_AGGREGATOR_H
+#define WSN_AGGREGATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "wsn-fedlearning-model.h"
+
+namespace ns3
+{
+
+/**
+ * 联邦学习的模型聚合器基类。
+ *
+ * 每收到一个模型调用一次 Add，凑够数量以后调用 Aggregate
+ * 得到新的全局模型，Aggregate 之后聚合器自动清空。
+ * 所有参与聚合的模型长度必须一致。
+ */
+class WsnAggregator : public Object
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnAggregator ();
+
+    virtual ~WsnAggregator ();
+
+    /**
+     * 加入一个模型，权重取 WsnModel::GetWeight
+     */
+    void Add (Ptr<const WsnModel> model);
+
+    /**
+     * 已经加入的模型个数
+     */
+    uint32_t GetN (void) const;
+
+    /**
+     * 已经加入的模型的权重之和
+     */
+    double GetTotalWeight (void) const;
+
+    /**
+     * 计算聚合结果，权重为所有输入模型的权重之和
+     */
+    Ptr<WsnModel> Aggregate (void);
+
+    void Reset (void);
+
+protected:
+    virtual void DoDispose (void);
+
+    /**
+     * 参数个数，第一个模型加入时确定
+     */
+    uint32_t GetModelSize (void) const;
+
+private:
+    virtual void DoAdd (Ptr<const WsnModel> model) = 0;
+
+    virtual void DoAggregate (std::vector<double> &result) = 0;
+
+    virtual void DoReset (void) = 0;
+
+    uint32_t m_n;               // 已加入的模型个数
+    uint32_t m_size;            // 模型参数个数
+    double m_totalWeight;       // 权重之和
+};
+
+
+/**
+ * FedAvg：按坐标求（加权）平均。
+ *
+ * 只保存一个连续的累加缓冲区，用 Kahan 补偿求和，
+ * 内层循环逐元素独立，编译器可以直接向量化。
+ */
+class WsnFedAvgAggregator : public WsnAggregator
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnFedAvgAggregator ();
+
+    virtual ~WsnFedAvgAggregator ();
+
+private:
+    virtual void DoAdd (Ptr<const WsnModel> model);
+
+    virtual void DoAggregate (std::vector<double> &result);
+
+    virtual void DoReset (void);
+
+    bool m_weighted;                // 是否按样本数加权
+    double m_weightSum;             // 实际使用的权重之和
+    std::vector<double> m_sum;      // 累加和
+    std::vector<double> m_comp;     // Kahan 补偿项
+};
+
+
+/**
+ * 按坐标的顺序统计量聚合器基类（中位数、截尾均值）。
+ *
+ * 输入模型只保存引用，聚合时按块把每个坐标的 k 个取值
+ * 转置到连续的缓冲区里，再交给 ReduceColumn 计算。
+ */
+class WsnOrderStatisticAggregator : public WsnAggregator
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnOrderStatisticAggregator ();
+
+    virtual ~WsnOrderStatisticAggregator ();
+
+private:
+    virtual void DoAdd (Ptr<const WsnModel> model);
+
+    virtual void DoAggregate (std::vector<double> &result);
+
+    virtual void DoReset (void);
+
+    /**
+     * @param column 某个坐标上所有模型的取值，可以被重排
+     * @param n 取值个数
+     * @return 这个坐标的聚合结果
+     */
+    virtual double ReduceColumn (double *column, uint32_t n) const = 0;
+
+    std::vector<Ptr<const WsnModel> > m_models;
+    std::vector<double> m_block;    // 转置缓冲区
+};
+
+
+/**
+ * 按坐标取中位数
+ */
+class WsnMedianAggregator : public WsnOrderStatisticAggregator
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnMedianAggregator ();
+
+    virtual ~WsnMedianAggregator ();
+
+private:
+    virtual double ReduceColumn (double *column, uint32_t n) const;
+};
+
+
+/**
+ * 按坐标的截尾均值，两端各去掉 TrimFraction 比例的取值
+ */
+class WsnTrimmedMeanAggregator : public WsnOrderStatisticAggregator
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnTrimmedMeanAggregator ();
+
+    virtual ~WsnTrimmedMeanAggregator ();
+
+private:
+    virtual double ReduceColumn (double *column, uint32_t n) const;
+
+    double m_trim;
+};
+
+}
+
+#endif
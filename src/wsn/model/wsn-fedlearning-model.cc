@@ -0,0 +1,139 @@
+#include "wsn-fedlearning-model.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WsnModelStore");
+
+WsnModel::WsnModel (void)
+  : m_weight (1.0)
+{
+}
+
+WsnModel::WsnModel (std::vector<double> params)
+  : m_params (std::move (params)),
+    m_weight (1.0)
+{
+}
+
+WsnModel::WsnModel (std::vector<double> params, double weight)
+  : m_params (std::move (params)),
+    m_weight (weight)
+{
+}
+
+uint32_t
+WsnModel::GetSize (void) const
+{
+  return m_params.size ();
+}
+
+double
+WsnModel::GetWeight (void) const
+{
+  return m_weight;
+}
+
+uint32_t
+WsnModel::GetSerializedSize (void) const
+{
+  return m_params.size () * sizeof (double) + sizeof (double) + 4;
+}
+
+const double *
+WsnModel::GetData (void) const
+{
+  return m_params.data ();
+}
+
+const std::vector<double> &
+WsnModel::Get (void) const
+{
+  return m_params;
+}
+
+//------------------WsnModelStore---------------//
+
+/**
+ * 句柄表最多缓存的模型个数
+ */
+static GlobalValue g_modelCacheSize ("WsnModelCacheSize",
+                                     "The number of the most recently sent models "
+                                     "that receivers find by handle instead of "
+                                     "decoding the frames.",
+                                     UintegerValue (256),
+                                     MakeUintegerChecker<uint32_t> ());
+
+WsnModelStore::WsnModelStore ()
+  : m_nextHandle (1),
+    m_destroyHooked (false)
+{
+}
+
+WsnModelStore::~WsnModelStore ()
+{
+  m_models.clear ();
+}
+
+uint32_t
+WsnModelStore::Add (Ptr<const WsnModel> model)
+{
+  uint32_t handle = m_nextHandle++;
+  if (m_nextHandle == 0)
+    {
+      m_nextHandle = 1;
+    }
+  NS_LOG_FUNCTION (this << handle << model->GetSize ());
+
+  UintegerValue capacity;
+  g_modelCacheSize.GetValue (capacity);
+  while (!m_order.empty () && m_order.size () >= capacity.Get ())
+    {
+      m_models.erase (m_order.front ());
+      m_order.pop_front ();
+    }
+  if (capacity.Get () > 0)
+    {
+      m_models[handle] = model;
+      m_order.push_back (handle);
+    }
+
+  // 仿真结束时全部清掉
+  if (!m_destroyHooked)
+    {
+      Simulator::ScheduleDestroy (&WsnModelStore::Clear, this);
+      m_destroyHooked = true;
+    }
+  return handle;
+}
+
+Ptr<const WsnModel>
+WsnModelStore::Find (uint32_t handle) const
+{
+  std::unordered_map<uint32_t, Ptr<const WsnModel> >::const_iterator it = m_models.find (handle);
+  if (it == m_models.end ())
+    {
+      NS_LOG_LOGIC ("model handle " << handle << " evicted or unknown");
+      return 0;
+    }
+  return it->second;
+}
+
+uint32_t
+WsnModelStore::GetN (void) const
+{
+  return m_models.size ();
+}
+
+void
+WsnModelStore::Clear (void)
+{
+  m_models.clear ();
+  m_order.clear ();
+  m_destroyHooked = false;
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef WSN_FEDLEARNING_MODEL_H
+#define WSN_FEDLEARNING_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/singleton.h"
+#include "ns3/ptr.h"
+
+namespace ns3
+{
+
+/**
+ * 只读的模型参数块，由引用计数共享。
+ *
+ * 一次广播/转发过程中所有的包都持有同一个 WsnModel，
+ * 参数本身只在创建的时候拷贝（或移动）一次。
+ */
+class WsnModel : public SimpleRefCount<WsnModel>
+{
+public:
+    WsnModel (void);
+
+    WsnModel (std::vector<double> params);
+
+    /**
+     * @param params 模型参数
+     * @param weight 聚合权重（一般是本地训练的样本数）
+     */
+    WsnModel (std::vector<double> params, double weight);
+
+    /**
+     * 参数个数
+     */
+    uint32_t GetSize (void) const;
+
+    double GetWeight (void) const;
+
+    /**
+     * 模型在空口上占用的字节数（4字节长度 + 8字节权重 + 每个参数8字节）
+     */
+    uint32_t GetSerializedSize (void) const;
+
+    const double * GetData (void) const;
+
+    const std::vector<double> & Get (void) const;
+
+private:
+    const std::vector<double> m_params;
+    const double m_weight;
+};
+
+
+/**
+ * 模型句柄表：WsnFedTag 把句柄写进 TagBuffer，
+ * 接收端通过句柄找回发送端的同一个 WsnModel，不用再解码。
+ *
+ * 表只是一个有界的缓存，按登记的先后保留最近的 WsnModelCacheSize 个模型。
+ * 模型的字节本身在包里，句柄找不到时接收端从包里的字节解码出模型。
+ */
+class WsnModelStore : public Singleton<WsnModelStore>
+{
+public:
+    ~WsnModelStore ();
+
+    /**
+     * 登记一个模型，返回句柄（0 是无效句柄），表满时淘汰最早登记的模型
+     */
+    uint32_t Add (Ptr<const WsnModel> model);
+
+    /**
+     * 按句柄查找模型，找不到（未知或已经被淘汰）返回 0
+     */
+    Ptr<const WsnModel> Find (uint32_t handle) const;
+
+    uint32_t GetN (void) const;
+
+    void Clear (void);
+
+private:
+
+    friend class Singleton<WsnModelStore>;
+
+    WsnModelStore ();
+
+    uint32_t m_nextHandle;     // 下一个分配的句柄
+
+    bool m_destroyHooked;      // 是否已经挂上 Simulator::Destroy
+
+    std::unordered_map<uint32_t, Ptr<const WsnModel> > m_models;
+
+    std::deque<uint32_t> m_order;   // 按登记先后排列的句柄
+};
+
+}
+
+#endif
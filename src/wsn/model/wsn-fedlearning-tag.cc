@@ -25,57 +25,103 @@ WsnFedTag::GetInstanceTypeId (void) const
 WsnFedTag::WsnFedTag (void)
 {
     size = 0;
+    m_handle = 0;
+    m_fragment = 0;
+    m_fragments = 1;
 }
 
 WsnFedTag::WsnFedTag (std::vector<double> mode)
-  : m_model (mode)
+  : m_handle (0),
+    m_fragment (0),
+    m_fragments (1)
 {
-    size = m_model.size();
+    Set (Create<WsnModel> (std::move (mode)));
+}
+
+WsnFedTag::WsnFedTag (Ptr<const WsnModel> mode)
+  : m_handle (0),
+    m_fragment (0),
+    m_fragments (1)
+{
+    Set (mode);
 }
 
 uint32_t
 WsnFedTag::GetSerializedSize (void) const
 {
-  return size*sizeof (double)+4;
+  // 只有句柄、参数个数和分片信息
+  return 12;
 }
 
 void
 WsnFedTag::Serialize (TagBuffer i) const
 {
+  i.WriteU32(m_handle);
   i.WriteU32(size);
-  for(uint32_t it = 0; it < size; ++ it)
-  {
-    i.WriteDouble(m_model[it]);
-  }
+  i.WriteU16(m_fragment);
+  i.WriteU16(m_fragments);
 }
 
 void
 WsnFedTag::Deserialize (TagBuffer i)
 {
+  m_handle = i.ReadU32();
   size = i.ReadU32();
-  for(uint32_t j = 0; j < size; ++ j)
-  {
-    double x = i.ReadDouble ();
-    m_model.push_back(x);
-  }
+  m_fragment = i.ReadU16();
+  m_fragments = i.ReadU16();
+  m_model = WsnModelStore::Get ()->Find (m_handle);
 }
 
 void
 WsnFedTag::Print (std::ostream &os) const
 {
-  
+  os << "handle=" << m_handle << " size=" << size
+     << " fragment=" << m_fragment << "/" << m_fragments;
 }
 
 void
-WsnFedTag::Set (std::vector<double> mode)
+WsnFedTag::Set (Ptr<const WsnModel> mode)
 {
   m_model = mode;
+  size = m_model->GetSize ();
+  m_handle = WsnModelStore::Get ()->Add (m_model);
 }
 
-std::vector<double>
+Ptr<const WsnModel>
 WsnFedTag::Get (void) const
 {
   return m_model;
 }
 
+uint32_t
+WsnFedTag::GetModelSize (void) const
+{
+  return size*sizeof (double)+sizeof (double)+4;
+}
+
+uint32_t
+WsnFedTag::GetHandle (void) const
+{
+  return m_handle;
+}
+
+void
+WsnFedTag::SetFragment (uint16_t index, uint16_t count)
+{
+  m_fragment = index;
+  m_fragments = count;
+}
+
+uint16_t
+WsnFedTag::GetFragmentIndex (void) const
+{
+  return m_fragment;
+}
+
+uint16_t
+WsnFedTag::GetFragmentCount (void) const
+{
+  return m_fragments;
+}
+
 }
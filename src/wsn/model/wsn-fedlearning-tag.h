@@ -4,11 +4,19 @@
 #include <stdint.h>
 #include <vector>
 #include "ns3/node.h"
+#include "wsn-fedlearning-model.h"
 
 namespace ns3
 {
 
-
+/**
+ * 携带模型的包标签。
+ *
+ * 模型编码后的字节放在包里，标签里只序列化模型句柄、参数个数和分片信息。
+ * 标签对象持有模型的引用；接收端用句柄在 WsnModelStore 里找回发送端的
+ * 同一个模型，转发和扇出时不会拷贝参数。句柄已经被淘汰时 Get 返回 0，
+ * 由接收端从包里的字节解码。模型在空口上的大小由 GetModelSize 给出。
+ */
  class WsnFedTag : public Tag
   {
   public:
@@ -21,21 +29,42 @@ namespace ns3
     WsnFedTag (void);
     
     WsnFedTag (std::vector<double> model);
-    
+
+    WsnFedTag (Ptr<const WsnModel> model);
+
     virtual uint32_t GetSerializedSize (void) const;
     virtual void Serialize (TagBuffer i) const;
     virtual void Deserialize (TagBuffer i);
     virtual void Print (std::ostream &os) const;
     
-    void Set (std::vector<double> model);
+    void Set (Ptr<const WsnModel> model);
     
-    std::vector<double> Get (void) const;
+    Ptr<const WsnModel> Get (void) const;
+
+    /**
+     * 模型序列化后的字节数，用来计算空口占用
+     */
+    uint32_t GetModelSize (void) const;
+
+    uint32_t GetHandle (void) const;
+
+    /**
+     * 模型被切成多个 MAC 帧发送时，本帧的序号和总帧数
+     */
+    void SetFragment (uint16_t index, uint16_t count);
+
+    uint16_t GetFragmentIndex (void) const;
+
+    uint16_t GetFragmentCount (void) const;
   private:
     uint32_t size;
-    std::vector<double> m_model;
+    uint32_t m_handle;
+    uint16_t m_fragment;
+    uint16_t m_fragments;
+    Ptr<const WsnModel> m_model;
   };
 
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,398 @@
+#include "wsn-model-codec.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WsnModelCodec");
+
+NS_OBJECT_ENSURE_REGISTERED (WsnModelCodec);
+NS_OBJECT_ENSURE_REGISTERED (WsnRawCodec);
+NS_OBJECT_ENSURE_REGISTERED (WsnQuantizationCodec);
+NS_OBJECT_ENSURE_REGISTERED (WsnTopKCodec);
+NS_OBJECT_ENSURE_REGISTERED (WsnDeltaCodec);
+
+TypeId
+WsnModelCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnModelCodec")
+    .SetParent<Object> ()
+    .SetGroupName ("Wsn")
+  ;
+  return tid;
+}
+
+WsnModelCodec::WsnModelCodec ()
+{
+}
+
+WsnModelCodec::~WsnModelCodec ()
+{
+}
+
+void
+WsnModelCodec::Encode (Ptr<const WsnModel> model, std::vector<uint8_t> &buffer)
+{
+  NS_LOG_FUNCTION (this << model->GetSize ());
+  buffer.clear ();
+  WriteU32 (buffer, model->GetSize ());
+  WriteDouble (buffer, model->GetWeight ());
+  DoEncode (model->Get (), buffer);
+}
+
+Ptr<WsnModel>
+WsnModelCodec::Decode (const std::vector<uint8_t> &buffer)
+{
+  const uint8_t *p = buffer.data ();
+  uint32_t n = ReadU32 (p);
+  double weight = ReadDouble (p);
+  std::vector<double> params (n);
+  DoDecode (p, params);
+  return Create<WsnModel> (std::move (params), weight);
+}
+
+void
+WsnModelCodec::SetReference (Ptr<const WsnModel> global)
+{
+}
+
+void
+WsnModelCodec::WriteU32 (std::vector<uint8_t> &buffer, uint32_t v)
+{
+  uint8_t bytes[sizeof (v)];
+  std::memcpy (bytes, &v, sizeof (v));
+  buffer.insert (buffer.end (), bytes, bytes + sizeof (v));
+}
+
+void
+WsnModelCodec::WriteDouble (std::vector<uint8_t> &buffer, double v)
+{
+  uint8_t bytes[sizeof (v)];
+  std::memcpy (bytes, &v, sizeof (v));
+  buffer.insert (buffer.end (), bytes, bytes + sizeof (v));
+}
+
+uint32_t
+WsnModelCodec::ReadU32 (const uint8_t *&p)
+{
+  uint32_t v;
+  std::memcpy (&v, p, sizeof (v));
+  p += sizeof (v);
+  return v;
+}
+
+double
+WsnModelCodec::ReadDouble (const uint8_t *&p)
+{
+  double v;
+  std::memcpy (&v, p, sizeof (v));
+  p += sizeof (v);
+  return v;
+}
+
+//------------------WsnRawCodec---------------//
+
+TypeId
+WsnRawCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnRawCodec")
+    .SetParent<WsnModelCodec> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnRawCodec> ()
+  ;
+  return tid;
+}
+
+WsnRawCodec::WsnRawCodec ()
+{
+}
+
+WsnRawCodec::~WsnRawCodec ()
+{
+}
+
+void
+WsnRawCodec::DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer)
+{
+  size_t offset = buffer.size ();
+  buffer.resize (offset + params.size () * sizeof (double));
+  std::memcpy (buffer.data () + offset, params.data (), params.size () * sizeof (double));
+}
+
+void
+WsnRawCodec::DoDecode (const uint8_t *p, std::vector<double> &params)
+{
+  std::memcpy (params.data (), p, params.size () * sizeof (double));
+}
+
+//------------------WsnQuantizationCodec---------------//
+
+TypeId
+WsnQuantizationCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnQuantizationCodec")
+    .SetParent<WsnModelCodec> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnQuantizationCodec> ()
+    .AddAttribute ("Bits",
+                   "Bits per quantized parameter, 8 or 16.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&WsnQuantizationCodec::m_bits),
+                   MakeUintegerChecker<uint8_t> (8, 16))
+  ;
+  return tid;
+}
+
+WsnQuantizationCodec::WsnQuantizationCodec ()
+  : m_bits (8)
+{
+}
+
+WsnQuantizationCodec::~WsnQuantizationCodec ()
+{
+}
+
+void
+WsnQuantizationCodec::DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer)
+{
+  uint32_t n = params.size ();
+  double lo = 0.0;
+  double hi = 0.0;
+  if (n)
+    {
+      std::pair<std::vector<double>::const_iterator, std::vector<double>::const_iterator> range =
+        std::minmax_element (params.begin (), params.end ());
+      lo = *range.first;
+      hi = *range.second;
+    }
+  bool wide = m_bits > 8;
+  double levels = wide ? 65535.0 : 255.0;
+  double scale = (hi - lo) / levels;
+  double inv = scale > 0 ? 1.0 / scale : 0.0;
+
+  WriteDouble (buffer, lo);
+  WriteDouble (buffer, scale);
+  size_t offset = buffer.size ();
+  buffer.resize (offset + n * (wide ? 2 : 1));
+  uint8_t *out = buffer.data () + offset;
+  const double *x = params.data ();
+  if (wide)
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint16_t q = static_cast<uint16_t> ((x[i] - lo) * inv + 0.5);
+          std::memcpy (out + 2 * i, &q, 2);
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          out[i] = static_cast<uint8_t> ((x[i] - lo) * inv + 0.5);
+        }
+    }
+}
+
+void
+WsnQuantizationCodec::DoDecode (const uint8_t *p, std::vector<double> &params)
+{
+  double lo = ReadDouble (p);
+  double scale = ReadDouble (p);
+  uint32_t n = params.size ();
+  double *x = params.data ();
+  if (m_bits > 8)
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint16_t q;
+          std::memcpy (&q, p + 2 * i, 2);
+          x[i] = lo + q * scale;
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          x[i] = lo + p[i] * scale;
+        }
+    }
+}
+
+//------------------WsnTopKCodec---------------//
+
+TypeId
+WsnTopKCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnTopKCodec")
+    .SetParent<WsnModelCodec> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnTopKCodec> ()
+    .AddAttribute ("Ratio",
+                   "Fraction of the parameters kept in every encoded model.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&WsnTopKCodec::m_ratio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("ErrorFeedback",
+                   "Carry the dropped part of every model over to the next encoding.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&WsnTopKCodec::m_errorFeedback),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+WsnTopKCodec::WsnTopKCodec ()
+  : m_ratio (0.01),
+    m_errorFeedback (true)
+{
+}
+
+WsnTopKCodec::~WsnTopKCodec ()
+{
+}
+
+void
+WsnTopKCodec::DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer)
+{
+  uint32_t n = params.size ();
+  if (!m_errorFeedback || m_residual.size () != n)
+    {
+      m_residual.assign (n, 0.0);
+    }
+  // 残差里先放 v = x + r，编码完以后减去发出去的部分
+  double *v = m_residual.data ();
+  const double *x = params.data ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      v[i] += x[i];
+    }
+
+  uint32_t k = std::min<uint32_t> (n, static_cast<uint32_t> (std::ceil (m_ratio * n)));
+  m_index.resize (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      m_index[i] = i;
+    }
+  std::nth_element (m_index.begin (), m_index.begin () + k, m_index.end (),
+                    [v] (uint32_t a, uint32_t b) { return std::fabs (v[a]) > std::fabs (v[b]); });
+  std::sort (m_index.begin (), m_index.begin () + k);
+
+  WriteU32 (buffer, k);
+  size_t offset = buffer.size ();
+  buffer.resize (offset + k * 8);
+  uint8_t *out = buffer.data () + offset;
+  for (uint32_t j = 0; j < k; ++j)
+    {
+      uint32_t i = m_index[j];
+      float value = static_cast<float> (v[i]);
+      std::memcpy (out + 8 * j, &i, 4);
+      std::memcpy (out + 8 * j + 4, &value, 4);
+      v[i] -= value;
+    }
+}
+
+void
+WsnTopKCodec::DoDecode (const uint8_t *p, std::vector<double> &params)
+{
+  uint32_t k = ReadU32 (p);
+  std::fill (params.begin (), params.end (), 0.0);
+  for (uint32_t j = 0; j < k; ++j)
+    {
+      uint32_t i;
+      float value;
+      std::memcpy (&i, p + 8 * j, 4);
+      std::memcpy (&value, p + 8 * j + 4, 4);
+      params[i] = value;
+    }
+}
+
+//------------------WsnDeltaCodec---------------//
+
+TypeId
+WsnDeltaCodec::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnDeltaCodec")
+    .SetParent<WsnModelCodec> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnDeltaCodec> ()
+    .AddAttribute ("InnerCodec",
+                   "TypeId of the codec applied to the difference to the last global model.",
+                   StringValue ("ns3::WsnQuantizationCodec"),
+                   MakeStringAccessor (&WsnDeltaCodec::m_innerType),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+WsnDeltaCodec::WsnDeltaCodec ()
+{
+}
+
+WsnDeltaCodec::~WsnDeltaCodec ()
+{
+}
+
+void
+WsnDeltaCodec::DoDispose (void)
+{
+  m_inner = 0;
+  m_reference = 0;
+  WsnModelCodec::DoDispose ();
+}
+
+void
+WsnDeltaCodec::SetReference (Ptr<const WsnModel> global)
+{
+  m_reference = global;
+}
+
+Ptr<WsnModelCodec>
+WsnDeltaCodec::GetInner (void)
+{
+  if (m_inner == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_innerType);
+      m_inner = factory.Create<WsnModelCodec> ();
+    }
+  return m_inner;
+}
+
+void
+WsnDeltaCodec::DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer)
+{
+  std::vector<double> delta (params);
+  if (m_reference != 0 && m_reference->GetSize () == delta.size ())
+    {
+      const double *g = m_reference->GetData ();
+      for (uint32_t i = 0; i < delta.size (); ++i)
+        {
+          delta[i] -= g[i];
+        }
+    }
+  GetInner ()->DoEncode (delta, buffer);
+}
+
+void
+WsnDeltaCodec::DoDecode (const uint8_t *p, std::vector<double> &params)
+{
+  GetInner ()->DoDecode (p, params);
+  if (m_reference != 0 && m_reference->GetSize () == params.size ())
+    {
+      const double *g = m_reference->GetData ();
+      for (uint32_t i = 0; i < params.size (); ++i)
+        {
+          params[i] += g[i];
+        }
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+#ifndef WSN_MODEL_CODEC_H
+#define WSN_MODEL_CODEC_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "wsn-fedlearning-model.h"
+
+namespace ns3
+{
+
+/**
+ * 模型压缩编解码器基类。
+ *
+ * Encode 把模型编成真实的字节流，WsnNwkProtocol 按字节流的长度
+ * 切成 MAC 帧发送，所以空口时间和能耗对应压缩后的大小。
+ * 字节流开头是 4 字节参数个数和 8 字节权重，后面由子类决定。
+ *
+ * 编解码器带状态（误差反馈、参考模型），每个节点各用一个实例。
+ */
+class WsnModelCodec : public Object
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnModelCodec ();
+
+    virtual ~WsnModelCodec ();
+
+    void Encode (Ptr<const WsnModel> model, std::vector<uint8_t> &buffer);
+
+    Ptr<WsnModel> Decode (const std::vector<uint8_t> &buffer);
+
+    /**
+     * 设置最近一次的全局模型，差分编码以它为参考
+     */
+    virtual void SetReference (Ptr<const WsnModel> global);
+
+protected:
+    static void WriteU32 (std::vector<uint8_t> &buffer, uint32_t v);
+    static void WriteDouble (std::vector<uint8_t> &buffer, double v);
+    static uint32_t ReadU32 (const uint8_t *&p);
+    static double ReadDouble (const uint8_t *&p);
+
+private:
+    friend class WsnDeltaCodec;
+
+    /**
+     * 编码参数部分，追加到 buffer 末尾
+     */
+    virtual void DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer) = 0;
+
+    /**
+     * 从 p 开始解码 params.size () 个参数
+     */
+    virtual void DoDecode (const uint8_t *p, std::vector<double> &params) = 0;
+};
+
+
+/**
+ * 不压缩，按 float64 原样编码，只用来按真实大小分片
+ */
+class WsnRawCodec : public WsnModelCodec
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnRawCodec ();
+
+    virtual ~WsnRawCodec ();
+
+private:
+    virtual void DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer);
+
+    virtual void DoDecode (const uint8_t *p, std::vector<double> &params);
+};
+
+
+/**
+ * 线性量化：每个参数按 [min, max] 量化成 8 位或 16 位整数
+ */
+class WsnQuantizationCodec : public WsnModelCodec
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnQuantizationCodec ();
+
+    virtual ~WsnQuantizationCodec ();
+
+private:
+    virtual void DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer);
+
+    virtual void DoDecode (const uint8_t *p, std::vector<double> &params);
+
+    uint8_t m_bits;
+};
+
+
+/**
+ * Top-k 稀疏化：只发送绝对值最大的 k 个参数（下标 + float32），
+ * 没有发出去的部分累积到残差里，下一次编码时补上（误差反馈）
+ */
+class WsnTopKCodec : public WsnModelCodec
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnTopKCodec ();
+
+    virtual ~WsnTopKCodec ();
+
+private:
+    virtual void DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer);
+
+    virtual void DoDecode (const uint8_t *p, std::vector<double> &params);
+
+    double m_ratio;                 // 保留的参数比例
+    bool m_errorFeedback;
+    std::vector<double> m_residual; // 误差反馈的残差
+    std::vector<uint32_t> m_index;
+};
+
+
+/**
+ * 差分编码：对 (模型 - 上一次的全局模型) 用内层编解码器编码，
+ * 解码后再加回参考模型
+ */
+class WsnDeltaCodec : public WsnModelCodec
+{
+public:
+    static TypeId GetTypeId (void);
+
+    WsnDeltaCodec ();
+
+    virtual ~WsnDeltaCodec ();
+
+    virtual void SetReference (Ptr<const WsnModel> global);
+
+protected:
+    virtual void DoDispose (void);
+
+private:
+    virtual void DoEncode (const std::vector<double> &params, std::vector<uint8_t> &buffer);
+
+    virtual void DoDecode (const uint8_t *p, std::vector<double> &params);
+
+    Ptr<WsnModelCodec> GetInner (void);
+
+    std::string m_innerType;        // 内层编解码器的 TypeId
+    Ptr<WsnModelCodec> m_inner;
+    Ptr<const WsnModel> m_reference;
+};
+
+}
+
+#endif
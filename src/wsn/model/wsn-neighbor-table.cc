@@ -1,183 +1,385 @@
+
 #include "wsn-neighbor-table.h"
+#include <cstring>
 
 namespace ns3 {
 
+static uint32_t
+RelationIndex(Relationship relationship) {
+  uint32_t i = static_cast<uint32_t>(relationship);
+  return i < 4 ? i : static_cast<uint32_t>(Relationship::NO_RELATIONSHIP);
+}
+
+//------------------SlotIndex---------------//
+
+const uint32_t NeighborTable::SlotIndex::NONE;
+
+NeighborTable::SlotIndex::SlotIndex()
+  : m_size(0), m_mask(0) {
+}
+
+uint32_t
+NeighborTable::SlotIndex::Bucket(uint64_t key) const {
+  // fold the high half in first: MAC addresses of one vendor differ only
+  // in the last bytes, which end up in the high half of the key
+  key ^= key >> 32;
+  // Fibonacci hashing, the table size is a power of two
+  return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+}
+
+uint32_t
+NeighborTable::SlotIndex::Find(uint64_t key) const {
+  if (m_slots.empty()) {
+    return NONE;
+  }
+  for (uint32_t b = Bucket(key); m_slots[b] != NONE; b = (b + 1) & m_mask) {
+    if (m_keys[b] == key) {
+      return m_slots[b];
+    }
+  }
+  return NONE;
+}
+
+void
+NeighborTable::SlotIndex::Insert(uint64_t key, uint32_t slot) {
+  // keep the load factor at or below 1/2
+  if (2 * (m_size + 1) > m_slots.size()) {
+    Rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+  }
+  uint32_t b = Bucket(key);
+  for (; m_slots[b] != NONE; b = (b + 1) & m_mask) {
+    if (m_keys[b] == key) {
+      m_slots[b] = slot;
+      return;
+    }
+  }
+  m_keys[b] = key;
+  m_slots[b] = slot;
+  m_size++;
+}
+
+void
+NeighborTable::SlotIndex::Erase(uint64_t key) {
+  if (m_slots.empty()) {
+    return;
+  }
+  uint32_t b = Bucket(key);
+  for (; m_slots[b] != NONE; b = (b + 1) & m_mask) {
+    if (m_keys[b] == key) {
+      break;
+    }
+  }
+  if (m_slots[b] == NONE) {
+    return;
+  }
+  // backward-shift deletion: no tombstones needed with linear probing
+  uint32_t hole = b;
+  for (uint32_t next = (hole + 1) & m_mask; m_slots[next] != NONE; next = (next + 1) & m_mask) {
+    uint32_t home = Bucket(m_keys[next]);
+    if (((next - home) & m_mask) >= ((next - hole) & m_mask)) {
+      m_keys[hole] = m_keys[next];
+      m_slots[hole] = m_slots[next];
+      hole = next;
+    }
+  }
+  m_slots[hole] = NONE;
+  m_size--;
+}
+
+void
+NeighborTable::SlotIndex::Reserve(uint32_t n) {
+  uint32_t capacity = m_slots.empty() ? 16 : m_slots.size();
+  while (capacity < 2 * n) {
+    capacity *= 2;
+  }
+  if (capacity != m_slots.size()) {
+    Rehash(capacity);
+  }
+}
+
+void
+NeighborTable::SlotIndex::Clear() {
+  m_keys.clear();
+  m_slots.clear();
+  m_size = 0;
+  m_mask = 0;
+}
+
+void
+NeighborTable::SlotIndex::Rehash(uint32_t capacity) {
+  std::vector<uint64_t> keys;
+  std::vector<uint32_t> slots;
+  keys.swap(m_keys);
+  slots.swap(m_slots);
+  m_keys.assign(capacity, 0);
+  m_slots.assign(capacity, NONE);
+  m_mask = capacity - 1;
+  m_size = 0;
+  for (uint32_t i = 0; i < slots.size(); ++i) {
+    if (slots[i] != NONE) {
+      Insert(keys[i], slots[i]);
+    }
+  }
+}
+
+//------------------NeighborTable---------------//
+
 NeighborTable::NeighborTable() {
   // constructor
 }
 
-void 
+uint64_t
+NeighborTable::Key(Mac64Address extendedAddr) {
+  uint8_t buffer[8];
+  uint64_t key;
+  extendedAddr.CopyTo(buffer);
+  std::memcpy(&key, buffer, sizeof(key));
+  return key;
+}
+
+uint64_t
+NeighborTable::Key(NwkShortAddress networkAddr) {
+  return networkAddr.GetAddressU16();
+}
+
+uint32_t
+NeighborTable::Slot(NwkShortAddress networkAddr) const {
+  return m_byNetworkAddr.Find(Key(networkAddr));
+}
+
+void
+NeighborTable::LinkRelationship(uint32_t slot) {
+  std::vector<uint32_t> &list = m_byRelationship[RelationIndex(m_neighbors[slot].relationship)];
+  m_relationPos[slot] = list.size();
+  list.push_back(slot);
+}
+
+void
+NeighborTable::UnlinkRelationship(uint32_t slot) {
+  std::vector<uint32_t> &list = m_byRelationship[RelationIndex(m_neighbors[slot].relationship)];
+  uint32_t pos = m_relationPos[slot];
+  list[pos] = list.back();
+  m_relationPos[list[pos]] = pos;
+  list.pop_back();
+}
+
+void
+NeighborTable::MoveSlot(uint32_t from, uint32_t to) {
+  // move the entry in slot 'from' into slot 'to' and fix every index
+  m_neighbors[to] = m_neighbors[from];
+  m_relationPos[to] = m_relationPos[from];
+  m_byRelationship[RelationIndex(m_neighbors[to].relationship)][m_relationPos[to]] = to;
+  m_byNetworkAddr.Insert(Key(m_neighbors[to].networkAddr), to);
+  uint64_t ext = Key(m_neighbors[to].extendedAddr);
+  if (m_byExtendedAddr.Find(ext) == from) {
+    m_byExtendedAddr.Insert(ext, to);
+  }
+}
+
+void
 NeighborTable::AddNeighborEntry(NeighborTable::NeighborEntry neighbor) {
-  // add a new neighbor entry to the vector
-  m_neighbors.push_back(neighbor);
+  uint32_t slot = Slot(neighbor.networkAddr);
+  if (slot != SlotIndex::NONE) {
+    // replace the existing entry
+    UnlinkRelationship(slot);
+    uint64_t oldExt = Key(m_neighbors[slot].extendedAddr);
+    if (m_byExtendedAddr.Find(oldExt) == slot) {
+      m_byExtendedAddr.Erase(oldExt);
+    }
+    m_neighbors[slot] = neighbor;
+  } else {
+    slot = m_neighbors.size();
+    m_neighbors.push_back(neighbor);
+    m_relationPos.push_back(0);
+    m_byNetworkAddr.Insert(Key(neighbor.networkAddr), slot);
+  }
+  m_byExtendedAddr.Insert(Key(neighbor.extendedAddr), slot);
+  LinkRelationship(slot);
+}
+
+void
+NeighborTable::AddNeighborEntries(const std::vector<NeighborEntry> &neighbors) {
+  uint32_t n = m_neighbors.size() + neighbors.size();
+  m_neighbors.reserve(n);
+  m_relationPos.reserve(n);
+  m_byNetworkAddr.Reserve(n);
+  m_byExtendedAddr.Reserve(n);
+  for (const auto &neighbor : neighbors) {
+    AddNeighborEntry(neighbor);
+  }
 }
 
-std::vector<NeighborTable::NeighborEntry> 
+const std::vector<NeighborTable::NeighborEntry> &
 NeighborTable::GetNeighborEntries() const {
   // return the vector of neighbor entries
   return m_neighbors;
 }
 
-NeighborTable::NeighborEntry 
+NeighborTable::RelationshipRange
+NeighborTable::GetNeighborEntries(Relationship relationship) const {
+  return RelationshipRange(m_neighbors.data(), m_byRelationship[RelationIndex(relationship)]);
+}
+
+NeighborTable::NeighborEntry
 NeighborTable::GetNeighborEntry(NwkShortAddress networkAddr) const {
   // find and return the neighbor entry with the given network address
-  for (auto& neighbor : m_neighbors) {
-    if (neighbor.networkAddr == networkAddr) {
-      return neighbor;
-    }
+  uint32_t slot = Slot(networkAddr);
+  if (slot != SlotIndex::NONE) {
+    return m_neighbors[slot];
   }
-  
+
   // throw an exception if not found
   throw std::runtime_error("No neighbor entry with this network address");
 }
 
-bool 
+bool
 NeighborTable::HasNeighborEntry(NwkShortAddress networkAddr) const {
   // check if there is a neighbor entry with the given network address
-  for (auto& neighbor : m_neighbors) {
-    if (neighbor.networkAddr == networkAddr) {
-      return true;
-    }
-  }
-  return false;
+  return Slot(networkAddr) != SlotIndex::NONE;
 }
 
-void 
+const NeighborTable::NeighborEntry *
+NeighborTable::FindNeighborEntry(Mac64Address extendedAddr) const {
+  uint32_t slot = m_byExtendedAddr.Find(Key(extendedAddr));
+  return slot != SlotIndex::NONE ? &m_neighbors[slot] : 0;
+}
+
+const NeighborTable::NeighborEntry *
+NeighborTable::FindNeighborEntry(NwkShortAddress networkAddr) const {
+  uint32_t slot = Slot(networkAddr);
+  return slot != SlotIndex::NONE ? &m_neighbors[slot] : 0;
+}
+
+void
 NeighborTable::RemoveNeighborEntry(NwkShortAddress networkAddr) {
   // remove the neighbor entry with the given network address from the vector
-  for (auto it = m_neighbors.begin(); it != m_neighbors.end(); ++it) {
-    if (it->networkAddr == networkAddr) {
-      m_neighbors.erase(it);
-      break;
-    }
+  uint32_t slot = Slot(networkAddr);
+  if (slot == SlotIndex::NONE) {
+    return;
   }
+  UnlinkRelationship(slot);
+  m_byNetworkAddr.Erase(Key(networkAddr));
+  uint64_t ext = Key(m_neighbors[slot].extendedAddr);
+  if (m_byExtendedAddr.Find(ext) == slot) {
+    m_byExtendedAddr.Erase(ext);
+  }
+  uint32_t last = m_neighbors.size() - 1;
+  if (slot != last) {
+    MoveSlot(last, slot);
+  }
+  m_neighbors.pop_back();
+  m_relationPos.pop_back();
+}
+
+uint32_t
+NeighborTable::GetN() const {
+  return m_neighbors.size();
+}
+
+uint32_t
+NeighborTable::GetN(Relationship relationship) const {
+  return m_byRelationship[RelationIndex(relationship)].size();
 }
 
-void 
+void
+NeighborTable::Clear() {
+  m_neighbors.clear();
+  m_relationPos.clear();
+  for (auto &list : m_byRelationship) {
+    list.clear();
+  }
+  m_byNetworkAddr.Clear();
+  m_byExtendedAddr.Clear();
+}
+
+void
 NeighborTable::SetExtendedAddress(NwkShortAddress networkAddr, Mac64Address extendedAddr) {
   // set the extended address of the neighbor entry with the given network address
-  for (auto& neighbor : m_neighbors) {
-    if (neighbor.networkAddr == networkAddr) {
-      neighbor.extendedAddr = extendedAddr;
-      break;
+  uint32_t slot = Slot(networkAddr);
+  if (slot != SlotIndex::NONE) {
+    uint64_t oldExt = Key(m_neighbors[slot].extendedAddr);
+    if (m_byExtendedAddr.Find(oldExt) == slot) {
+      m_byExtendedAddr.Erase(oldExt);
     }
+    m_neighbors[slot].extendedAddr = extendedAddr;
+    m_byExtendedAddr.Insert(Key(extendedAddr), slot);
   }
 }
 
-void 
+void
 NeighborTable::SetDeviceType(NwkShortAddress networkAddr, DeviceTypes deviceType) {
    // set the device type of the neighbor entry with the given network address
-   for (auto& neighbor : m_neighbors) {
-     if (neighbor.networkAddr == networkAddr) {
-       neighbor.deviceType = deviceType;
-       break;
-     }
+   uint32_t slot = Slot(networkAddr);
+   if (slot != SlotIndex::NONE) {
+     m_neighbors[slot].deviceType = deviceType;
    }
 }
 
-void 
+void
 NeighborTable::SetRelationship(NwkShortAddress networkAddr, Relationship relationship) {
    // set the relationship of the neighbor entry with the given network address
-   for (auto& neighbor : m_neighbors) {
-     if (neighbor.networkAddr == networkAddr) { 
-       neighbor.relationship = relationship; 
-       break; 
-     } 
-   } 
-} 
-
-void 
+   uint32_t slot = Slot(networkAddr);
+   if (slot != SlotIndex::NONE) {
+     UnlinkRelationship(slot);
+     m_neighbors[slot].relationship = relationship;
+     LinkRelationship(slot);
+   }
+}
+
+void
 NeighborTable::SetRxOnWhenIdle(NwkShortAddress networkAddr, bool rxOnWhenIdle)
-{ 
-   // set the rx on when idle flag of the neighbor entry with the given 
-   //network address 
-   for (auto& neighbor : m_neighbors)
-    { 
-     if (neighbor.networkAddr == networkAddr)
-        { 
-            neighbor.rxOnWhenIdle = rxOnWhenIdle; 
-            break; 
-        } 
-   } 
-} 
-
-
-
-void 
-NeighborTable::SetLinkQuality(NwkShortAddress networkAddr, uint8_t linkQuality) {
-  // loop through the vector and find the matching entry
-  for (auto &entry : m_neighbors) {
-    if (entry.networkAddr == networkAddr) {
-      // update the link quality field
-      entry.linkQuality = linkQuality;
-      break;
+{
+   // set the rx on when idle flag of the neighbor entry with the given
+   //network address
+   uint32_t slot = Slot(networkAddr);
+   if (slot != SlotIndex::NONE)
+    {
+      m_neighbors[slot].rxOnWhenIdle = rxOnWhenIdle;
     }
+}
+
+void
+NeighborTable::SetLinkQuality(NwkShortAddress networkAddr, uint8_t linkQuality) {
+  // find the matching entry and update the link quality field
+  uint32_t slot = Slot(networkAddr);
+  if (slot != SlotIndex::NONE) {
+    m_neighbors[slot].linkQuality = linkQuality;
   }
 }
 
-Mac64Address 
+Mac64Address
 NeighborTable::GetExtendedAddress(NwkShortAddress networkAddr) const {
-  // loop through the vector and find the matching entry
-  for (const auto &entry : m_neighbors) {
-    if (entry.networkAddr == networkAddr) {
-      // return the extended address field
-      return entry.extendedAddr;
-    }
-  }
+  const NeighborEntry *entry = FindNeighborEntry(networkAddr);
   // return a default value if not found
-  return 0;
+  return entry ? entry->extendedAddr : Mac64Address();
 }
 
-DeviceTypes 
+DeviceTypes
 NeighborTable::GetDeviceType(NwkShortAddress networkAddr) const {
-  // loop through the vector and find the matching entry
-  for (const auto &entry : m_neighbors) {
-    if (entry.networkAddr == networkAddr) {
-      // return the device type field
-      return entry.deviceType;
-    }
-  }
+  const NeighborEntry *entry = FindNeighborEntry(networkAddr);
   // return a default value if not found
-  return DeviceTypes::UNKNOWN;
+  return entry ? entry->deviceType : DeviceTypes::UNKNOWN;
 }
 
-Relationship 
+Relationship
 NeighborTable::GetRelationship(NwkShortAddress networkAddr) const {
-  // loop through the vector and find the matching entry
-  for (const auto &entry : m_neighbors) {
-    if (entry.networkAddr == networkAddr) {
-      // return the relationship field
-      return entry.relationship;
-    }
-  }
+  const NeighborEntry *entry = FindNeighborEntry(networkAddr);
   // return a default value if not found
-  return Relationship::NO_RELATIONSHIP;
+  return entry ? entry->relationship : Relationship::NO_RELATIONSHIP;
 }
 
-bool 
+bool
 NeighborTable::GetRxOnWhenIdle(NwkShortAddress networkAddr) const {
-  // loop through the vector and find the matching entry
-  for (const auto &entry : m_neighbors) {
-    if (entry.networkAddr == networkAddr) {
-      // return the rx on when idle field
-      return entry.rxOnWhenIdle;
-    }
-  }
+  const NeighborEntry *entry = FindNeighborEntry(networkAddr);
   // return a default value if not found
-  return false;
+  return entry ? entry->rxOnWhenIdle : false;
 }
 
-uint8_t 
+uint8_t
 NeighborTable::GetLinkQuality(NwkShortAddress networkAddr) const {
-   // loop through the vector and find the matching entry 
-   for (const auto &entry : m_neighbors) { 
-     if (entry.networkAddr == networkAddr) { 
-       // return the link quality field 
-       return entry.linkQuality; 
-     } 
-   } 
-   // return a default value if not found 
-   return 0; 
- }
-
-}
\ No newline at end of file
+  const NeighborEntry *entry = FindNeighborEntry(networkAddr);
+  // return a default value if not found
+  return entry ? entry->linkQuality : 0;
+}
+
+}
@@ -1,4 +1,3 @@
-
 #ifndef WSN_NEIGHBOR_H
 #define WSN_NEIGHBOR_H
 
@@ -25,6 +24,15 @@ enum class Relationship {
   NO_RELATIONSHIP
 };
 
+/**
+ * Neighbor table.
+ *
+ * Entries are stored densely in a vector.  Two open-addressing hash
+ * indexes (by network address and by extended address) map a key to
+ * its slot, so every Get/Set/Has is O(1).  A per-relationship slot list
+ * allows iterating e.g. only the children without copying entries.
+ * Removal moves the last entry into the freed slot.
+ */
 class NeighborTable {
 public:
   struct NeighborEntry {
@@ -36,13 +44,61 @@ public:
     uint8_t linkQuality;
   };
 
+  /**
+   * Iterates over the entries of one relationship class.
+   */
+  class RelationshipIterator {
+  public:
+    RelationshipIterator(const NeighborEntry *entries, std::vector<uint32_t>::const_iterator it)
+      : m_entries(entries), m_it(it) {}
+    const NeighborEntry & operator*() const { return m_entries[*m_it]; }
+    const NeighborEntry * operator->() const { return &m_entries[*m_it]; }
+    RelationshipIterator & operator++() { ++m_it; return *this; }
+    bool operator!=(const RelationshipIterator &o) const { return m_it != o.m_it; }
+    bool operator==(const RelationshipIterator &o) const { return m_it == o.m_it; }
+  private:
+    const NeighborEntry *m_entries;
+    std::vector<uint32_t>::const_iterator m_it;
+  };
+
+  /**
+   * Range of entries with one relationship, usable in range-for.
+   */
+  class RelationshipRange {
+  public:
+    RelationshipRange(const NeighborEntry *entries, const std::vector<uint32_t> &slots)
+      : m_entries(entries), m_slots(slots) {}
+    RelationshipIterator begin() const { return RelationshipIterator(m_entries, m_slots.begin()); }
+    RelationshipIterator end() const { return RelationshipIterator(m_entries, m_slots.end()); }
+    uint32_t size() const { return m_slots.size(); }
+  private:
+    const NeighborEntry *m_entries;
+    const std::vector<uint32_t> &m_slots;
+  };
+
   NeighborTable();
 
+  /**
+   * Add a neighbor; an existing entry with the same network address is replaced.
+   */
   void AddNeighborEntry(NeighborEntry neighbor);
-  std::vector<NeighborEntry> GetNeighborEntries() const;
+  /**
+   * Add many neighbors at once, growing the indexes only once.
+   */
+  void AddNeighborEntries(const std::vector<NeighborEntry> &neighbors);
+  const std::vector<NeighborEntry> & GetNeighborEntries() const;
+  RelationshipRange GetNeighborEntries(Relationship relationship) const;
   NeighborEntry GetNeighborEntry(NwkShortAddress networkAddr) const;
   bool HasNeighborEntry(NwkShortAddress networkAddr) const;
+  /**
+   * \return the entry with this extended address, or 0 if there is none
+   */
+  const NeighborEntry * FindNeighborEntry(Mac64Address extendedAddr) const;
+  const NeighborEntry * FindNeighborEntry(NwkShortAddress networkAddr) const;
   void RemoveNeighborEntry(NwkShortAddress networkAddr);
+  uint32_t GetN() const;
+  uint32_t GetN(Relationship relationship) const;
+  void Clear();
 
   void SetExtendedAddress(NwkShortAddress networkAddr, Mac64Address extendedAddr);
   void SetDeviceType(NwkShortAddress networkAddr, DeviceTypes deviceType);
@@ -57,10 +113,41 @@ public:
   uint8_t GetLinkQuality(NwkShortAddress networkAddr) const;
 
 private:
+  /**
+   * Open-addressing (linear probing) map from a 64-bit key to a slot.
+   */
+  class SlotIndex {
+  public:
+    SlotIndex();
+    uint32_t Find(uint64_t key) const;
+    void Insert(uint64_t key, uint32_t slot);
+    void Erase(uint64_t key);
+    void Reserve(uint32_t n);
+    void Clear();
+    static const uint32_t NONE = 0xffffffff;
+  private:
+    uint32_t Bucket(uint64_t key) const;
+    void Rehash(uint32_t capacity);
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_slots;  // NONE marks an empty bucket
+    uint32_t m_size;
+    uint32_t m_mask;
+  };
+
+  static uint64_t Key(Mac64Address extendedAddr);
+  static uint64_t Key(NwkShortAddress networkAddr);
+  uint32_t Slot(NwkShortAddress networkAddr) const;
+  void LinkRelationship(uint32_t slot);
+  void UnlinkRelationship(uint32_t slot);
+  void MoveSlot(uint32_t from, uint32_t to);
+
   std::vector<NeighborEntry> m_neighbors;
+  std::vector<uint32_t> m_relationPos;            // position of each slot in its relationship list
+  std::vector<uint32_t> m_byRelationship[4];      // slots, one list per Relationship
+  SlotIndex m_byNetworkAddr;
+  SlotIndex m_byExtendedAddr;
 };
 
 } // namespace ns3
 
 #endif
-
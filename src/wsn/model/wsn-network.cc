@@ -1,5 +1,12 @@
 #include "wsn-network.h"
 #include "wsn-address-allocator.h"
+#include "wsn-training-pool.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3
 {
@@ -14,6 +21,76 @@ WsnNwkProtocol::GetTypeId (void)
     static TypeId tid = TypeId ("ns3::WsnNwkProtocol")
                     .SetParent<Object> ()
                     .AddConstructor<WsnNwkProtocol>()
+                    .AddAttribute ("Aggregator",
+                                   "The aggregator used by the coordinator, FedAvg if not set.",
+                                   PointerValue (),
+                                   MakePointerAccessor (&WsnNwkProtocol::m_aggregator),
+                                   MakePointerChecker<WsnAggregator> ())
+                    .AddAttribute ("Quorum",
+                                   "Number of models the coordinator waits for before aggregating.",
+                                   UintegerValue (2),
+                                   MakeUintegerAccessor (&WsnNwkProtocol::m_quorum),
+                                   MakeUintegerChecker<uint32_t> (1))
+                    .AddAttribute ("InNetworkAggregation",
+                                   "Routers aggregate the models of their child subtree and forward one partial model.",
+                                   BooleanValue (false),
+                                   MakeBooleanAccessor (&WsnNwkProtocol::m_inNetworkAggregation),
+                                   MakeBooleanChecker ())
+                    .AddAttribute ("PartialAggregationTimeout",
+                                   "How long a router waits for missing children before forwarding a partial model.",
+                                   TimeValue (Seconds (10.0)),
+                                   MakeTimeAccessor (&WsnNwkProtocol::m_partialAggregationTimeout),
+                                   MakeTimeChecker ())
+                    .AddAttribute ("ModelCodec",
+                                   "TypeId of the codec used to compress models on the air, empty for none.",
+                                   StringValue (""),
+                                   MakeStringAccessor (&WsnNwkProtocol::m_codecType),
+                                   MakeStringChecker ())
+                    .AddAttribute ("FragmentSize",
+                                   "Model bytes carried by one MAC frame, encoded or not.",
+                                   UintegerValue (90),
+                                   MakeUintegerAccessor (&WsnNwkProtocol::m_fragmentSize),
+                                   MakeUintegerChecker<uint32_t> (1, 97))
+                    .AddAttribute ("ReassemblyTimeout",
+                                   "How long the fragments of an incomplete model are kept.",
+                                   TimeValue (Seconds (60.0)),
+                                   MakeTimeAccessor (&WsnNwkProtocol::m_reassemblyTimeout),
+                                   MakeTimeChecker ())
+                    .AddAttribute ("TreeRouting",
+                                   "Compute the next hop from the Cskip address tree instead of the routing table.",
+                                   BooleanValue (false),
+                                   MakeBooleanAccessor (&WsnNwkProtocol::m_treeRouting),
+                                   MakeBooleanChecker ())
+                    .AddAttribute ("ComputeLatency",
+                                   "Simulated time a node spends on local training when a train callback is set.",
+                                   TimeValue (Seconds (1.0)),
+                                   MakeTimeAccessor (&WsnNwkProtocol::m_computeLatency),
+                                   MakeTimeChecker ())
+                    .AddAttribute ("SampleCount",
+                                   "Number of local training samples, used as the weight of the local model.",
+                                   DoubleValue (1.0),
+                                   MakeDoubleAccessor (&WsnNwkProtocol::m_sampleCount),
+                                   MakeDoubleChecker<double> (0.0))
+                    .AddTraceSource ("Join",
+                                     "The node joined the network: own address, parent address, depth.",
+                                     MakeTraceSourceAccessor (&WsnNwkProtocol::m_joinTrace),
+                                     "ns3::WsnNwkProtocol::JoinTracedCallback")
+                    .AddTraceSource ("Tx",
+                                     "A network frame is handed to the MAC: packet, source, destination.",
+                                     MakeTraceSourceAccessor (&WsnNwkProtocol::m_txTrace),
+                                     "ns3::WsnNwkProtocol::PacketTracedCallback")
+                    .AddTraceSource ("Rx",
+                                     "A network frame is received from the MAC: packet, source, destination.",
+                                     MakeTraceSourceAccessor (&WsnNwkProtocol::m_rxTrace),
+                                     "ns3::WsnNwkProtocol::PacketTracedCallback")
+                    .AddTraceSource ("Aggregate",
+                                     "Models were aggregated: number of models, total weight, true for a partial (router) aggregate.",
+                                     MakeTraceSourceAccessor (&WsnNwkProtocol::m_aggregateTrace),
+                                     "ns3::WsnNwkProtocol::AggregateTracedCallback")
+                    .AddTraceSource ("RoundComplete",
+                                     "The coordinator produced a global model: round, time spent collecting models, round duration.",
+                                     MakeTraceSourceAccessor (&WsnNwkProtocol::m_roundTrace),
+                                     "ns3::WsnNwkProtocol::RoundTracedCallback")
                     ;
     return tid;
 }
@@ -22,12 +99,14 @@ WsnNwkProtocol::WsnNwkProtocol()
 {
   NS_LOG_INFO(this);
   m_depth = -1;
+  m_round = 0;
 }
 
 WsnNwkProtocol::WsnNwkProtocol(NODE_TYPE type)
 {
   NS_LOG_INFO(this);
   m_depth = -1;
+  m_round = 0;
   m_nodeType = type;
 }
 
@@ -68,7 +147,11 @@ WsnNwkProtocol::Send(NwkShortAddress sourceaddr,
   params.m_srcAddrMode = EXT_ADDR;
   params.m_dstAddrMode = EXT_ADDR;
   
-  NwkShortAddress nextHop = m_rtable.Lookup(dstaddr);
+  // 树路由按地址直接算下一跳，不在子树里的目的地址交给父节点
+  NwkShortAddress nextHop = m_treeRouting
+    ? NwkShortAddress(WsnAddressAllocator::Get()->GetTreeNextHop(m_depth,m_addr.GetAddressU16(),
+                                                                 dstaddr.GetAddressU16()))
+    : m_rtable.Lookup(dstaddr);
   
   if(nextHop.GetAddressU16() == 0x0000)
       nextHop = m_route;
@@ -78,6 +161,7 @@ WsnNwkProtocol::Send(NwkShortAddress sourceaddr,
 
   params.m_dstExtAddr = nextNeight.extendedAddr;
   NS_LOG_FUNCTION(this << " ntable MAC addr is  " << nextNeight.extendedAddr);
+  m_txTrace(packet,sourceaddr,dstaddr);
   // m_netDevice->GetMac()->McpsDataRequest(params,packet);
   Simulator::Schedule(Seconds(0.0),
                       &LrWpanMac::McpsDataRequest,
@@ -88,11 +172,7 @@ WsnNwkProtocol::Send(NwkShortAddress sourceaddr,
 void
 WsnNwkProtocol::BuildRtable(std::vector<StaticRoute>&rtable)
 {
-    for(std::vector<StaticRoute>::iterator begin = rtable.begin()
-                                ;begin != rtable.end(); ++ begin)
-    {
-        m_rtable.AddRoute(*begin);
-    }
+    m_rtable.AddRoutes(rtable);
 }
 
 void 
@@ -113,7 +193,26 @@ void
 WsnNwkProtocol::JoinRequest(Ptr<WsnNwkProtocol> wsnNwkProtocol)
 {
   NS_LOG_FUNCTION(this << " " << wsnNwkProtocol << m_nodeType);
-  uint16_t addr;
+  uint16_t addr = 0;
+  if(m_nodeType != NODE_TYPE::COOR)
+  {
+    addr = WsnAddressAllocator::Get()->AllocateNwkAddress(wsnNwkProtocol->GetDepth(),IsRoute(),
+                                                          wsnNwkProtocol->GetNwkShortAddress().GetAddressU16());
+    NS_LOG_FUNCTION(this << "addr is = " << addr);
+  }
+  Join(wsnNwkProtocol,addr);
+
+  // 树路由不需要路由表，也就不用广播路由更新
+  if(m_nodeType != NODE_TYPE::COOR && !m_treeRouting)
+    Simulator::Schedule(Seconds(0.1),&WsnNwkProtocol::Send,
+                        this,m_addr,m_route,Create<Packet>(50),
+                        NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_NETWORK_UPDATE);
+}
+
+void
+WsnNwkProtocol::Join(Ptr<WsnNwkProtocol> wsnNwkProtocol, NwkShortAddress addr)
+{
+  NS_LOG_FUNCTION(this << " " << wsnNwkProtocol << addr);
 
   MlmeStartRequestParams params;
   NeighborTable* ntable;
@@ -132,20 +231,25 @@ WsnNwkProtocol::JoinRequest(Ptr<WsnNwkProtocol> wsnNwkProtocol)
     parents = wsnNwkProtocol->GetNwkShortAddress();
     netDevice = wsnNwkProtocol->GetLrWpanNetDevice();
     
-    addr = WsnAddressAllocator::Get()->AllocateNwkAddress(m_depth-1,IsRoute(),
-                                                            parents.GetAddressU16());
-    NS_LOG_FUNCTION(this << "addr is = " << addr);
-    m_addr = std::move(NwkShortAddress(addr));
+    m_addr = addr;
 
     m_route = parents;
 
     That.extendedAddr = netDevice->GetMac()->GetExtendedAddress();
     That.networkAddr = wsnNwkProtocol->GetNwkShortAddress();
+    That.deviceType = wsnNwkProtocol->GetDeviceType();
+    That.relationship = Relationship::PARENT;
+    That.rxOnWhenIdle = true;
+    That.linkQuality = 0;
 
     NS_LOG_FUNCTION(this << " that net addr is " << That.networkAddr << " " << That.extendedAddr);
 
     This.extendedAddr = m_netDevice->GetMac()->GetExtendedAddress();
     This.networkAddr = GetNwkShortAddress();
+    This.deviceType = GetDeviceType();
+    This.relationship = Relationship::CHILD;
+    This.rxOnWhenIdle = true;
+    This.linkQuality = 0;
 
     NS_LOG_FUNCTION(this << " This net addr is " << This.networkAddr << " " << This.extendedAddr);
 
@@ -186,11 +290,7 @@ WsnNwkProtocol::JoinRequest(Ptr<WsnNwkProtocol> wsnNwkProtocol)
   
   Simulator::Schedule(Seconds(0.0),&LrWpanMac::MlmeStartRequest,
                         this->m_netDevice->GetMac(),params);
-  
-  if(m_nodeType != NODE_TYPE::COOR)
-    Simulator::Schedule(Seconds(0.1),&WsnNwkProtocol::Send,
-                        this,m_addr,parents,Create<Packet>(50),
-                        NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_NETWORK_UPDATE);
+  m_joinTrace(m_addr,m_route,m_depth);
 }
 
 void 
@@ -219,6 +319,22 @@ WsnNwkProtocol::GetPanID()
   return m_panId;
 }
 
+DeviceTypes
+WsnNwkProtocol::GetDeviceType()
+{
+  switch(m_nodeType)
+  {
+    case NODE_TYPE::COOR :
+      return DeviceTypes::COORDINATOR;
+    case NODE_TYPE::ROUTE :
+      return DeviceTypes::ROUTER;
+    case NODE_TYPE::EDGE :
+      return DeviceTypes::END_DEVICE;
+    default:
+      return DeviceTypes::UNKNOWN;
+  }
+}
+
 uint8_t
 WsnNwkProtocol::GetDepth()
 {
@@ -268,22 +384,18 @@ WsnNwkProtocol::NotifyNewAggregate (void)
 void 
 WsnNwkProtocol::BeaconIndication (MlmeBeaconNotifyIndicationParams params, Ptr<Packet> p)
 {
-    NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " secs | Received BEACON packet of size " << p->GetSize ());
+    NS_LOG_INFO (m_addr << " Received BEACON packet of size " << p->GetSize ());
 }
 
 void
 WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
 {    
     NS_LOG_FUNCTION(this);
-    if(m_nodeType == NODE_TYPE::EDGE)
-      NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s EDGE Received packet of size " << p->GetSize ());
-    else if(m_nodeType == NODE_TYPE::COOR)
-      NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s Coordinator Received packet (size " << p->GetSize () << " bytes)");
-    else 
-      NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s Route Received packet (size " << p->GetSize () << " bytes)");
+    NS_LOG_INFO (m_addr << " " << m_nodeType << " Received packet of size " << p->GetSize ());
     
     NwkHeader receiverNwkHeader;
     p->RemoveHeader(receiverNwkHeader);
+    m_rxTrace(p,receiverNwkHeader.GetSourceAddr(),receiverNwkHeader.GetDestAddr());
 
     double Delay = 0.1;
     double gap = 0.1;
@@ -299,17 +411,15 @@ WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
         {
           return;
         }
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s Received Command packet of size " << p->GetSize ());
-        std::vector<NeighborTable::NeighborEntry> ntable = m_ntable.GetNeighborEntries();
-        for(auto it : ntable)
+        NS_LOG_LOGIC (m_addr << " Received Command packet of size " << p->GetSize ());
+        for(const auto &it : m_ntable.GetNeighborEntries())
         {
           if(it.extendedAddr == params.m_srcExtAddr) 
           {
-            NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " secs update route ");
+            NS_LOG_LOGIC (m_addr << " update route " << receiverNwkHeader.GetSourceAddr() << " via " << it.networkAddr);
             // 更新路由表
             StaticRoute newRoute(receiverNwkHeader.GetSourceAddr(),it.networkAddr);
             m_rtable.AddRoute(newRoute);
-            m_rtable.Print();
             continue;
           }
           // 注意要把包复制出来，要不然会出现浅拷贝
@@ -318,26 +428,39 @@ WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
                         this,receiverNwkHeader.GetSourceAddr(),it.networkAddr
                         ,newp,NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_NETWORK_UPDATE);
           Delay += gap;
-          NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " send update route --->>>");
+          NS_LOG_LOGIC (m_addr << " send update route to " << it.networkAddr);
         }
       }
       else if(pl.GetnwkCommandIdentifier() == (uint8_t)WsnNwkPayload::WSN_PL_MODEL_RECV)
       {
+        // 分片的模型要等所有分片都到了才交给上层，转发则逐片进行
+        Ptr<const WsnModel> model;
         if(m_nodeType == NODE_TYPE::COOR)
         {
-          FvGModel(p->Copy());
+          if(IsModelComplete(p,model))
+            FvGModel(model);
           return;
         }
-        if(m_wsnGetModelCallback.IsNull())
+        // 上行的模型在路由器上先做子树内的部分聚合
+        if(m_nodeType == NODE_TYPE::ROUTE && m_inNetworkAggregation
+           && receiverNwkHeader.GetDestAddr() == NwkShortAddress((uint16_t)0))
+        {
+          if(IsModelComplete(p,model))
+            PartialAggregate(model);
+          return;
+        }
+        // 做部分聚合的路由器即使自己不训练，也要把全局模型转发给子树
+        bool learning = IsLearning();
+        if(!learning && !(m_nodeType == NODE_TYPE::ROUTE && m_inNetworkAggregation))
         {
           NS_LOG_FUNCTION(this << " i  am not the learning node");
           return;
         }
-        if(receiverNwkHeader.GetDestAddr() != NwkShortAddress((uint16_t)0))
-          RecvModel(p->Copy());
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s Received model packet of size " << p->GetSize ());
-        std::vector<NeighborTable::NeighborEntry> ntable = m_ntable.GetNeighborEntries();
-        for(auto it : ntable)
+        if(learning && receiverNwkHeader.GetDestAddr() != NwkShortAddress((uint16_t)0)
+           && IsModelComplete(p,model))
+          RecvModel(model);
+        NS_LOG_LOGIC (m_addr << " Received model packet of size " << p->GetSize ());
+        for(const auto &it : m_ntable.GetNeighborEntries())
         {
           if(it.extendedAddr == params.m_srcExtAddr) 
           {
@@ -350,7 +473,7 @@ WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
                         this,m_addr,it.networkAddr
                         ,newp,NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_MODEL_RECV);
           Delay += gap;
-          NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " send update model --->>>");
+          NS_LOG_LOGIC (m_addr << " forward model to " << it.networkAddr);
         }
       }
     }
@@ -358,7 +481,7 @@ WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
     {
       if(m_nodeType == NODE_TYPE::ROUTE || (receiverNwkHeader.GetDestAddr() != m_addr))
       {
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " secs | Received DATA packet of size " << p->GetSize () << 
+        NS_LOG_LOGIC (m_addr << " Received DATA packet of size " << p->GetSize () << 
         ",but i am a " << m_nodeType << " m_addr is " << m_addr << " ,so i will forwarding packet");
         // 路由器转发数据包
         // Send(receiverNwkHeader.GetSourceAddr(),receiverNwkHeader.GetDestAddr(),p,NwkHeader::NWK_FRAME_DATA);
@@ -369,7 +492,7 @@ WsnNwkProtocol::DataIndication (McpsDataIndicationParams params, Ptr<Packet> p)
       }
       else 
       {
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " secs | Coor Received DATA packet of size " << p->GetSize ());
+        NS_LOG_LOGIC (m_addr << " Coor Received DATA packet of size " << p->GetSize ());
         //实现应用层回调 
       }
     }
@@ -380,14 +503,14 @@ WsnNwkProtocol::TransEndIndication (McpsDataConfirmParams params)
 {
     if (params.m_status == LrWpanMcpsDataConfirmStatus::IEEE_802_15_4_SUCCESS)
     {
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " secs | Transmission successfully sent");
+        NS_LOG_LOGIC (m_addr << " Transmission successfully sent");
     }
 }
 
 void 
 WsnNwkProtocol::DataIndicationCoordinator (McpsDataIndicationParams params, Ptr<Packet> p)
 {
-    NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "s Coordinator Received DATA packet (size " << p->GetSize () << " bytes)");
+    NS_LOG_INFO (m_addr << " Coordinator Received DATA packet (size " << p->GetSize () << " bytes)");
 }
 
 void 
@@ -396,7 +519,7 @@ WsnNwkProtocol::StartConfirm (MlmeStartConfirmParams params)
     NS_LOG_FUNCTION(this);
     if (params.m_status == MLMESTART_SUCCESS)
     {
-        NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << "Beacon status SUCESSFUL");
+        NS_LOG_INFO (m_addr << " Beacon status SUCESSFUL");
     }
 }
 
@@ -434,6 +557,18 @@ WsnNwkProtocol::SetGetModelCallBack(WsnGetModelCallback mCb)
   m_wsnGetModelCallback = mCb;
 }
 
+void
+WsnNwkProtocol::SetTrainCallBack(WsnGetModelCallback mCb)
+{
+  m_wsnTrainCallback = mCb;
+}
+
+bool
+WsnNwkProtocol::IsLearning()
+{
+  return !m_wsnGetModelCallback.IsNull() || !m_wsnTrainCallback.IsNull();
+}
+
 void 
 WsnNwkProtocol::DoInitialize (void)
 {
@@ -444,6 +579,15 @@ WsnNwkProtocol::DoDispose (void)
 {
     NS_LOG_FUNCTION (this);
     m_node = 0;
+    m_partialTimeout.Cancel();
+    if(m_training != 0)
+    {
+      WsnTrainingPool::Get()->Wait(m_training);
+      m_training = 0;
+    }
+    m_aggregator = 0;
+    m_codec = 0;
+    m_reassembly.clear();
     Object::DoDispose ();
 }
 
@@ -451,6 +595,11 @@ void
 WsnNwkProtocol::GetModel(void)
 {
   NS_LOG_FUNCTION(this);
+  if(!m_wsnTrainCallback.IsNull())
+  {
+    StartTraining();
+    return;
+  }
   if(m_wsnGetModelCallback.IsNull())
   {
     NS_LOG_FUNCTION(this << "m_wsnGetModelCallback is Null");
@@ -462,87 +611,301 @@ WsnNwkProtocol::GetModel(void)
     Simulator::Schedule(Seconds(1.0),&WsnNwkProtocol::GetModel,this);
     return;
   }
+  SendLocalModel(std::move(model));
+}
+
+void
+WsnNwkProtocol::StartTraining()
+{
+  if(m_training != 0)
+  {
+    NS_LOG_FUNCTION(this << " training already running");
+    return;
+  }
+  // 训练在线程池里跑，仿真时间过了 ComputeLatency 以后再取结果
+  m_training = WsnTrainingPool::Get()->Submit(m_wsnTrainCallback);
+  uint32_t context = m_node != 0 ? m_node->GetId() : Simulator::GetContext();
+  Simulator::ScheduleWithContext(context,m_computeLatency,&WsnNwkProtocol::TrainingDone,this);
+}
+
+void
+WsnNwkProtocol::TrainingDone()
+{
+  if(m_training == 0)
+  {
+    return;
+  }
+  std::vector<double> model = WsnTrainingPool::Get()->Wait(m_training);
+  m_training = 0;
+  if(!model.size())
+  {
+    NS_LOG_FUNCTION(this << " training returned an empty model");
+    return;
+  }
+  SendLocalModel(std::move(model));
+}
+
+void
+WsnNwkProtocol::SendLocalModel(std::vector<double> model)
+{
   NS_LOG_FUNCTION(this << "Get model is " << model.size());
-  for(auto it : model)
+
+  Ptr<WsnModel> local = Create<WsnModel> (std::move (model), m_sampleCount);
+  if(m_nodeType == NODE_TYPE::ROUTE && m_inNetworkAggregation)
   {
-    NS_LOG_UNCOND(it << " ");
+    // 路由器自己的模型也并到子树的部分聚合里
+    AddPartialModel(local);
+    return;
   }
-  NS_LOG_UNCOND("\n");
-  
-  Ptr<Packet> packet = Create<Packet>(50);
-  WsnFedTag wsnFedTag(model);
-  packet->AddPacketTag(wsnFedTag);
-  Simulator::Schedule(Seconds(0.0),&WsnNwkProtocol::Send,
-              this,m_addr,NwkShortAddress((uint16_t)0)
-              ,packet,NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_MODEL_RECV);
+
+  SendModelFrames(NwkShortAddress((uint16_t)0),BuildModelFrames(local),Seconds(0.0));
 }
 
 void 
-WsnNwkProtocol::RecvModel(Ptr<Packet> model)
+WsnNwkProtocol::RecvModel(Ptr<const WsnModel> model_)
 {
-  NS_LOG_FUNCTION(this);
-  WsnFedTag m_model;
-  model->RemovePacketTag(m_model);
-  std::vector<double> model_;
-  model_ = m_model.Get();
-  NS_LOG_FUNCTION(this << " Recv model is " << model_.size());
-  
-  for(auto it : model_)
+  NS_LOG_FUNCTION(this << " Recv model is " << model_->GetSize());
+
+  if(GetCodec() != 0)
   {
-    NS_LOG_UNCOND(it << " ");
+    GetCodec()->SetReference(model_);
   }
-  NS_LOG_UNCOND("\n");
-
-  m_wsnRecvModelCallback(m_model.Get());
+  m_wsnRecvModelCallback(model_->Get());
   Simulator::Schedule(Seconds(3.0),&WsnNwkProtocol::GetModel,this);
 }
 
 void 
-WsnNwkProtocol::FvGModel(Ptr<Packet> model)
+WsnNwkProtocol::FvGModel(Ptr<const WsnModel> model)
+{
+  NS_LOG_FUNCTION(this);
+  Ptr<WsnAggregator> aggregator = GetAggregator();
+  aggregator->Add(model);
+  NS_LOG_FUNCTION(this << model->GetSize() << " aggregated " << aggregator->GetN() << "/" << m_quorum);
+  if(aggregator->GetN() == 1)
+  {
+    m_roundStart = Simulator::Now();
+  }
+  if(aggregator->GetN() < m_quorum)
+  {
+    return;
+  }
+
+  uint32_t nModels = aggregator->GetN();
+  Ptr<WsnModel> global = aggregator->Aggregate();
+  NS_LOG_DEBUG(m_addr << " global model of " << nModels << " models, weight " << global->GetWeight());
+  m_aggregateTrace(nModels,global->GetWeight(),false);
+  m_roundTrace(m_round++,Simulator::Now() - m_roundStart,Simulator::Now() - m_roundEnd);
+  m_roundEnd = Simulator::Now();
+
+  double Delay = 0.1;
+  // 所有邻居共享同一份全局模型，只编码一次
+  std::vector<Ptr<Packet> > frames = BuildModelFrames(global);
+  if(GetCodec() != 0)
+  {
+    GetCodec()->SetReference(global);
+  }
+  for(const auto &it : m_ntable.GetNeighborEntries())
+  {
+    SendModelFrames(it.networkAddr,frames,Seconds(Delay));
+    Delay += 0.1;
+    NS_LOG_LOGIC (m_addr << " Coor send fvg model to " << it.networkAddr);
+  }
+}
+
+void
+WsnNwkProtocol::PartialAggregate(Ptr<const WsnModel> model)
 {
   NS_LOG_FUNCTION(this);
-  WsnFedTag m_model;
-  model->RemovePacketTag(m_model);
-  std::vector<double> m = m_model.Get(); 
-  NS_LOG_FUNCTION(this << m.size() << "-------------------------->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
-  if(!m_modelFvg.size())
+  AddPartialModel(model);
+}
+
+void
+WsnNwkProtocol::AddPartialModel(Ptr<const WsnModel> model)
+{
+  Ptr<WsnAggregator> aggregator = GetAggregator();
+  aggregator->Add(model);
+  uint32_t quorum = GetSubtreeQuorum();
+  NS_LOG_FUNCTION(this << " partial " << aggregator->GetN() << "/" << quorum);
+  if(aggregator->GetN() >= quorum)
+  {
+    FlushPartialAggregate();
+  }
+  else if(!m_partialTimeout.IsRunning())
   {
-    m_modelFvg = m; 
-    m_modelFvg.push_back(1);
+    // 有孩子一直没交模型的时候，超时后把已经收到的先发上去
+    m_partialTimeout = Simulator::Schedule(m_partialAggregationTimeout,
+                                           &WsnNwkProtocol::FlushPartialAggregate,this);
+  }
+}
+
+void
+WsnNwkProtocol::FlushPartialAggregate()
+{
+  m_partialTimeout.Cancel();
+  Ptr<WsnAggregator> aggregator = GetAggregator();
+  if(aggregator->GetN() == 0)
+  {
+    return;
+  }
+  // 部分聚合结果的权重是子树内所有模型的权重之和
+  uint32_t nModels = aggregator->GetN();
+  Ptr<WsnModel> partial = aggregator->Aggregate();
+  m_aggregateTrace(nModels,partial->GetWeight(),true);
+  NS_LOG_FUNCTION(this << " forward partial model, weight " << partial->GetWeight());
+  SendModelFrames(NwkShortAddress((uint16_t)0),BuildModelFrames(partial),Seconds(0.0));
+}
+
+uint32_t
+WsnNwkProtocol::GetSubtreeQuorum()
+{
+  uint32_t quorum = IsLearning() ? 1 : 0;
+  return quorum + m_ntable.GetN(Relationship::CHILD);
+}
+
+std::vector<Ptr<Packet> >
+WsnNwkProtocol::BuildModelFrames(Ptr<const WsnModel> model)
+{
+  std::vector<Ptr<Packet> > frames;
+  Ptr<WsnModelCodec> codec = GetCodec();
+  std::vector<uint8_t> buffer;
+  Ptr<const WsnModel> shared = model;
+  if(codec == 0)
+  {
+    // 不压缩：帧里是模型按 float64 原样序列化的字节，空口占用和真实模型一致，
+    // 句柄找得到时接收端直接共享同一个模型
+    CreateObject<WsnRawCodec>()->Encode(model,buffer);
   }
   else
   {
-    double &tt = m_modelFvg[m_modelFvg.size()-1];
-    for(uint32_t i = 0; i < m_modelFvg.size()-1; ++ i)
-    {
-      m_modelFvg[i] = m[i]*(m_modelFvg[i]*tt)/(tt+1);
-    }
-    tt++;
+    // 压缩：接收端拿到的是解码以后的模型
+    codec->Encode(model,buffer);
+    shared = codec->Decode(buffer);
+  }
+  // 真实的字节按 FragmentSize 切成 MAC 帧
+  WsnFedTag wsnFedTag(shared);
+  uint32_t count = (buffer.size() + m_fragmentSize - 1) / m_fragmentSize;
+  NS_LOG_FUNCTION(this << " encoded " << model->GetSerializedSize() << " -> " << buffer.size()
+                  << " bytes, " << count << " frames");
+  for(uint32_t i = 0; i < count; ++ i)
+  {
+    uint32_t offset = i * m_fragmentSize;
+    uint32_t len = std::min<uint32_t>(m_fragmentSize, buffer.size() - offset);
+    Ptr<Packet> packet = Create<Packet>(buffer.data() + offset, len);
+    wsnFedTag.SetFragment(i,count);
+    packet->AddPacketTag(wsnFedTag);
+    frames.push_back(packet);
   }
-  for(auto it : m_modelFvg)
+  return frames;
+}
+
+void
+WsnNwkProtocol::SendModelFrames(NwkShortAddress dst, const std::vector<Ptr<Packet> > &frames, Time delay)
+{
+  // 分片都交给 MAC 的发送队列，按顺序发出
+  for(auto it : frames)
   {
-    NS_LOG_UNCOND(it << " <-> ");
+    Simulator::Schedule(delay,&WsnNwkProtocol::Send,
+                this,m_addr,dst
+                ,it->Copy(),NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_MODEL_RECV);
   }
-  NS_LOG_UNCOND("\n");
-  if(m_modelFvg[m_modelFvg.size()-1] > 1)
+}
+
+bool
+WsnNwkProtocol::IsModelComplete(Ptr<const Packet> p, Ptr<const WsnModel> &model)
+{
+  WsnFedTag tag;
+  p->PeekPacketTag(tag);
+  if(tag.GetFragmentCount() <= 1)
   {
-    m_modelFvg.pop_back();
-    double Delay = 0.1;
-    std::vector<NeighborTable::NeighborEntry> ntable = m_ntable.GetNeighborEntries();
-    for(auto it : ntable)
+    model = tag.Get();
+    if(model == 0)
     {
-      // 注意要把包复制出来，要不然会出现浅拷贝
-      Ptr<Packet> newp = Create<Packet>(0);
-      WsnFedTag newTag(m_modelFvg);
-      newp->AddPacketTag(newTag);
-      Simulator::Schedule(Seconds(Delay),&WsnNwkProtocol::Send,
-                    this,m_addr,it.networkAddr
-                    ,newp,NwkHeader::NWK_FRAME_COMMAND,WsnNwkPayload::WSN_PL_MODEL_RECV);
-      Delay += 0.1;
-      NS_LOG_UNCOND (m_addr << " " <<Simulator::Now ().GetSeconds () << " Coor send fvg model --->>>");
+      model = DecodeModel(std::vector<Ptr<const Packet> >(1,p));
     }
-    m_modelFvg.clear();
+    return true;
+  }
+  // 清掉早就过期的残缺模型
+  Time expire = Simulator::Now() - m_reassemblyTimeout;
+  for(std::map<uint32_t, Reassembly>::iterator it = m_reassembly.begin();
+      it != m_reassembly.end();)
+  {
+    if(it->second.start < expire)
+      m_reassembly.erase(it++);
+    else
+      ++it;
+  }
+
+  std::map<uint32_t, Reassembly>::iterator it = m_reassembly.find(tag.GetHandle());
+  if(it == m_reassembly.end())
+  {
+    Reassembly entry;
+    entry.fragments.resize(tag.GetFragmentCount());
+    entry.count = 0;
+    entry.start = Simulator::Now();
+    it = m_reassembly.insert(std::make_pair(tag.GetHandle(),entry)).first;
+  }
+  // MAC 重传可能让同一个分片到达多次，按序号记录，重复的不计数
+  Reassembly &entry = it->second;
+  uint16_t index = tag.GetFragmentIndex();
+  if(index >= entry.fragments.size() || entry.fragments[index] != 0)
+  {
+    NS_LOG_LOGIC(this << " duplicate fragment " << index << " of model " << tag.GetHandle());
+    return false;
+  }
+  entry.fragments[index] = p->Copy();
+  if(++entry.count < entry.fragments.size())
+  {
+    return false;
+  }
+  // 句柄已经被淘汰时从分片的字节解码
+  model = tag.Get();
+  if(model == 0)
+  {
+    model = DecodeModel(entry.fragments);
+  }
+  m_reassembly.erase(it);
+  return true;
+}
+
+Ptr<const WsnModel>
+WsnNwkProtocol::DecodeModel(const std::vector<Ptr<const Packet> > &fragments)
+{
+  std::vector<uint8_t> buffer;
+  for(const auto &it : fragments)
+  {
+    uint32_t offset = buffer.size();
+    buffer.resize(offset + it->GetSize());
+    it->CopyData(buffer.data() + offset, it->GetSize());
+  }
+  NS_LOG_FUNCTION(this << " decode " << buffer.size() << " bytes");
+  Ptr<WsnModelCodec> codec = GetCodec();
+  if(codec == 0)
+  {
+    return CreateObject<WsnRawCodec>()->Decode(buffer);
+  }
+  return codec->Decode(buffer);
+}
+
+Ptr<WsnModelCodec>
+WsnNwkProtocol::GetCodec()
+{
+  if(m_codec == 0 && !m_codecType.empty())
+  {
+    ObjectFactory factory;
+    factory.SetTypeId(m_codecType);
+    m_codec = factory.Create<WsnModelCodec>();
+  }
+  return m_codec;
+}
+
+Ptr<WsnAggregator>
+WsnNwkProtocol::GetAggregator()
+{
+  if(m_aggregator == 0)
+  {
+    m_aggregator = CreateObject<WsnFedAvgAggregator>();
   }
+  return m_aggregator;
 }
 
 void
@@ -10,6 +10,8 @@
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
 #include "ns3/callback.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 
 #include "wsn-address-allocator.h"
 #include "wsn-neighbor-table.h"
@@ -17,10 +19,14 @@
 #include "wsn-nwk-short-address.h"
 #include "wsn-route.h"
 #include "wsn-fedlearning-tag.h"
+#include "wsn-aggregator.h"
+#include "wsn-model-codec.h"
+#include "wsn-training-pool.h"
 #include "wsn-network-pl.h"
 
 #include <utility>
 #include <vector>
+#include <map>
 #include <iostream>
 
 
@@ -41,6 +47,26 @@ class WsnNwkProtocol : public Object
     typedef Callback<void,std::vector<double> > WsnRecvModelCallback;
     typedef Callback<std::vector<double> > WsnGetModelCallback;
 
+    /**
+     * 入网：自己的地址，父节点地址，深度
+     */
+    typedef void (* JoinTracedCallback)(NwkShortAddress self, NwkShortAddress parent, uint8_t depth);
+
+    /**
+     * 网络层收发：包（不含网络层头），源地址，目的地址
+     */
+    typedef void (* PacketTracedCallback)(Ptr<const Packet> packet, NwkShortAddress src, NwkShortAddress dst);
+
+    /**
+     * 聚合：模型个数，总权重，是否是路由器上的部分聚合
+     */
+    typedef void (* AggregateTracedCallback)(uint32_t nModels, double weight, bool partial);
+
+    /**
+     * 一轮结束：轮次，从收到第一个模型到聚合完成的时间，距上一轮结束的时间
+     */
+    typedef void (* RoundTracedCallback)(uint32_t round, Time collect, Time duration);
+
     WsnNwkProtocol();
 
     WsnNwkProtocol(NODE_TYPE type);
@@ -69,6 +95,8 @@ class WsnNwkProtocol : public Object
 
     uint8_t GetDepth();
 
+    DeviceTypes GetDeviceType();
+
     NwkShortAddress GetNwkShortAddress();
 
     Ptr<LrWpanNetDevice> GetLrWpanNetDevice();
@@ -83,6 +111,12 @@ class WsnNwkProtocol : public Object
 
     void JoinRequest(Ptr<WsnNwkProtocol> parents);
 
+    /**
+     * 用已经分配好的地址加入 parents：设置深度、地址、双方的邻居表和 MAC，
+     * 不分配地址也不广播路由更新。WsnHelper::InstallTree 批量建树时使用。
+     */
+    void Join(Ptr<WsnNwkProtocol> parents, NwkShortAddress addr);
+
     void BeaconIndication (MlmeBeaconNotifyIndicationParams params, Ptr<Packet> p);
 
     void DataIndication (McpsDataIndicationParams params, Ptr<Packet> p);
@@ -99,9 +133,77 @@ class WsnNwkProtocol : public Object
 
     void SetGetModelCallBack(WsnGetModelCallback mCb);
 
-    void RecvModel(Ptr<Packet> model);
+    /**
+     * 设置异步训练回调：回调在 WsnTrainingPool 的工作线程上执行，
+     * 经过 ComputeLatency 的仿真时间后把结果发给父节点。
+     * 设置了它以后不再调用 GetModel 回调。
+     */
+    void SetTrainCallBack(WsnGetModelCallback mCb);
+
+    /**
+     * 是否设置了训练回调（同步或异步）
+     */
+    bool IsLearning();
+
+    void RecvModel(Ptr<const WsnModel> model);
+
+    /**
+     * 把训练任务提交到线程池
+     */
+    void StartTraining();
+
+    /**
+     * 仿真时间到了计算延迟，取回训练结果并发送。
+     * 工作线程还没算完时在 WsnTrainingPool::Wait 里阻塞仿真线程，
+     * 阻塞只拖慢仿真的运行，结果交回的仿真时刻仍然是 ComputeLatency 之后
+     */
+    void TrainingDone();
+
+    /**
+     * 发送本地训练好的模型
+     */
+    void SendLocalModel(std::vector<double> model);
 
-    void FvGModel(Ptr<Packet> model);
+    void FvGModel(Ptr<const WsnModel> model);
+
+    Ptr<WsnAggregator> GetAggregator();
+
+    /**
+     * 路由器收到孩子上行的模型，做子树内的部分聚合
+     */
+    void PartialAggregate(Ptr<const WsnModel> model);
+
+    void AddPartialModel(Ptr<const WsnModel> model);
+
+    /**
+     * 把当前的部分聚合结果连同权重发给父节点
+     */
+    void FlushPartialAggregate();
+
+    /**
+     * 路由器每轮需要等待的模型数：孩子个数，加上自己（如果自己也训练）
+     */
+    uint32_t GetSubtreeQuorum();
+
+    /**
+     * 把模型编码并切成帧；没有设置编解码器时帧里是模型按 float64 原样序列化的字节
+     */
+    std::vector<Ptr<Packet> > BuildModelFrames(Ptr<const WsnModel> model);
+
+    void SendModelFrames(NwkShortAddress dst, const std::vector<Ptr<Packet> > &frames, Time delay);
+
+    /**
+     * 按序号记录收到的分片，模型的每个分片都到齐时返回 true 并在 model 里给出模型，
+     * 重复到达的分片不计数。句柄在 WsnModelStore 里找不到时从分片的字节解码
+     */
+    bool IsModelComplete(Ptr<const Packet> p, Ptr<const WsnModel> &model);
+
+    /**
+     * 把按序排好的分片拼起来，用本节点的编解码器解码
+     */
+    Ptr<const WsnModel> DecodeModel(const std::vector<Ptr<const Packet> > &fragments);
+
+    Ptr<WsnModelCodec> GetCodec();
 
     protected:
     
@@ -151,8 +253,62 @@ class WsnNwkProtocol : public Object
     WsnRecvModelCallback m_wsnRecvModelCallback;
 
     WsnGetModelCallback m_wsnGetModelCallback;
+
+    WsnGetModelCallback m_wsnTrainCallback;   // 异步训练回调
+
+    Ptr<WsnTrainingPool::Job> m_training;     // 正在进行的训练
+
+    Time m_computeLatency;    // 本地训练的仿真耗时
+
+    uint32_t m_round;         // 协调器已经完成的轮数
+
+    Time m_roundStart;        // 本轮收到第一个模型的时间
+
+    Time m_roundEnd;          // 上一轮聚合完成的时间
+
+    TracedCallback<NwkShortAddress, NwkShortAddress, uint8_t> m_joinTrace;
+
+    TracedCallback<Ptr<const Packet>, NwkShortAddress, NwkShortAddress> m_txTrace;
+
+    TracedCallback<Ptr<const Packet>, NwkShortAddress, NwkShortAddress> m_rxTrace;
+
+    TracedCallback<uint32_t, double, bool> m_aggregateTrace;
+
+    TracedCallback<uint32_t, Time, Time> m_roundTrace;
     
-    std::vector<double> m_modelFvg;
+    Ptr<WsnAggregator> m_aggregator; // 协调器的聚合器
+
+    uint32_t m_quorum;  // 每轮聚合需要的模型个数
+
+    double m_sampleCount; // 本地样本数，作为本地模型的权重
+
+    bool m_treeRouting;   // 按 Cskip 地址树计算下一跳
+
+    bool m_inNetworkAggregation; // 路由器是否做部分聚合
+
+    Time m_partialAggregationTimeout;
+
+    EventId m_partialTimeout;
+
+    std::string m_codecType;    // 模型编解码器的 TypeId
+
+    Ptr<WsnModelCodec> m_codec;
+
+    uint32_t m_fragmentSize;    // 每个 MAC 帧携带的编码字节数
+
+    Time m_reassemblyTimeout;   // 残缺模型的分片保留多久
+
+    /**
+     * 一个模型的重组状态
+     */
+    struct Reassembly
+    {
+        std::vector<Ptr<const Packet> > fragments;  // 按序号收到的分片，没收到的是 0
+        uint16_t count;                             // 已收到的不同分片数
+        Time start;                                 // 首片时间
+    };
+
+    std::map<uint32_t, Reassembly> m_reassembly; // 句柄 -> 重组状态
 
 };  
 
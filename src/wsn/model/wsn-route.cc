@@ -1,5 +1,6 @@
 #include "wsn-route.h"
 #include <ns3/log.h>
+#include <algorithm>
 
 namespace ns3
 {
@@ -45,36 +46,100 @@ RoutingTable::GetType(void)
 
 RoutingTable::RoutingTable()
 {
-    m_routes.clear();
+    Clear();
+}
+
+uint32_t
+RoutingTable::LowerBound(uint16_t dest) const
+{
+    return std::lower_bound(m_dests.begin(), m_dests.end(), dest) - m_dests.begin();
 }
 
 void 
 RoutingTable::AddRoute(const StaticRoute& route)
 {
-    m_routes[route.GetDestination()] = route.GetNextHop();
+    uint16_t dest = route.GetDestination().GetAddressU16();
+    uint32_t i = LowerBound(dest);
+    if(i < m_dests.size() && m_dests[i] == dest)
+    {
+        m_nextHops[i] = route.GetNextHop();
+        return;
+    }
+    m_dests.insert(m_dests.begin() + i, dest);
+    m_nextHops.insert(m_nextHops.begin() + i, route.GetNextHop());
+}
+
+void
+RoutingTable::AddRoutes(const std::vector<StaticRoute>& routes)
+{
+    // 先追加再整体排序，稳定排序保证重复的目的地址以最后一条为准
+    std::vector<std::pair<uint16_t,NwkShortAddress> > merged;
+    merged.reserve(m_dests.size() + routes.size());
+    for(uint32_t i = 0; i < m_dests.size(); ++i)
+    {
+        merged.push_back(std::make_pair(m_dests[i], m_nextHops[i]));
+    }
+    for(const auto &route : routes)
+    {
+        merged.push_back(std::make_pair(route.GetDestination().GetAddressU16(), route.GetNextHop()));
+    }
+    std::stable_sort(merged.begin(), merged.end(),
+                     [](const std::pair<uint16_t,NwkShortAddress> &a,
+                        const std::pair<uint16_t,NwkShortAddress> &b) { return a.first < b.first; });
+    Clear();
+    m_dests.reserve(merged.size());
+    m_nextHops.reserve(merged.size());
+    for(const auto &route : merged)
+    {
+        if(!m_dests.empty() && m_dests.back() == route.first)
+        {
+            m_nextHops.back() = route.second;
+            continue;
+        }
+        m_dests.push_back(route.first);
+        m_nextHops.push_back(route.second);
+    }
 }
 
 void 
 RoutingTable::RemoveRoute(NwkShortAddress dest)
 {
-    if(m_routes.count(dest)) m_routes.erase(dest);
+    uint32_t i = LowerBound(dest.GetAddressU16());
+    if(i < m_dests.size() && m_dests[i] == dest.GetAddressU16())
+    {
+        m_dests.erase(m_dests.begin() + i);
+        m_nextHops.erase(m_nextHops.begin() + i);
+    }
 }
 
 NwkShortAddress 
-RoutingTable::Lookup(NwkShortAddress dest) 
+RoutingTable::Lookup(NwkShortAddress dest) const
 {
-    if(m_routes.count(dest)) return m_routes[dest];
+    uint32_t i = LowerBound(dest.GetAddressU16());
+    if(i < m_dests.size() && m_dests[i] == dest.GetAddressU16()) return m_nextHops[i];
     else return NwkShortAddress();
 }
 
+uint32_t
+RoutingTable::GetN() const
+{
+    return m_dests.size();
+}
+
+void
+RoutingTable::Clear()
+{
+    m_dests.clear();
+    m_nextHops.clear();
+}
+
 void 
 RoutingTable::Print() const
 {
-    for(std::map<NwkShortAddress,NwkShortAddress>::const_iterator begin = m_routes.begin(); 
-                            begin != m_routes.end(); ++ begin)
+    for(uint32_t i = 0; i < m_dests.size(); ++i)
     {
-        std::cout << begin->first << " " << begin->second << "\n"; 
+        std::cout << NwkShortAddress(m_dests[i]) << " " << m_nextHops[i] << "\n"; 
     }
 }
 
-}
\ No newline at end of file
+}
@@ -3,7 +3,7 @@
 
 #include "ns3/type-id.h"
 #include "wsn-nwk-short-address.h"
-#include <map>
+#include <vector>
 #include <iostream>
 
 
@@ -43,6 +43,8 @@ private:
 
 
 // 路由表类
+// 按目的地址排序的扁平数组，目的地址和下一跳分开存放，
+// 查找时只在连续的目的地址数组上二分
 class RoutingTable {
 public:
     static TypeId GetType(void);
@@ -57,6 +59,12 @@ public:
      */
     void AddRoute(const StaticRoute& route);
 
+    /**
+     * 批量添加静态路由，只排序一次；目的地址重复时后面的覆盖前面的
+     * @param routes 要添加的路由
+     */
+    void AddRoutes(const std::vector<StaticRoute>& routes);
+
     /**
      * 删除一条静态路由
      * @param dest 目的地址
@@ -68,7 +76,14 @@ public:
      * @param dest 目的地址
      * @return 下一跳地址，若不存在则返回无效地址
      */
-    NwkShortAddress Lookup(NwkShortAddress dest);
+    NwkShortAddress Lookup(NwkShortAddress dest) const;
+
+    /**
+     * 路由条数
+     */
+    uint32_t GetN() const;
+
+    void Clear();
 
     /**
      * 打印当前路由表
@@ -76,7 +91,13 @@ public:
     void Print() const;
 
 private:
-    std::map<NwkShortAddress,NwkShortAddress> m_routes;  // 静态路由表
+    /**
+     * 返回第一个不小于 dest 的下标
+     */
+    uint32_t LowerBound(uint16_t dest) const;
+
+    std::vector<uint16_t> m_dests;              // 排好序的目的地址
+    std::vector<NwkShortAddress> m_nextHops;    // 与 m_dests 一一对应的下一跳
 };
 
 }
@@ -0,0 +1,172 @@
+#include "wsn-trace-ring.h"
+#include "wsn-network.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE ("WsnTraceRing");
+
+NS_OBJECT_ENSURE_REGISTERED (WsnTraceRing);
+
+TypeId
+WsnTraceRing::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WsnTraceRing")
+    .SetParent<Object> ()
+    .SetGroupName ("Wsn")
+    .AddConstructor<WsnTraceRing> ()
+    .AddAttribute ("Capacity",
+                   "Number of records kept; older records are overwritten.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&WsnTraceRing::m_capacity),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+WsnTraceRing::WsnTraceRing ()
+  : m_capacity (65536),
+    m_head (0),
+    m_total (0)
+{
+}
+
+WsnTraceRing::~WsnTraceRing ()
+{
+}
+
+void
+WsnTraceRing::Install (Ptr<WsnNwkProtocol> nwk)
+{
+  NS_LOG_FUNCTION (this << nwk);
+  nwk->TraceConnectWithoutContext ("Join", MakeCallback (&WsnTraceRing::Join, this));
+  nwk->TraceConnectWithoutContext ("Tx", MakeCallback (&WsnTraceRing::Tx, this));
+  nwk->TraceConnectWithoutContext ("Rx", MakeCallback (&WsnTraceRing::Rx, this));
+  nwk->TraceConnectWithoutContext ("Aggregate", MakeCallback (&WsnTraceRing::Aggregate, this));
+  nwk->TraceConnectWithoutContext ("RoundComplete", MakeCallback (&WsnTraceRing::Round, this));
+}
+
+void
+WsnTraceRing::Install (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<WsnNwkProtocol> nwk = (*i)->GetObject<WsnNwkProtocol> ();
+      if (nwk != 0)
+        {
+          Install (nwk);
+        }
+    }
+}
+
+WsnTraceRing::Record &
+WsnTraceRing::Next (EventType type)
+{
+  if (m_records.size () != m_capacity)
+    {
+      // 第一次写入时才按 Capacity 分配
+      Clear ();
+      m_records.resize (m_capacity);
+    }
+  Record &record = m_records[m_head];
+  m_head = m_head + 1 == m_capacity ? 0 : m_head + 1;
+  m_total++;
+  record = Record ();
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.node = Simulator::GetContext ();
+  record.type = type;
+  return record;
+}
+
+void
+WsnTraceRing::Join (NwkShortAddress self, NwkShortAddress parent, uint8_t depth)
+{
+  Record &record = Next (JOIN);
+  record.size = depth;
+  record.src = self.GetAddressU16 ();
+  record.dst = parent.GetAddressU16 ();
+}
+
+void
+WsnTraceRing::Tx (Ptr<const Packet> packet, NwkShortAddress src, NwkShortAddress dst)
+{
+  Record &record = Next (TX);
+  record.size = packet->GetSize ();
+  record.src = src.GetAddressU16 ();
+  record.dst = dst.GetAddressU16 ();
+}
+
+void
+WsnTraceRing::Rx (Ptr<const Packet> packet, NwkShortAddress src, NwkShortAddress dst)
+{
+  Record &record = Next (RX);
+  record.size = packet->GetSize ();
+  record.src = src.GetAddressU16 ();
+  record.dst = dst.GetAddressU16 ();
+}
+
+void
+WsnTraceRing::Aggregate (uint32_t nModels, double weight, bool partial)
+{
+  Record &record = Next (AGGREGATE);
+  record.flag = partial;
+  record.count = nModels;
+  record.value[0] = weight;
+}
+
+void
+WsnTraceRing::Round (uint32_t round, Time collect, Time duration)
+{
+  Record &record = Next (ROUND);
+  record.count = round;
+  record.value[0] = collect.GetSeconds ();
+  record.value[1] = duration.GetSeconds ();
+}
+
+uint32_t
+WsnTraceRing::GetN (void) const
+{
+  return m_total < m_records.size () ? m_total : m_records.size ();
+}
+
+const WsnTraceRing::Record &
+WsnTraceRing::Get (uint32_t i) const
+{
+  NS_ASSERT (i < GetN ());
+  // 没有写满时从 0 开始，写满以后最旧的记录在 m_head
+  uint32_t first = m_total < m_records.size () ? 0 : m_head;
+  uint32_t slot = first + i;
+  return m_records[slot >= m_records.size () ? slot - m_records.size () : slot];
+}
+
+uint64_t
+WsnTraceRing::GetOverwritten (void) const
+{
+  return m_total - GetN ();
+}
+
+void
+WsnTraceRing::Clear (void)
+{
+  m_records.clear ();
+  m_head = 0;
+  m_total = 0;
+}
+
+void
+WsnTraceRing::Write (std::ostream &os) const
+{
+  uint32_t n = GetN ();
+  uint32_t first = m_total < m_records.size () ? 0 : m_head;
+  // 环形缓冲最多分成两段连续的内存
+  uint32_t tail = std::min<uint32_t> (n, m_records.size () - first);
+  os.write (reinterpret_cast<const char *> (m_records.data () + first), tail * sizeof (Record));
+  os.write (reinterpret_cast<const char *> (m_records.data ()), (n - tail) * sizeof (Record));
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef WSN_TRACE_RING_H
+#define WSN_TRACE_RING_H
+
+#include <stdint.h>
+#include <vector>
+#include <ostream>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "wsn-nwk-short-address.h"
+
+namespace ns3
+{
+
+class WsnNwkProtocol;
+
+/**
+ * 二进制环形缓冲的事件记录器。
+ *
+ * 连到 WsnNwkProtocol 的 Join/Tx/Rx/Aggregate/RoundComplete trace source 上，
+ * 每个事件写一条定长记录，不做任何格式化；缓冲区满了以后覆盖最旧的记录。
+ * Write 按时间顺序把记录原样写成二进制，离线再解析。
+ * 没有连接记录器时 trace source 没有开销。
+ */
+class WsnTraceRing : public Object
+{
+public:
+    enum EventType
+    {
+        JOIN      = 0,
+        TX        = 1,
+        RX        = 2,
+        AGGREGATE = 3,
+        ROUND     = 4,
+    };
+
+    /**
+     * 一条记录，40 字节
+     */
+    struct Record
+    {
+        int64_t time;       // 仿真时间（纳秒）
+        uint32_t node;      // 事件所在节点（仿真上下文）
+        uint8_t type;       // EventType
+        uint8_t flag;       // AGGREGATE：是否部分聚合
+        uint16_t size;      // TX/RX：包长；JOIN：深度
+        uint16_t src;       // TX/RX：源地址；JOIN：自己的地址
+        uint16_t dst;       // TX/RX：目的地址；JOIN：父节点地址
+        uint32_t count;     // AGGREGATE：模型个数；ROUND：轮次
+        double value[2];    // AGGREGATE：总权重；ROUND：收集时间和整轮时间（秒）
+    };
+
+    static TypeId GetTypeId (void);
+
+    WsnTraceRing ();
+
+    virtual ~WsnTraceRing ();
+
+    /**
+     * 连接一个节点的 trace source
+     */
+    void Install (Ptr<WsnNwkProtocol> nwk);
+
+    /**
+     * 连接所有节点上聚合的 WsnNwkProtocol
+     */
+    void Install (NodeContainer c);
+
+    /**
+     * 缓冲区里的记录数
+     */
+    uint32_t GetN (void) const;
+
+    /**
+     * 第 i 条记录，0 是最旧的
+     */
+    const Record & Get (uint32_t i) const;
+
+    /**
+     * 因为缓冲区满而被覆盖的记录数
+     */
+    uint64_t GetOverwritten (void) const;
+
+    void Clear (void);
+
+    /**
+     * 按时间顺序把所有记录原样写出
+     */
+    void Write (std::ostream &os) const;
+
+private:
+    Record & Next (EventType type);
+
+    void Join (NwkShortAddress self, NwkShortAddress parent, uint8_t depth);
+
+    void Tx (Ptr<const Packet> packet, NwkShortAddress src, NwkShortAddress dst);
+
+    void Rx (Ptr<const Packet> packet, NwkShortAddress src, NwkShortAddress dst);
+
+    void Aggregate (uint32_t nModels, double weight, bool partial);
+
+    void Round (uint32_t round, Time collect, Time duration);
+
+    uint32_t m_capacity;            // 最多保留的记录数
+    std::vector<Record> m_records;
+    uint32_t m_head;                // 下一条记录写的位置
+    uint64_t m_total;               // 写过的记录总数
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include "wsn-training-pool.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE ("WsnTrainingPool");
+
+WsnTrainingPool::Job::Job (TrainCallback train)
+  : m_train (train),
+    m_done (false)
+{
+}
+
+//------------------WsnTrainingPool---------------//
+
+WsnTrainingPool::WsnTrainingPool ()
+#ifdef HAVE_PTHREAD_H
+  : m_nThreads (std::max (1u, std::thread::hardware_concurrency ())),
+#else
+  : m_nThreads (0),
+#endif /* HAVE_PTHREAD_H */
+    m_destroyHooked (false),
+    m_stop (false)
+{
+}
+
+WsnTrainingPool::~WsnTrainingPool ()
+{
+  Stop ();
+  m_jobs.clear ();
+}
+
+void
+WsnTrainingPool::Start (void)
+{
+  m_stop = false;
+#ifdef HAVE_PTHREAD_H
+  while (m_threads.size () < m_nThreads)
+    {
+      m_threads.push_back (std::thread (&WsnTrainingPool::Run, this));
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+WsnTrainingPool::Stop (void)
+{
+#ifdef HAVE_PTHREAD_H
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_queued.notify_all ();
+  for (auto &thread : m_threads)
+    {
+      thread.join ();
+    }
+  m_threads.clear ();
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+WsnTrainingPool::Run (void)
+{
+#ifdef HAVE_PTHREAD_H
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      m_queued.wait (lock, [this] { return m_stop || !m_queue.empty (); });
+      if (m_queue.empty ())
+        {
+          return;
+        }
+      Job *job = m_queue.front ();
+      m_queue.pop_front ();
+      lock.unlock ();
+      std::vector<double> result = job->m_train ();
+      lock.lock ();
+      job->m_result.swap (result);
+      job->m_done = true;
+      m_finished.notify_all ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+Ptr<WsnTrainingPool::Job>
+WsnTrainingPool::Submit (TrainCallback train)
+{
+  Ptr<Job> job = Create<Job> (train);
+  m_jobs.push_back (job);
+  if (!m_destroyHooked)
+    {
+      Simulator::ScheduleDestroy (&WsnTrainingPool::Drain, this);
+      m_destroyHooked = true;
+    }
+  if (m_nThreads == 0)
+    {
+      return job;
+    }
+#ifdef HAVE_PTHREAD_H
+  Start ();
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_queue.push_back (PeekPointer (job));
+  }
+  m_queued.notify_one ();
+  NS_LOG_FUNCTION (this << job << m_queue.size ());
+#endif /* HAVE_PTHREAD_H */
+  return job;
+}
+
+std::vector<double>
+WsnTrainingPool::Wait (Ptr<Job> job)
+{
+  NS_LOG_FUNCTION (this << job);
+  std::vector<double> result;
+  if (m_nThreads == 0 && !job->m_done)
+    {
+      // 没有工作线程，在这里同步训练
+      job->m_result = job->m_train ();
+      job->m_done = true;
+    }
+#ifdef HAVE_PTHREAD_H
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_finished.wait (lock, [job] { return job->m_done; });
+    result.swap (job->m_result);
+  }
+#else
+  result.swap (job->m_result);
+#endif /* HAVE_PTHREAD_H */
+  m_jobs.remove (job);
+  return result;
+}
+
+void
+WsnTrainingPool::SetThreads (uint32_t n)
+{
+  // 改线程数之前先把已经提交的任务做完
+  Drain ();
+  Stop ();
+#ifndef HAVE_PTHREAD_H
+  if (n != 0)
+    {
+      NS_LOG_WARN ("Built without pthread, training runs synchronously in Wait");
+      n = 0;
+    }
+#endif /* HAVE_PTHREAD_H */
+  m_nThreads = n;
+}
+
+uint32_t
+WsnTrainingPool::GetThreads (void) const
+{
+  return m_nThreads;
+}
+
+uint32_t
+WsnTrainingPool::GetN (void) const
+{
+  return m_jobs.size ();
+}
+
+void
+WsnTrainingPool::Drain (void)
+{
+  while (!m_jobs.empty ())
+    {
+      Wait (m_jobs.front ());
+    }
+  m_destroyHooked = false;
+}
+
+}
@@ -0,0 +1,122 @@
+#ifndef WSN_TRAINING_POOL_H
+#define WSN_TRAINING_POOL_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <list>
+
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif /* HAVE_PTHREAD_H */
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/singleton.h"
+#include "ns3/callback.h"
+#include "ns3/ptr.h"
+
+namespace ns3
+{
+
+/**
+ * 本地训练线程池。
+ *
+ * 节点把训练任务交给池子以后仿真继续往下跑，训练在工作线程上并行执行；
+ * 节点在仿真时间到了计算延迟时再用 Wait 取结果，只有工作线程还没算完时才会阻塞。
+ * 结果交回仿真的时刻只由仿真时间决定，与线程调度无关，所以仿真结果可复现。
+ *
+ * 训练回调在工作线程上执行，不能调用 Simulator 或修改节点状态。
+ * Job 的引用计数只在主线程上操作，工作线程只持有裸指针。
+ *
+ * 没有 pthread 时（waf 没有打开 ENABLE_THREADING）不起工作线程，
+ * 所有任务都在 Wait 里同步执行。
+ */
+class WsnTrainingPool : public Singleton<WsnTrainingPool>
+{
+public:
+    typedef Callback<std::vector<double> > TrainCallback;
+
+    /**
+     * 一次训练任务
+     */
+    class Job : public SimpleRefCount<Job>
+    {
+    public:
+        Job (TrainCallback train);
+    private:
+        friend class WsnTrainingPool;
+        TrainCallback m_train;
+        std::vector<double> m_result;
+        bool m_done;               // 受 WsnTrainingPool::m_mutex 保护
+    };
+
+    ~WsnTrainingPool ();
+
+    /**
+     * 提交训练任务，立刻返回
+     */
+    Ptr<Job> Submit (TrainCallback train);
+
+    /**
+     * 等待任务完成并取出训练结果。
+     * 在调用线程（仿真线程）上阻塞到工作线程算完；没有工作线程时在这里同步训练
+     */
+    std::vector<double> Wait (Ptr<Job> job);
+
+    /**
+     * 设置工作线程个数，0 表示在 Wait 里同步执行；
+     * 默认是硬件线程数，没有 pthread 时总是 0
+     */
+    void SetThreads (uint32_t n);
+
+    uint32_t GetThreads (void) const;
+
+    /**
+     * 未取走结果的任务个数
+     */
+    uint32_t GetN (void) const;
+
+    /**
+     * 等待所有任务完成并丢弃结果，仿真结束时自动调用
+     */
+    void Drain (void);
+
+private:
+
+    friend class Singleton<WsnTrainingPool>;
+
+    WsnTrainingPool ();
+
+    void Start (void);
+
+    void Stop (void);
+
+    void Run (void);
+
+    uint32_t m_nThreads;                 // 工作线程个数
+
+    bool m_destroyHooked;                // 是否已经挂上 Simulator::Destroy
+
+    bool m_stop;                         // 通知工作线程退出
+
+    std::deque<Job *> m_queue;           // 还没开始的任务
+
+    std::list<Ptr<Job> > m_jobs;         // 未取走结果的任务，保证 Job 活到完成
+
+#ifdef HAVE_PTHREAD_H
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_queued;    // 有新任务
+
+    std::condition_variable m_finished;  // 有任务完成
+#endif /* HAVE_PTHREAD_H */
+};
+
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/pointer.h>
+#include <ns3/wsn-aggregator.h>
+#include <ns3/wsn-network.h>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * 三个参数的测试模型
+ */
+Ptr<WsnModel>
+MakeModel (double a, double b, double c, double weight)
+{
+  std::vector<double> params;
+  params.push_back (a);
+  params.push_back (b);
+  params.push_back (c);
+  return Create<WsnModel> (std::move (params), weight);
+}
+
+} // unnamed namespace
+
+/**
+ * FedAvg：加权和不加权的平均，Kahan 求和的精度
+ */
+class WsnFedAvgAggregatorTestCase : public TestCase
+{
+public:
+  WsnFedAvgAggregatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnFedAvgAggregatorTestCase::WsnFedAvgAggregatorTestCase ()
+  : TestCase ("FedAvg averages with and without sample weights")
+{
+}
+
+void
+WsnFedAvgAggregatorTestCase::DoRun (void)
+{
+  Ptr<WsnFedAvgAggregator> aggregator = CreateObject<WsnFedAvgAggregator> ();
+  aggregator->Add (MakeModel (1, 2, 3, 1));
+  aggregator->Add (MakeModel (3, 6, 9, 3));
+  // 长度不一致的模型被丢掉
+  aggregator->Add (Create<WsnModel> (std::vector<double> (5, 100.0), 10));
+  NS_TEST_EXPECT_MSG_EQ (aggregator->GetN (), 2, "Model of another size aggregated");
+  NS_TEST_EXPECT_MSG_EQ (aggregator->GetTotalWeight (), 4, "Wrong total weight");
+  Ptr<WsnModel> result = aggregator->Aggregate ();
+  NS_TEST_ASSERT_MSG_EQ (result->GetSize (), 3, "Wrong result size");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[0], 2.5, "Wrong weighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], 5.0, "Wrong weighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[2], 7.5, "Wrong weighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->GetWeight (), 4, "Result does not carry the total weight");
+  NS_TEST_EXPECT_MSG_EQ (aggregator->GetN (), 0, "Not reset after Aggregate");
+
+  // 不加权：算术平均，结果的权重仍然是权重之和
+  aggregator->SetAttribute ("Weighted", BooleanValue (false));
+  aggregator->Add (MakeModel (1, 2, 3, 1));
+  aggregator->Add (MakeModel (3, 6, 9, 3));
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[0], 2.0, "Wrong unweighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], 4.0, "Wrong unweighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[2], 6.0, "Wrong unweighted average");
+  NS_TEST_EXPECT_MSG_EQ (result->GetWeight (), 4, "Result does not carry the total weight");
+
+  // 1000 个 0.1 直接累加的误差约 1.4e-15，补偿求和以后在一个 ulp 以内
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      aggregator->Add (MakeModel (0.1, -0.1, 0.1, 1));
+    }
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[0], 0.1, 2e-17, "Compensated sum lost precision");
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[1], -0.1, 2e-17, "Compensated sum lost precision");
+
+  // 没有模型时结果为空
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (result->GetSize (), 0, "Result of no model is not empty");
+  NS_TEST_EXPECT_MSG_EQ (result->GetWeight (), 0, "Result of no model has a weight");
+  aggregator->Dispose ();
+}
+
+/**
+ * 中位数：奇数个取中间值，偶数个取中间两个的平均
+ */
+class WsnMedianAggregatorTestCase : public TestCase
+{
+public:
+  WsnMedianAggregatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnMedianAggregatorTestCase::WsnMedianAggregatorTestCase ()
+  : TestCase ("Coordinate-wise median of odd and even numbers of models")
+{
+}
+
+void
+WsnMedianAggregatorTestCase::DoRun (void)
+{
+  Ptr<WsnMedianAggregator> aggregator = CreateObject<WsnMedianAggregator> ();
+  aggregator->Add (MakeModel (5, -1, 0, 1));
+  aggregator->Add (MakeModel (1, -7, 0, 1));
+  aggregator->Add (MakeModel (3, 100, 0, 1));
+  Ptr<WsnModel> result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[0], 3, "Wrong odd median");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], -1, "Wrong odd median");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[2], 0, "Wrong odd median");
+  NS_TEST_EXPECT_MSG_EQ (result->GetWeight (), 3, "Wrong weight");
+
+  aggregator->Add (MakeModel (4, 1e9, -2, 1));
+  aggregator->Add (MakeModel (1, 0, -2, 1));
+  aggregator->Add (MakeModel (3, 1, 8, 1));
+  aggregator->Add (MakeModel (2, -1e9, -4, 1));
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[0], 2.5, "Wrong even median");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], 0.5, "Outliers moved the even median");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[2], -2, "Wrong even median");
+
+  // 一个模型的中位数就是它自己
+  aggregator->Add (MakeModel (1, 2, 3, 1));
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], 2, "Wrong median of one model");
+
+  // 跨过转置块的边界
+  for (uint32_t j = 0; j < 5; ++j)
+    {
+      std::vector<double> params (200);
+      for (uint32_t i = 0; i < params.size (); ++i)
+        {
+          params[i] = i + (j == 2 ? 0.0 : (j < 2 ? -1.0 : 1.0) * (j + 1));
+        }
+      aggregator->Add (Create<WsnModel> (std::move (params), 1));
+    }
+  result = aggregator->Aggregate ();
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (result->Get ()[i], i, "Wrong median of coordinate " << i);
+    }
+  aggregator->Dispose ();
+}
+
+/**
+ * 截尾均值：去掉 0 个时是平均，比例达到一半时只剩中间的值
+ */
+class WsnTrimmedMeanAggregatorTestCase : public TestCase
+{
+public:
+  WsnTrimmedMeanAggregatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * 对五个模型求截尾均值
+   * \param trim 截尾比例
+   * \return 聚合结果
+   */
+  Ptr<WsnModel> Aggregate (double trim);
+};
+
+WsnTrimmedMeanAggregatorTestCase::WsnTrimmedMeanAggregatorTestCase ()
+  : TestCase ("Trimmed mean with nothing, some and everything trimmed")
+{
+}
+
+Ptr<WsnModel>
+WsnTrimmedMeanAggregatorTestCase::Aggregate (double trim)
+{
+  Ptr<WsnTrimmedMeanAggregator> aggregator = CreateObject<WsnTrimmedMeanAggregator> ();
+  aggregator->SetAttribute ("TrimFraction", DoubleValue (trim));
+  aggregator->Add (MakeModel (10, 1, -3, 1));
+  aggregator->Add (MakeModel (1000, 2, -3, 1));
+  aggregator->Add (MakeModel (20, 3, 5, 1));
+  aggregator->Add (MakeModel (-1000, 4, 5, 1));
+  aggregator->Add (MakeModel (30, 5, 6, 1));
+  Ptr<WsnModel> result = aggregator->Aggregate ();
+  aggregator->Dispose ();
+  return result;
+}
+
+void
+WsnTrimmedMeanAggregatorTestCase::DoRun (void)
+{
+  // 什么都不去掉：算术平均
+  Ptr<WsnModel> result = Aggregate (0.0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[0], 12, 1e-12, "Wrong untrimmed mean");
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[1], 3, 1e-12, "Wrong untrimmed mean");
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[2], 2, 1e-12, "Wrong untrimmed mean");
+
+  // 比例不到一个值：什么都不去掉
+  result = Aggregate (0.19);
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[0], 12, 1e-12, "Fraction below one value trimmed");
+
+  // 两端各去掉一个
+  result = Aggregate (0.2);
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[0], 20, 1e-12, "Outliers not trimmed");
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[1], 3, 1e-12, "Wrong trimmed mean");
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[2], 7.0 / 3, 1e-12, "Wrong trimmed mean");
+
+  // 比例为一半：只剩中间的值，即中位数
+  result = Aggregate (0.5);
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[0], 20, "Everything trimmed");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[1], 3, "Everything trimmed");
+  NS_TEST_EXPECT_MSG_EQ (result->Get ()[2], 5, "Everything trimmed");
+  NS_TEST_EXPECT_MSG_EQ (result->GetWeight (), 5, "Wrong weight");
+
+  // 偶数个值时一半的比例会去掉所有值：保留中间的两个
+  Ptr<WsnTrimmedMeanAggregator> aggregator = CreateObject<WsnTrimmedMeanAggregator> ();
+  aggregator->SetAttribute ("TrimFraction", DoubleValue (0.5));
+  aggregator->Add (MakeModel (10, 0, 0, 1));
+  aggregator->Add (MakeModel (1000, 0, 0, 1));
+  aggregator->Add (MakeModel (20, 0, 0, 1));
+  aggregator->Add (MakeModel (30, 0, 0, 1));
+  result = aggregator->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (result->Get ()[0], 25, 1e-12, "Everything trimmed");
+  aggregator->Dispose ();
+}
+
+/**
+ * 协调器的 Quorum：0 不合法，1 时每个模型单独聚合
+ */
+class WsnQuorumTestCase : public TestCase
+{
+public:
+  WsnQuorumTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Aggregate trace
+   * \param nModels 模型个数
+   * \param weight 总权重
+   * \param partial 是否是部分聚合
+   */
+  void Aggregated (uint32_t nModels, double weight, bool partial);
+
+  std::vector<uint32_t> m_aggregated;  //!< 每次聚合的模型个数
+};
+
+WsnQuorumTestCase::WsnQuorumTestCase ()
+  : TestCase ("Coordinator quorum of 0 and 1")
+{
+}
+
+void
+WsnQuorumTestCase::Aggregated (uint32_t nModels, double weight, bool partial)
+{
+  m_aggregated.push_back (nModels);
+}
+
+void
+WsnQuorumTestCase::DoRun (void)
+{
+  Ptr<WsnNwkProtocol> coordinator = CreateObject<WsnNwkProtocol> ();
+  coordinator->SetNodeType (NODE_TYPE::COOR);
+  coordinator->TraceConnectWithoutContext ("Aggregate", MakeCallback (&WsnQuorumTestCase::Aggregated, this));
+
+  NS_TEST_EXPECT_MSG_EQ (coordinator->SetAttributeFailSafe ("Quorum", UintegerValue (0)), false,
+                         "Quorum of 0 accepted");
+
+  // 1：每收到一个模型就是一轮
+  coordinator->SetAttribute ("Quorum", UintegerValue (1));
+  coordinator->FvGModel (MakeModel (1, 2, 3, 2));
+  coordinator->FvGModel (MakeModel (4, 5, 6, 3));
+  NS_TEST_ASSERT_MSG_EQ (m_aggregated.size (), 2, "Not one round per model");
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated[0], 1, "Round of more than one model");
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated[1], 1, "Round of more than one model");
+  NS_TEST_EXPECT_MSG_EQ (coordinator->GetAggregator ()->GetN (), 0, "Model left in the aggregator");
+
+  // 2：两个模型一轮
+  m_aggregated.clear ();
+  coordinator->SetAttribute ("Quorum", UintegerValue (2));
+  coordinator->FvGModel (MakeModel (1, 2, 3, 2));
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated.size (), 0, "Aggregated below the quorum");
+  coordinator->FvGModel (MakeModel (4, 5, 6, 3));
+  NS_TEST_ASSERT_MSG_EQ (m_aggregated.size (), 1, "Not aggregated at the quorum");
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated[0], 2, "Wrong number of models");
+
+  coordinator->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 聚合器的测试集
+ */
+class WsnAggregatorTestSuite : public TestSuite
+{
+public:
+  WsnAggregatorTestSuite ();
+};
+
+WsnAggregatorTestSuite::WsnAggregatorTestSuite ()
+  : TestSuite ("wsn-aggregator", UNIT)
+{
+  AddTestCase (new WsnFedAvgAggregatorTestCase, TestCase::QUICK);
+  AddTestCase (new WsnMedianAggregatorTestCase, TestCase::QUICK);
+  AddTestCase (new WsnTrimmedMeanAggregatorTestCase, TestCase::QUICK);
+  AddTestCase (new WsnQuorumTestCase, TestCase::QUICK);
+}
+
+static WsnAggregatorTestSuite g_wsnAggregatorTestSuite;
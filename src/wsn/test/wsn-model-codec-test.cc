@@ -0,0 +1,382 @@
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/packet.h>
+#include <ns3/global-value.h>
+#include <ns3/uinteger.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/string.h>
+#include <ns3/wsn-model-codec.h>
+#include <ns3/wsn-fedlearning-tag.h>
+#include <ns3/wsn-network.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * 测试用的模型：参数在 [-3, 3] 之间，符号和大小都不规则
+ */
+Ptr<WsnModel>
+MakeModel (uint32_t n, double weight)
+{
+  std::vector<double> params (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      params[i] = 3.0 * std::sin (0.7 * i + 0.3) * std::cos (0.05 * i);
+    }
+  return Create<WsnModel> (std::move (params), weight);
+}
+
+/**
+ * 把帧里的字节按顺序拼起来
+ */
+std::vector<uint8_t>
+Concatenate (const std::vector<Ptr<Packet> > &frames)
+{
+  std::vector<uint8_t> buffer;
+  for (uint32_t i = 0; i < frames.size (); ++i)
+    {
+      uint32_t offset = buffer.size ();
+      buffer.resize (offset + frames[i]->GetSize ());
+      frames[i]->CopyData (buffer.data () + offset, frames[i]->GetSize ());
+    }
+  return buffer;
+}
+
+} // unnamed namespace
+
+/**
+ * 编解码器往返：解码结果和原模型的误差在每种编码的理论界以内
+ */
+class WsnCodecRoundTripTestCase : public TestCase
+{
+public:
+  WsnCodecRoundTripTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * 编码再解码
+   * \param codec 编解码器
+   * \param model 模型
+   * \param size 编码后的字节数
+   * \return 解码出来的模型
+   */
+  Ptr<WsnModel> RoundTrip (Ptr<WsnModelCodec> codec, Ptr<const WsnModel> model, uint32_t &size);
+
+  /**
+   * 检查线性量化的误差不超过半个量化间隔
+   * \param codec 编解码器
+   * \param model 模型
+   * \param levels 量化级数
+   * \param lo 参数的下界
+   * \param hi 参数的上界
+   */
+  void CheckQuantization (Ptr<WsnModelCodec> codec, Ptr<const WsnModel> model,
+                          double levels, double lo, double hi);
+};
+
+WsnCodecRoundTripTestCase::WsnCodecRoundTripTestCase ()
+  : TestCase ("Model codecs decode within their error bounds")
+{
+}
+
+Ptr<WsnModel>
+WsnCodecRoundTripTestCase::RoundTrip (Ptr<WsnModelCodec> codec, Ptr<const WsnModel> model, uint32_t &size)
+{
+  std::vector<uint8_t> buffer;
+  codec->Encode (model, buffer);
+  size = buffer.size ();
+  Ptr<WsnModel> decoded = codec->Decode (buffer);
+  NS_TEST_EXPECT_MSG_EQ (decoded->GetSize (), model->GetSize (), "Wrong number of parameters");
+  NS_TEST_EXPECT_MSG_EQ (decoded->GetWeight (), model->GetWeight (), "Wrong weight");
+  return decoded;
+}
+
+void
+WsnCodecRoundTripTestCase::CheckQuantization (Ptr<WsnModelCodec> codec, Ptr<const WsnModel> model,
+                                              double levels, double lo, double hi)
+{
+  uint32_t size;
+  Ptr<WsnModel> decoded = RoundTrip (codec, model, size);
+  double bound = (hi - lo) / levels / 2 + 1e-12;
+  double worst = 0;
+  for (uint32_t i = 0; i < model->GetSize (); ++i)
+    {
+      worst = std::max (worst, std::fabs (decoded->Get ()[i] - model->Get ()[i]));
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (worst, bound, "Quantization error above half a step, " << levels << " levels");
+}
+
+void
+WsnCodecRoundTripTestCase::DoRun (void)
+{
+  const uint32_t n = 1000;
+  Ptr<WsnModel> model = MakeModel (n, 7.0);
+  double lo = *std::min_element (model->Get ().begin (), model->Get ().end ());
+  double hi = *std::max_element (model->Get ().begin (), model->Get ().end ());
+  uint32_t size;
+
+  // 原样编码：逐位相同
+  Ptr<WsnModel> decoded = RoundTrip (CreateObject<WsnRawCodec> (), model, size);
+  NS_TEST_EXPECT_MSG_EQ (size, model->GetSerializedSize (), "Raw encoding is not the serialized size");
+  NS_TEST_EXPECT_MSG_EQ ((decoded->Get () == model->Get ()), true, "Raw encoding is lossy");
+
+  // 线性量化：半个量化间隔
+  Ptr<WsnQuantizationCodec> quantization = CreateObject<WsnQuantizationCodec> ();
+  CheckQuantization (quantization, model, 255.0, lo, hi);
+  RoundTrip (quantization, model, size);
+  NS_TEST_EXPECT_MSG_EQ (size, 12 + 16 + n, "Wrong 8-bit encoded size");
+  quantization->SetAttribute ("Bits", UintegerValue (16));
+  CheckQuantization (quantization, model, 65535.0, lo, hi);
+  RoundTrip (quantization, model, size);
+  NS_TEST_EXPECT_MSG_EQ (size, 12 + 16 + 2 * n, "Wrong 16-bit encoded size");
+
+  // 所有参数相同时没有误差
+  Ptr<WsnModel> flat = Create<WsnModel> (std::vector<double> (10, 0.25), 1.0);
+  decoded = RoundTrip (quantization, flat, size);
+  NS_TEST_EXPECT_MSG_EQ ((decoded->Get () == flat->Get ()), true, "Constant model not exact");
+
+  // Top-k：只保留绝对值最大的 k 个，保留的按 float32 精度，其余为 0
+  Ptr<WsnTopKCodec> topk = CreateObject<WsnTopKCodec> ();
+  topk->SetAttribute ("Ratio", DoubleValue (0.1));
+  topk->SetAttribute ("ErrorFeedback", BooleanValue (false));
+  decoded = RoundTrip (topk, model, size);
+  NS_TEST_EXPECT_MSG_EQ (size, 12 + 4 + 8 * (n / 10), "Wrong top-k encoded size");
+  uint32_t kept = 0;
+  double smallestKept = hi - lo;
+  double largestDropped = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double x = model->Get ()[i];
+      double y = decoded->Get ()[i];
+      if (y != 0)
+        {
+          kept++;
+          smallestKept = std::min (smallestKept, std::fabs (x));
+          NS_TEST_EXPECT_MSG_EQ_TOL (y, x, std::fabs (x) * 1e-7, "Kept parameter " << i << " not float precision");
+        }
+      else
+        {
+          largestDropped = std::max (largestDropped, std::fabs (x));
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (kept, n / 10, "Wrong number of kept parameters");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (largestDropped, smallestKept, "A dropped parameter is larger than a kept one");
+
+  // 误差反馈：没发出去的部分在下一次编码时补上
+  topk = CreateObject<WsnTopKCodec> ();
+  topk->SetAttribute ("Ratio", DoubleValue (0.1));
+  Ptr<WsnModel> first = RoundTrip (topk, model, size);
+  Ptr<WsnModel> zero = Create<WsnModel> (std::vector<double> (n, 0.0), 7.0);
+  Ptr<WsnModel> second = RoundTrip (topk, zero, size);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (second->Get ()[i] != 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (first->Get ()[i], 0, "Residual " << i << " was already sent");
+          NS_TEST_EXPECT_MSG_EQ_TOL (second->Get ()[i], model->Get ()[i], std::fabs (model->Get ()[i]) * 1e-7,
+                                     "Residual " << i << " not carried over");
+        }
+    }
+
+  // 差分编码：误差是差值的半个量化间隔
+  Ptr<WsnModel> reference = MakeModel (n, 1.0);
+  std::vector<double> params (model->Get ());
+  double dlo = 0;
+  double dhi = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      params[i] = reference->Get ()[i] + 0.01 * std::sin (1.3 * i);
+      double delta = params[i] - reference->Get ()[i];
+      dlo = std::min (dlo, delta);
+      dhi = std::max (dhi, delta);
+    }
+  Ptr<WsnModel> update = Create<WsnModel> (params, 3.0);
+  Ptr<WsnDeltaCodec> delta = CreateObject<WsnDeltaCodec> ();
+  delta->SetReference (reference);
+  CheckQuantization (delta, update, 255.0, dlo, dhi);
+  delta->Dispose ();
+}
+
+/**
+ * BuildModelFrames 切出来的帧：大小、分片序号，拼起来就是编码后的模型
+ */
+class WsnModelFramesTestCase : public TestCase
+{
+public:
+  WsnModelFramesTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * 检查帧的大小和分片信息
+   * \param frames 帧
+   * \param size 编码后的总字节数
+   * \param fragmentSize 每帧最多的字节数
+   */
+  void CheckFrames (const std::vector<Ptr<Packet> > &frames, uint32_t size, uint32_t fragmentSize);
+};
+
+WsnModelFramesTestCase::WsnModelFramesTestCase ()
+  : TestCase ("Models are cut into MAC frames carrying the encoded bytes")
+{
+}
+
+void
+WsnModelFramesTestCase::CheckFrames (const std::vector<Ptr<Packet> > &frames, uint32_t size, uint32_t fragmentSize)
+{
+  uint32_t count = (size + fragmentSize - 1) / fragmentSize;
+  NS_TEST_ASSERT_MSG_EQ (frames.size (), count, "Wrong number of frames");
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < frames.size (); ++i)
+    {
+      uint32_t expected = i + 1 < count ? fragmentSize : size - i * fragmentSize;
+      NS_TEST_EXPECT_MSG_EQ (frames[i]->GetSize (), expected, "Wrong size of frame " << i);
+      total += frames[i]->GetSize ();
+      WsnFedTag tag;
+      NS_TEST_ASSERT_MSG_EQ (frames[i]->PeekPacketTag (tag), true, "Frame " << i << " without model tag");
+      NS_TEST_EXPECT_MSG_EQ (tag.GetFragmentIndex (), i, "Wrong fragment index");
+      NS_TEST_EXPECT_MSG_EQ (tag.GetFragmentCount (), count, "Wrong fragment count");
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, size, "Frames do not add up to the encoded model");
+}
+
+void
+WsnModelFramesTestCase::DoRun (void)
+{
+  Ptr<WsnModel> model = MakeModel (1000, 2.0);
+  Ptr<WsnNwkProtocol> protocol = CreateObject<WsnNwkProtocol> ();
+
+  // 不压缩：帧里是模型原样序列化的字节
+  std::vector<Ptr<Packet> > frames = protocol->BuildModelFrames (model);
+  CheckFrames (frames, model->GetSerializedSize (), 90);
+  Ptr<WsnModel> decoded = CreateObject<WsnRawCodec> ()->Decode (Concatenate (frames));
+  NS_TEST_EXPECT_MSG_EQ ((decoded->Get () == model->Get ()), true, "Frames do not carry the model");
+  NS_TEST_EXPECT_MSG_EQ (decoded->GetWeight (), 2.0, "Frames do not carry the weight");
+
+  // 比一帧小的模型只有一帧
+  Ptr<WsnModel> small = MakeModel (5, 1.0);
+  CheckFrames (protocol->BuildModelFrames (small), small->GetSerializedSize (), 90);
+
+  // 压缩：帧里是编码后的字节
+  protocol->SetAttribute ("ModelCodec", StringValue ("ns3::WsnQuantizationCodec"));
+  protocol->SetAttribute ("FragmentSize", UintegerValue (50));
+  frames = protocol->BuildModelFrames (model);
+  std::vector<uint8_t> buffer;
+  CreateObject<WsnQuantizationCodec> ()->Encode (model, buffer);
+  CheckFrames (frames, buffer.size (), 50);
+  NS_TEST_EXPECT_MSG_EQ ((Concatenate (frames) == buffer), true, "Frames do not carry the encoded model");
+
+  protocol->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 分片重组：乱序和重复到达的分片，以及句柄被淘汰以后从字节解码
+ */
+class WsnReassemblyTestCase : public TestCase
+{
+public:
+  WsnReassemblyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnReassemblyTestCase::WsnReassemblyTestCase ()
+  : TestCase ("Models are reassembled once every fragment index arrived")
+{
+}
+
+void
+WsnReassemblyTestCase::DoRun (void)
+{
+  // 4 + 8 + 99 * 8 = 804 字节，9 帧
+  Ptr<WsnModel> model = MakeModel (99, 4.0);
+  Ptr<WsnNwkProtocol> sender = CreateObject<WsnNwkProtocol> ();
+  Ptr<WsnNwkProtocol> receiver = CreateObject<WsnNwkProtocol> ();
+  std::vector<Ptr<Packet> > frames = sender->BuildModelFrames (model);
+  NS_TEST_ASSERT_MSG_EQ (frames.size (), 9, "Unexpected number of frames");
+
+  // 倒序到达，每个分片都重传一次：重复的分片不能凑数
+  Ptr<const WsnModel> received;
+  for (uint32_t i = frames.size () - 1; i > 0; --i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (receiver->IsModelComplete (frames[i], received), false,
+                             "Complete without fragment 0");
+      NS_TEST_EXPECT_MSG_EQ (receiver->IsModelComplete (frames[i]->Copy (), received), false,
+                             "Duplicate of fragment " << i << " completed the model");
+    }
+  NS_TEST_EXPECT_MSG_EQ (received, 0, "Model given out before completion");
+  NS_TEST_EXPECT_MSG_EQ (receiver->IsModelComplete (frames[0], received), true, "Not complete with every fragment");
+  NS_TEST_EXPECT_MSG_EQ (received, model, "The sender's model is not shared");
+
+  // 完成以后状态被清掉，重新开始计数
+  received = 0;
+  NS_TEST_EXPECT_MSG_EQ (receiver->IsModelComplete (frames[0], received), false, "Reassembly not reset");
+
+  // 交错乱序
+  Ptr<WsnModel> other = MakeModel (99, 5.0);
+  std::vector<Ptr<Packet> > otherFrames = sender->BuildModelFrames (other);
+  const uint32_t order[] = {4, 0, 8, 2, 2, 6, 1, 7, 3, 0, 5};
+  const uint32_t nOrder = sizeof (order) / sizeof (order[0]);
+  for (uint32_t i = 0; i < nOrder; ++i)
+    {
+      bool complete = receiver->IsModelComplete (otherFrames[order[i]], received);
+      bool last = i + 1 == nOrder;
+      NS_TEST_EXPECT_MSG_EQ (complete, last,
+                             "Wrong completion after fragment " << order[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (received, other, "Wrong model reassembled");
+
+  // 句柄已经被淘汰：从分片的字节解码
+  GlobalValue::Bind ("WsnModelCacheSize", UintegerValue (0));
+  frames = sender->BuildModelFrames (model);
+  GlobalValue::Bind ("WsnModelCacheSize", UintegerValue (256));
+  received = 0;
+  std::reverse (frames.begin (), frames.end ());
+  for (uint32_t i = 0; i < frames.size (); ++i)
+    {
+      receiver->IsModelComplete (frames[i], received);
+    }
+  NS_TEST_ASSERT_MSG_NE (received, 0, "Model not decoded from the frames");
+  NS_TEST_EXPECT_MSG_NE (received, model, "Evicted model still shared");
+  NS_TEST_EXPECT_MSG_EQ ((received->Get () == model->Get ()), true, "Wrong model decoded");
+  NS_TEST_EXPECT_MSG_EQ (received->GetWeight (), 4.0, "Wrong weight decoded");
+
+  // 单帧的模型直接交付
+  Ptr<WsnModel> small = MakeModel (5, 1.0);
+  frames = sender->BuildModelFrames (small);
+  NS_TEST_EXPECT_MSG_EQ (receiver->IsModelComplete (frames[0], received), true, "Single frame not complete");
+  NS_TEST_EXPECT_MSG_EQ (received, small, "Wrong single frame model");
+
+  sender->Dispose ();
+  receiver->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 模型编解码、分片和重组的测试集
+ */
+class WsnModelCodecTestSuite : public TestSuite
+{
+public:
+  WsnModelCodecTestSuite ();
+};
+
+WsnModelCodecTestSuite::WsnModelCodecTestSuite ()
+  : TestSuite ("wsn-model-codec", UNIT)
+{
+  AddTestCase (new WsnCodecRoundTripTestCase, TestCase::QUICK);
+  AddTestCase (new WsnModelFramesTestCase, TestCase::QUICK);
+  AddTestCase (new WsnReassemblyTestCase, TestCase::QUICK);
+}
+
+static WsnModelCodecTestSuite g_wsnModelCodecTestSuite;
@@ -0,0 +1,265 @@
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/nstime.h>
+#include <ns3/mac64-address.h>
+#include <ns3/wsn-network.h>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * 三个参数的测试模型
+ */
+Ptr<WsnModel>
+MakeModel (double value, double weight)
+{
+  return Create<WsnModel> (std::vector<double> (3, value), weight);
+}
+
+/**
+ * 路由器自己训练出来的模型
+ */
+std::vector<double>
+LocalModel (void)
+{
+  return std::vector<double> (3, 7.0);
+}
+
+/**
+ * 在 protocol 的邻居表里加 n 个孩子
+ */
+void
+AddChildren (Ptr<WsnNwkProtocol> protocol, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      NeighborTable::NeighborEntry child;
+      child.extendedAddr = Mac64Address::Allocate ();
+      child.networkAddr = NwkShortAddress ((uint16_t)(0x100 + i));
+      child.deviceType = DeviceTypes::END_DEVICE;
+      child.relationship = Relationship::CHILD;
+      child.rxOnWhenIdle = true;
+      child.linkQuality = 0;
+      protocol->GetNeighborTable ()->AddNeighborEntry (child);
+    }
+}
+
+/**
+ * 开了子树内部分聚合的路由器
+ */
+Ptr<WsnNwkProtocol>
+MakeRouter (uint32_t nChildren)
+{
+  Ptr<WsnNwkProtocol> router = CreateObject<WsnNwkProtocol> ();
+  router->SetNodeType (NODE_TYPE::ROUTE);
+  router->SetAttribute ("InNetworkAggregation", BooleanValue (true));
+  router->SetAttribute ("PartialAggregationTimeout", TimeValue (Seconds (10)));
+  AddChildren (router, nChildren);
+  return router;
+}
+
+} // unnamed namespace
+
+/**
+ * 子树的 quorum：孩子个数，路由器自己训练时再加一
+ */
+class WsnSubtreeQuorumTestCase : public TestCase
+{
+public:
+  WsnSubtreeQuorumTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnSubtreeQuorumTestCase::WsnSubtreeQuorumTestCase ()
+  : TestCase ("Subtree quorum with and without a training router")
+{
+}
+
+void
+WsnSubtreeQuorumTestCase::DoRun (void)
+{
+  Ptr<WsnNwkProtocol> router = MakeRouter (0);
+  NS_TEST_EXPECT_MSG_EQ (router->GetSubtreeQuorum (), 0, "Leaf router that does not train waits for a model");
+
+  AddChildren (router, 3);
+  // 父节点不算在子树里
+  NeighborTable::NeighborEntry parent;
+  parent.extendedAddr = Mac64Address::Allocate ();
+  parent.networkAddr = NwkShortAddress ((uint16_t)0);
+  parent.deviceType = DeviceTypes::COORDINATOR;
+  parent.relationship = Relationship::PARENT;
+  parent.rxOnWhenIdle = true;
+  parent.linkQuality = 0;
+  router->GetNeighborTable ()->AddNeighborEntry (parent);
+  NS_TEST_EXPECT_MSG_EQ (router->GetSubtreeQuorum (), 3, "Quorum is not the number of children");
+
+  router->SetGetModelCallBack (MakeCallback (&LocalModel));
+  NS_TEST_EXPECT_MSG_EQ (router->IsLearning (), true, "Router with a model callback does not train");
+  NS_TEST_EXPECT_MSG_EQ (router->GetSubtreeQuorum (), 4, "Training router does not count its own model");
+
+  router->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 部分聚合：子树的模型到齐马上转发，路由器自己的模型也并进去
+ */
+class WsnPartialAggregateTestCase : public TestCase
+{
+public:
+  WsnPartialAggregateTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Aggregate trace
+   * \param nModels 模型个数
+   * \param weight 总权重
+   * \param partial 是否是部分聚合
+   */
+  void Aggregated (uint32_t nModels, double weight, bool partial);
+
+  uint32_t m_nAggregates;   //!< 聚合次数
+  uint32_t m_nModels;       //!< 最后一次聚合的模型个数
+  double m_weight;          //!< 最后一次聚合的总权重
+  bool m_partial;           //!< 最后一次聚合是否是部分聚合
+};
+
+WsnPartialAggregateTestCase::WsnPartialAggregateTestCase ()
+  : TestCase ("Router forwards the partial model once the subtree is complete"),
+    m_nAggregates (0),
+    m_nModels (0),
+    m_weight (0),
+    m_partial (false)
+{
+}
+
+void
+WsnPartialAggregateTestCase::Aggregated (uint32_t nModels, double weight, bool partial)
+{
+  ++m_nAggregates;
+  m_nModels = nModels;
+  m_weight = weight;
+  m_partial = partial;
+}
+
+void
+WsnPartialAggregateTestCase::DoRun (void)
+{
+  // 路由器不训练：两个孩子的模型到齐就转发
+  Ptr<WsnNwkProtocol> router = MakeRouter (2);
+  router->TraceConnectWithoutContext ("Aggregate", MakeCallback (&WsnPartialAggregateTestCase::Aggregated, this));
+  router->PartialAggregate (MakeModel (1, 2));
+  NS_TEST_EXPECT_MSG_EQ (m_nAggregates, 0, "Forwarded before the subtree is complete");
+  router->PartialAggregate (MakeModel (4, 3));
+  NS_TEST_ASSERT_MSG_EQ (m_nAggregates, 1, "Not forwarded once the subtree is complete");
+  NS_TEST_EXPECT_MSG_EQ (m_nModels, 2, "Wrong number of models in the partial");
+  NS_TEST_EXPECT_MSG_EQ (m_weight, 5, "Partial does not carry the subtree weight");
+  NS_TEST_EXPECT_MSG_EQ (m_partial, true, "Router aggregate not marked partial");
+  NS_TEST_EXPECT_MSG_EQ (router->GetAggregator ()->GetN (), 0, "Model left in the aggregator");
+
+  // 没有模型时 flush 什么也不做
+  router->FlushPartialAggregate ();
+  NS_TEST_EXPECT_MSG_EQ (m_nAggregates, 1, "Empty partial forwarded");
+  router->Dispose ();
+  // 转发的帧在 t=0 排队，没有 MAC，不跑仿真直接丢掉
+  Simulator::Destroy ();
+
+  // 路由器也训练：一个孩子加自己
+  m_nAggregates = 0;
+  router = MakeRouter (1);
+  router->SetAttribute ("SampleCount", DoubleValue (4));
+  router->SetGetModelCallBack (MakeCallback (&LocalModel));
+  router->TraceConnectWithoutContext ("Aggregate", MakeCallback (&WsnPartialAggregateTestCase::Aggregated, this));
+  router->PartialAggregate (MakeModel (1, 2));
+  NS_TEST_EXPECT_MSG_EQ (m_nAggregates, 0, "Forwarded without the router's own model");
+  router->SendLocalModel (LocalModel ());
+  NS_TEST_ASSERT_MSG_EQ (m_nAggregates, 1, "Own model does not complete the subtree");
+  NS_TEST_EXPECT_MSG_EQ (m_nModels, 2, "Wrong number of models in the partial");
+  NS_TEST_EXPECT_MSG_EQ (m_weight, 6, "Own sample count not added to the subtree weight");
+
+  router->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 有孩子一直不交模型时，超时以后转发已经收到的部分
+ */
+class WsnPartialAggregateTimeoutTestCase : public TestCase
+{
+public:
+  WsnPartialAggregateTimeoutTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Aggregate trace
+   * \param nModels 模型个数
+   * \param weight 总权重
+   * \param partial 是否是部分聚合
+   */
+  void Aggregated (uint32_t nModels, double weight, bool partial);
+
+  std::vector<uint32_t> m_aggregated;  //!< 每次聚合的模型个数
+  std::vector<Time> m_times;           //!< 每次聚合的时间
+};
+
+WsnPartialAggregateTimeoutTestCase::WsnPartialAggregateTimeoutTestCase ()
+  : TestCase ("Router forwards an incomplete subtree after the timeout")
+{
+}
+
+void
+WsnPartialAggregateTimeoutTestCase::Aggregated (uint32_t nModels, double weight, bool partial)
+{
+  m_aggregated.push_back (nModels);
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+WsnPartialAggregateTimeoutTestCase::DoRun (void)
+{
+  Ptr<WsnNwkProtocol> router = MakeRouter (3);
+  router->TraceConnectWithoutContext ("Aggregate", MakeCallback (&WsnPartialAggregateTimeoutTestCase::Aggregated, this));
+  router->PartialAggregate (MakeModel (1, 1));
+  router->PartialAggregate (MakeModel (2, 1));
+
+  // 超时事件排在 Stop 之前，转发帧的 Send 排在 Stop 之后，不会跑到没有 MAC 的发送
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated.size (), 0, "Forwarded before the timeout");
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_aggregated.size (), 1, "Not forwarded at the timeout");
+  NS_TEST_EXPECT_MSG_EQ (m_aggregated[0], 2, "Wrong number of models in the partial");
+  NS_TEST_EXPECT_MSG_EQ (m_times[0], Seconds (10), "Timeout not measured from the first model");
+  NS_TEST_EXPECT_MSG_EQ (router->GetAggregator ()->GetN (), 0, "Model left in the aggregator");
+  router->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * 路由器子树内部分聚合的测试集
+ */
+class WsnPartialAggregationTestSuite : public TestSuite
+{
+public:
+  WsnPartialAggregationTestSuite ();
+};
+
+WsnPartialAggregationTestSuite::WsnPartialAggregationTestSuite ()
+  : TestSuite ("wsn-partial-aggregation", UNIT)
+{
+  AddTestCase (new WsnSubtreeQuorumTestCase, TestCase::QUICK);
+  AddTestCase (new WsnPartialAggregateTestCase, TestCase::QUICK);
+  AddTestCase (new WsnPartialAggregateTimeoutTestCase, TestCase::QUICK);
+}
+
+static WsnPartialAggregationTestSuite g_wsnPartialAggregationTestSuite;
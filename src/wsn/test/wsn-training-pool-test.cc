@@ -0,0 +1,209 @@
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/nstime.h>
+#include <ns3/mac64-address.h>
+#include <ns3/core-config.h>
+#include <ns3/wsn-network.h>
+#include <ns3/wsn-training-pool.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <thread>
+#include <chrono>
+#endif /* HAVE_PTHREAD_H */
+
+using namespace ns3;
+
+/**
+ * StartTraining 和 TrainingDone 的顺序：训练结果只在 ComputeLatency 之后交回，
+ * 和工作线程哪个先算完无关
+ */
+class WsnTrainingOrderTestCase : public TestCase
+{
+public:
+  WsnTrainingOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * 慢的训练回调，在工作线程上执行
+   * \return 训练出来的模型
+   */
+  std::vector<double> TrainSlow (void);
+
+  /**
+   * 马上返回的训练回调
+   * \return 训练出来的模型
+   */
+  std::vector<double> TrainFast (void);
+
+  /**
+   * 记录两个路由器的聚合器里各有几个模型
+   */
+  void Check (void);
+
+  /**
+   * 路由器有一个孩子，自己也训练，子树的 quorum 是 2，
+   * 自己的模型交回以后留在聚合器里等孩子
+   * \param latency 计算延迟
+   * \param samples 本地样本数
+   * \param train 训练回调
+   * \return 路由器
+   */
+  Ptr<WsnNwkProtocol> MakeRouter (Time latency, double samples,
+                                  Callback<std::vector<double> > train);
+
+  Ptr<WsnNwkProtocol> m_slow;                  //!< 训练慢、计算延迟短的路由器
+  Ptr<WsnNwkProtocol> m_fast;                  //!< 训练快、计算延迟长的路由器
+  uint32_t m_nSlow;                            //!< 慢回调的调用次数
+  uint32_t m_nFast;                            //!< 快回调的调用次数
+  bool m_onWorker;                             //!< 慢回调是否在工作线程上执行
+  std::vector<std::pair<uint32_t, uint32_t> > m_checks;  //!< 每次检查时两个聚合器里的模型数
+#ifdef HAVE_PTHREAD_H
+  std::thread::id m_main;                      //!< 仿真线程
+#endif /* HAVE_PTHREAD_H */
+};
+
+WsnTrainingOrderTestCase::WsnTrainingOrderTestCase ()
+  : TestCase ("Training results are delivered after the compute latency"),
+    m_nSlow (0),
+    m_nFast (0),
+    m_onWorker (false)
+{
+}
+
+std::vector<double>
+WsnTrainingOrderTestCase::TrainSlow (void)
+{
+  ++m_nSlow;
+#ifdef HAVE_PTHREAD_H
+  m_onWorker = std::this_thread::get_id () != m_main;
+  std::this_thread::sleep_for (std::chrono::milliseconds (20));
+#endif /* HAVE_PTHREAD_H */
+  return std::vector<double> (3, 1.0);
+}
+
+std::vector<double>
+WsnTrainingOrderTestCase::TrainFast (void)
+{
+  ++m_nFast;
+  return std::vector<double> (3, 2.0);
+}
+
+void
+WsnTrainingOrderTestCase::Check (void)
+{
+  m_checks.push_back (std::make_pair (m_slow->GetAggregator ()->GetN (),
+                                      m_fast->GetAggregator ()->GetN ()));
+}
+
+Ptr<WsnNwkProtocol>
+WsnTrainingOrderTestCase::MakeRouter (Time latency, double samples,
+                                      Callback<std::vector<double> > train)
+{
+  Ptr<WsnNwkProtocol> router = CreateObject<WsnNwkProtocol> ();
+  router->SetNodeType (NODE_TYPE::ROUTE);
+  router->SetAttribute ("InNetworkAggregation", BooleanValue (true));
+  router->SetAttribute ("ComputeLatency", TimeValue (latency));
+  router->SetAttribute ("SampleCount", DoubleValue (samples));
+  router->SetTrainCallBack (train);
+  NeighborTable::NeighborEntry child;
+  child.extendedAddr = Mac64Address::Allocate ();
+  child.networkAddr = NwkShortAddress ((uint16_t)0x100);
+  child.deviceType = DeviceTypes::END_DEVICE;
+  child.relationship = Relationship::CHILD;
+  child.rxOnWhenIdle = true;
+  child.linkQuality = 0;
+  router->GetNeighborTable ()->AddNeighborEntry (child);
+  return router;
+}
+
+void
+WsnTrainingOrderTestCase::DoRun (void)
+{
+  WsnTrainingPool *pool = WsnTrainingPool::Get ();
+  uint32_t nThreads = pool->GetThreads ();
+#ifdef HAVE_PTHREAD_H
+  m_main = std::this_thread::get_id ();
+  pool->SetThreads (2);
+#endif /* HAVE_PTHREAD_H */
+
+  m_slow = MakeRouter (Seconds (1), 3, MakeCallback (&WsnTrainingOrderTestCase::TrainSlow, this));
+  m_fast = MakeRouter (Seconds (2), 5, MakeCallback (&WsnTrainingOrderTestCase::TrainFast, this));
+  m_slow->GetModel ();
+  m_fast->GetModel ();
+  NS_TEST_EXPECT_MSG_EQ (pool->GetN (), 2, "Training not submitted to the pool");
+  // 训练还没交回时再开始一次不会重复提交
+  m_slow->StartTraining ();
+  NS_TEST_EXPECT_MSG_EQ (pool->GetN (), 2, "Training submitted twice");
+
+  Simulator::Schedule (Seconds (0.5), &WsnTrainingOrderTestCase::Check, this);
+  Simulator::Schedule (Seconds (1.5), &WsnTrainingOrderTestCase::Check, this);
+  Simulator::Schedule (Seconds (2.5), &WsnTrainingOrderTestCase::Check, this);
+  // 子树没到齐，部分聚合的超时在 11 s 以后，不会发帧
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_checks.size (), 3, "Checks did not run");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[0].first, 0, "Slow result delivered before its compute latency");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[0].second, 0, "Fast result delivered before its compute latency");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[1].first, 1, "Slow result not delivered at its compute latency");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[1].second, 0, "Fast result delivered before its compute latency");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[2].first, 1, "Slow result delivered twice");
+  NS_TEST_EXPECT_MSG_EQ (m_checks[2].second, 1, "Fast result not delivered at its compute latency");
+  NS_TEST_EXPECT_MSG_EQ (m_nSlow, 1, "Slow training ran more than once");
+  NS_TEST_EXPECT_MSG_EQ (m_nFast, 1, "Fast training ran more than once");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetN (), 0, "Result left in the pool");
+#ifdef HAVE_PTHREAD_H
+  NS_TEST_EXPECT_MSG_EQ (m_onWorker, true, "Training ran on the simulation thread");
+#endif /* HAVE_PTHREAD_H */
+
+  Ptr<WsnModel> local = m_slow->GetAggregator ()->Aggregate ();
+  NS_TEST_EXPECT_MSG_EQ (local->Get ()[0], 1.0, "Wrong trained model");
+  NS_TEST_EXPECT_MSG_EQ (local->GetWeight (), 3, "Trained model not weighted by SampleCount");
+
+  m_slow->Dispose ();
+  m_fast->Dispose ();
+  m_slow = 0;
+  m_fast = 0;
+  Simulator::Destroy ();
+
+  // 没有工作线程：训练在 TrainingDone 的 Wait 里同步执行
+  pool->SetThreads (0);
+  m_nSlow = 0;
+  m_onWorker = true;
+  m_slow = MakeRouter (Seconds (1), 3, MakeCallback (&WsnTrainingOrderTestCase::TrainSlow, this));
+  m_slow->StartTraining ();
+  NS_TEST_EXPECT_MSG_EQ (m_nSlow, 0, "Synchronous training ran before the compute latency");
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nSlow, 1, "Synchronous training did not run");
+  NS_TEST_EXPECT_MSG_EQ (m_slow->GetAggregator ()->GetN (), 1, "Synchronous result not delivered");
+#ifdef HAVE_PTHREAD_H
+  NS_TEST_EXPECT_MSG_EQ (m_onWorker, false, "Synchronous training ran on another thread");
+#endif /* HAVE_PTHREAD_H */
+
+  m_slow->Dispose ();
+  m_slow = 0;
+  Simulator::Destroy ();
+  pool->SetThreads (nThreads);
+}
+
+/**
+ * 本地训练线程池的测试集
+ */
+class WsnTrainingPoolTestSuite : public TestSuite
+{
+public:
+  WsnTrainingPoolTestSuite ();
+};
+
+WsnTrainingPoolTestSuite::WsnTrainingPoolTestSuite ()
+  : TestSuite ("wsn-training-pool", UNIT)
+{
+  AddTestCase (new WsnTrainingOrderTestCase, TestCase::QUICK);
+}
+
+static WsnTrainingPoolTestSuite g_wsnTrainingPoolTestSuite;
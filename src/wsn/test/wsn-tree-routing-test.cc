@@ -0,0 +1,221 @@
+#include <ns3/test.h>
+#include <ns3/wsn-address-allocator.h>
+#include <ns3/wsn-route.h>
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Cskip 地址分配和树路由：建一棵满树，每一对（节点，目的地址）的下一跳
+ * 都和沿父节点链算出来的一致
+ */
+class WsnTreeNextHopTestCase : public TestCase
+{
+public:
+  WsnTreeNextHopTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * 给 parent 分配所有的孩子，路由器孩子再往下递归
+   * \param parent 父节点地址
+   * \param depth 父节点深度
+   */
+  void Grow (uint16_t parent, uint8_t depth);
+
+  std::map<uint16_t, uint16_t> m_parent;  //!< 每个节点的父节点
+  std::map<uint16_t, uint8_t> m_depth;    //!< 每个节点的深度
+};
+
+static const uint16_t g_n = 4;  //!< 每个父节点最多的孩子数
+static const uint16_t g_r = 2;  //!< 其中路由器的个数
+static const uint8_t g_d = 3;   //!< 树的最大深度
+
+WsnTreeNextHopTestCase::WsnTreeNextHopTestCase ()
+  : TestCase ("Tree next hop of every node to every destination")
+{
+}
+
+void
+WsnTreeNextHopTestCase::Grow (uint16_t parent, uint8_t depth)
+{
+  if (depth == g_d)
+    {
+      return;
+    }
+  WsnAddressAllocator *allocator = WsnAddressAllocator::Get ();
+  std::vector<uint16_t> routers;
+  for (uint16_t i = 0; i < g_n; ++i)
+    {
+      bool router = i < g_r;
+      uint16_t addr = allocator->AllocateNwkAddress (depth, router, parent);
+      NS_TEST_ASSERT_MSG_EQ (m_depth.count (addr), 0, "Address " << addr << " allocated twice");
+      m_parent[addr] = parent;
+      m_depth[addr] = depth + 1;
+      if (router)
+        {
+          routers.push_back (addr);
+        }
+    }
+  // 先分配完一层再往下，和按父节点分别计数的孩子序号无关
+  for (uint16_t router : routers)
+    {
+      Grow (router, depth + 1);
+    }
+}
+
+void
+WsnTreeNextHopTestCase::DoRun (void)
+{
+  WsnAddressAllocator *allocator = WsnAddressAllocator::Get ();
+  allocator->SetWsnAddressAllocator (g_n, g_r, g_d);
+  m_depth[0] = 0;
+  Grow (0, 0);
+  // 1 + 4 + 2 * 4 + 4 * 4
+  NS_TEST_ASSERT_MSG_EQ (m_depth.size (), 29, "Wrong number of nodes in the full tree");
+
+  for (const auto &self : m_depth)
+    {
+      for (const auto &dest : m_depth)
+        {
+          // 沿 dest 的父节点链往上找 self，找到时链上的前一个节点就是下一跳
+          uint16_t expected = 0;
+          uint16_t hop = dest.first;
+          while (hop != 0 && m_parent[hop] != self.first)
+            {
+              hop = m_parent[hop];
+            }
+          if (hop != 0 && dest.first != self.first)
+            {
+              expected = hop;
+            }
+          bool descendant = expected != 0;
+          NS_TEST_EXPECT_MSG_EQ (allocator->IsDescendant (self.second, self.first, dest.first), descendant,
+                                 "Subtree of " << self.first << " at depth " << (int)self.second
+                                 << " and " << dest.first);
+          NS_TEST_EXPECT_MSG_EQ (allocator->GetTreeNextHop (self.second, self.first, dest.first), expected,
+                                 "Next hop from " << self.first << " at depth " << (int)self.second
+                                 << " to " << dest.first);
+        }
+    }
+  allocator->Reset ();
+}
+
+/**
+ * 路由器和终端的序号按父节点分别计数
+ */
+class WsnAddressCounterTestCase : public TestCase
+{
+public:
+  WsnAddressCounterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnAddressCounterTestCase::WsnAddressCounterTestCase ()
+  : TestCase ("Child counters are kept per parent")
+{
+}
+
+void
+WsnAddressCounterTestCase::DoRun (void)
+{
+  WsnAddressAllocator *allocator = WsnAddressAllocator::Get ();
+  allocator->SetWsnAddressAllocator (g_n, g_r, g_d);
+  // Cskip(0) = 13，Cskip(1) = 5
+  uint16_t a = allocator->AllocateNwkAddress (0, true, 0);
+  uint16_t b = allocator->AllocateNwkAddress (0, true, 0);
+  NS_TEST_EXPECT_MSG_EQ (a, 1, "Wrong first router");
+  NS_TEST_EXPECT_MSG_EQ (b, 14, "Wrong second router");
+
+  // 两个路由器交替加孩子，各自从自己的第一个孩子开始
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, false, a), a + 11, "Wrong first end device of a");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, false, b), b + 11, "Counter shared between parents");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, true, b), b + 1, "Wrong first router of b");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, false, a), a + 12, "Wrong second end device of a");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, true, a), a + 1, "Router counter shared with end devices");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, true, b), b + 6, "Wrong second router of b");
+  // 协调器的终端在两个路由器的地址块之后
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (0, false, 0), 27, "Wrong end device of the coordinator");
+
+  // Reset 以后重新从第一个孩子开始
+  allocator->Reset ();
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (0, true, 0), 1, "Router counter not reset");
+  NS_TEST_EXPECT_MSG_EQ (allocator->AllocateNwkAddress (1, false, a), a + 11, "End device counter not reset");
+  allocator->Reset ();
+}
+
+/**
+ * 批量加静态路由：目的地址重复时后加的覆盖先加的
+ */
+class WsnRoutingTableTestCase : public TestCase
+{
+public:
+  WsnRoutingTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WsnRoutingTableTestCase::WsnRoutingTableTestCase ()
+  : TestCase ("Later routes to the same destination override earlier ones")
+{
+}
+
+void
+WsnRoutingTableTestCase::DoRun (void)
+{
+  RoutingTable table;
+  table.AddRoute (StaticRoute (NwkShortAddress ((uint16_t)5), NwkShortAddress ((uint16_t)1)));
+  table.AddRoute (StaticRoute (NwkShortAddress ((uint16_t)9), NwkShortAddress ((uint16_t)1)));
+
+  std::vector<StaticRoute> routes;
+  routes.push_back (StaticRoute (NwkShortAddress ((uint16_t)7), NwkShortAddress ((uint16_t)2)));
+  routes.push_back (StaticRoute (NwkShortAddress ((uint16_t)5), NwkShortAddress ((uint16_t)3)));
+  routes.push_back (StaticRoute (NwkShortAddress ((uint16_t)7), NwkShortAddress ((uint16_t)4)));
+  routes.push_back (StaticRoute (NwkShortAddress ((uint16_t)3), NwkShortAddress ((uint16_t)6)));
+  table.AddRoutes (routes);
+
+  NS_TEST_EXPECT_MSG_EQ (table.GetN (), 4, "Duplicate destinations kept");
+  // 批内重复：以最后一条为准
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)7)).GetAddressU16 (), 4,
+                         "Earlier route of the batch wins");
+  // 批和表里已有的重复：批覆盖表
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)5)).GetAddressU16 (), 3,
+                         "Existing route not overridden");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)9)).GetAddressU16 (), 1,
+                         "Untouched route lost");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)3)).GetAddressU16 (), 6,
+                         "New route lost");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)8)).GetAddressU16 (), 0,
+                         "Route to an unknown destination");
+
+  // 单条加的也覆盖
+  table.AddRoute (StaticRoute (NwkShortAddress ((uint16_t)9), NwkShortAddress ((uint16_t)8)));
+  NS_TEST_EXPECT_MSG_EQ (table.GetN (), 4, "Duplicate destination added");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (NwkShortAddress ((uint16_t)9)).GetAddressU16 (), 8,
+                         "Single route does not override");
+}
+
+/**
+ * 地址分配和路由的测试集
+ */
+class WsnTreeRoutingTestSuite : public TestSuite
+{
+public:
+  WsnTreeRoutingTestSuite ();
+};
+
+WsnTreeRoutingTestSuite::WsnTreeRoutingTestSuite ()
+  : TestSuite ("wsn-tree-routing", UNIT)
+{
+  AddTestCase (new WsnTreeNextHopTestCase, TestCase::QUICK);
+  AddTestCase (new WsnAddressCounterTestCase, TestCase::QUICK);
+  AddTestCase (new WsnRoutingTableTestCase, TestCase::QUICK);
+}
+
+static WsnTreeRoutingTestSuite g_wsnTreeRoutingTestSuite;
@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure the cost of hooking one trace source and setting one attribute
+ * on every node of a large topology, with one Config call per path and
+ * with a single Config::Batch.
+ */
+
+/// Trace sink
+static uint32_t g_drops = 0;
+
+/**
+ * Trace sink
+ * \param p the dropped packet
+ */
+static void
+Drop (Ptr<const Packet> p)
+{
+  g_drops++;
+}
+
+/**
+ * Build the Config path of the first device of a node.
+ * \param node the node index
+ * \param leaf the attribute or trace source name
+ * \returns the Config path
+ */
+static std::string
+DevicePath (uint32_t node, std::string leaf)
+{
+  std::ostringstream oss;
+  oss << "/NodeList/" << node << "/DeviceList/0/$ns3::SimpleNetDevice/" << leaf;
+  return oss.str ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nodes = 10000;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark Config::Connect and Config::Set on many nodes.");
+  cmd.AddValue ("nodes", "number of nodes", nodes);
+  cmd.Parse (argc, argv);
+
+  NodeContainer c;
+  c.Create (nodes);
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      c.Get (i)->AddDevice (CreateObject<SimpleNetDevice> ());
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      Config::ConnectWithoutContext (DevicePath (i, "PhyRxDrop"), MakeCallback (&Drop));
+      Config::Set (DevicePath (i, "PointToPointMode"), BooleanValue (true));
+    }
+  int64_t single = clock.End ();
+
+  clock.Start ();
+  Config::Batch batch;
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      batch.ConnectWithoutContext (DevicePath (i, "PhyRxDrop"), MakeCallback (&Drop));
+      batch.Set (DevicePath (i, "PointToPointMode"), BooleanValue (false));
+    }
+  batch.Apply ();
+  int64_t batched = clock.End ();
+
+  std::cout << "nodes " << nodes << std::endl;
+  std::cout << "one path per call: " << single << " ms" << std::endl;
+  std::cout << "batch:             " << batched << " ms" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure how fast events scheduled with Simulator::ScheduleWithContext
+ * from other threads reach the main thread, for each
+ * DefaultSimulatorImpl::Inbox and an increasing number of producer threads.
+ */
+
+/// Events executed so far in the current run (main thread only)
+uint64_t g_consumed = 0;
+/// Events expected in the current run
+uint64_t g_total = 0;
+
+/// Event scheduled by the producer threads
+void
+Consume (void)
+{
+  g_consumed++;
+}
+
+/**
+ * Keep the simulation alive until all the events from the producers
+ * have been executed.
+ */
+void
+Poll (void)
+{
+  if (g_consumed < g_total)
+    {
+      Simulator::Schedule (TimeStep (1), &Poll);
+    }
+}
+
+/**
+ * Producer thread body
+ * \param id the producer index, used as event context
+ * \param events the number of events to schedule
+ */
+void
+Produce (uint32_t id, uint32_t events)
+{
+  for (uint32_t i = 0; i < events; ++i)
+    {
+      Simulator::ScheduleWithContext (id, TimeStep (0), &Consume);
+    }
+}
+
+/**
+ * Start the producers from inside Simulator::Run
+ * \param threads the producer threads
+ * \param nThreads the number of producers
+ * \param events the number of events per producer
+ */
+void
+StartProducers (std::vector<std::thread> *threads, uint32_t nThreads, uint32_t events)
+{
+  for (uint32_t i = 0; i < nThreads; ++i)
+    {
+      threads->push_back (std::thread (&Produce, i, events));
+    }
+  Poll ();
+}
+
+/**
+ * Run one measurement
+ * \param inbox the DefaultSimulatorImpl::Inbox value
+ * \param nThreads the number of producers
+ * \param events the number of events per producer
+ * \return events per second
+ */
+double
+Run (const std::string &inbox, uint32_t nThreads, uint32_t events)
+{
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::Inbox", StringValue (inbox));
+  g_consumed = 0;
+  g_total = (uint64_t) nThreads * events;
+
+  std::vector<std::thread> threads;
+  Simulator::Schedule (TimeStep (0), &StartProducers, &threads, nThreads, events);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  for (auto &thread : threads)
+    {
+      thread.join ();
+    }
+  Simulator::Destroy ();
+
+  double seconds = std::chrono::duration<double> (end - start).count ();
+  return g_consumed / seconds;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t events = 200000;
+  uint32_t maxThreads = 8;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark cross-thread ScheduleWithContext throughput.");
+  cmd.AddValue ("events", "events scheduled by each producer thread", events);
+  cmd.AddValue ("maxThreads", "largest number of producer threads", maxThreads);
+  cmd.Parse (argc, argv);
+
+  std::cout << std::setw (10) << "producers"
+            << std::setw (16) << "Locked ev/s"
+            << std::setw (16) << "LockFree ev/s" << std::endl;
+  for (uint32_t n = 1; n <= maxThreads; n *= 2)
+    {
+      double locked = Run ("Locked", n, events);
+      double lockFree = Run ("LockFree", n, events);
+      std::cout << std::setw (10) << n
+                << std::setw (16) << std::fixed << std::setprecision (0) << locked
+                << std::setw (16) << lockFree << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure the cost of creating objects with attributes, through
+ * CreateObject and through an ObjectFactory, and of setting and
+ * getting attributes and connecting trace sources by name, the
+ * pattern of topology construction.
+ */
+
+/// Base class of the created objects
+class BenchBase : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BenchBase")
+      .SetParent<Object> ()
+      .AddAttribute ("A", "", UintegerValue (1),
+                     MakeUintegerAccessor (&BenchBase::m_a),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("B", "", DoubleValue (2),
+                     MakeDoubleAccessor (&BenchBase::m_b),
+                     MakeDoubleChecker<double> ())
+      .AddAttribute ("C", "", TimeValue (Seconds (3)),
+                     MakeTimeAccessor (&BenchBase::m_c),
+                     MakeTimeChecker ())
+      .AddAttribute ("D", "", BooleanValue (false),
+                     MakeBooleanAccessor (&BenchBase::m_d),
+                     MakeBooleanChecker ())
+      .AddTraceSource ("Trace", "",
+                       MakeTraceSourceAccessor (&BenchBase::m_trace),
+                       "ns3::TracedValueCallback::Uint32")
+    ;
+    return tid;
+  }
+
+private:
+  uint32_t m_a;                    ///< Attribute A
+  double m_b;                      ///< Attribute B
+  Time m_c;                        ///< Attribute C
+  bool m_d;                        ///< Attribute D
+  TracedValue<uint32_t> m_trace;   ///< Trace source
+};
+
+/// The created objects
+class BenchDerived : public BenchBase
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BenchDerived")
+      .SetParent<BenchBase> ()
+      .AddConstructor<BenchDerived> ()
+      .AddAttribute ("E", "", UintegerValue (5),
+                     MakeUintegerAccessor (&BenchDerived::m_e),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("F", "", DoubleValue (6),
+                     MakeDoubleAccessor (&BenchDerived::m_f),
+                     MakeDoubleChecker<double> ())
+      .AddAttribute ("G", "", StringValue ("g"),
+                     MakeStringAccessor (&BenchDerived::m_g),
+                     MakeStringChecker ())
+      .AddAttribute ("H", "", IntegerValue (-8),
+                     MakeIntegerAccessor (&BenchDerived::m_h),
+                     MakeIntegerChecker<int32_t> ())
+    ;
+    return tid;
+  }
+
+private:
+  uint32_t m_e;      ///< Attribute E
+  double m_f;        ///< Attribute F
+  std::string m_g;   ///< Attribute G
+  int32_t m_h;       ///< Attribute H
+};
+
+/**
+ * Trace sink
+ * \param oldValue the old value
+ * \param newValue the new value
+ */
+static void
+Sink (uint32_t oldValue, uint32_t newValue)
+{
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 100000;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark object creation and attribute access by name.");
+  cmd.AddValue ("n", "number of objects", n);
+  cmd.Parse (argc, argv);
+
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::duration<double, std::nano> Ns;
+  std::vector<Ptr<BenchDerived> > objects;
+  objects.reserve (n);
+
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      objects.push_back (CreateObject<BenchDerived> ());
+    }
+  Clock::duration create = Clock::now () - start;
+  objects.clear ();
+
+  ObjectFactory factory ("BenchDerived");
+  factory.Set ("A", UintegerValue (10));
+  factory.Set ("C", TimeValue (Seconds (30)));
+  factory.Set ("F", DoubleValue (60));
+  start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      objects.push_back (factory.Create<BenchDerived> ());
+    }
+  Clock::duration factoryCreate = Clock::now () - start;
+
+  start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      objects[i]->SetAttribute ("B", DoubleValue (i));
+      objects[i]->SetAttribute ("H", IntegerValue (i));
+    }
+  Clock::duration set = Clock::now () - start;
+
+  UintegerValue a;
+  start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      objects[i]->GetAttribute ("A", a);
+    }
+  Clock::duration get = Clock::now () - start;
+
+  start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      objects[i]->TraceConnectWithoutContext ("Trace", MakeCallback (&Sink));
+    }
+  Clock::duration connect = Clock::now () - start;
+
+  std::cout << std::setw (24) << "operation" << std::setw (16) << "ns/object" << std::endl;
+  std::cout << std::setw (24) << "CreateObject"
+            << std::setw (16) << Ns (create).count () / n << std::endl;
+  std::cout << std::setw (24) << "ObjectFactory::Create"
+            << std::setw (16) << Ns (factoryCreate).count () / n << std::endl;
+  std::cout << std::setw (24) << "SetAttribute x2"
+            << std::setw (16) << Ns (set).count () / n << std::endl;
+  std::cout << std::setw (24) << "GetAttribute"
+            << std::setw (16) << Ns (get).count () / n << std::endl;
+  std::cout << std::setw (24) << "TraceConnect"
+            << std::setw (16) << Ns (connect).count () / n << std::endl;
+  return 0;
+}
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the packet tag operations:
+// adding, looking up, replacing and removing packet tags, on packets
+// which own their tags and on copies sharing them.
+// Sample usage:  ./waf --run 'bench-packet-tags --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/// BenchTag class of N bytes used for benchmarking packet tags
+template <int N>
+class BenchTag : public Tag
+{
+public:
+  /**
+   * Get the bench tag name.
+   * \return the name.
+   */
+  static std::string GetName (void) {
+    std::ostringstream oss;
+    oss << "anon::BenchPacketTag<" << N << ">";
+    return oss.str ();
+  }
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId (GetName ().c_str ())
+      .SetParent<Tag> ()
+      .SetGroupName ("Utils")
+      .HideFromDocumentation ()
+      .AddConstructor<BenchTag<N> > ()
+      ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const {
+    return N;
+  }
+  virtual void Serialize (TagBuffer buf) const {
+    for (uint32_t i = 0; i < N; ++i)
+      {
+        buf.WriteU8 (m_value);
+      }
+  }
+  virtual void Deserialize (TagBuffer buf) {
+    for (uint32_t i = 0; i < N; ++i)
+      {
+        m_value = buf.ReadU8 ();
+      }
+  }
+  virtual void Print (std::ostream &os) const {
+    os << "N=" << N;
+  }
+  BenchTag ()
+    : Tag (),
+      m_value (N) {}
+  uint8_t m_value; ///< the value of each byte of the tag
+};
+
+/// The tags a frame typically carries: a priority, a flow id, a timestamp
+typedef BenchTag<1> PriorityTag;
+typedef BenchTag<4> FlowTag;
+typedef BenchTag<8> TimeTag;
+/// A tag larger than PACKET_TAG_INLINE_SIZE, such as a TXVECTOR
+typedef BenchTag<64> VectorTag;
+/// A tag the packets do not carry
+typedef BenchTag<2> MissingTag;
+
+/**
+ * \returns a packet carrying the priority, flow id and timestamp tags
+ */
+static Ptr<Packet>
+CreateTaggedPacket (void)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddPacketTag (PriorityTag ());
+  p->AddPacketTag (FlowTag ());
+  p->AddPacketTag (TimeTag ());
+  return p;
+}
+
+static void
+benchAddRemove (uint32_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  PriorityTag priority;
+  FlowTag flow;
+  TimeTag time;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->AddPacketTag (priority);
+      p->AddPacketTag (flow);
+      p->AddPacketTag (time);
+      p->RemovePacketTag (priority);
+      p->RemovePacketTag (flow);
+      p->RemovePacketTag (time);
+    }
+}
+
+static void
+benchPeek (uint32_t n)
+{
+  Ptr<Packet> p = CreateTaggedPacket ();
+  PriorityTag priority;
+  FlowTag flow;
+  TimeTag time;
+  MissingTag missing;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->PeekPacketTag (priority);
+      p->PeekPacketTag (flow);
+      p->PeekPacketTag (time);
+      p->PeekPacketTag (missing);
+    }
+}
+
+static void
+benchCopyReplace (uint32_t n)
+{
+  Ptr<Packet> p = CreateTaggedPacket ();
+  FlowTag flow;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> q = p->Copy ();
+      q->ReplacePacketTag (flow);
+      q->PeekPacketTag (flow);
+    }
+}
+
+static void
+benchForward (uint32_t n)
+{
+  Ptr<Packet> p = CreateTaggedPacket ();
+  PriorityTag priority;
+  VectorTag vector;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // a device queues a copy with its own tags, and strips them
+      Ptr<Packet> q = p->Copy ();
+      q->RemovePacketTag (priority);
+      q->AddPacketTag (vector);
+      q->PeekPacketTag (vector);
+      q->RemovePacketTag (vector);
+    }
+}
+
+static void
+benchCreate (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = CreateTaggedPacket ();
+      Ptr<Packet> q = p->Copy ();
+      q->RemoveAllPacketTags ();
+    }
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration(bench, n);
+      minDelay = std::min(minDelay, delay);
+    }
+  double ns = minDelay;
+  ns *= 1000000;
+  ns /= n;
+  std::cout << ns << " ns/iteration"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark the packet tags");
+  cmd.AddValue ("n", "number of iterations", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of iterations must be specified " <<
+        "by command-line argument --n=(number of iterations)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-packet-tags with n=" << n << std::endl;
+  std::cout << "Tagged packets carry tags of 1, 4 and 8 bytes." << std::endl;
+
+  runBench (&benchAddRemove, n, minIterations, "Add and remove 3 tags");
+  runBench (&benchPeek, n, minIterations, "Peek 3 tags and a missing one");
+  runBench (&benchCopyReplace, n, minIterations, "Copy tagged packet, replace a tag");
+  runBench (&benchForward, n, minIterations, "Copy tagged packet, remove a tag, add/peek/remove a 64-byte tag");
+  runBench (&benchCreate, n, minIterations, "Create tagged packet, copy, remove all tags");
+
+  return 0;
+}
@@ -32,6 +32,7 @@
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 using namespace ns3;
 
@@ -310,6 +311,39 @@ benchFragment (uint32_t n)
   }
 }
 
+static void
+benchReassembly (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  std::vector<uint8_t> payload (8000, 0x55);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (&payload[0], payload.size ());
+    p->AddHeader (udp);
+
+    /* Fragment the datagram, send each fragment with its own header */
+    std::vector<Ptr<Packet> > fragments;
+    for (uint32_t offset = 0; offset < p->GetSize (); offset += 1480)
+      {
+        uint32_t size = std::min<uint32_t> (1480, p->GetSize () - offset);
+        Ptr<Packet> fragment = p->CreateFragment (offset, size);
+        fragment->AddHeader (ipv4);
+        fragments.push_back (fragment);
+      }
+
+    /* Strip the headers and reassemble the datagram */
+    Ptr<Packet> datagram = Create<Packet> ();
+    for (uint32_t j = 0; j < fragments.size (); j++)
+      {
+        Ptr<Packet> fragment = fragments[j]->Copy ();
+        fragment->RemoveHeader (ipv4);
+        datagram->AddAtEnd (fragment);
+      }
+    datagram->RemoveHeader (udp);
+  }
+}
+
 static void
 benchByteTags (uint32_t n)
 {
@@ -362,12 +396,14 @@ int main (int argc, char *argv[])
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  bool enableDeferredPrinting = false;
 
   CommandLine cmd (__FILE__);
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("enable-deferred-printing", "enable packet printing, with metadata computed on demand", enableDeferredPrinting);
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -379,11 +415,21 @@ int main (int argc, char *argv[])
   std::cout << "Running bench-packets with n=" << n << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
 
+  if (enableDeferredPrinting)
+    {
+      Packet::EnableDeferredPrinting ();
+    }
+  else if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+
   runBench (&benchA, n, minIterations, "Copy packet, remove headers");
   runBench (&benchB, n, minIterations, "Just add headers");
   runBench (&benchC, n, minIterations, "Remove by func call");
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
+  runBench (&benchReassembly, n, minIterations, "Fragment and reassemble an 8000-byte datagram");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
 
   return 0;
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure the cost of drawing random values one at a time with
+ * GetValue and in batches with GetValues.
+ */
+
+/**
+ * Time one random variable.
+ * \param name The name to print.
+ * \param rv The random variable.
+ * \param n The number of values.
+ * \param batch The size of the batches.
+ */
+static void
+Bench (std::string name, Ptr<RandomVariableStream> rv, uint32_t n, uint32_t batch)
+{
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::duration<double, std::nano> Ns;
+  std::vector<double> values (batch);
+  double sum = 0;
+
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      sum += rv->GetValue ();
+    }
+  Clock::duration scalar = Clock::now () - start;
+
+  start = Clock::now ();
+  for (uint32_t i = 0; i < n; i += batch)
+    {
+      uint32_t count = std::min (batch, n - i);
+      rv->GetValues (values.data (), count);
+      for (uint32_t j = 0; j < count; ++j)
+        {
+          sum += values[j];
+        }
+    }
+  Clock::duration bulk = Clock::now () - start;
+
+  std::cout << std::setw (24) << name
+            << std::setw (16) << Ns (scalar).count () / n
+            << std::setw (16) << Ns (bulk).count () / n
+            << std::setw (16) << sum / (2.0 * n) << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 10000000;
+  uint32_t batch = 1024;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark GetValue against GetValues.");
+  cmd.AddValue ("n", "number of values", n);
+  cmd.AddValue ("batch", "number of values per GetValues call", batch);
+  cmd.Parse (argc, argv);
+
+  std::cout << std::setw (24) << "distribution"
+            << std::setw (16) << "GetValue ns"
+            << std::setw (16) << "GetValues ns"
+            << std::setw (16) << "mean" << std::endl;
+  Bench ("Uniform", CreateObject<UniformRandomVariable> (), n, batch);
+  Bench ("Exponential", CreateObject<ExponentialRandomVariable> (), n, batch);
+  Bench ("Pareto", CreateObject<ParetoRandomVariable> (), n, batch);
+  Bench ("Weibull", CreateObject<WeibullRandomVariable> (), n, batch);
+  Bench ("Normal", CreateObject<NormalRandomVariable> (), n, batch);
+  return 0;
+}
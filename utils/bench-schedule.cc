@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure the cost of creating, scheduling, executing and releasing
+ * events bound to a few arguments, the pattern of packet-heavy
+ * simulations.  Each batch schedules `pop` events and runs them, so
+ * that the event queue stays small and allocation dominates.
+ */
+
+/// Event target
+class Sink
+{
+public:
+  Sink ()
+    : m_sum (0)
+  {
+  }
+  /**
+   * Event with two arguments
+   * \param a the first argument
+   * \param b the second argument
+   */
+  void Receive (uint32_t a, double b)
+  {
+    m_sum += a + b;
+  }
+  /**
+   * Event with four arguments
+   * \param a the first argument
+   * \param b the second argument
+   * \param c the third argument
+   * \param d the fourth argument
+   */
+  void Receive4 (uint32_t a, double b, uint64_t c, uint16_t d)
+  {
+    m_sum += a + b + c + d;
+  }
+  double m_sum; ///< accumulated arguments
+};
+
+int main (int argc, char *argv[])
+{
+  uint32_t pop = 1000;
+  uint32_t batches = 5000;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark event allocation and scheduling.");
+  cmd.AddValue ("pop", "events per batch", pop);
+  cmd.AddValue ("batches", "number of batches", batches);
+  cmd.Parse (argc, argv);
+
+  Sink sink;
+  // batches are too short for SystemWallClockMs
+  typedef std::chrono::steady_clock Clock;
+  Clock::duration schedule2 (0);
+  Clock::duration run2 (0);
+  Clock::duration schedule4 (0);
+  Clock::duration run4 (0);
+  Clock::time_point start;
+  for (uint32_t b = 0; b < batches; ++b)
+    {
+      start = Clock::now ();
+      for (uint32_t i = 0; i < pop; ++i)
+        {
+          Simulator::Schedule (NanoSeconds (i), &Sink::Receive, &sink, i, 1.0);
+        }
+      schedule2 += Clock::now () - start;
+      start = Clock::now ();
+      Simulator::Run ();
+      run2 += Clock::now () - start;
+
+      start = Clock::now ();
+      for (uint32_t i = 0; i < pop; ++i)
+        {
+          Simulator::Schedule (NanoSeconds (i), &Sink::Receive4, &sink, i, 1.0, i, 2);
+        }
+      schedule4 += Clock::now () - start;
+      start = Clock::now ();
+      Simulator::Run ();
+      run4 += Clock::now () - start;
+    }
+  Simulator::Destroy ();
+
+  double total = (double) pop * batches;
+  typedef std::chrono::duration<double, std::nano> Ns;
+  std::cout << std::setw (8) << "args"
+            << std::setw (16) << "schedule ns/ev"
+            << std::setw (16) << "run ns/ev" << std::endl;
+  std::cout << std::setw (8) << 2
+            << std::setw (16) << Ns (schedule2).count () / total
+            << std::setw (16) << Ns (run2).count () / total << std::endl;
+  std::cout << std::setw (8) << 4
+            << std::setw (16) << Ns (schedule4).count () / total
+            << std::setw (16) << Ns (run4).count () / total << std::endl;
+  return 0;
+}
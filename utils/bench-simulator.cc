@@ -199,6 +199,60 @@ GetRandomStream (std::string filename)
 }
 
 
+/**
+ * Benchmark the current scheduler
+ * \param pop the event population size
+ * \param total the total number of events to run
+ * \param runs the number of runs
+ * \param stream the event time distribution
+ */
+void
+Run (uint32_t pop, uint32_t total, uint32_t runs, Ptr<RandomVariableStream> stream)
+{
+  Bench *bench = new Bench (pop, total);
+  bench->SetRandomStream (stream);
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+       std::left << std::setw (3 * g_fwidth) << "Initialization:" <<
+       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+  LOG (std::left << std::setw (g_fwidth) << "" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+  LOG (std::setfill ('-') <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::setfill (' ')
+       );
+
+  // prime
+  DEB ("priming");
+  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+  bench->RunBench ();
+
+  bench->SetPopulation (pop);
+  bench->SetTotal (total);
+  for (uint32_t i = 0; i < runs; i++)
+    {
+      std::cout << std::setw (g_fwidth) << i;
+
+      bench->RunBench ();
+    }
+
+  LOG ("");
+  delete bench;
+}
+
 
 int main (int argc, char *argv[])
 {
@@ -208,6 +262,8 @@ int main (int argc, char *argv[])
   bool schedList          = false;
   bool schedMap           = true;
   bool schedPriorityQueue = false;
+  bool schedLadder        = false;
+  bool schedAll           = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
@@ -223,13 +279,16 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "With --all every scheduler replays the same distribution.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("calrev", "reverse ordering in the CalendarScheduler", calRev);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("pri",   "use PriorityQueue",             schedPriorityQueue);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
+  cmd.AddValue ("all",   "run every scheduler in turn",   schedAll);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
@@ -258,64 +317,56 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::PriorityQueueScheduler");
     }
-      
-  Simulator::SetScheduler (factory);
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
+
+  std::vector<ObjectFactory> factories;
+  if (schedAll)
+    {
+      const char *types[] = {
+        "ns3::ListScheduler",
+        "ns3::MapScheduler",
+        "ns3::HeapScheduler",
+        "ns3::CalendarScheduler",
+        "ns3::PriorityQueueScheduler",
+        "ns3::LadderScheduler"
+      };
+      for (uint32_t i = 0; i < sizeof (types) / sizeof (types[0]); ++i)
+        {
+          factories.push_back (ObjectFactory (types[i]));
+          if (factories.back ().GetTypeId ().GetName () == "ns3::CalendarScheduler")
+            {
+              factories.back ().Set ("Reverse", BooleanValue (calRev));
+            }
+        }
+    }
+  else
+    {
+      factories.push_back (factory);
+    }
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  std::string order;
-  if (schedCal)
-    {
-      order = ": insertion order: " + std::string (calRev ? "reverse" : "normal");
-    }
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName () << order);
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
 
-  Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
-
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Initialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<ObjectFactory>::iterator f = factories.begin (); f != factories.end (); ++f)
     {
-      std::cout << std::setw (g_fwidth) << i;
-
-      bench->RunBench ();
+      // every scheduler replays the same event time distribution
+      Simulator::SetScheduler (*f);
+      std::string order;
+      if (f->GetTypeId ().GetName () == "ns3::CalendarScheduler")
+        {
+          order = ": insertion order: " + std::string (calRev ? "reverse" : "normal");
+        }
+      LOG ("");
+      LOGME ("scheduler: " << f->GetTypeId ().GetName () << order);
+      Run (pop, total, runs, GetRandomStream (filename));
+      Simulator::Destroy ();
     }
-
-  LOG ("");
-  Simulator::Destroy ();
-  delete bench;
   return 0;
 }